@@ -70,6 +70,13 @@ namespace Falcor
         return nullptr;
     }
 
+    ConstantBuffer::SharedPtr ConstantBuffer::clone() const
+    {
+        SharedPtr pBuffer = SharedPtr(new ConstantBuffer(mName, mpReflector, getSize()));
+        pBuffer->setBlob(mData.data(), 0, mData.size());
+        return pBuffer;
+    }
+
     bool ConstantBuffer::uploadToGPU(size_t offset, size_t size)
     {
         if (mDirty) mpCbv = nullptr;
@@ -65,6 +65,7 @@ namespace Falcor
 
             Var operator[](size_t offset) { return Var(get(), offset); }
             Var operator[](const std::string& var) { return Var(get(), get()->getVariableOffset(var)); }
+            Var operator[](const ShaderVarHandle& handle) { return Var(get(), get()->getVariableOffset(handle)); }
         };
 
         using SharedConstPtr = std::shared_ptr<const ConstantBuffer>;
@@ -85,6 +86,10 @@ namespace Falcor
         */
         static SharedPtr create(Program::SharedPtr& pProgram, const std::string& name, size_t overrideSize = 0);
 
+        /** Create a new constant buffer with the same layout and a copy of the CPU data. The GPU copy is uploaded when the new buffer is first used
+        */
+        SharedPtr clone() const;
+
         ~ConstantBuffer();
 
         /** Set a variable into the buffer.
@@ -98,6 +103,17 @@ namespace Falcor
             return VariablesBuffer::setVariable(name, 0, value);
         }
 
+        /** Set a variable into the buffer using a handle resolved with getVariableHandle(). This doesn't parse the name or allocate memory.
+            The function will validate that the value Type matches the declaration in the shader. If there's a mismatch, an error will be logged and the call will be ignored.
+            \param[in] handle The variable handle
+            \param[in] value Value to set
+        */
+        template<typename T>
+        void setVariable(const ShaderVarHandle& handle, const T& value)
+        {
+            return VariablesBuffer::setVariable(handle, 0, value);
+        }
+
         /** Set a variable array in the buffer.
             The function will validate that the value Type matches the declaration in the shader. If there's a mismatch, an error will be logged and the call will be ignored.
             \param[in] offset The variable byte offset inside the buffer
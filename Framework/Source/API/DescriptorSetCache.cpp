@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "DescriptorSetCache.h"
+
+namespace Falcor
+{
+    static size_t combineHash(size_t seed, const void* p)
+    {
+        return seed ^ (std::hash<const void*>()(p) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+
+    DescriptorSetCache::Key::Key(const DescriptorSet::Layout* pLayout, const std::shared_ptr<const void>& pLayoutOwner) : mpLayout(pLayout), mpLayoutOwner(pLayoutOwner)
+    {
+        mHash = combineHash(0, pLayout);
+    }
+
+    void DescriptorSetCache::Key::addDescriptor(const std::shared_ptr<const void>& pObject)
+    {
+        mHash = combineHash(mHash, pObject.get());
+        mObjects.push_back(pObject);
+    }
+
+    bool DescriptorSetCache::Key::operator==(const Key& other) const
+    {
+        if (mHash != other.mHash || mpLayout != other.mpLayout || mObjects.size() != other.mObjects.size()) return false;
+        for (size_t i = 0; i < mObjects.size(); i++)
+        {
+            if (mObjects[i] != other.mObjects[i]) return false;
+        }
+        return true;
+    }
+
+    DescriptorSetCache::SharedPtr DescriptorSetCache::create(uint32_t frameLifetime, uint32_t maxSets)
+    {
+        return SharedPtr(new DescriptorSetCache(frameLifetime, maxSets));
+    }
+
+    DescriptorSet::SharedPtr DescriptorSetCache::find(const Key& key)
+    {
+        mStats.lookups++;
+        auto it = mSets.find(key);
+        if (it == mSets.end()) return nullptr;
+
+        mStats.hits++;
+        mStats.descriptorWritesAvoided += key.getDescriptorCount();
+        it->second.lastUsedFrame = mFrameID;
+        it->second.wasFound = true;
+        return it->second.pSet;
+    }
+
+    void DescriptorSetCache::insert(const Key& key, const DescriptorSet::SharedPtr& pSet)
+    {
+        mStats.descriptorWrites += key.getDescriptorCount();
+        if (mSets.size() >= mMaxSets)
+        {
+            mStats.rejectedInserts++;
+            return;
+        }
+        mSets[key] = { pSet, mFrameID, false };
+        mStats.cachedSets = mSets.size();
+    }
+
+    void DescriptorSetCache::endFrame()
+    {
+        for (auto it = mSets.begin(); it != mSets.end();)
+        {
+            if (it->second.wasFound == false || mFrameID - it->second.lastUsedFrame >= mFrameLifetime)
+            {
+                // Releasing the set defers the release of its descriptors until the GPU is done with the current frame
+                it = mSets.erase(it);
+                mStats.evictions++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        mStats.cachedSets = mSets.size();
+        mFrameID++;
+    }
+
+    void DescriptorSetCache::clear()
+    {
+        mSets.clear();
+        mStats.cachedSets = 0;
+    }
+
+    void DescriptorSetCache::resetStats()
+    {
+        size_t cachedSets = mStats.cachedSets;
+        mStats = Stats();
+        mStats.cachedSets = cachedSets;
+    }
+}
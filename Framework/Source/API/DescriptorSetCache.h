@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/DescriptorSet.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    /** A cache of descriptor-sets keyed by their content.
+        Descriptor-sets are never modified after they were written, so sets with the same layout and the same views can be shared between parameter-blocks. Instead of allocating a new set and writing all of its descriptors, a block which finds a matching set in the cache binds it directly.
+        Sets which were not used for a number of frames are evicted. Sets which were never found by a lookup are evicted at the end of the frame they were inserted in, so blocks whose content changes every draw (for example, a per-mesh constant buffer which gets a new view on each update) don't keep their sets alive. The number of cached sets is bounded as well.
+        The descriptors are returned to the pool through the pool's fenced deferred-release, so a set which is still referenced by in-flight command lists is never overwritten.
+    */
+    class DescriptorSetCache
+    {
+    public:
+        using SharedPtr = std::shared_ptr<DescriptorSetCache>;
+        using SharedConstPtr = std::shared_ptr<const DescriptorSetCache>;
+        static const uint32_t kDefaultFrameLifetime = 8;
+        static const uint32_t kDefaultMaxSets = 4096;
+
+        /** The content of a descriptor-set. The key holds references to the layout owner and the views, so their addresses can't be reused by other objects while the key is alive
+        */
+        class Key
+        {
+        public:
+            /** Create a key
+                \param[in] pLayout The set layout
+                \param[in] pLayoutOwner The object which owns the layout (usually the reflection object). Keeps the layout alive while the set is cached
+            */
+            Key(const DescriptorSet::Layout* pLayout, const std::shared_ptr<const void>& pLayoutOwner);
+
+            /** Add the next descriptor. Descriptors must be added in range order
+                \param[in] pObject The view or sampler object. Use the null-views for empty descriptors
+            */
+            void addDescriptor(const std::shared_ptr<const void>& pObject);
+
+            size_t getHash() const { return mHash; }
+            uint32_t getDescriptorCount() const { return (uint32_t)mObjects.size(); }
+            bool operator==(const Key& other) const;
+        private:
+            const DescriptorSet::Layout* mpLayout;
+            std::shared_ptr<const void> mpLayoutOwner;
+            std::vector<std::shared_ptr<const void>> mObjects;
+            size_t mHash;
+        };
+
+        struct Stats
+        {
+            uint64_t lookups = 0;                   ///< Number of lookups since the stats were reset
+            uint64_t hits = 0;                      ///< Number of lookups which found a cached set
+            uint64_t descriptorWrites = 0;          ///< Number of descriptors written into new sets
+            uint64_t descriptorWritesAvoided = 0;   ///< Number of descriptor writes skipped because a cached set was reused
+            uint64_t evictions = 0;                 ///< Number of sets evicted from the cache
+            uint64_t rejectedInserts = 0;           ///< Number of sets which were not cached because the cache was full
+            size_t cachedSets = 0;                  ///< Number of sets currently in the cache
+        };
+
+        /** Create a new cache
+            \param[in] frameLifetime The number of frames a set can stay unused before it is evicted
+            \param[in] maxSets The maximum number of cached sets
+        */
+        static SharedPtr create(uint32_t frameLifetime = kDefaultFrameLifetime, uint32_t maxSets = kDefaultMaxSets);
+
+        /** Find a set matching the key. Updates the set's last-used frame
+            \return The cached set, or nullptr if the content isn't in the cache
+        */
+        DescriptorSet::SharedPtr find(const Key& key);
+
+        /** Add a newly written set to the cache. Ignored if the cache is full
+        */
+        void insert(const Key& key, const DescriptorSet::SharedPtr& pSet);
+
+        /** Advance the frame counter and evict the sets which were not used for the cache's frame lifetime. Called by the device when presenting
+        */
+        void endFrame();
+
+        /** Remove all the sets from the cache
+        */
+        void clear();
+
+        /** Get the cache counters
+        */
+        const Stats& getStats() const { return mStats; }
+
+        /** Reset the counters. The number of cached sets is not affected
+        */
+        void resetStats();
+    private:
+        DescriptorSetCache(uint32_t frameLifetime, uint32_t maxSets) : mFrameLifetime(frameLifetime), mMaxSets(maxSets) {}
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const { return key.getHash(); }
+        };
+
+        struct Entry
+        {
+            DescriptorSet::SharedPtr pSet;
+            uint64_t lastUsedFrame;
+            bool wasFound;      ///< Whether a lookup ever returned the set
+        };
+
+        std::unordered_map<Key, Entry, KeyHash> mSets;
+        uint32_t mFrameLifetime;
+        uint32_t mMaxSets;
+        uint64_t mFrameID = 0;
+        Stats mStats;
+    };
+}
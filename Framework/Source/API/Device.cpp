@@ -65,6 +65,7 @@ namespace Falcor
         mpGpuDescPool = DescriptorPool::create(poolDesc, mpRenderContext->getLowLevelData()->getFence());
         poolDesc.setShaderVisible(false).setDescCount(DescriptorPool::Type::Rtv, 16 * 1024).setDescCount(DescriptorPool::Type::Dsv, 1024);
         mpCpuDescPool = DescriptorPool::create(poolDesc, mpRenderContext->getLowLevelData()->getFence());
+        mpDescriptorSetCache = DescriptorSetCache::create();
 
         if (mpRenderContext) mpRenderContext->flush();  // This will bind the descriptor heaps
 
@@ -180,6 +181,7 @@ namespace Falcor
 
         mpRenderContext.reset();
         mpResourceAllocator.reset();
+        mpDescriptorSetCache.reset();
         mpCpuDescPool.reset();
         mpGpuDescPool.reset();
         mpFrameFence.reset();
@@ -195,6 +197,7 @@ namespace Falcor
         apiPresent();
         mpFrameFence->gpuSignal(mpRenderContext->getLowLevelData()->getCommandQueue());
         executeDeferredReleases();
+        mpDescriptorSetCache->endFrame();
         mFrameID++;
     }
 
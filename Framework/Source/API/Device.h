@@ -32,6 +32,7 @@
 #include "API/RenderContext.h"
 #include "API/LowLevel/DescriptorPool.h"
 #include "API/LowLevel/ResourceAllocator.h"
+#include "API/DescriptorSetCache.h"
 #include "API/QueryHeap.h"
 
 namespace Falcor
@@ -139,6 +140,7 @@ namespace Falcor
 
         const DescriptorPool::SharedPtr& getCpuDescriptorPool() const { return mpCpuDescPool; }
         const DescriptorPool::SharedPtr& getGpuDescriptorPool() const { return mpGpuDescPool; }
+        const DescriptorSetCache::SharedPtr& getDescriptorSetCache() const { return mpDescriptorSetCache; }
         const ResourceAllocator::SharedPtr& getResourceAllocator() const { return mpResourceAllocator; }
         const QueryHeap::SharedPtr& getTimestampQueryHeap() const { return mTimestampQueryHeap; }
         void releaseResource(ApiObjectHandle pResource);
@@ -179,6 +181,7 @@ namespace Falcor
         ResourceAllocator::SharedPtr mpResourceAllocator;
         DescriptorPool::SharedPtr mpCpuDescPool;
         DescriptorPool::SharedPtr mpGpuDescPool;
+        DescriptorSetCache::SharedPtr mpDescriptorSetCache;
         bool mIsWindowOccluded = false;
         GpuFence::SharedPtr mpFrameFence;
 
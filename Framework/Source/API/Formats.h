@@ -220,6 +220,15 @@ namespace Falcor
         return kFormatDesc[(uint32_t)format].compressionRatio.height;
     }
 
+    /** Get the size in bytes of a 2D image with the given dimensions. Compressed formats are rounded up to whole blocks
+    */
+    inline size_t getFormatImageSize(ResourceFormat format, uint32_t width, uint32_t height)
+    {
+        uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+        uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+        return (size_t)((width + widthRatio - 1) / widthRatio) * ((height + heightRatio - 1) / heightRatio) * getFormatBytesPerBlock(format);
+    }
+
     /** Get the number of channels
     */
     inline uint32_t getFormatChannelCount(ResourceFormat format)
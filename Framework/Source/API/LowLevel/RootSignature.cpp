@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "API/LowLevel/RootSignature.h"
 #include "Graphics/Program/ProgramReflection.h"
+#include <unordered_map>
 
 namespace Falcor
 {
@@ -61,18 +62,83 @@ namespace Falcor
         return create(Desc());
     }
 
+    static size_t hashDesc(const RootSignature::Desc& desc)
+    {
+        // FNV-1a over the ranges of every set
+        uint64_t hash = 14695981039346656037ull;
+        auto hashU32 = [&hash](uint32_t v)
+        {
+            hash ^= v;
+            hash *= 1099511628211ull;
+        };
+
+        hashU32((uint32_t)desc.getSetsCount());
+        for (size_t s = 0; s < desc.getSetsCount(); s++)
+        {
+            const auto& set = desc.getSet(s);
+            hashU32((uint32_t)set.getVisibility());
+            hashU32((uint32_t)set.getRangeCount());
+            for (size_t r = 0; r < set.getRangeCount(); r++)
+            {
+                const auto& range = set.getRange(r);
+                hashU32((uint32_t)range.type);
+                hashU32(range.baseRegIndex);
+                hashU32(range.descCount);
+                hashU32(range.regSpace);
+            }
+        }
+        return (size_t)hash;
+    }
+
+    bool RootSignature::Desc::operator==(const Desc& other) const
+    {
+#ifdef FALCOR_DXR
+        if (mIsLocal != other.mIsLocal) return false;
+#endif
+        if (mSets.size() != other.mSets.size()) return false;
+        for (size_t s = 0; s < mSets.size(); s++)
+        {
+            const auto& a = mSets[s];
+            const auto& b = other.mSets[s];
+            if (a.getVisibility() != b.getVisibility() || a.getRangeCount() != b.getRangeCount()) return false;
+            for (size_t r = 0; r < a.getRangeCount(); r++)
+            {
+                const auto& ra = a.getRange(r);
+                const auto& rb = b.getRange(r);
+                if (ra.type != rb.type || ra.baseRegIndex != rb.baseRegIndex || ra.descCount != rb.descCount || ra.regSpace != rb.regSpace) return false;
+            }
+        }
+        return true;
+    }
+
     RootSignature::SharedPtr RootSignature::create(const Desc& desc)
     {
         bool empty = desc.mSets.size() == 0;
         if (empty && spEmptySig) return spEmptySig;
 
+        // Root signatures are interned by their description. Every ProgramVars object asks for one, and many programs and permutations share the same layout
+        static std::unordered_map<size_t, std::vector<std::weak_ptr<RootSignature>>> sCache;
+        auto& bucket = sCache[hashDesc(desc)];
+        for (auto it = bucket.begin(); it != bucket.end();)
+        {
+            SharedPtr pExisting = it->lock();
+            if (pExisting == nullptr)
+            {
+                it = bucket.erase(it);
+                continue;
+            }
+            if (pExisting->mDesc == desc) return pExisting;
+            ++it;
+        }
+
         SharedPtr pSig = SharedPtr(new RootSignature(desc));
         if (pSig->apiInit() == false)
         {
-            pSig = nullptr;
+            return nullptr;
         }
 
         if (empty) spEmptySig = pSig;
+        else bucket.push_back(pSig);
 
         return pSig;
     }
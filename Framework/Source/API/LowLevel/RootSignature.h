@@ -53,6 +53,7 @@ namespace Falcor
 #endif
             size_t getSetsCount() const { return mSets.size(); }
             const DescriptorSetLayout getSet(size_t index) const { return mSets[index]; }
+            bool operator==(const Desc& other) const;
         private:
             friend class RootSignature;
             std::vector<DescriptorSetLayout> mSets;
@@ -64,6 +64,7 @@ namespace Falcor
                 Element(StructuredBuffer* pBuf, size_t element) : mpBuf(pBuf), mElement(element) {}
                 Var operator[](size_t offset) { return Var(mpBuf, offset, mElement); }
                 Var operator[](const std::string& var) { return Var(mpBuf, mpBuf->getVariableOffset(var), mElement); }
+                Var operator[](const ShaderVarHandle& handle) { return Var(mpBuf, mpBuf->getVariableOffset(handle), mElement); }
                 size_t getElement() const { return mElement; }
             private:
                 StructuredBuffer* mpBuf;
@@ -90,8 +90,17 @@ namespace Falcor
 
     size_t VariablesBuffer::getVariableOffset(const std::string& varName) const
     {
-        const auto& pVar = mpReflector->findMember(varName);
-        return pVar ? pVar->getOffset() : kInvalidOffset;
+        return mpReflector->getVariableHandle(varName).offset;
+    }
+
+    size_t VariablesBuffer::getVariableOffset(const ShaderVarHandle& handle) const
+    {
+        if (handle.pReflector != mpReflector.get())
+        {
+            logWarning("VariablesBuffer::getVariableOffset() - " + std::string(handle.isValid() ? "the handle was resolved against a different reflection object" : "invalid variable handle") + " for buffer \"" + mName + "\"");
+            return kInvalidOffset;
+        }
+        return handle.offset;
     }
 
     bool VariablesBuffer::uploadToGPU(size_t offset, size_t size)
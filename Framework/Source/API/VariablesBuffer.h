@@ -78,6 +78,19 @@ namespace Falcor
         */
         size_t getVariableOffset(const std::string& varName) const;
 
+        /** Get a handle to a variable inside the buffer. See notes about naming in the VariablesBuffer class description.
+            Resolve the handle once and use it in per-frame and per-draw code instead of the name. The handle is valid for any buffer created with the same reflection object
+        */
+        const ShaderVarHandle& getVariableHandle(const std::string& varName) const { return mpReflector->getVariableHandle(varName); }
+
+        /** Get a variable offset from a handle. Returns kInvalidOffset if the handle wasn't resolved against this buffer's reflection
+        */
+        size_t getVariableOffset(const ShaderVarHandle& handle) const;
+
+        /** Get the CPU copy of the buffer data
+        */
+        const std::vector<uint8_t>& getCpuData() const { return mData; }
+
         size_t getElementCount() const { return mElementCount; }
 
         size_t getElementSize() const { return mElementSize; }
@@ -104,6 +117,13 @@ namespace Falcor
         template<typename T>
         void setVariableArray(const std::string& name, size_t elementIndex, const T* pValue, size_t count);
 
+        template<typename T>
+        void setVariable(const ShaderVarHandle& handle, size_t elementIndex, const T& value)
+        {
+            size_t offset = getVariableOffset(handle);
+            if (offset != kInvalidOffset) setVariable(offset, elementIndex, value);
+        }
+
         ReflectionResourceType::SharedConstPtr mpReflector;
         std::vector<uint8_t> mData;
         mutable bool mDirty = true;
@@ -134,6 +134,53 @@ struct MaterialData
     MaterialResources resources;
 };
 
+/** A material in the scene-wide material table. Same data as MaterialData, but the textures and the sampler are indices into the table's resource arrays
+*/
+struct MaterialTableEntry
+{
+    float4 baseColor DEFAULTS(float4(1));
+    float4 specular  DEFAULTS(float4(0));
+    float3 emissive  DEFAULTS(float3(0));
+    float alphaThreshold DEFAULTS(0.5f);
+
+    float IoR DEFAULTS(1);
+    uint32_t id DEFAULTS(0);
+    uint32_t flags DEFAULTS(0);
+    uint32_t samplerIndex DEFAULTS(0);
+
+    float2 heightScaleOffset DEFAULTS(float2(1, 0));
+    uint32_t baseColorIndex DEFAULTS(0);
+    uint32_t specularIndex DEFAULTS(0);
+
+    uint32_t emissiveIndex DEFAULTS(0);
+    uint32_t normalMapIndex DEFAULTS(0);
+    uint32_t occlusionMapIndex DEFAULTS(0);
+    uint32_t lightMapIndex DEFAULTS(0);
+
+    uint32_t heightMapIndex DEFAULTS(0);
+    float3 pad DEFAULTS(float3(0));
+};
+
+/*******************************************************************
+                    Indirect draws
+*******************************************************************/
+
+/** A mesh instance in a GPU-culled indirect draw list. The bounds are relative to the instance's transform hierarchy node
+*/
+struct IndirectInstanceData
+{
+    float3 boundsCenter DEFAULTS(float3(0));
+    uint32_t transformNode DEFAULTS(0);     ///< Index of the instance's node in the transform hierarchy GPU buffer
+
+    float3 boundsExtent DEFAULTS(float3(0));
+    uint32_t drawIndex DEFAULTS(0);         ///< Index of the instance's draw in the argument buffer
+
+    uint32_t visibleBase DEFAULTS(0);       ///< First slot of the instance's draw in the visible-instance list
+    uint32_t materialIndex DEFAULTS(0);     ///< Index into the scene material table
+    uint32_t drawId DEFAULTS(0);            ///< Zero-based order of the instance in the draw list
+    uint32_t pad DEFAULTS(0);
+};
+
 /*******************************************************************
                     Lights
 *******************************************************************/
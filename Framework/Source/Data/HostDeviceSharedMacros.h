@@ -34,6 +34,8 @@
 
 #define MAX_INSTANCES 64    ///< Max supported instances per draw call
 #define MAX_BONES 256       ///< Max supported bones per model
+#define MAX_MATERIAL_TABLE_TEXTURES 256 ///< Max unique textures in the scene material table
+#define MAX_MATERIAL_TABLE_SAMPLERS 16  ///< Max unique samplers in the scene material table
 
 /*******************************************************************
                     Glue code for CPU/GPU compilation
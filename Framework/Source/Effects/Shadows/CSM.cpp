@@ -38,6 +38,7 @@ namespace Falcor
     const char* kDepthPassFile = "Effects/DepthPass.slang";
     const char* kShadowPassfile = "Effects/ShadowPass.slang";
     const char* kVisibilityPassFile = "Effects/VisibilityPass.ps.slang";
+    static const Program::DefineSymbol kTestAlphaDefine = Program::internDefine("TEST_ALPHA");
 
     const Gui::DropdownList kFilterList = {
         { (uint32_t)CsmFilterPoint, "Point" },
@@ -149,11 +150,11 @@ namespace Falcor
                     pDefaultBlock->setSrv(mBindLocations.alphaMap, 0, nullptr);
                 }
                 pDefaultBlock->setSampler(mBindLocations.alphaMapSampler, 0, mpAlphaSampler);
-                currentData.pContext->getGraphicsState()->getProgram()->addDefine("TEST_ALPHA");
+                currentData.pContext->getGraphicsState()->getProgram()->addDefine(kTestAlphaDefine);
             }
             else
             {
-                currentData.pContext->getGraphicsState()->getProgram()->removeDefine("TEST_ALPHA");
+                currentData.pContext->getGraphicsState()->getProgram()->removeDefine(kTestAlphaDefine);
             }
             const auto& pRsState = getRasterizerState(currentData.pMaterial);
             if(pRsState != mpLastSetRs)
@@ -165,20 +166,20 @@ namespace Falcor
         };
     };
 
-    void createShadowMatrix(const DirectionalLight* pLight, const glm::vec3& center, float radius, glm::mat4& shadowVP)
+    void createDirectionalShadowMatrix(const LightData& light, const glm::vec3& center, float radius, glm::mat4& shadowVP)
     {
-        glm::mat4 view = glm::lookAt(center, center + pLight->getWorldDirection(), glm::vec3(0, 1, 0));
+        glm::mat4 view = glm::lookAt(center, center + light.dirW, glm::vec3(0, 1, 0));
         glm::mat4 proj = glm::ortho(-radius, radius, -radius, radius, -radius, radius);
 
         shadowVP = proj * view;
     }
 
-    void createShadowMatrix(const PointLight* pLight, const glm::vec3& center, float radius, float fboAspectRatio, glm::mat4& shadowVP)
+    void createPointShadowMatrix(const LightData& light, const glm::vec3& center, float radius, float fboAspectRatio, glm::mat4& shadowVP)
     {
-        const glm::vec3 lightPos = pLight->getWorldPosition();
-        const glm::vec3 lookat = pLight->getWorldDirection() + lightPos;
+        const glm::vec3 lightPos = light.posW;
+        const glm::vec3 lookat = light.dirW + lightPos;
         glm::vec3 up(0, 1, 0);
-        if(abs(glm::dot(up, pLight->getWorldDirection())) >= 0.95f)
+        if(abs(glm::dot(up, light.dirW)) >= 0.95f)
         {
             up = glm::vec3(1, 0, 0);
         }
@@ -187,20 +188,20 @@ namespace Falcor
         float distFromCenter = glm::length(lightPos - center);
         float nearZ = max(0.1f, distFromCenter - radius);
         float maxZ = min(radius * 2, distFromCenter + radius);
-        float angle = pLight->getOpeningAngle() * 2;
+        float angle = light.openingAngle * 2;
         glm::mat4 proj = glm::perspective(angle, fboAspectRatio, nearZ, maxZ);
 
         shadowVP = proj * view;
     }
 
-    void createShadowMatrix(const Light* pLight, const glm::vec3& center, float radius, float fboAspectRatio, glm::mat4& shadowVP)
+    void createShadowMatrix(const LightData& light, const glm::vec3& center, float radius, float fboAspectRatio, glm::mat4& shadowVP)
     {
-        switch(pLight->getType())
+        switch(light.type)
         {
         case LightDirectional:
-            return createShadowMatrix((DirectionalLight*)pLight, center, radius, shadowVP);
+            return createDirectionalShadowMatrix(light, center, radius, shadowVP);
         case LightPoint:
-            return createShadowMatrix((PointLight*)pLight, center, radius, fboAspectRatio, shadowVP);
+            return createPointShadowMatrix(light, center, radius, fboAspectRatio, shadowVP);
         default:
             should_not_get_here();
         }
@@ -578,7 +579,7 @@ namespace Falcor
         camClipSpaceToWorldSpace(pCamera, camFrustum.crd, camFrustum.center, camFrustum.radius);
 
         // Create the global shadow space
-        createShadowMatrix(mpLight.get(), camFrustum.center, camFrustum.radius, mShadowPass.fboAspectRatio, mCsmData.globalMat);
+        createShadowMatrix(getLightData(), camFrustum.center, camFrustum.radius, mShadowPass.fboAspectRatio, mCsmData.globalMat);
 
         if(mCsmData.cascadeCount == 1)
         {
@@ -842,7 +843,7 @@ namespace Falcor
             break;
         }    
 
-        mCsmData.lightDir = glm::normalize(((DirectionalLight*)mpLight.get())->getWorldDirection());
+        mCsmData.lightDir = glm::normalize(getLightData().dirW);
         ConstantBuffer::SharedPtr pCB = pVars->getConstantBuffer("PerFrameCB");
         size_t offset = pCB->getVariableOffset(varName + ".globalMat");
         pCB->setBlob(&mCsmData, offset, sizeof(mCsmData));
@@ -882,6 +883,29 @@ namespace Falcor
         return mpCsmSceneRenderer->isMeshCullingEnabled();
     }
 
+    const LightData& CascadedShadowMaps::getLightData() const
+    {
+        // The simulation thread modifies the live light while a snapshot is rendered
+        if (mpSnapshot && mpScene)
+        {
+            for (uint32_t i = 0; i < std::min(mpScene->getLightCount(), mpSnapshot->getLightCount()); i++)
+            {
+                if (mpScene->getLight(i).get() == mpLight.get())
+                {
+                    return mpSnapshot->getLightData(i);
+                }
+            }
+        }
+        return mpLight->getData();
+    }
+
+    void CascadedShadowMaps::setSceneSnapshot(const SceneSnapshot::SharedPtr& pSnapshot)
+    {
+        mpSnapshot = pSnapshot;
+        mpCsmSceneRenderer->setSnapshot(pSnapshot);
+        mpSceneRenderer->setSnapshot(pSnapshot);
+    }
+
     void CascadedShadowMaps::resizeVisibilityBuffer(uint32_t width, uint32_t height)
     {
         Fbo::Desc fboDesc;
@@ -31,6 +31,7 @@
 #include "../Utils/GaussianBlur.h"
 #include "Graphics/Light.h"
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/SceneSnapshot.h"
 #include "Utils/Math/ParallelReduction.h"
 
 namespace Falcor
@@ -149,10 +150,15 @@ namespace Falcor
         */
         void resizeVisibilityBuffer(uint32_t width, uint32_t height);
 
+        /** Render the shadow maps from a scene snapshot instead of the live scene. See SceneRenderer::setSnapshot()
+        */
+        void setSceneSnapshot(const SceneSnapshot::SharedPtr& pSnapshot);
+
     private:
         CascadedShadowMaps(uint32_t mapWidth, uint32_t mapHeight, uint32_t windowWidth, uint32_t windowHeight, Light::SharedConstPtr pLight, Scene::SharedConstPtr pScene, uint32_t cascadeCount, ResourceFormat shadowMapFormat);
         Light::SharedConstPtr mpLight;
         Scene::SharedConstPtr mpScene;
+        SceneSnapshot::SharedPtr mpSnapshot;
         Camera::SharedPtr mpLightCamera;
         std::shared_ptr<CsmSceneRenderer> mpCsmSceneRenderer;
         std::shared_ptr<SceneRenderer> mpSceneRenderer;
@@ -166,6 +172,9 @@ namespace Falcor
         void partitionCascades(const Camera* pCamera, const glm::vec2& distanceRange);
         void renderScene(RenderContext* pCtx);
 
+        // The light data of the rendered frame. Comes from the snapshot if one is set
+        const LightData& getLightData() const;
+
         // Shadow-pass
         struct
         {
@@ -64,6 +64,7 @@
 
 #if defined FALCOR_D3D12 || defined FALCOR_VK
 #include "API/DescriptorSet.h"
+#include "API/DescriptorSetCache.h"
 #include "API/LowLevel/DescriptorPool.h"
 #include "API/LowLevel/FencedPool.h"
 #include "API/LowLevel/GpuFence.h"
@@ -89,18 +90,23 @@
 #include "Graphics/Program/GraphicsProgram.h"
 #include "Graphics/Program/ComputeProgram.h"
 #include "Graphics/Program/ParameterBlock.h"
+#include "Graphics/Program/ShaderArchive.h"
 
 // Material
 #include "Graphics/Material/Material.h"
+#include "Graphics/Material/MaterialTable.h"
 
 // Model
 #include "Graphics/Model/Mesh.h"
 #include "Graphics/Model/Model.h"
+#include "Graphics/Model/GeometryArena.h"
 #include "Graphics/Model/ModelRenderer.h"
 
 // Scene
 #include "Graphics/Scene/Scene.h"
 #include "Graphics/Scene/SceneRenderer.h"
+#include "Graphics/Scene/SceneSnapshot.h"
+#include "Graphics/Scene/IndirectDrawList.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 
 // Math
@@ -126,6 +132,7 @@
 #include "Utils/Platform/OS.h"
 #include "Utils/Platform/ProgressBar.h"
 #include "Utils/ThreadPool.h"
+#include "Utils/SimulationThread.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
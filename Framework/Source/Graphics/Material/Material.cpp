@@ -293,8 +293,10 @@ namespace Falcor
 
         pCB->setBlob(&data, offset, dataSize);
 
-        // Now set the textures
-#define set_texture(texName) pBlock->setTexture(varName + "resources." #texName, data.resources.texName)
+        // Now set the textures. The handles are cached by the block's reflection, and the material's own block uses an empty prefix so the names don't need to be rebuilt
+        const ParameterBlockReflection* pReflector = pBlock->getReflection().get();
+        auto getHandle = [&](const std::string& name) -> const ShaderVarHandle& { return varName.empty() ? pReflector->getResourceHandle(name) : pReflector->getResourceHandle(varName + name); };
+#define set_texture(texName) {static const std::string kName("resources." #texName); pBlock->setTexture(getHandle(kName), data.resources.texName);}
         set_texture(baseColor);
         set_texture(specular);
         set_texture(emissive);
@@ -303,7 +305,8 @@ namespace Falcor
         set_texture(lightMap);
         set_texture(heightMap);
 #undef set_texture
-        pBlock->setSampler(varName + "resources.samplerState", data.resources.samplerState);
+        static const std::string kSamplerName("resources.samplerState");
+        pBlock->setSampler(getHandle(kSamplerName), data.resources.samplerState);
     }
 
     void Material::setIntoParameterBlock(ParameterBlock* pBlock) const
@@ -330,7 +333,8 @@ namespace Falcor
         {
             mParamBlockDirty = false;
             setIntoParameterBlock(mpParameterBlock.get());
+            mpSnapshot = mpParameterBlock->snapshot();
         }
-        return mpParameterBlock;
+        return mpSnapshot;
     }
 }
@@ -259,6 +259,7 @@ namespace Falcor
         void setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const char varName[]) const;
         
         /** Get the ParameterBlock object for the material. Each material is created with a parameter-block. Using it is more efficient than assigning data to a custom constant-buffer.
+            The block is an immutable snapshot which is rebuilt when the material changes. Materials with identical data share the same snapshot, and the block can be bound with a single ProgramVars::setParameterBlock() call
         */
         ParameterBlock::SharedConstPtr getParameterBlock() const;
     private:
@@ -274,6 +275,7 @@ namespace Falcor
         bool mOcclusionMapEnabled = false;
         mutable bool mParamBlockDirty = true;
         ParameterBlock::SharedPtr mpParameterBlock;
+        mutable ParameterBlock::SharedConstPtr mpSnapshot;
         static uint32_t sMaterialCounter;
         static ParameterBlockReflection::SharedConstPtr spBlockReflection;
     };
@@ -0,0 +1,194 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MaterialTable.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Program/ProgramVars.h"
+#include <cstring>
+
+namespace Falcor
+{
+    static const char* kTableName = "gMaterialTable";
+    static const char* kTexturesName = "gMaterialTextures";
+    static const char* kSamplersName = "gMaterialSamplers";
+
+    MaterialTable::SharedPtr MaterialTable::create()
+    {
+        return SharedPtr(new MaterialTable());
+    }
+
+    uint32_t MaterialTable::addTexture(const Texture::SharedPtr& pTexture)
+    {
+        if (pTexture == nullptr) return 0;
+        auto it = mTextureIndices.find(pTexture.get());
+        if (it != mTextureIndices.end()) return it->second;
+        if (mTextures.size() == MAX_MATERIAL_TABLE_TEXTURES)
+        {
+            mTexturesOverflowed = true;
+            return 0;
+        }
+        uint32_t index = (uint32_t)mTextures.size();
+        mTextureIndices[pTexture.get()] = index;
+        mTextures.push_back(pTexture);
+        return index;
+    }
+
+    uint32_t MaterialTable::addSampler(const Sampler::SharedPtr& pSampler)
+    {
+        const Sampler::SharedPtr& pActual = pSampler ? pSampler : Sampler::getDefault();
+        auto it = mSamplerIndices.find(pActual.get());
+        if (it != mSamplerIndices.end()) return it->second;
+        if (mSamplers.size() == MAX_MATERIAL_TABLE_SAMPLERS)
+        {
+            mSamplersOverflowed = true;
+            return 0;
+        }
+        uint32_t index = (uint32_t)mSamplers.size();
+        mSamplerIndices[pActual.get()] = index;
+        mSamplers.push_back(pActual);
+        return index;
+    }
+
+    bool MaterialTable::update(const Scene* pScene)
+    {
+        auto prevTextures = std::move(mTextures);
+        auto prevSamplers = std::move(mSamplers);
+        auto prevEntries = std::move(mEntries);
+        auto prevIndices = std::move(mMaterialIndices);
+        mTextures.clear();
+        mSamplers.clear();
+        mEntries.clear();
+        mMaterialIndices.clear();
+        mTextureIndices.clear();
+        mSamplerIndices.clear();
+        bool prevTexturesOverflowed = mTexturesOverflowed;
+        bool prevSamplersOverflowed = mSamplersOverflowed;
+        mTexturesOverflowed = false;
+        mSamplersOverflowed = false;
+
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Material* pMaterial = pModel->getMesh(meshID)->getMaterial().get();
+                if (pMaterial == nullptr || mMaterialIndices.find(pMaterial) != mMaterialIndices.end()) continue;
+
+                MaterialTableEntry entry;
+                entry.baseColor = pMaterial->getBaseColor();
+                entry.specular = pMaterial->getSpecularParams();
+                entry.emissive = pMaterial->getEmissiveColor();
+                entry.alphaThreshold = pMaterial->getAlphaThreshold();
+                entry.IoR = pMaterial->getIndexOfRefraction();
+                entry.id = pMaterial->getId();
+                entry.flags = pMaterial->getFlags();
+                entry.samplerIndex = addSampler(pMaterial->getSampler());
+                entry.heightScaleOffset = vec2(pMaterial->getHeightScale(), pMaterial->getHeightOffset());
+                entry.baseColorIndex = addTexture(pMaterial->getBaseColorTexture());
+                entry.specularIndex = addTexture(pMaterial->getSpecularTexture());
+                entry.emissiveIndex = addTexture(pMaterial->getEmissiveTexture());
+                entry.normalMapIndex = addTexture(pMaterial->getNormalMap());
+                entry.occlusionMapIndex = addTexture(pMaterial->getOcclusionMap());
+                entry.lightMapIndex = addTexture(pMaterial->getLightMap());
+                entry.heightMapIndex = addTexture(pMaterial->getHeightMap());
+
+                mMaterialIndices[pMaterial] = (uint32_t)mEntries.size();
+                mEntries.push_back(entry);
+            }
+        }
+
+        if (prevIndices != mMaterialIndices) mIndexVersion++;
+
+        bool entriesChanged = (prevEntries.size() != mEntries.size()) || (mEntries.size() && memcmp(prevEntries.data(), mEntries.data(), mEntries.size() * sizeof(MaterialTableEntry)) != 0);
+        mBufferDirty = mBufferDirty || entriesChanged;
+        bool changed = entriesChanged || (prevTextures != mTextures) || (prevSamplers != mSamplers);
+
+        // The table is rebuilt every frame. Only warn when the overflow appears or the content changes
+        if (mTexturesOverflowed && (changed || prevTexturesOverflowed == false))
+        {
+            logWarning("MaterialTable - the scene uses more than " + std::to_string(MAX_MATERIAL_TABLE_TEXTURES) + " textures. Increase MAX_MATERIAL_TABLE_TEXTURES. Some materials will sample the wrong texture");
+        }
+        if (mSamplersOverflowed && (changed || prevSamplersOverflowed == false))
+        {
+            logWarning("MaterialTable - the scene uses more than " + std::to_string(MAX_MATERIAL_TABLE_SAMPLERS) + " samplers. Increase MAX_MATERIAL_TABLE_SAMPLERS. Some materials will use the wrong sampler");
+        }
+        return changed;
+    }
+
+    uint32_t MaterialTable::getMaterialIndex(const Material* pMaterial) const
+    {
+        auto it = mMaterialIndices.find(pMaterial);
+        return (it == mMaterialIndices.end()) ? kInvalidIndex : it->second;
+    }
+
+    bool MaterialTable::isDeclared(const ProgramVars* pVars)
+    {
+        return pVars->getReflection()->getDefaultParameterBlock()->getResource(kTableName) != nullptr;
+    }
+
+    bool MaterialTable::setIntoProgramVars(ProgramVars* pVars)
+    {
+        const ParameterBlockReflection* pReflector = pVars->getReflection()->getDefaultParameterBlock().get();
+        const ReflectionVar::SharedConstPtr& pTableVar = pReflector->getResource(kTableName);
+        if (pTableVar == nullptr)
+        {
+            logWarning("MaterialTable::setIntoProgramVars() - the program doesn't declare the material table. Compile it with _MATERIAL_TABLE");
+            return false;
+        }
+
+        // The structured buffer can only be created once we have the reflection of the entry struct
+        uint32_t elementCount = std::max(1u, getMaterialCount());
+        if (mpBuffer == nullptr || mpBuffer->getElementCount() < elementCount)
+        {
+            mpBuffer = StructuredBuffer::create(kTableName, pTableVar->getType()->unwrapArray()->asResourceType()->inherit_shared_from_this::shared_from_this(), elementCount, Resource::BindFlags::ShaderResource);
+            assert(mpBuffer->getElementSize() == sizeof(MaterialTableEntry));
+            mBufferDirty = true;
+        }
+        if (mBufferDirty && mEntries.size())
+        {
+            mpBuffer->setBlob(mEntries.data(), 0, mEntries.size() * sizeof(MaterialTableEntry));
+            mBufferDirty = false;
+        }
+
+        ParameterBlock* pBlock = pVars->getDefaultBlock().get();
+        pVars->setStructuredBuffer(kTableName, mpBuffer);
+
+        ParameterBlockReflection::BindLocation texLoc = pReflector->getResourceBinding(kTexturesName);
+        for (uint32_t i = 0; i < MAX_MATERIAL_TABLE_TEXTURES; i++)
+        {
+            pBlock->setSrv(texLoc, i, i < mTextures.size() ? mTextures[i]->getSRV() : ShaderResourceView::getNullView());
+        }
+
+        ParameterBlockReflection::BindLocation samplerLoc = pReflector->getResourceBinding(kSamplersName);
+        for (uint32_t i = 0; i < MAX_MATERIAL_TABLE_SAMPLERS; i++)
+        {
+            pBlock->setSampler(samplerLoc, i, i < mSamplers.size() ? mSamplers[i] : Sampler::getDefault());
+        }
+        return true;
+    }
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <unordered_map>
+#include "Graphics/Material/Material.h"
+#include "API/StructuredBuffer.h"
+
+namespace Falcor
+{
+    class Scene;
+    class ProgramVars;
+
+    /** A scene-wide material table.
+        All the materials in the scene are stored in a single structured buffer. Textures and samplers are referenced by index into descriptor arrays, so draws only need to pass a material index.
+        Draws which use different materials don't require any binding changes between them, which allows merging them into a single instanced or indirect call.
+        Programs opt-in by compiling with the _MATERIAL_TABLE define, which declares gMaterialTable, gMaterialTextures and gMaterialSamplers. See prepareShadingData() in Shading.slang.
+        The arrays are bounded by MAX_MATERIAL_TABLE_TEXTURES and MAX_MATERIAL_TABLE_SAMPLERS.
+    */
+    class MaterialTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<MaterialTable>;
+        using SharedConstPtr = std::shared_ptr<const MaterialTable>;
+        static const uint32_t kInvalidIndex = -1;
+
+        /** Create an empty table
+        */
+        static SharedPtr create();
+
+        /** Rebuild the table from the materials in the scene. Cheap when nothing changed - the GPU buffer and the resource arrays are only updated when the content is different
+            \return true if the table content changed
+        */
+        bool update(const Scene* pScene);
+
+        /** Get the index of a material in the table
+            \return The index, or kInvalidIndex if the material is not in the table
+        */
+        uint32_t getMaterialIndex(const Material* pMaterial) const;
+
+        /** Bind the table into a program-vars object. The program must be compiled with the _MATERIAL_TABLE define. Unchanged bindings are skipped by the parameter-block, so this can be called every frame
+            \return false if the program doesn't declare the table, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        /** Check if a program-vars object was created from a program which declares the table
+        */
+        static bool isDeclared(const ProgramVars* pVars);
+
+        uint32_t getMaterialCount() const { return (uint32_t)mEntries.size(); }
+        uint32_t getTextureCount() const { return (uint32_t)mTextures.size(); }
+        uint32_t getSamplerCount() const { return (uint32_t)mSamplers.size(); }
+
+        /** Get a counter which changes every time the material indices change
+        */
+        uint32_t getIndexVersion() const { return mIndexVersion; }
+    private:
+        MaterialTable() = default;
+        uint32_t addTexture(const Texture::SharedPtr& pTexture);
+        uint32_t addSampler(const Sampler::SharedPtr& pSampler);
+
+        std::unordered_map<const Material*, uint32_t> mMaterialIndices;
+        std::vector<MaterialTableEntry> mEntries;
+        std::vector<Texture::SharedPtr> mTextures;
+        std::vector<Sampler::SharedPtr> mSamplers;
+        std::unordered_map<const Texture*, uint32_t> mTextureIndices;
+        std::unordered_map<const Sampler*, uint32_t> mSamplerIndices;
+        StructuredBuffer::SharedPtr mpBuffer;
+        bool mBufferDirty = true;
+        bool mTexturesOverflowed = false;
+        bool mSamplersOverflowed = false;
+        uint32_t mIndexVersion = 0;
+    };
+}
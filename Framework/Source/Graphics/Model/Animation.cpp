@@ -30,6 +30,7 @@
 #include "AnimationController.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/transform.hpp"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -146,4 +147,90 @@ namespace Falcor
             pAnimationController->setBoneLocalTransform(Key.boneID, T);
         }
     }
+
+    template<typename KeyType>
+    KeyType Animation::calcKeyAtTime(const AnimationChannel<KeyType>& channel, float ticks) const
+    {
+        KeyType curValue;
+        if (channel.keys.size() > 0)
+        {
+            // Binary search for the last key at or before 'ticks'. Unlike calcCurrentKey() this doesn't rely on the previous key used, so instances playing the same animation at different times don't thrash each other.
+            auto it = std::upper_bound(channel.keys.begin(), channel.keys.end(), ticks, [](float t, const AnimationKey<KeyType>& key) { return t < key.time; });
+            uint32_t curKeyIndex = (it == channel.keys.begin()) ? 0 : uint32_t(it - channel.keys.begin()) - 1;
+            uint32_t nextKeyIndex = (curKeyIndex + 1) % channel.keys.size();
+            const AnimationKey<KeyType>& curKey = channel.keys[curKeyIndex];
+            const AnimationKey<KeyType>& nextKey = channel.keys[nextKeyIndex];
+
+            float diff = nextKey.time - curKey.time;
+            if (diff == 0 || ticks < curKey.time)
+            {
+                curValue = curKey.value;
+            }
+            else
+            {
+                if (diff < 0)
+                {
+                    diff += mDuration;
+                }
+
+                float ratio = (ticks - curKey.time) / diff;
+                curValue = interpolate(curKey.value, nextKey.value, ratio);
+            }
+        }
+        return curValue;
+    }
+
+    Animation::BoneTransform Animation::BoneTransform::fromMatrix(const glm::mat4& m)
+    {
+        BoneTransform t;
+        t.translation = glm::vec3(m[3]);
+        glm::mat3 rotation(m);
+        for (int i = 0; i < 3; i++)
+        {
+            t.scaling[i] = glm::length(rotation[i]);
+            if (t.scaling[i] > 0) rotation[i] /= t.scaling[i];
+        }
+        // A mirrored basis isn't a rotation. Move the reflection into the scale.
+        if (glm::determinant(rotation) < 0)
+        {
+            t.scaling.x = -t.scaling.x;
+            rotation[0] = -rotation[0];
+        }
+        t.rotation = glm::normalize(glm::quat_cast(rotation));
+        return t;
+    }
+
+    glm::mat4 Animation::BoneTransform::toMatrix() const
+    {
+        glm::mat4 translationMat;
+        translationMat[3] = glm::vec4(translation, 1);
+        return translationMat * glm::mat4_cast(rotation) * glm::scale(scaling);
+    }
+
+    Animation::BoneTransform Animation::BoneTransform::blend(const BoneTransform& a, const BoneTransform& b, float weight)
+    {
+        BoneTransform t;
+        t.translation = interpolate(a.translation, b.translation, weight);
+        t.rotation = interpolate(a.rotation, b.rotation, weight);
+        t.scaling = interpolate(a.scaling, b.scaling, weight);
+        return t;
+    }
+
+    void Animation::evaluate(double totalTime, BoneTransform* pBoneLocalTransforms) const
+    {
+        float ticks = (float)fmod(totalTime * mTicksPerSecond, mDuration);
+        if (ticks < 0)
+        {
+            ticks += mDuration;
+        }
+
+        for (const auto& Key : mAnimationSets)
+        {
+            // Same defaults as animate(): a bone without scaling keys isn't scaled
+            BoneTransform& t = pBoneLocalTransforms[Key.boneID];
+            t.translation = calcKeyAtTime(Key.translation, ticks);
+            t.rotation = calcKeyAtTime(Key.rotation, ticks);
+            t.scaling = (Key.scaling.keys.size() > 0) ? calcKeyAtTime(Key.scaling, ticks) : glm::vec3(1);
+        }
+    }
 }
@@ -54,6 +54,24 @@ namespace Falcor
             uint32_t lastKeyUsed = 0;
         };
 
+        /** Local transform of a bone, split into its channels so that poses can be blended
+        */
+        struct BoneTransform
+        {
+            glm::vec3 translation = glm::vec3(0);
+            glm::quat rotation = glm::quat(1, 0, 0, 0);
+            glm::vec3 scaling = glm::vec3(1);
+
+            /** Split a local transform matrix into its channels. Shear is dropped.
+            */
+            static BoneTransform fromMatrix(const glm::mat4& m);
+            glm::mat4 toMatrix() const;
+
+            /** Blend two transforms. Translation and scaling are interpolated linearly, rotation is slerped.
+            */
+            static BoneTransform blend(const BoneTransform& a, const BoneTransform& b, float weight);
+        };
+
         struct AnimationSet
         {
             uint32_t boneID;
@@ -67,6 +85,13 @@ namespace Falcor
         static UniquePtr create(const Animation& other);
         ~Animation();
         void animate(double totalTime, AnimationController* pAnimationController);
+
+        /** Evaluate the animation without touching the cached key positions. Safe to call for many instances sharing the same animation.
+            \param[in] totalTime The animation time
+            \param[out] pBoneLocalTransforms Array indexed by bone ID. Only entries of bones affected by the animation are written.
+        */
+        void evaluate(double totalTime, BoneTransform* pBoneLocalTransforms) const;
+
         const std::string& getName() const { return mName; }
 
     private:
@@ -81,5 +106,8 @@ namespace Falcor
 
         template<typename _KeyType>
         _KeyType calcCurrentKey(AnimationChannel<_KeyType>& channel, float ticks, float lastUpdateTime);
+
+        template<typename _KeyType>
+        _KeyType calcKeyAtTime(const AnimationChannel<_KeyType>& channel, float ticks) const;
     };
 }
\ No newline at end of file
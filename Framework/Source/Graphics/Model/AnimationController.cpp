@@ -76,6 +76,10 @@ namespace Falcor
         mBones = Bones;
         mBoneTransforms.resize(mBones.size());
         mBoneInvTransposeTransforms.resize(mBones.size());
+        for (const auto& bone : mBones)
+        {
+            mOriginalLocalTransforms.push_back(Animation::BoneTransform::fromMatrix(bone.originalLocalTransform));
+        }
         setActiveAnimation(kBindPoseAnimationId);
     }
 
@@ -84,11 +88,15 @@ namespace Falcor
         mBones = other.mBones;
         mBoneTransforms = other.mBoneTransforms;
         mBoneInvTransposeTransforms = other.mBoneInvTransposeTransforms;
+        mOriginalLocalTransforms = other.mOriginalLocalTransforms;
         for (const auto& it : other.mAnimations)
         {
             mAnimations.push_back(Animation::create(*it));
         }
         mActiveAnimation = other.mActiveAnimation;
+        mInstances = other.mInstances;
+        mInstanceBoneTransforms = other.mInstanceBoneTransforms;
+        mInstanceBoneInvTransposeTransforms = other.mInstanceBoneInvTransposeTransforms;
     }
 
     void AnimationController::addAnimation(Animation::UniquePtr pAnimation)
@@ -106,6 +114,7 @@ namespace Falcor
 
     void AnimationController::animate(double currentTime)
     {
+        mCurrentTime = currentTime;
         if(mActiveAnimation != kBindPoseAnimationId)
         {
             mAnimations[mActiveAnimation]->animate(currentTime, this);
@@ -141,4 +150,115 @@ namespace Falcor
     { 
         return mAnimations[ID]->getName(); 
     }
-}
\ No newline at end of file
+
+    uint32_t AnimationController::addInstance(const InstanceState& state)
+    {
+        mInstances.push_back(state);
+        mInstanceBoneTransforms.resize(mInstances.size() * mBones.size());
+        mInstanceBoneInvTransposeTransforms.resize(mInstances.size() * mBones.size());
+
+        uint32_t instanceID = getInstanceCount() - 1;
+        animateInstance(instanceID, mCurrentTime);
+        return instanceID;
+    }
+
+    void AnimationController::removeInstance(uint32_t instanceID)
+    {
+        assert(instanceID < mInstances.size());
+        mInstances.erase(mInstances.begin() + instanceID);
+
+        auto eraseRange = [this, instanceID](std::vector<glm::mat4>& v)
+        {
+            auto first = v.begin() + instanceID * mBones.size();
+            v.erase(first, first + mBones.size());
+        };
+        eraseRange(mInstanceBoneTransforms);
+        eraseRange(mInstanceBoneInvTransposeTransforms);
+    }
+
+    void AnimationController::setInstanceState(uint32_t instanceID, const InstanceState& state)
+    {
+        assert(instanceID < mInstances.size());
+        assert(state.animationId == kModelAnimationId || state.animationId == kBindPoseAnimationId || state.animationId < mAnimations.size());
+        assert(state.blendAnimationId == kBindPoseAnimationId || state.blendAnimationId < mAnimations.size());
+        mInstances[instanceID] = state;
+        animateInstance(instanceID, mCurrentTime);
+    }
+
+    void AnimationController::animateInstances(double currentTime)
+    {
+        for (uint32_t i = 0; i < getInstanceCount(); i++)
+        {
+            animateInstance(i, currentTime);
+        }
+    }
+
+    void AnimationController::animateInstance(uint32_t instanceID, double currentTime)
+    {
+        const InstanceState& state = mInstances[instanceID];
+        const size_t boneCount = mBones.size();
+        glm::mat4* pBoneMat = mInstanceBoneTransforms.data() + instanceID * boneCount;
+
+        // Instances following the controller's animation share its pose
+        if (state.animationId == kModelAnimationId && state.timeOffset == 0 && state.speed == 1 && state.blendWeight == 0)
+        {
+            std::copy(mBoneTransforms.begin(), mBoneTransforms.end(), pBoneMat);
+            std::copy(mBoneInvTransposeTransforms.begin(), mBoneInvTransposeTransforms.end(), mInstanceBoneInvTransposeTransforms.data() + instanceID * boneCount);
+            return;
+        }
+
+        const double time = currentTime * state.speed + state.timeOffset;
+        const uint32_t animationId = (state.animationId == kModelAnimationId) ? mActiveAnimation : state.animationId;
+
+        // Evaluate the local transforms. Bones which are not animated keep their original transform.
+        auto evaluateLocal = [this, time](uint32_t id, std::vector<Animation::BoneTransform>& local)
+        {
+            local = mOriginalLocalTransforms;
+            if (id != kBindPoseAnimationId)
+            {
+                mAnimations[id]->evaluate(time, local.data());
+            }
+        };
+
+        std::vector<Animation::BoneTransform>& local = mScratchLocalTransforms[0];
+        evaluateLocal(animationId, local);
+
+        if (state.blendWeight > 0)
+        {
+            // Blend the channels before composing them. Blending the matrices directly doesn't yield a rotation, and the error would compound down the hierarchy.
+            std::vector<Animation::BoneTransform>& blendLocal = mScratchLocalTransforms[1];
+            evaluateLocal(state.blendAnimationId, blendLocal);
+            for (size_t b = 0; b < boneCount; b++)
+            {
+                local[b] = Animation::BoneTransform::blend(local[b], blendLocal[b], state.blendWeight);
+            }
+        }
+
+        mScratchLocalMatrices.resize(boneCount);
+        for (size_t b = 0; b < boneCount; b++)
+        {
+            mScratchLocalMatrices[b] = local[b].toMatrix();
+        }
+        calculateInstanceBoneTransforms(instanceID, mScratchLocalMatrices.data());
+    }
+
+    void AnimationController::calculateInstanceBoneTransforms(uint32_t instanceID, const glm::mat4* pLocalTransforms)
+    {
+        const size_t boneCount = mBones.size();
+        glm::mat4* pBoneMat = mInstanceBoneTransforms.data() + instanceID * boneCount;
+        glm::mat4* pInvTransposeMat = mInstanceBoneInvTransposeTransforms.data() + instanceID * boneCount;
+
+        // Bones are sorted so that parents come before their children. pBoneMat holds the global transforms until the offsets are applied below.
+        for (size_t i = 0; i < boneCount; i++)
+        {
+            const Bone& bone = mBones[i];
+            pBoneMat[i] = (bone.parentID != kInvalidBoneID) ? pBoneMat[bone.parentID] * pLocalTransforms[i] : pLocalTransforms[i];
+        }
+
+        for (size_t i = 0; i < boneCount; i++)
+        {
+            pBoneMat[i] = pBoneMat[i] * mBones[i].offset;
+            pInvTransposeMat[i] = transpose(inverse(pBoneMat[i]));
+        }
+    }
+}
@@ -54,6 +54,18 @@ namespace Falcor
         using UniqueConstPtr = std::unique_ptr<const AnimationController>;
         static const uint32_t kInvalidBoneID = -1;
         static const uint32_t kBindPoseAnimationId = -1;
+        static const uint32_t kModelAnimationId = -2;
+
+        /** Per-instance playback state. Instances share the skeleton and the animation clips, only the playback state and the resulting bone matrices are stored per instance.
+        */
+        struct InstanceState
+        {
+            uint32_t animationId = kModelAnimationId;           ///< Animation to play. kModelAnimationId follows the controller's active animation, kBindPoseAnimationId uses the bind pose.
+            uint32_t blendAnimationId = kBindPoseAnimationId;   ///< Optional animation blended with the active one
+            float blendWeight = 0;                              ///< Weight of the blend animation, in [0, 1]
+            double timeOffset = 0;                              ///< Offset in seconds added to the global time
+            float speed = 1;                                    ///< Playback speed multiplier
+        };
 
         static UniquePtr create(const std::vector<Bone>& bones);
         static UniquePtr create(const AnimationController& other);
@@ -74,6 +86,27 @@ namespace Falcor
         uint32_t getBoneIdFromName(const std::string& name) const;
         void setBoneLocalTransform(uint32_t boneID, const glm::mat4& transform);
 
+        /** Add an animation instance. Returns the instance ID.
+        */
+        uint32_t addInstance(const InstanceState& state = InstanceState());
+
+        /** Remove an animation instance. IDs of the following instances are shifted down by one.
+        */
+        void removeInstance(uint32_t instanceID);
+
+        uint32_t getInstanceCount() const { return uint32_t(mInstances.size()); }
+        const InstanceState& getInstanceState(uint32_t instanceID) const { return mInstances[instanceID]; }
+        void setInstanceState(uint32_t instanceID, const InstanceState& state);
+
+        /** Update the bone matrices of all instances. Call after animate(), since instances following the controller's animation copy its pose.
+        */
+        void animateInstances(double currentTime);
+
+        /** Get the bone matrices of an instance. The matrices of all instances are stored contiguously, getBoneCount() matrices per instance.
+        */
+        const mat4* getInstanceBoneMatrices(uint32_t instanceID) const { return mInstanceBoneTransforms.data() + instanceID * mBones.size(); }
+        const mat4* getInstanceBoneInvTransposeMatrices(uint32_t instanceID) const { return mInstanceBoneInvTransposeTransforms.data() + instanceID * mBones.size(); }
+
     private:
         AnimationController(const std::vector<Bone>& bones);
         AnimationController(const AnimationController& other);
@@ -85,6 +118,16 @@ namespace Falcor
 
         uint32_t mActiveAnimation = kBindPoseAnimationId;
 
+        std::vector<InstanceState> mInstances;
+        std::vector<glm::mat4> mInstanceBoneTransforms;             // [Instance][Bone]
+        std::vector<glm::mat4> mInstanceBoneInvTransposeTransforms; // [Instance][Bone]
+        std::vector<Animation::BoneTransform> mOriginalLocalTransforms;     // Bind pose, split into channels for blending
+        std::vector<Animation::BoneTransform> mScratchLocalTransforms[2];
+        std::vector<glm::mat4> mScratchLocalMatrices;
+        double mCurrentTime = 0;
+
         void calculateBoneTransforms();
+        void animateInstance(uint32_t instanceID, double currentTime);
+        void calculateInstanceBoneTransforms(uint32_t instanceID, const glm::mat4* pLocalTransforms);
     };
 }
\ No newline at end of file
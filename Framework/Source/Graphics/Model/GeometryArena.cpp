@@ -0,0 +1,275 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "GeometryArena.h"
+#include <map>
+#include <set>
+#include "API/Device.h"
+#include "Graphics/Model/Mesh.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        // Meshes can share an arena if they are drawn with the same input layout, topology and index format, and their buffers have the same bind flags
+        std::string getArenaKey(const Vao* pVao)
+        {
+            std::string key = std::to_string((uint32_t)pVao->getPrimitiveTopology()) + "," + std::to_string((uint32_t)pVao->getIndexBufferFormat()) + "," + std::to_string((uint32_t)pVao->getIndexBuffer()->getBindFlags());
+            const VertexLayout* pLayout = pVao->getVertexLayout().get();
+            for (uint32_t i = 0; i < (uint32_t)pLayout->getBufferCount(); i++)
+            {
+                key += "|";
+                const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
+                const Buffer* pVB = (i < pVao->getVertexBuffersCount()) ? pVao->getVertexBuffer(i).get() : nullptr;
+                if (pVbLayout == nullptr || pVB == nullptr) continue;
+
+                key += std::to_string(pVbLayout->getStride()) + "," + std::to_string((uint32_t)pVbLayout->getInputClass()) + "," + std::to_string((uint32_t)pVB->getBindFlags());
+                for (uint32_t e = 0; e < pVbLayout->getElementCount(); e++)
+                {
+                    key += "," + pVbLayout->getElementName(e) + ":" + std::to_string((uint32_t)pVbLayout->getElementFormat(e)) + ":" + std::to_string(pVbLayout->getElementShaderLocation(e)) +
+                        ":" + std::to_string(pVbLayout->getElementOffset(e)) + ":" + std::to_string(pVbLayout->getElementArraySize(e));
+                }
+            }
+            return key;
+        }
+
+        bool canMerge(const Mesh* pMesh)
+        {
+            const Vao* pVao = pMesh->getVao().get();
+            if (pVao == nullptr || pVao->getIndexBuffer() == nullptr || pVao->getVertexLayout() == nullptr) return false;
+            if (pVao->getVertexLayout()->getBufferCount() > pVao->getVertexBuffersCount()) return false;
+            if (pMesh->hasBones()) return false;
+            const Material* pMaterial = pMesh->getMaterial().get();
+            return (pMaterial == nullptr) || (EXTRACT_EMISSIVE_TYPE(pMaterial->getFlags()) == ChannelTypeUnused);
+        }
+
+        void countBuffers(const std::vector<Mesh*>& meshes, uint32_t& vaoCount, uint32_t& bufferCount, uint64_t& bufferBytes)
+        {
+            std::set<const Vao*> vaos;
+            std::set<const Buffer*> buffers;
+            for (const Mesh* pMesh : meshes)
+            {
+                const Vao* pVao = pMesh->getVao().get();
+                vaos.insert(pVao);
+                for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+                {
+                    buffers.insert(pVao->getVertexBuffer(i).get());
+                }
+                buffers.insert(pVao->getIndexBuffer().get());
+            }
+            buffers.erase(nullptr);
+
+            vaoCount = (uint32_t)vaos.size();
+            bufferCount = (uint32_t)buffers.size();
+            bufferBytes = 0;
+            for (const Buffer* pBuffer : buffers)
+            {
+                bufferBytes += pBuffer->getSize();
+            }
+        }
+
+        // A range of vertices in the source buffers. Submeshes of binary models share their vertex buffers, so the range is copied once for all of them
+        using VertexRangeKey = std::pair<std::vector<const Buffer*>, int32_t>;
+
+        VertexRangeKey getVertexRangeKey(const Mesh* pMesh)
+        {
+            const Vao* pVao = pMesh->getVao().get();
+            VertexRangeKey key;
+            key.second = pMesh->getBaseVertex();
+            for (uint32_t vb = 0; vb < pVao->getVertexBuffersCount(); vb++)
+            {
+                key.first.push_back(pVao->getVertexBuffer(vb).get());
+            }
+            return key;
+        }
+
+        /** Find the meshes whose vertex ranges overlap a range with a different set of buffers. A range is copied once per distinct set of buffers,
+            so merging such a mesh duplicates the vertices of the shared buffers
+        */
+        std::set<const Mesh*> findPartiallySharedMeshes(const std::vector<Mesh*>& meshes)
+        {
+            std::map<std::pair<const Buffer*, int32_t>, std::set<VertexRangeKey>> users;
+            for (const Mesh* pMesh : meshes)
+            {
+                VertexRangeKey key = getVertexRangeKey(pMesh);
+                for (const Buffer* pVB : key.first)
+                {
+                    if (pVB) users[std::make_pair(pVB, key.second)].insert(key);
+                }
+            }
+
+            std::set<const Mesh*> partiallyShared;
+            for (const Mesh* pMesh : meshes)
+            {
+                VertexRangeKey key = getVertexRangeKey(pMesh);
+                for (const Buffer* pVB : key.first)
+                {
+                    if (pVB && users[std::make_pair(pVB, key.second)].size() > 1)
+                    {
+                        partiallyShared.insert(pMesh);
+                        break;
+                    }
+                }
+            }
+            return partiallyShared;
+        }
+
+        struct VertexRange
+        {
+            const Vao* pSrcVao;
+            int32_t srcBaseVertex;
+            uint32_t vertexCount;
+            int32_t dstBaseVertex;
+        };
+
+        Vao::SharedPtr createArena(const std::vector<Mesh*>& meshes, std::vector<uint32_t>& startIndices, std::vector<int32_t>& baseVertices)
+        {
+            const Vao* pFirstVao = meshes[0]->getVao().get();
+            const VertexLayout::SharedPtr& pLayout = pFirstVao->getVertexLayout();
+            const ResourceFormat ibFormat = pFirstVao->getIndexBufferFormat();
+            const uint32_t indexSize = getFormatBytesPerBlock(ibFormat);
+
+            // Assign the arena ranges
+            std::map<VertexRangeKey, size_t> rangeMap;
+            std::vector<VertexRange> ranges;
+            uint32_t vertexCount = 0;
+            uint32_t indexCount = 0;
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                const Mesh* pMesh = meshes[i];
+                const Vao* pVao = pMesh->getVao().get();
+                VertexRangeKey key = getVertexRangeKey(pMesh);
+
+                auto it = rangeMap.find(key);
+                if (it == rangeMap.end())
+                {
+                    it = rangeMap.insert(std::make_pair(key, ranges.size())).first;
+                    ranges.push_back({ pVao, pMesh->getBaseVertex(), pMesh->getVertexCount(), (int32_t)vertexCount });
+                    vertexCount += pMesh->getVertexCount();
+                }
+                baseVertices[i] = ranges[it->second].dstBaseVertex;
+                startIndices[i] = indexCount;
+                indexCount += pMesh->getIndexCount();
+            }
+
+            // Create the buffers and copy the data
+            RenderContext* pContext = gpDevice->getRenderContext().get();
+            Vao::BufferVec vbs(pLayout->getBufferCount());
+            for (uint32_t vb = 0; vb < (uint32_t)vbs.size(); vb++)
+            {
+                const Buffer* pSrcVB = pFirstVao->getVertexBuffer(vb).get();
+                if (pSrcVB == nullptr) continue;
+
+                const uint64_t stride = pLayout->getBufferLayout(vb)->getStride();
+                vbs[vb] = Buffer::create(size_t(stride * vertexCount), pSrcVB->getBindFlags(), Buffer::CpuAccess::None);
+                for (const VertexRange& range : ranges)
+                {
+                    pContext->copyBufferRegion(vbs[vb].get(), stride * range.dstBaseVertex, range.pSrcVao->getVertexBuffer(vb).get(), stride * range.srcBaseVertex, stride * range.vertexCount);
+                }
+            }
+
+            Buffer::SharedPtr pIB = Buffer::create(size_t(indexSize) * indexCount, pFirstVao->getIndexBuffer()->getBindFlags(), Buffer::CpuAccess::None);
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                const Mesh* pMesh = meshes[i];
+                pContext->copyBufferRegion(pIB.get(), uint64_t(indexSize) * startIndices[i], pMesh->getVao()->getIndexBuffer().get(), uint64_t(indexSize) * pMesh->getStartIndex(), uint64_t(indexSize) * pMesh->getIndexCount());
+            }
+
+            return Vao::create(pFirstVao->getPrimitiveTopology(), pLayout, vbs, pIB, ibFormat);
+        }
+    }
+
+    std::string GeometryArena::Stats::toString() const
+    {
+        auto toMB = [](uint64_t bytes) { return std::to_string(double(bytes) / (1024 * 1024)) + " MB"; };
+        return "merged " + std::to_string(mergedMeshCount) + " out of " + std::to_string(meshCount) + " meshes into " + std::to_string(arenaCount) + " arenas (" + std::to_string(partiallySharedMeshCount) +
+            " skipped because they share vertex buffers). VAOs " + std::to_string(vaoCountBefore) +
+            " -> " + std::to_string(vaoCountAfter) + ", buffers " + std::to_string(bufferCountBefore) + " -> " + std::to_string(bufferCountAfter) + ", buffer memory " + toMB(bufferBytesBefore) + " -> " + toMB(bufferBytesAfter);
+    }
+
+    GeometryArena::Stats GeometryArena::merge(const std::vector<Mesh*>& meshes)
+    {
+        // Remove duplicates, but keep the order of the meshes so that meshes which are drawn together stay close in memory
+        std::vector<Mesh*> uniqueMeshes;
+        std::set<const Mesh*> seen;
+        for (Mesh* pMesh : meshes)
+        {
+            if (pMesh && seen.insert(pMesh).second) uniqueMeshes.push_back(pMesh);
+        }
+
+        Stats stats;
+        stats.meshCount = (uint32_t)uniqueMeshes.size();
+        countBuffers(uniqueMeshes, stats.vaoCountBefore, stats.bufferCountBefore, stats.bufferBytesBefore);
+
+        std::vector<Mesh*> mergeable;
+        for (Mesh* pMesh : uniqueMeshes)
+        {
+            if (canMerge(pMesh)) mergeable.push_back(pMesh);
+        }
+        std::set<const Mesh*> partiallyShared = findPartiallySharedMeshes(mergeable);
+        stats.partiallySharedMeshCount = (uint32_t)partiallyShared.size();
+
+        std::map<std::string, std::vector<Mesh*>> groups;
+        for (Mesh* pMesh : mergeable)
+        {
+            if (partiallyShared.count(pMesh) == 0)
+            {
+                groups[getArenaKey(pMesh->getVao().get())].push_back(pMesh);
+            }
+        }
+
+        for (const auto& group : groups)
+        {
+            const std::vector<Mesh*>& groupMeshes = group.second;
+            // A single mesh gains nothing, unless it's in an arena which other meshes are leaving
+            if (groupMeshes.size() == 1 && groupMeshes[0]->getStartIndex() == 0 && groupMeshes[0]->getBaseVertex() == 0) continue;
+
+            std::vector<uint32_t> startIndices(groupMeshes.size());
+            std::vector<int32_t> baseVertices(groupMeshes.size());
+            Vao::SharedPtr pVao = createArena(groupMeshes, startIndices, baseVertices);
+
+            for (size_t i = 0; i < groupMeshes.size(); i++)
+            {
+                groupMeshes[i]->mpVao = pVao;
+                groupMeshes[i]->mStartIndex = startIndices[i];
+                groupMeshes[i]->mBaseVertex = baseVertices[i];
+            }
+            stats.mergedMeshCount += (uint32_t)groupMeshes.size();
+            stats.arenaCount++;
+        }
+
+        countBuffers(uniqueMeshes, stats.vaoCountAfter, stats.bufferCountAfter, stats.bufferBytesAfter);
+
+        // An arena only holds the ranges its meshes use, and each range once. Growing means some vertices were copied more than once
+        if (stats.bufferBytesAfter > stats.bufferBytesBefore)
+        {
+            logWarning("GeometryArena::merge() - the merged buffers are larger than the original ones (" + stats.toString() + "). Some vertex ranges were duplicated");
+        }
+        return stats;
+    }
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "API/VAO.h"
+
+namespace Falcor
+{
+    class Mesh;
+
+    /** Packs the geometry of many meshes into shared vertex and index buffers.
+
+        Meshes with the same vertex layout, topology and index format are copied into one set of buffers and share a single VAO. Each mesh then draws from the shared
+        buffers using its start index and base vertex (Mesh::getStartIndex() and Mesh::getBaseVertex()). Switching between meshes of an arena doesn't rebind any buffers
+        and doesn't change the pipeline state, and a single arena is what multi-draw and indirect submission need to draw many meshes with one VAO.
+
+        Meshes with bones keep their own buffers, since the skinning cache skins whole vertex buffers. Meshes with an emissive material keep their own buffers as well, since
+        area lights read the whole buffers of their mesh.
+        Meshes which share some of their vertex buffers with other meshes, but not all of them (for example, binary-model submeshes with generated bitangents), keep their own buffers.
+        Each of them would need its own copy of the shared vertex range, so merging them would grow the geometry memory.
+    */
+    class GeometryArena
+    {
+    public:
+        /** Statistics about a merge. The buffer counts and sizes are for the unique vertex and index buffers referenced by the meshes
+        */
+        struct Stats
+        {
+            uint32_t meshCount = 0;             ///< Number of meshes passed to merge()
+            uint32_t mergedMeshCount = 0;       ///< Number of meshes which were moved into an arena
+            uint32_t partiallySharedMeshCount = 0;  ///< Number of meshes skipped because they share only some of their vertex buffers
+            uint32_t arenaCount = 0;            ///< Number of arenas created
+            uint32_t vaoCountBefore = 0;
+            uint32_t vaoCountAfter = 0;
+            uint32_t bufferCountBefore = 0;
+            uint32_t bufferCountAfter = 0;
+            uint64_t bufferBytesBefore = 0;
+            uint64_t bufferBytesAfter = 0;
+
+            /** Get a one line summary of the stats, for logging
+            */
+            std::string toString() const;
+        };
+
+        /** Move the geometry of the meshes into arenas. Meshes which are already in an arena are moved into the new one, and the old buffers are released once nothing else references them.
+            The data is copied on the GPU, using the device's render context.
+            \param[in] meshes The meshes to merge. Meshes which appear more than once are only merged once
+            \return Statistics about the buffers before and after merging
+        */
+        static Stats merge(const std::vector<Mesh*>& meshes);
+    };
+}
@@ -31,6 +31,7 @@
 #include "glm/matrix.hpp"
 #include "glm/common.hpp"
 #include "glm/geometric.hpp"
+#include "glm/gtc/packing.hpp"
 
 #include "Framework.h"
 #include "AssimpModelImporter.h"
@@ -42,6 +43,8 @@
 #include "API/Buffer.h"
 #include "Utils/Platform/OS.h"
 #include "Graphics/TextureHelper.h"
+#include "Graphics/TextureCooker.h"
+#include "Graphics/TextureStreamer.h"
 #include "API/VertexLayout.h"
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
@@ -197,6 +200,71 @@ namespace Falcor
         { VERTEX_DIFFUSE_COLOR_LOC, VERTEX_DIFFUSE_COLOR_NAME,  ResourceFormat::RGBA32Float },
     };
 
+    // Texture coordinates outside of [0, 1] are stored as half only if they stay below this value, which keeps the error under 1/2048
+    static const float kMaxHalfTexCrd = 2.0f;
+
+    ResourceFormat getTexCrdFormat(const aiVector3D* pTexCrd, uint32_t vertexCount)
+    {
+        float minCrd = 0, maxCrd = 0;
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            minCrd = min(minCrd, min(pTexCrd[i].x, pTexCrd[i].y));
+            maxCrd = max(maxCrd, max(pTexCrd[i].x, pTexCrd[i].y));
+        }
+
+        if (minCrd >= 0 && maxCrd <= 1) return ResourceFormat::RG16Unorm;
+        if (max(-minCrd, maxCrd) <= kMaxHalfTexCrd) return ResourceFormat::RG16Float;
+        return ResourceFormat::RGB32Float;
+    }
+
+    // Octahedral mapping of a direction to [-1, 1]^2. Decoded by decodeOctahedral() in DefaultVS.slang
+    vec2 encodeOctahedral(vec3 v)
+    {
+        float l1Norm = abs(v.x) + abs(v.y) + abs(v.z);
+        if (l1Norm == 0) return vec2(0);
+
+        v /= l1Norm;
+        vec2 e(v.x, v.y);
+        if (v.z < 0)
+        {
+            e = (1.f - abs(vec2(v.y, v.x))) * vec2(v.x >= 0 ? 1.f : -1.f, v.y >= 0 ? 1.f : -1.f);
+        }
+        return e;
+    }
+
+    void writeUnorm16(uint8_t* pDst, const float* pSrc, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ((uint16_t*)pDst)[i] = (uint16_t)(glm::clamp(pSrc[i], 0.f, 1.f) * 65535.f + 0.5f);
+        }
+    }
+
+    void writeSnorm16(uint8_t* pDst, const float* pSrc, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ((int16_t*)pDst)[i] = (int16_t)glm::round(glm::clamp(pSrc[i], -1.f, 1.f) * 32767.f);
+        }
+    }
+
+    // Rounds the weights to 8 bits while keeping their sum at 255, so that the blended bone matrix isn't scaled
+    void writeUnorm8Weights(uint8_t* pDst, const vec4& weights)
+    {
+        int32_t sum = 0;
+        uint32_t largest = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            pDst[i] = (uint8_t)(glm::clamp(weights[i], 0.f, 1.f) * 255.f + 0.5f);
+            sum += pDst[i];
+            if (weights[i] > weights[largest]) largest = i;
+        }
+        if (sum != 0)
+        {
+            pDst[largest] = (uint8_t)glm::clamp(int32_t(pDst[largest]) + 255 - sum, 0, 255);
+        }
+    }
+
 
     glm::mat4 aiMatToGLM(const aiMatrix4x4& aiMat)
     {
@@ -268,6 +336,24 @@ namespace Falcor
         }
     }
 
+    std::string getTexturePath(const std::string& folder, const aiString& path)
+    {
+        std::string fullpath = folder + '/' + std::string(path.data);
+        return replaceSubstring(fullpath, "\\", "/");
+    }
+
+    struct AssimpModelImporter::ParsedFile
+    {
+        std::string filename;
+        std::string fullpath;
+        Model::LoadFlags flags;
+        Assimp::Importer importer;
+        const aiScene* pScene = nullptr;
+        std::string error;
+        std::map<std::string, Bitmap::UniqueConstPtr> bitmaps;   // Decoded textures, keyed by their full path
+        std::map<std::string, std::string> cookedFiles;          // Cooked DDS files, keyed by the full path of the source texture
+    };
+
     void AssimpModelImporter::loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, Material* pMaterial, bool isObjFile, bool useSrgb)
     {
         for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
@@ -304,10 +390,37 @@ namespace Falcor
                 }
                 else
                 {
-                    // create a new texture
-                    std::string fullpath = folder + '/' + s;
-                    fullpath = replaceSubstring(fullpath, "\\", "/");
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    // create a new texture. Use the cooked file or the bitmap if they were already prepared by parse()
+                    std::string fullpath = getTexturePath(folder, path);
+                    const auto& cookedFile = mpParsedFile->cookedFiles.find(fullpath);
+                    const auto& bitmap = mpParsedFile->bitmaps.find(fullpath);
+                    const auto& pStreamer = TextureStreamer::getActive();
+                    std::string ddsFile = (cookedFile != mpParsedFile->cookedFiles.end()) ? cookedFile->second : (hasSuffix(fullpath, ".dds") ? fullpath : "");
+                    if (pStreamer && ddsFile.size())
+                    {
+                        pTex = pStreamer->createTexture(ddsFile, isSrgbRequired(aiType, useSrgb), fullpath);
+                    }
+
+                    // Textures which can't be streamed are loaded in full
+                    if (pTex == nullptr)
+                    {
+                        if (cookedFile != mpParsedFile->cookedFiles.end())
+                        {
+                            pTex = createTextureFromFile(cookedFile->second, true, isSrgbRequired(aiType, useSrgb));
+                            if (pTex)
+                            {
+                                pTex->setSourceFilename(stripDataDirectories(fullpath));
+                            }
+                        }
+                        else if (bitmap != mpParsedFile->bitmaps.end() && bitmap->second)
+                        {
+                            pTex = createTextureFromBitmap(bitmap->second.get(), fullpath, true, isSrgbRequired(aiType, useSrgb));
+                        }
+                        else
+                        {
+                            pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                        }
+                    }
                     if (pTex)
                     {
                         mTextureCache[s] = pTex;
@@ -335,6 +448,10 @@ namespace Falcor
         Material::SharedPtr pMaterial = Material::create(nameVec[0]);
 
         loadTextures(pAiMaterial, folder, pMaterial.get(), isObjFile, useSrgb);
+        if (TextureStreamer::getActive())
+        {
+            TextureStreamer::getActive()->registerMaterial(pMaterial);
+        }
 
         if(is_set(mFlags, Model::LoadFlags::UseSpecGlossMaterials))
         {
@@ -416,14 +533,14 @@ namespace Falcor
         return pMaterial;
     }
 
-    bool verifyScene(const aiScene* pScene)
+    bool verifyScene(const aiScene* pScene, std::string& error)
     {
         bool b = true;
 
         // No internal textures
         if (pScene->mTextures != 0)
         {
-            logError("Model has internal textures");
+            error = "Model has internal textures";
             b = false;
         }
         return b;
@@ -431,6 +548,8 @@ namespace Falcor
 
     AssimpModelImporter::AssimpModelImporter(Model& model, Model::LoadFlags flags) : mFlags(flags), mModel(model)
     {
+        // Shaders which read the raw buffers (ray tracing, area lights) expect 32-bit indices and RGB32Float attributes
+        mQuantizeGeometry = is_set(flags, Model::LoadFlags::QuantizeGeometry) && (is_set(flags, Model::LoadFlags::BuffersAsShaderResource) == false);
     }
 
     bool AssimpModelImporter::createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb)
@@ -502,13 +621,17 @@ namespace Falcor
         return parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
     }
 
-    bool AssimpModelImporter::initModel(const std::string& filename)
+    std::shared_ptr<AssimpModelImporter::ParsedFile> AssimpModelImporter::parse(const std::string& filename, Model::LoadFlags flags)
     {
-        std::string fullpath;
-        if (findFileInDataDirectories(filename, fullpath) == false)
+        // This runs on worker threads, so errors are stored and only logged by import()
+        auto pParsedFile = std::make_shared<ParsedFile>();
+        pParsedFile->filename = filename;
+        pParsedFile->flags = flags;
+
+        if (findFileInDataDirectories(filename, pParsedFile->fullpath) == false)
         {
-            logError(std::string("Can't find model file ") + filename, true);
-            return false;
+            pParsedFile->error = std::string("Can't find model file ") + filename;
+            return pParsedFile;
         }
 
         uint32_t assimpFlags = aiProcessPreset_TargetRealtime_MaxQuality |
@@ -516,27 +639,73 @@ namespace Falcor
             aiProcess_FlipUVs |
             0;
 
-        if(is_set(mFlags, Model::LoadFlags::FindDegeneratePrimitives) == false) assimpFlags &= ~aiProcess_FindDegenerates;
-        if(is_set(mFlags, Model::LoadFlags::DontMergeMeshes))                   assimpFlags &= ~aiProcess_OptimizeMeshes; // Avoid merging original meshes
-        if(is_set(mFlags, Model::LoadFlags::RemoveInstancing))                  assimpFlags |= aiProcess_PreTransformVertices;
+        if(is_set(flags, Model::LoadFlags::FindDegeneratePrimitives) == false) assimpFlags &= ~aiProcess_FindDegenerates;
+        if(is_set(flags, Model::LoadFlags::DontMergeMeshes))                   assimpFlags &= ~aiProcess_OptimizeMeshes; // Avoid merging original meshes
+        if(is_set(flags, Model::LoadFlags::RemoveInstancing))                  assimpFlags |= aiProcess_PreTransformVertices;
 
         // Never use Assimp's tangent gen code
         assimpFlags &= ~(aiProcess_CalcTangentSpace);
 
-        Assimp::Importer importer;
-        const aiScene* pScene = importer.ReadFile(fullpath, assimpFlags);
+        const aiScene* pScene = pParsedFile->importer.ReadFile(pParsedFile->fullpath, assimpFlags);
 
-        if((pScene == nullptr) || (verifyScene(pScene) == false))
+        std::string verifyError;
+        if((pScene == nullptr) || (verifyScene(pScene, verifyError) == false))
         {
             std::string str("Can't open model file '");
-            str = str + std::string(filename) + "'\n" + importer.GetErrorString();
-            logError(str, true);
+            pParsedFile->error = str + std::string(filename) + "'\n" + verifyError + pParsedFile->importer.GetErrorString();
+            return pParsedFile;
+        }
+        pParsedFile->pScene = pScene;
+
+        // Cook or decode the textures. Creating the texture objects is left to import()
+        auto last = pParsedFile->fullpath.find_last_of("/\\");
+        std::string modelFolder = pParsedFile->fullpath.substr(0, last);
+        bool useSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        for (uint32_t m = 0; m < pScene->mNumMaterials; m++)
+        {
+            const aiMaterial* pAiMaterial = pScene->mMaterials[m];
+            for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
+            {
+                aiString path;
+                if (pAiMaterial->GetTextureCount((aiTextureType)i) != 1 || pAiMaterial->GetTexture((aiTextureType)i, 0, &path) != aiReturn_SUCCESS || path.length == 0)
+                {
+                    continue;
+                }
+
+                std::string fullpath = getTexturePath(modelFolder, path);
+                if (hasSuffix(fullpath, ".dds") == false && pParsedFile->bitmaps.count(fullpath) == 0 && pParsedFile->cookedFiles.count(fullpath) == 0)
+                {
+                    std::string cookedFile = TextureCooker::getCookedFile(fullpath, true, isSrgbRequired((aiTextureType)i, useSrgb));
+                    if (cookedFile.size())
+                    {
+                        pParsedFile->cookedFiles[fullpath] = cookedFile;
+                    }
+                    else
+                    {
+                        pParsedFile->bitmaps[fullpath] = loadTextureBitmap(fullpath);
+                    }
+                }
+            }
+        }
+
+        return pParsedFile;
+    }
+
+    bool AssimpModelImporter::initModel(const ParsedFile& parsedFile)
+    {
+        const std::string& filename = parsedFile.filename;
+        if (parsedFile.pScene == nullptr)
+        {
+            logError(parsedFile.error, true);
             return false;
         }
 
+        mpParsedFile = &parsedFile;
+        const aiScene* pScene = parsedFile.pScene;
+
         // Extract the folder name
-        auto last = fullpath.find_last_of("/\\");
-        std::string modelFolder = fullpath.substr(0, last);
+        auto last = parsedFile.fullpath.find_last_of("/\\");
+        std::string modelFolder = parsedFile.fullpath.substr(0, last);
 
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
@@ -553,13 +722,29 @@ namespace Falcor
             return false;
         }
 
+        if (mQuantizeGeometry && mUnquantizedGeometryBytes > 0)
+        {
+            uint64_t saved = mUnquantizedGeometryBytes - mGeometryBytes;
+            logInfo("AssimpModelImporter: quantized the geometry of " + filename + " from " + std::to_string(mUnquantizedGeometryBytes) + " to " + std::to_string(mGeometryBytes) +
+                " bytes, saved " + std::to_string(saved) + " bytes (" + std::to_string(100 * saved / mUnquantizedGeometryBytes) + "%)");
+        }
+        else if (is_set(mFlags, Model::LoadFlags::QuantizeGeometry))
+        {
+            logWarning("AssimpModelImporter: ignoring Model::LoadFlags::QuantizeGeometry for " + filename + ", it can't be used together with BuffersAsShaderResource");
+        }
+
         return true;
     }
 
     bool AssimpModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags)
     {
-        AssimpModelImporter loader(model, flags);
-        return loader.initModel(filename);
+        return import(model, parse(filename, flags));
+    }
+
+    bool AssimpModelImporter::import(Model& model, const std::shared_ptr<ParsedFile>& pParsedFile)
+    {
+        AssimpModelImporter loader(model, pParsedFile->flags);
+        return loader.initModel(*pParsedFile);
     }
 
     bool AssimpModelImporter::isUsedNode(const aiNode* pNode) const
@@ -766,7 +951,9 @@ namespace Falcor
     {
         uint32_t vertexCount = pAiMesh->mNumVertices;
         uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
+        // List topologies don't reserve the strip-cut value, so 16-bit indices can address 0x10000 vertices
+        ResourceFormat indexFormat = (mQuantizeGeometry && vertexCount <= 0x10000) ? ResourceFormat::R16Uint : ResourceFormat::R32Uint;
+        auto pIB = createIndexBuffer(pAiMesh, indexFormat);
         BoundingBox boundingBox = createMeshBbox(pAiMesh);
 
         const bool generateTangentSpace = (pAiMesh->HasTangentsAndBitangents() == false) && (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false);
@@ -796,7 +983,7 @@ namespace Falcor
         for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
         {
             const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
-            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data(), boundingBox);
         }
 
         Vao::Topology topology = Vao::Topology::TriangleList;
@@ -819,7 +1006,7 @@ namespace Falcor
         auto pMaterial = mAiMaterialToFalcor[pAiMesh->mMaterialIndex];
         assert(pMaterial);
 
-        Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones(), indexFormat);
 
         if (generateTangentSpace)
         {
@@ -830,16 +1017,28 @@ namespace Falcor
         return pMesh;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
+    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh, ResourceFormat format)
     {
         std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
-        const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
         Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
         {
             bindFlags |= Buffer::BindFlags::ShaderResource;
         }
-        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data());;
+
+        mUnquantizedGeometryBytes += sizeof(uint32_t) * indices.size();
+        if (format == ResourceFormat::R16Uint)
+        {
+            std::vector<uint16_t> indices16(indices.begin(), indices.end());
+            const uint32_t size = (uint32_t)(sizeof(uint16_t) * indices16.size());
+            mGeometryBytes += size;
+            return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices16.data());
+        }
+
+        assert(format == ResourceFormat::R32Uint);
+        const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
+        mGeometryBytes += size;
+        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data());
     }
 
 
@@ -870,6 +1069,31 @@ namespace Falcor
         }
     }
 
+    ResourceFormat AssimpModelImporter::getElementFormat(const aiMesh* pAiMesh, uint32_t location) const
+    {
+        ResourceFormat format = kLayoutData[location].format;
+        if (mQuantizeGeometry == false) return format;
+
+        // The skinning cache reads and writes the positions, normals and bitangents of skinned meshes as RGB32Float
+        const bool hasBones = pAiMesh->HasBones();
+        switch (location)
+        {
+        case VERTEX_POSITION_LOC:
+            return (hasBones == false && is_set(mFlags, Model::LoadFlags::QuantizePositions)) ? ResourceFormat::RGBA16Unorm : format;
+        case VERTEX_NORMAL_LOC:
+        case VERTEX_BITANGENT_LOC:
+            return hasBones ? format : ResourceFormat::RG16Snorm;
+        case VERTEX_TEXCOORD_LOC:
+            return getTexCrdFormat(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices);
+        case VERTEX_LIGHTMAP_UV_LOC:
+            return getTexCrdFormat(pAiMesh->mTextureCoords[1], pAiMesh->mNumVertices);
+        case VERTEX_BONE_WEIGHT_LOC:
+            return ResourceFormat::RGBA8Unorm;
+        default:
+            return format;
+        }
+    }
+
     VertexLayout::SharedPtr AssimpModelImporter::createVertexLayout(const aiMesh* pAiMesh)
     {
         static const uint32_t kMaxSupportedUVs = 2;
@@ -902,7 +1126,7 @@ namespace Falcor
             if (isElementUsed(pAiMesh, location))
             {
                 VertexBufferLayout::SharedPtr pVbLayout = VertexBufferLayout::create();
-                pVbLayout->addElement(kLayoutData[location].name, 0, kLayoutData[location].format, 1, location);
+                pVbLayout->addElement(kLayoutData[location].name, 0, getElementFormat(pAiMesh, location), 1, location);
                 pLayout->addBufferLayout(bufferCount, pVbLayout);
                 bufferCount++;
             }
@@ -911,11 +1135,15 @@ namespace Falcor
         return pLayout;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
+    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights, const BoundingBox& boundingBox)
     {
         const uint32_t vertexStride = pLayout->getStride();
         std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
 
+        // Quantized positions are relative to the bounding-box. The vertex shader decodes them with the same box, see SceneRenderer::setMeshConstants()
+        const vec3 boxMin = boundingBox.center - boundingBox.extent;
+        const vec3 boxSize = boundingBox.extent * 2.f;
+
         for (uint32_t vertexID = 0; vertexID < pAiMesh->mNumVertices; vertexID++)
         {
             uint8_t* pVertex = &initData[vertexStride * vertexID];
@@ -924,6 +1152,7 @@ namespace Falcor
             {
                 uint32_t offset = pLayout->getElementOffset(elementID);
                 uint32_t location = pLayout->getElementShaderLocation(elementID);
+                ResourceFormat format = pLayout->getElementFormat(elementID);
                 uint8_t* pDst = pVertex + offset;
 
                 uint8_t* pSrc = nullptr;
@@ -931,38 +1160,69 @@ namespace Falcor
                 switch (location)
                 {
                 case VERTEX_POSITION_LOC:
+                    if (format == ResourceFormat::RGBA16Unorm)
+                    {
+                        const aiVector3D& p = pAiMesh->mVertices[vertexID];
+                        vec4 q(0, 0, 0, 1);
+                        for (uint32_t c = 0; c < 3; c++)
+                        {
+                            q[c] = (boxSize[c] > 0) ? (p[c] - boxMin[c]) / boxSize[c] : 0.f;
+                        }
+                        writeUnorm16(pDst, &q[0], 4);
+                        continue;
+                    }
                     pSrc = (uint8_t*)(&pAiMesh->mVertices[vertexID]);
                     size = sizeof(pAiMesh->mVertices[0]);
                     break;
                 case VERTEX_NORMAL_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mNormals[vertexID]);
-                    size = sizeof(pAiMesh->mNormals[0]);
-                    break;
                 case VERTEX_BITANGENT_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mBitangents[vertexID]);
-                    size = sizeof(pAiMesh->mBitangents[0]);
+                {
+                    const aiVector3D* pVectors = (location == VERTEX_NORMAL_LOC) ? pAiMesh->mNormals : pAiMesh->mBitangents;
+                    if (format == ResourceFormat::RG16Snorm)
+                    {
+                        const aiVector3D& v = pVectors[vertexID];
+                        vec2 e = encodeOctahedral(vec3(v.x, v.y, v.z));
+                        writeSnorm16(pDst, &e[0], 2);
+                        continue;
+                    }
+                    pSrc = (uint8_t*)(&pVectors[vertexID]);
+                    size = sizeof(pVectors[0]);
                     break;
+                }
                 case VERTEX_DIFFUSE_COLOR_LOC:
                     pSrc = (uint8_t*)(&pAiMesh->mColors[0][vertexID]);
                     size = sizeof(pAiMesh->mColors[0][0]);
                     break;
                 case VERTEX_TEXCOORD_LOC:
-                    if (pAiMesh->mTextureCoords[0][vertexID].z != 0.f)
+                case VERTEX_LIGHTMAP_UV_LOC:
+                {
+                    const uint32_t channel = (location == VERTEX_TEXCOORD_LOC) ? 0 : 1;
+                    const aiVector3D& crd = pAiMesh->mTextureCoords[channel][vertexID];
+                    if (crd.z != 0.f)
                     {
-                        Falcor::logErrorAndExit("AssimpModelImporter::createVertexBuffer: Texcoord[0].z != 0.0");
+                        Falcor::logErrorAndExit("AssimpModelImporter::createVertexBuffer: Texcoord[" + std::to_string(channel) + "].z != 0.0");
                     }
-                    pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[0][vertexID]);
-                    size = sizeof(pAiMesh->mTextureCoords[0][vertexID]);
-                    break;
-                case VERTEX_LIGHTMAP_UV_LOC:
-                    if (pAiMesh->mTextureCoords[1][vertexID].z != 0.f)
+                    if (format == ResourceFormat::RG16Unorm)
+                    {
+                        writeUnorm16(pDst, &crd.x, 2);
+                        continue;
+                    }
+                    if (format == ResourceFormat::RG16Float)
                     {
-                        Falcor::logErrorAndExit("AssimpModelImporter::createVertexBuffer: Texcoord[1].z != 0.0");
+                        ((uint16_t*)pDst)[0] = glm::packHalf1x16(crd.x);
+                        ((uint16_t*)pDst)[1] = glm::packHalf1x16(crd.y);
+                        continue;
                     }
-                    pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[1][vertexID]);
-                    size = sizeof(pAiMesh->mTextureCoords[1][vertexID]);
+                    pSrc = (uint8_t*)(&crd);
+                    size = sizeof(crd);
                     break;
+                }
                 case VERTEX_BONE_WEIGHT_LOC:
+                    if (format == ResourceFormat::RGBA8Unorm)
+                    {
+                        writeUnorm8Weights(pDst, pBoneWeights[vertexID]);
+                        continue;
+                    }
                     pSrc = (uint8_t*)(&pBoneWeights[vertexID]);
                     size = sizeof(pBoneWeights[vertexID]);
                     break;
@@ -978,6 +1238,13 @@ namespace Falcor
                 memcpy(pDst, pSrc, size);
             }
         }
+
+        for (uint32_t elementID = 0; elementID < pLayout->getElementCount(); elementID++)
+        {
+            mUnquantizedGeometryBytes += uint64_t(getFormatBytesPerBlock(kLayoutData[pLayout->getElementShaderLocation(elementID)].format)) * pAiMesh->mNumVertices;
+        }
+        mGeometryBytes += initData.size();
+
         Buffer::BindFlags bindFlags = Buffer::BindFlags::Vertex;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
         {
@@ -65,6 +65,24 @@ namespace Falcor
         */
         static bool import(Model& model, const std::string& filename, Model::LoadFlags flags);
 
+        /** CPU-side data of a model file, see parse()
+        */
+        struct ParsedFile;
+
+        /** Read a model file through ASSIMP and decode its textures, without creating any GPU resources. This function can be called from any thread.
+            \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation
+            \return The parsed file. Errors are reported when the file is passed to import()
+        */
+        static std::shared_ptr<ParsedFile> parse(const std::string& filename, Model::LoadFlags flags);
+
+        /** Create a model from a file returned by parse(). Creates the GPU resources, so it should be called from the thread which owns the device.
+            \param[out] model Model object to load into
+            \param[in] pParsedFile The parsed model file
+            \return Whether import succeeded
+        */
+        static bool import(Model& model, const std::shared_ptr<ParsedFile>& pParsedFile);
+
     private:
 
         using IdToMesh = std::unordered_map<uint32_t, Mesh::SharedPtr>;
@@ -73,7 +91,7 @@ namespace Falcor
         AssimpModelImporter(const AssimpModelImporter&) = delete;
         void operator=(const AssimpModelImporter&) = delete;
 
-        bool initModel(const std::string& filename);
+        bool initModel(const ParsedFile& parsedFile);
         bool createDrawList(const aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
@@ -87,8 +105,9 @@ namespace Falcor
 
         Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
         VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        ResourceFormat getElementFormat(const aiMesh* pAiMesh, uint32_t location) const;
+        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh, ResourceFormat format);
+        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights, const BoundingBox& boundingBox);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, Material* pMaterial, bool isObjFile, bool useSrgb);
         Material::SharedPtr createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb);
 
@@ -102,9 +121,13 @@ namespace Falcor
         std::map<uint32_t, Material::SharedPtr> mAiMaterialToFalcor;
 
         Model& mModel;
+        const ParsedFile* mpParsedFile = nullptr;
 
         std::vector<Bone> mBones;
         Model::LoadFlags mFlags;
+        bool mQuantizeGeometry = false;
+        uint64_t mGeometryBytes = 0;                // Size of the created vertex and index buffers
+        uint64_t mUnquantizedGeometryBytes = 0;     // Size the buffers would have without Model::LoadFlags::QuantizeGeometry
         std::map<const std::string, Texture::SharedPtr> mTextureCache;
     };
 }
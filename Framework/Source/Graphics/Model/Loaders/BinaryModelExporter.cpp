@@ -138,6 +138,11 @@ namespace Falcor
         case ResourceFormat::RGB32Float:
         case ResourceFormat::RGBA32Float:
             return AttribFormat_F32;
+        case ResourceFormat::RG16Unorm:
+        case ResourceFormat::RG16Snorm:
+        case ResourceFormat::RG16Float:
+        case ResourceFormat::RGBA16Unorm:
+            return AttribFormat_Max; // Quantized attributes (Model::LoadFlags::QuantizeGeometry) have no binary representation
         default:
             should_not_get_here(); // Format not supported by the binary file
             return AttribFormat_Max;
@@ -204,7 +209,7 @@ namespace Falcor
             }
 
             const auto& pVao = pMesh->getVao();
-            auto& submesh = mMeshes[pVao.get()];
+            auto& submesh = mMeshes[std::make_pair(pVao.get(), pMesh->getBaseVertex())];
             submesh.push_back(i);
         }
 
@@ -290,7 +295,7 @@ namespace Falcor
 
             vbInfo[i].pBuffer = pVao->getVertexBuffer(i);
             vbInfo[i].stride = pLayout->getStride();
-            vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
+            vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read) + vbInfo[i].stride * pMesh->getBaseVertex();
         }
 
         // Write the vertex buffer
@@ -346,8 +351,19 @@ namespace Falcor
         mStream << (int32_t)primCount;
 
         // Output the index buffer
-        const void* pIndices = pMesh->getVao()->getIndexBuffer()->map(Buffer::MapType::Read);
-        mStream.write(pIndices, indexCount * sizeof(uint32_t));
+        const void* pData = pMesh->getVao()->getIndexBuffer()->map(Buffer::MapType::Read);
+        if (pMesh->getVao()->getIndexBufferFormat() == ResourceFormat::R16Uint)
+        {
+            // The binary format only stores 32-bit indices
+            const uint16_t* pIndices16 = (const uint16_t*)pData + pMesh->getStartIndex();
+            std::vector<uint32_t> indices(pIndices16, pIndices16 + indexCount);
+            mStream.write(indices.data(), indexCount * sizeof(uint32_t));
+        }
+        else
+        {
+            const uint32_t* pIndices = (const uint32_t*)pData + pMesh->getStartIndex();
+            mStream.write(pIndices, indexCount * sizeof(uint32_t));
+        }
         pMesh->getVao()->getIndexBuffer()->unmap();
 
         return true;
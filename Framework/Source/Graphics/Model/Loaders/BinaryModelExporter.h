@@ -69,7 +69,7 @@ namespace Falcor
         void warning(const std::string& Msg);
 
         bool prepareSubmeshes();
-        std::map<const Vao*, std::vector<uint32_t>> mMeshes; // Maps to meshID in model
+        std::map<std::pair<const Vao*, int32_t>, std::vector<uint32_t>> mMeshes; // Maps a VAO and base vertex to meshID in model. Meshes packed into a GeometryArena share the VAO, but not the vertices
         std::map<const Texture*, int32_t> mTextureHash;
         uint32_t mInstanceCount = 0; // Not the same as Model::Instance count. Model keeps the total instance count, while the binary format has a concept of meshes and submeshes, and the instance count there is the mesh instance count.
     };
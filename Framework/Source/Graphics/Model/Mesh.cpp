@@ -50,9 +50,10 @@ namespace Falcor
         Vao::Topology topology,
         const Material::SharedPtr& pMaterial,
         const BoundingBox& boundingBox,
-        bool hasBones)
+        bool hasBones,
+        ResourceFormat indexFormat)
     {
-        return SharedPtr(new Mesh(vertexBuffers, vertexCount, pIndexBuffer, indexCount, pLayout, topology, pMaterial, boundingBox, hasBones));
+        return SharedPtr(new Mesh(vertexBuffers, vertexCount, pIndexBuffer, indexCount, pLayout, topology, pMaterial, boundingBox, hasBones, indexFormat));
     }
 
     Mesh::Mesh(const Vao::BufferVec& vertexBuffers,
@@ -63,7 +64,8 @@ namespace Falcor
         Vao::Topology topology,
         const Material::SharedPtr& pMaterial,
         const BoundingBox& boundingBox,
-        bool hasBones) 
+        bool hasBones,
+        ResourceFormat indexFormat)
         : mId(sMeshCounter++)
         , mIndexCount(indexCount)
         , mVertexCount(vertexCount)
@@ -89,7 +91,7 @@ namespace Falcor
 
         mPrimitiveCount = mIndexCount / VertsPerPrim;
 
-        mpVao = Vao::create(topology, pLayout, vertexBuffers, pIndexBuffer, ResourceFormat::R32Uint);
+        mpVao = Vao::create(topology, pLayout, vertexBuffers, pIndexBuffer, indexFormat);
     }
 
     void Mesh::resetGlobalIdCounter()
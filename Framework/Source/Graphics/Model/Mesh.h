@@ -47,6 +47,7 @@ namespace Falcor
     class AssimpModelImporter;
     class BinaryModelImporter;
     class SimpleModelImporter;
+    class GeometryArena;
 
     /** Class representing a single mesh
     */
@@ -65,6 +66,7 @@ namespace Falcor
             \param[in] pMaterial The material of the mesh
             \param[in] BoundingBox The mesh's axis-aligned bounding-box
             \param[in] bHasBones Indicates the the mesh uses bones for animation
+            \param[in] indexFormat The format of the index buffer, R32Uint or R16Uint
         */
         static SharedPtr create(const Vao::BufferVec& vertexBuffers,
             uint32_t vertexCount,
@@ -74,7 +76,8 @@ namespace Falcor
             Vao::Topology topology,
             const Material::SharedPtr& pMaterial,
             const BoundingBox& boundingBox,
-            bool hasBones);
+            bool hasBones,
+            ResourceFormat indexFormat = ResourceFormat::R32Uint);
 
         /** Destructor
         */
@@ -112,6 +115,14 @@ namespace Falcor
         */
         const Vao::SharedPtr& getVao() const { return mpVao; }
 
+        /** Get the location of the mesh's first index in the index buffer. Non-zero when the mesh is packed into a GeometryArena.
+        */
+        uint32_t getStartIndex() const { return mStartIndex; }
+
+        /** Get the value added to the mesh's indices before reading the vertex buffers. Non-zero when the mesh is packed into a GeometryArena.
+        */
+        int32_t getBaseVertex() const { return mBaseVertex; }
+
         /** Get global mesh ID
         */
         const uint32_t getId() const { return mId; }
@@ -129,6 +140,7 @@ namespace Falcor
         friend AssimpModelImporter;
         friend BinaryModelImporter;
         friend SimpleModelImporter;
+        friend GeometryArena;
 
     private:
         Mesh(const Vao::BufferVec& vertexBuffers,
@@ -139,7 +151,8 @@ namespace Falcor
             Vao::Topology topology,
             const Material::SharedPtr& pMaterial,
             const BoundingBox& boundingBox,
-            bool hasBones);
+            bool hasBones,
+            ResourceFormat indexFormat);
 
         static uint32_t sMeshCounter;
 
@@ -148,6 +161,8 @@ namespace Falcor
         uint32_t mIndexCount = 0;
         uint32_t mVertexCount = 0;
         uint32_t mPrimitiveCount = 0;
+        uint32_t mStartIndex = 0;
+        int32_t mBaseVertex = 0;
         bool mHasBones = false;
         Material::SharedPtr mpMaterial;
         BoundingBox mBoundingBox;
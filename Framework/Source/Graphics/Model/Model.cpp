@@ -87,22 +87,53 @@ namespace Falcor
 
     Model::~Model() = default;
 
+    struct Model::PreloadedFile
+    {
+        std::string filename;
+        LoadFlags flags;
+        std::shared_ptr<AssimpModelImporter::ParsedFile> pAssimpFile;
+    };
+
     Model::SharedPtr Model::createFromFile(const char* filename, LoadFlags flags)
     {
+        return createFromPreloadedFile(preloadFromFile(filename, flags));
+    }
+
+    Model::PreloadedFilePtr Model::preloadFromFile(const char* filename, LoadFlags flags)
+    {
+        PreloadedFilePtr pFile = std::make_shared<PreloadedFile>();
+        pFile->filename = filename;
+        pFile->flags = flags;
+        if(hasSuffix(filename, ".bin", false) == false)
+        {
+            pFile->pAssimpFile = AssimpModelImporter::parse(filename, flags);
+        }
+        return pFile;
+    }
+
+    Model::SharedPtr Model::createFromPreloadedFile(const PreloadedFilePtr& pFile)
+    {
+        const char* filename = pFile->filename.c_str();
         SharedPtr pModel = SharedPtr(new Model());
         bool res;
-        if(hasSuffix(filename, ".bin", false))
+        if(pFile->pAssimpFile == nullptr)
         {
-            res = BinaryModelImporter::import(*pModel, filename, flags);
+            res = BinaryModelImporter::import(*pModel, filename, pFile->flags);
         }
         else
         {
-            res = AssimpModelImporter::import(*pModel, filename, flags);
+            res = AssimpModelImporter::import(*pModel, pFile->pAssimpFile);
         }
 
         if(res)
         {
             pModel->calculateModelProperties();
+            // Merge after the meshes were sorted by material, so that meshes drawn one after the other are close in memory
+            if (is_set(pFile->flags, LoadFlags::MergeGeometryBuffers))
+            {
+                GeometryArena::Stats stats = pModel->mergeGeometryBuffers();
+                logInfo("Model \"" + pFile->filename + "\": " + stats.toString());
+            }
             pModel->setFilename(filename);
 
             std::string name = getFilenameFromPath(filename);
@@ -220,15 +251,16 @@ namespace Falcor
         mRadius = glm::length(modelMin - modelMax) * 0.5f;
     }
 
-    bool Model::animate(double currentTime)
+    bool Model::animate(double currentTime, bool updateGpuData)
     {
         bool changed = false;
         if(mpAnimationController)
         {
             mpAnimationController->animate(currentTime);
+            mpAnimationController->animateInstances(currentTime);
             changed = true;     // TODO: AnimationController::animate should return changed status. For now just mark it as always changed.
 
-            if (update())
+            if (updateGpuData && update())
             {
                 changed = true;
             }
@@ -292,6 +324,47 @@ namespace Falcor
         return mpAnimationController != nullptr ? mpAnimationController->getBoneInvTransposeMatrices().data() : nullptr;
     }
 
+    uint32_t Model::addAnimationInstance(const AnimationController::InstanceState& state)
+    {
+        assert(mpAnimationController);
+        return mpAnimationController->addInstance(state);
+    }
+
+    void Model::removeAnimationInstance(uint32_t animationInstanceID)
+    {
+        assert(mpAnimationController);
+        mpAnimationController->removeInstance(animationInstanceID);
+    }
+
+    uint32_t Model::getAnimationInstanceCount() const
+    {
+        return mpAnimationController ? mpAnimationController->getInstanceCount() : 0;
+    }
+
+    void Model::setAnimationInstanceState(uint32_t animationInstanceID, const AnimationController::InstanceState& state)
+    {
+        assert(animationInstanceID < getAnimationInstanceCount());
+        mpAnimationController->setInstanceState(animationInstanceID, state);
+    }
+
+    const AnimationController::InstanceState& Model::getAnimationInstanceState(uint32_t animationInstanceID) const
+    {
+        assert(animationInstanceID < getAnimationInstanceCount());
+        return mpAnimationController->getInstanceState(animationInstanceID);
+    }
+
+    const mat4* Model::getInstanceBoneMatrices(uint32_t animationInstanceID) const
+    {
+        assert(mpAnimationController == nullptr || animationInstanceID < getAnimationInstanceCount());
+        return mpAnimationController != nullptr ? mpAnimationController->getInstanceBoneMatrices(animationInstanceID) : nullptr;
+    }
+
+    const mat4* Model::getInstanceBoneInvTransposeMatrices(uint32_t animationInstanceID) const
+    {
+        assert(mpAnimationController == nullptr || animationInstanceID < getAnimationInstanceCount());
+        return mpAnimationController != nullptr ? mpAnimationController->getInstanceBoneInvTransposeMatrices(animationInstanceID) : nullptr;
+    }
+
     void Model::bindSamplerToMaterials(const Sampler::SharedPtr& pSampler)
     {
         // Go over materials for all meshes and bind the sampler
@@ -333,6 +406,24 @@ namespace Falcor
         return pVao;
     }
 
+    std::vector<Mesh*> Model::getUniqueMeshes() const
+    {
+        std::vector<Mesh*> meshes;
+        meshes.reserve(mMeshes.size());
+        for (const auto& meshInstances : mMeshes)
+        {
+            meshes.push_back(meshInstances[0]->getObject().get());
+        }
+        return meshes;
+    }
+
+    GeometryArena::Stats Model::mergeGeometryBuffers()
+    {
+        GeometryArena::Stats stats = GeometryArena::merge(getUniqueMeshes());
+        calculateModelProperties();
+        return stats;
+    }
+
     bool Model::update()
     {
         if (mpSkinningCache)
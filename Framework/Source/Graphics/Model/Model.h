@@ -35,6 +35,7 @@
 #include "API/Sampler.h"
 #include "Graphics/Model/AnimationController.h"
 #include "Graphics/Model/SkinningCache.h"
+#include "Graphics/Model/GeometryArena.h"
 
 namespace Falcor
 {
@@ -44,6 +45,7 @@ namespace Falcor
     class BinaryModelExporter;
     class Buffer;
     class Camera;
+    class Scene;
 
     /** Class representing a complete model object, including meshes, animations and materials
     */
@@ -67,12 +69,32 @@ namespace Falcor
             BuffersAsShaderResource     = 0x10,   ///< Generate the VBs and IB with the shader-resource-view bind flag
             RemoveInstancing            = 0x20,   ///< Flatten mesh instances
             UseSpecGlossMaterials       = 0x40,   ///< Set materials to use Spec-Gloss shading model. Otherwise default is Metal-Rough.
+            MergeGeometryBuffers        = 0x80,   ///< Pack the vertices and indices of all the meshes into shared buffers, see GeometryArena. Meshes with bones or emissive materials are not packed.
+            QuantizeGeometry            = 0x100,  ///< Use 16-bit indices for meshes with at most 65536 vertices, and store normals and bitangents as octahedral RG16Snorm, texture coordinates as RG16Unorm or RG16Float and bone weights as RGBA8Unorm. Ignored with BuffersAsShaderResource, since shaders reading the raw buffers expect 32-bit data. The skinning cache requires BuffersAsShaderResource, so quantized bone weights are only read by vertex-shader skinning.
+            QuantizePositions           = 0x200,  ///< Together with QuantizeGeometry, also store positions as RGBA16Unorm relative to the mesh's bounding-box. Meshes with bones keep 32-bit positions, normals and bitangents.
         };
 
         /** Create a new model from file
         */
         static SharedPtr createFromFile(const char* filename, LoadFlags flags = LoadFlags::None);
 
+        /** The CPU-side part of loading a model file, see preloadFromFile()
+        */
+        struct PreloadedFile;
+        using PreloadedFilePtr = std::shared_ptr<PreloadedFile>;
+
+        /** Parse a model file and decode its textures without creating GPU resources. Can be called from any thread, which allows multiple files to be loaded in parallel.
+            Binary model files are not preloaded, they are read by createFromPreloadedFile().
+            \param[in] filename Model's filename
+            \param[in] flags Flags controlling model creation
+        */
+        static PreloadedFilePtr preloadFromFile(const char* filename, LoadFlags flags = LoadFlags::None);
+
+        /** Create a model from a preloaded file. Creates the GPU resources, so it should be called from the thread which owns the device.
+            \return A new model, or nullptr if loading failed
+        */
+        static SharedPtr createFromPreloadedFile(const PreloadedFilePtr& pFile);
+
         static SharedPtr create();
 
         static const char* kSupportedFileFormatsStr;
@@ -152,6 +174,12 @@ namespace Falcor
         */
         void addMeshInstance(const Mesh::SharedPtr& pMesh, const glm::mat4& baseTransform);
 
+        /** Pack the vertices and indices of the model's meshes into shared buffers. See GeometryArena.
+            Done by createFromFile() when the MergeGeometryBuffers flag is set. Use Scene::mergeGeometryBuffers() to pack the meshes of all the models in a scene together.
+            \return Statistics about the buffers before and after merging
+        */
+        GeometryArena::Stats mergeGeometryBuffers();
+
         /** Check if the model contains animations.
         */
         bool hasAnimations() const;
@@ -162,9 +190,10 @@ namespace Falcor
 
         /** Animate the active animation. Use setActiveAnimation() to switch between different animations.
             \param[in] currentTime The current global time
+            \param[in] updateGpuData If false, the skinned vertex buffers are not updated. The caller is then responsible for updating the skinning cache
             \return true if model has changed
         */
-        bool animate(double currentTime);
+        bool animate(double currentTime, bool updateGpuData = true);
 
         /** Get the animation name from animation ID.
         */
@@ -182,6 +211,31 @@ namespace Falcor
         */
         uint32_t getActiveAnimation() const;
 
+        /** Add a per-instance animation state. Instances share the mesh data and animation clips, but each plays its own animation, time offset and blend.
+            \return The animation instance ID
+        */
+        uint32_t addAnimationInstance(const AnimationController::InstanceState& state = AnimationController::InstanceState());
+
+        /** Remove a per-instance animation state. IDs of the following animation instances are shifted down by one.
+        */
+        void removeAnimationInstance(uint32_t animationInstanceID);
+
+        /** Get the number of per-instance animation states.
+        */
+        uint32_t getAnimationInstanceCount() const;
+
+        /** Check if the model's instances are animated separately.
+        */
+        bool hasInstancedAnimation() const { return getAnimationInstanceCount() != 0; }
+
+        /** Set the animation state of an instance.
+        */
+        void setAnimationInstanceState(uint32_t animationInstanceID, const AnimationController::InstanceState& state);
+
+        /** Get the animation state of an instance.
+        */
+        const AnimationController::InstanceState& getAnimationInstanceState(uint32_t animationInstanceID) const;
+
         /** Set the animation controller for the model.
         */
         void setAnimationController(AnimationController::UniquePtr pAnimController);
@@ -218,6 +272,16 @@ namespace Falcor
         */
         const mat4* getBoneInvTransposeMatrices() const;
 
+        /** Get array of bone matrices for an animation instance.
+            \return If model has bones, return pointer to the instance's matrices in the current state of its animation. Otherwise nullptr.
+        */
+        const mat4* getInstanceBoneMatrices(uint32_t animationInstanceID) const;
+
+        /** Get array of bones' inverse transpose matrices for an animation instance.
+            \return If model has bones, return pointer to the instance's matrices in the current state of its animation. Otherwise nullptr.
+        */
+        const mat4* getInstanceBoneInvTransposeMatrices(uint32_t animationInstanceID) const;
+
         /** Force all texture maps in all materials to use a specific texture sampler with one of their maps
             \param[in] Type The map Type to bind the sampler with
         */
@@ -255,6 +319,7 @@ namespace Falcor
 
     protected:
         friend class SimpleModelImporter;
+        friend class Scene;
 
         Model();
         Model(const Model& other);
@@ -286,6 +351,7 @@ namespace Falcor
         static uint32_t sModelCounter;
 
         void calculateModelProperties();
+        std::vector<Mesh*> getUniqueMeshes() const;
     };
 
     enum_class_operators(Model::LoadFlags);
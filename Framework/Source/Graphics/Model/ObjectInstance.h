@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <atomic>
 #include "Graphics/Paths/MovableObject.h"
 #include "Utils/AABB.h"
 #include "glm/mat4x4.hpp"
@@ -97,13 +98,21 @@ namespace Falcor
         /** Sets visibility of this instance
             \param[in] visible Visibility of this instance
         */
-        void setVisible(bool visible) { mVisible = visible; };
+        void setVisible(bool visible)
+        {
+            if (mVisible != visible) sVisibilityVersion++;
+            mVisible = visible;
+        };
 
         /** Gets whether this instance is visible
             \return Whether this instance is visible
         */
         bool isVisible() const { return mVisible; };
 
+        /** Get a counter which changes whenever the visibility of any instance of this type changes. Lets caches detect visibility changes without scanning the instances
+        */
+        static uint32_t getVisibilityVersion() { return sVisibilityVersion; }
+
         /** Gets instance name
             \return Instance name
         */
@@ -206,6 +215,15 @@ namespace Falcor
             return mPrevFinalTransformMatrix;
         }
 
+        /** Gets a counter which is incremented whenever the transform matrix changes. Used to detect changes without comparing matrices.
+            \return Transform version
+        */
+        uint32_t getTransformVersion() const
+        {
+            updateInstanceProperties();
+            return mTransformVersion;
+        }
+
         /** Gets the bounding box
             \return Bounding box
         */
@@ -258,6 +276,7 @@ namespace Falcor
                 mPrevFinalTransformMatrix = mPrevMovable.matrix * mBase.matrix;
 
                 mBoundingBox = mpObject->getBoundingBox().transform(mFinalTransformMatrix);
+                mTransformVersion++;
             }
         }
 
@@ -334,5 +353,11 @@ namespace Falcor
         mutable glm::mat4 mFinalTransformMatrix;
         mutable glm::mat4 mPrevFinalTransformMatrix;
         mutable BoundingBox mBoundingBox;
+        mutable uint32_t mTransformVersion = 0;
+
+        static std::atomic<uint32_t> sVisibilityVersion;
     };
+
+    template<typename ObjectType>
+    std::atomic<uint32_t> ObjectInstance<ObjectType>::sVisibilityVersion(0);
 }
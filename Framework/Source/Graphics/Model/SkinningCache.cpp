@@ -46,15 +46,21 @@ namespace Falcor
     }
 
     bool SkinningCache::update(const Model* pModel)
+    {
+        return update(pModel, pModel->getBoneMatrices(), pModel->getBoneInvTransposeMatrices());
+    }
+
+    bool SkinningCache::update(const Model* pModel, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices)
     {
         bool changed = false;
-        if (pModel->hasBones())
+        // Models with per-instance animation are skinned in the vertex shader, see SceneRenderer::renderMeshInstances()
+        if (pModel->hasBones() && pModel->hasInstancedAnimation() == false)
         {
             RenderContext::SharedPtr pRenderContext = gpDevice->getRenderContext();
             pRenderContext->pushComputeState(mSkinningPass.pState);
             pRenderContext->pushComputeVars(mSkinningPass.pVars);
 
-            setPerModelData(pModel);
+            setPerModelData(pModel, pBoneMatrices, pBoneInvTransposeMatrices);
 
             for (uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
             {
@@ -209,7 +215,7 @@ namespace Falcor
         }
     }
 
-    void SkinningCache::setPerModelData(const Model* pModel)
+    void SkinningCache::setPerModelData(const Model* pModel, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices)
     {
         // Set bones
         assert(pModel->hasBones());
@@ -217,8 +223,8 @@ namespace Falcor
         if (pCB)
         {
             assert(pModel->getBoneCount() <= MAX_BONES);
-            pCB->setVariableArray(mVariableOffsets.bonesOffset, pModel->getBoneMatrices(), pModel->getBoneCount());
-            pCB->setVariableArray(mVariableOffsets.bonesInvTransposeOffset, pModel->getBoneInvTransposeMatrices(), pModel->getBoneCount());
+            pCB->setVariableArray(mVariableOffsets.bonesOffset, pBoneMatrices, pModel->getBoneCount());
+            pCB->setVariableArray(mVariableOffsets.bonesInvTransposeOffset, pBoneInvTransposeMatrices, pModel->getBoneCount());
         }
     }
 
@@ -51,7 +51,8 @@ namespace Falcor
             We could extend that to hold multiple buffers to cache entire animations.
 
         3)  We could also extend it to hold skinned buffers per mesh instance, to enable
-            mesh instances to be animated separately.
+            mesh instances to be animated separately. Currently, models with per-instance
+            animation (Model::hasInstancedAnimation()) bypass the cache and use vertex shader skinning.
 
         4)  Provide metric on amount of change to guide choice of BVH rebuild/refit for ray tracing purposes.
 
@@ -69,6 +70,10 @@ namespace Falcor
         */
         bool update(const Model* pModel);
 
+        /** Create/update skinned vertex buffers for model, using bone matrices captured separately from the model's current animation state.
+        */
+        bool update(const Model* pModel, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices);
+
         /** Returns the vertex array object for pMesh containing skinned vertex buffers if it exists.
         */
         Vao::SharedPtr getVao(const Mesh* pMesh) const;
@@ -80,7 +85,7 @@ namespace Falcor
         void initVariableOffsets(const ParameterBlockReflection* pBlock);
         void initMeshBufferLocations(const ParameterBlockReflection* pBlock);
         void createVertexBuffers(const Mesh* pMesh);
-        void setPerModelData(const Model* pModel);
+        void setPerModelData(const Model* pModel, const glm::mat4* pBoneMatrices, const glm::mat4* pBoneInvTransposeMatrices);
         void setPerMeshData(const Mesh* pMesh);
 
         struct VertexBuffers
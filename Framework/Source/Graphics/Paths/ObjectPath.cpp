@@ -49,6 +49,7 @@ namespace Falcor
         keyFrame.position = position;
         keyFrame.up = up;
         mDirty = true;
+        markArcLengthDirty(0, kAllSegments);
 
         if(mKeyFrames.size() == 0 || mKeyFrames[0].time > time)
         {
@@ -92,6 +93,51 @@ namespace Falcor
             return false;
         }
 
+        // Sample all attached objects in one batch, so the splines and the arc-length table are only validated once
+        mSampleTimes.resize(mpObjects.size());
+        mSampledFrames.resize(mpObjects.size());
+        for(size_t i = 0 ; i < mpObjects.size() ; i++)
+        {
+            mSampleTimes[i] = currentTime + mTimeOffsets[i];
+        }
+        getFramesAtTimes(mSampleTimes.data(), (uint32_t)mSampleTimes.size(), mSampledFrames.data());
+        evaluateFrame(currentTime, mCurrentFrame);
+
+        for(size_t i = 0 ; i < mpObjects.size() ; i++)
+        {
+            const Frame& frame = mSampledFrames[i];
+            mpObjects[i]->move(frame.position, frame.target, frame.up);
+        }
+
+        return true;
+    }
+
+    void ObjectPath::getFrameAtTime(double currentTime, Frame& frameOut)
+    {
+        getFramesAtTimes(&currentTime, 1, &frameOut);
+    }
+
+    void ObjectPath::getFramesAtTimes(const double* pTimes, uint32_t count, Frame* pFramesOut)
+    {
+        if(mKeyFrames.size() == 0)
+        {
+            return;
+        }
+
+        updateSplines();
+        if(mParameterization == Parameterization::ConstantSpeed)
+        {
+            updateArcLengthTable();
+        }
+
+        for(uint32_t i = 0 ; i < count ; i++)
+        {
+            evaluateFrame(pTimes[i], pFramesOut[i]);
+        }
+    }
+
+    void ObjectPath::evaluateFrame(double currentTime, Frame& frameOut) const
+    {
         double animTime = currentTime;
         const auto& firstFrame = mKeyFrames[0];
         const auto& lastFrame = mKeyFrames[mKeyFrames.size() - 1];
@@ -109,62 +155,52 @@ namespace Falcor
 
         if(animTime >= lastFrame.time)
         {
-            mCurrentFrame = lastFrame;
+            frameOut = lastFrame;
         }
         else if(animTime <= firstFrame.time)
         {
-            mCurrentFrame = firstFrame;
+            frameOut = firstFrame;
         }
-        else
+        else if(mParameterization == Parameterization::ConstantSpeed)
         {
-            // Find out where we are
-            bool foundFrame = false;
-            for(uint32_t i = 0 ; i < (uint32_t)mKeyFrames.size() - 1; i++)
-            {
-                const auto& curKey = mKeyFrames[i];
-                const auto& nextKey = mKeyFrames[i + 1];
-
-                if(animTime >= curKey.time && animTime < nextKey.time)
-                {
-                    // Found the animation keys. Interpolate
-                    float t = getInterpolationFactor(i, animTime);
-                    getFrameAt(i, t, mCurrentFrame);
-                    foundFrame = true;
-                    break;
-                }
-            }
-            assert(foundFrame);
+            uint32_t segment;
+            float t;
+            findArcLengthParam((animTime - firstFrame.time) / (lastFrame.time - firstFrame.time), segment, t);
+            frameOut = interpolateFrame(segment, t);
+            frameOut.time = float(animTime);
         }
-
-        for(auto& pObj : mpObjects)
+        else
         {
-            pObj->move(mCurrentFrame.position, mCurrentFrame.target, mCurrentFrame.up);
+            // Find the last key frame which starts at or before the current time
+            auto it = std::upper_bound(mKeyFrames.begin(), mKeyFrames.end(), animTime, [](double time, const Frame& frame) { return time < frame.time; });
+            assert(it != mKeyFrames.begin() && it != mKeyFrames.end());
+            uint32_t i = (uint32_t)(it - mKeyFrames.begin()) - 1;
+            float t = getInterpolationFactor(i, animTime);
+            frameOut = interpolateFrame(i, t);
         }
-
-        return true;
     }
 
     void ObjectPath::getFrameAt(uint32_t frameID, float t, Frame& frameOut)
+    {
+        updateSplines();
+        frameOut = interpolateFrame(frameID, t);
+    }
+
+    ObjectPath::Frame ObjectPath::interpolateFrame(uint32_t frameID, float t) const
     {
         if (getKeyFrameCount() == 1)
         {
-            frameOut = mKeyFrames[0];
-            return;
+            return mKeyFrames[0];
         }
 
-        if (mMode == Interpolation::Linear || getKeyFrameCount() < 3)
+        if (useCubicSpline())
         {
-            frameOut = linearInterpolation(frameID, t);
-            return;
+            return cubicSplineInterpolation(frameID, t);
         }
-        else if(mMode == Interpolation::CubicSpline)
+        else
         {
-            frameOut = cubicSplineInterpolation(frameID, t);
-            return;
+            return linearInterpolation(frameID, t);
         }
-
-        should_not_get_here();
-        return;
     }
 
     float ObjectPath::getInterpolationFactor(uint32_t frameID, double currentTime) const
@@ -192,24 +228,29 @@ namespace Falcor
         return result;
     }
 
-    ObjectPath::Frame ObjectPath::cubicSplineInterpolation(uint32_t currentFrame, float t)
+    void ObjectPath::updateSplines()
     {
-        if (mDirty)
+        if (mDirty == false || useCubicSpline() == false)
         {
-            mDirty = false;
-            std::vector<glm::vec3> positions, targets, ups;
-            for (auto& a : mKeyFrames)
-            {
-                positions.push_back(a.position);
-                targets.push_back(a.target);
-                ups.push_back(a.up);
-            }
+            return;
+        }
 
-            mpPositionSpline = std::make_unique<Vec3CubicSpline>(positions.data(), uint32_t(mKeyFrames.size()));
-            mpTargetSpline = std::make_unique<Vec3CubicSpline>(targets.data(), uint32_t(mKeyFrames.size()));
-            mpUpSpline = std::make_unique<Vec3CubicSpline>(ups.data(), uint32_t(mKeyFrames.size()));
+        mDirty = false;
+        std::vector<glm::vec3> positions, targets, ups;
+        for (auto& a : mKeyFrames)
+        {
+            positions.push_back(a.position);
+            targets.push_back(a.target);
+            ups.push_back(a.up);
         }
 
+        mpPositionSpline = std::make_unique<Vec3CubicSpline>(positions.data(), uint32_t(mKeyFrames.size()));
+        mpTargetSpline = std::make_unique<Vec3CubicSpline>(targets.data(), uint32_t(mKeyFrames.size()));
+        mpUpSpline = std::make_unique<Vec3CubicSpline>(ups.data(), uint32_t(mKeyFrames.size()));
+    }
+
+    ObjectPath::Frame ObjectPath::cubicSplineInterpolation(uint32_t currentFrame, float t) const
+    {
         const Frame& current = mKeyFrames[currentFrame];
         const Frame& next = mKeyFrames[currentFrame + 1];
 
@@ -222,12 +263,153 @@ namespace Falcor
         return result;
     }
 
-    void ObjectPath::attachObject(const IMovableObject::SharedPtr& pObject)
+    glm::vec3 ObjectPath::interpolatePosition(uint32_t segment, float t) const
+    {
+        if (useCubicSpline())
+        {
+            return mpPositionSpline->interpolate(segment, t);
+        }
+        else
+        {
+            return glm::mix(mKeyFrames[segment].position, mKeyFrames[segment + 1].position, t);
+        }
+    }
+
+    void ObjectPath::markArcLengthDirty(uint32_t firstSegment, uint32_t lastSegment)
+    {
+        // The dirty range is [dirtyBegin, dirtyEnd). An empty range means the table is up-to-date
+        uint32_t end = (lastSegment == kAllSegments) ? kAllSegments : lastSegment + 1;
+        if (mArcLength.dirtyBegin == mArcLength.dirtyEnd)
+        {
+            mArcLength.dirtyBegin = firstSegment;
+            mArcLength.dirtyEnd = end;
+        }
+        else
+        {
+            mArcLength.dirtyBegin = std::min(mArcLength.dirtyBegin, firstSegment);
+            mArcLength.dirtyEnd = std::max(mArcLength.dirtyEnd, end);
+        }
+    }
+
+    void ObjectPath::updateArcLengthTable()
+    {
+        const uint32_t segmentCount = (getKeyFrameCount() > 1) ? getKeyFrameCount() - 1 : 0;
+        const uint32_t S = kArcLengthSamplesPerSegment;
+
+        // A key frame was added or removed without going through markArcLengthDirty(), or the table was never built
+        if (mArcLength.segmentStart.size() != segmentCount + 1)
+        {
+            mArcLength.segmentSamples.resize(segmentCount * S);
+            mArcLength.segmentStart.resize(segmentCount + 1);
+            mArcLength.dirtyBegin = 0;
+            mArcLength.dirtyEnd = kAllSegments;
+        }
+
+        if (mArcLength.dirtyBegin == mArcLength.dirtyEnd)
+        {
+            return;
+        }
+
+        // Re-sample the dirty segments
+        const uint32_t dirtyEnd = std::min(mArcLength.dirtyEnd, segmentCount);
+        for (uint32_t s = mArcLength.dirtyBegin; s < dirtyEnd; s++)
+        {
+            glm::vec3 prev = interpolatePosition(s, 0);
+            float length = 0;
+            for (uint32_t j = 0; j < S; j++)
+            {
+                glm::vec3 cur = interpolatePosition(s, float(j + 1) / float(S));
+                length += glm::length(cur - prev);
+                mArcLength.segmentSamples[s * S + j] = length;
+                prev = cur;
+            }
+        }
+        mArcLength.dirtyBegin = mArcLength.dirtyEnd = 0;
+
+        // Prefix sums
+        mArcLength.segmentStart[0] = 0;
+        for (uint32_t s = 0; s < segmentCount; s++)
+        {
+            mArcLength.segmentStart[s + 1] = mArcLength.segmentStart[s] + mArcLength.segmentSamples[s * S + S - 1];
+        }
+
+        // Invert the piecewise-linear distance function into a table with equally spaced distances
+        const float totalLength = mArcLength.segmentStart[segmentCount];
+        const uint32_t tableSize = segmentCount * S + 1;
+        mArcLength.uniformTable.resize(tableSize);
+        if (totalLength <= 0)
+        {
+            // Degenerate path. Fall back to uniform parameter spacing
+            for (uint32_t i = 0; i < tableSize; i++)
+            {
+                mArcLength.uniformTable[i] = float(i) / float(S);
+            }
+            return;
+        }
+
+        uint32_t sample = 0;
+        const uint32_t sampleCount = segmentCount * S;
+        for (uint32_t i = 0; i < tableSize; i++)
+        {
+            float distance = totalLength * float(i) / float(tableSize - 1);
+            // Find the first sample at or beyond the distance. Samples are monotonic, so the search continues from the previous entry
+            auto sampleDistance = [&](uint32_t k) { return mArcLength.segmentStart[k / S] + mArcLength.segmentSamples[k]; };
+            while (sample < sampleCount - 1 && sampleDistance(sample) < distance)
+            {
+                sample++;
+            }
+
+            float endDistance = sampleDistance(sample);
+            float beginDistance = (sample % S) ? sampleDistance(sample - 1) : mArcLength.segmentStart[sample / S];
+            float range = endDistance - beginDistance;
+            float f = (range > 0) ? glm::clamp((distance - beginDistance) / range, 0.0f, 1.0f) : 0.0f;
+            mArcLength.uniformTable[i] = (float(sample) + f) / float(S);
+        }
+    }
+
+    void ObjectPath::findArcLengthParam(double fraction, uint32_t& segment, float& t) const
+    {
+        const uint32_t segmentCount = getKeyFrameCount() - 1;
+        const uint32_t tableSize = (uint32_t)mArcLength.uniformTable.size();
+
+        double x = glm::clamp(fraction, 0.0, 1.0) * double(tableSize - 1);
+        uint32_t i = std::min((uint32_t)x, tableSize - 2);
+        float u = glm::mix(mArcLength.uniformTable[i], mArcLength.uniformTable[i + 1], float(x - double(i)));
+
+        segment = std::min((uint32_t)u, segmentCount - 1);
+        t = glm::clamp(u - float(segment), 0.0f, 1.0f);
+    }
+
+    float ObjectPath::getLength()
+    {
+        if (getKeyFrameCount() < 2)
+        {
+            return 0;
+        }
+
+        updateSplines();
+        updateArcLengthTable();
+        return mArcLength.segmentStart.back();
+    }
+
+    void ObjectPath::setFramePosition(uint32_t frameID, const glm::vec3& pos)
+    {
+        mDirty = true;
+        mKeyFrames[frameID].position = pos;
+
+        // Moving a key frame changes the two adjacent segments. Cubic spline key frames also affect their neighbors
+        uint32_t range = useCubicSpline() ? kSplineInfluence + 1 : 1;
+        uint32_t first = (frameID > range) ? frameID - range : 0;
+        markArcLengthDirty(first, frameID + range - 1);
+    }
+
+    void ObjectPath::attachObject(const IMovableObject::SharedPtr& pObject, float timeOffset)
     {
         // Only attach the object if its not already found
         if(std::find(mpObjects.begin(), mpObjects.end(), pObject) == mpObjects.end())
         {
             mpObjects.push_back(pObject);
+            mTimeOffsets.push_back(timeOffset);
             pObject->attachPath(this);
         }
     }
@@ -238,6 +420,7 @@ namespace Falcor
         if(it != mpObjects.end())
         {
             (*it)->attachPath(nullptr);
+            mTimeOffsets.erase(mTimeOffsets.begin() + (it - mpObjects.begin()));
             mpObjects.erase(it);
         }
     }
@@ -249,12 +432,14 @@ namespace Falcor
             pObj->attachPath(nullptr);
         }
         mpObjects.clear();
+        mTimeOffsets.clear();
     }
 
     void ObjectPath::removeKeyFrame(uint32_t frameID)
     {
         mKeyFrames.erase(mKeyFrames.begin() + frameID);
         mDirty = true;
+        markArcLengthDirty(0, kAllSegments);
     }
 
     uint32_t ObjectPath::setFrameTime(uint32_t frameID, float time)
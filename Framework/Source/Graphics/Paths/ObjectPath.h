@@ -58,9 +58,29 @@ namespace Falcor
             CubicSpline     ///< Cubic spline interpolation.  Requires at least 3 key frames. Path updates will fall-back to linear interpolation when there are less than 3 key frames
         };
 
+        /** Ways to map time to positions along the path
+        */
+        enum class Parameterization
+        {
+            KeyFrameTime,   ///< Key frames are reached at their times. Speed along the path varies with the key frame spacing
+            ConstantSpeed   ///< The path is traversed at constant speed between the first and last key frame times. Uses a precomputed arc-length table
+        };
+
         /**  Set the interpolation mode.
         */
-        void setInterpolationMode(Interpolation mode) { mMode = mode; }
+        void setInterpolationMode(Interpolation mode) { mMode = mode; mDirty = true; markArcLengthDirty(0, kAllSegments); }
+
+        /** Set the parameterization mode.
+        */
+        void setParameterization(Parameterization parameterization) { mParameterization = parameterization; }
+
+        /** Get the parameterization mode.
+        */
+        Parameterization getParameterization() const { return mParameterization; }
+
+        /** Get the length of the path. Only the positions are taken into account.
+        */
+        float getLength();
 
         /** Insert a key frame. Key frame will be inserted/sorted into the path based on time.
             \param[in] time Time in seconds
@@ -81,8 +101,10 @@ namespace Falcor
         bool animate(double currentTime);
 
         /** Attach a movable object to the path, such as models, cameras, and lights.
+            \param[in] pObject The object to attach
+            \param[in] timeOffset Offset in seconds added to the animation time of this object. Allows many objects to follow the same path at different positions.
         */
-        void attachObject(const IMovableObject::SharedPtr& pObject);
+        void attachObject(const IMovableObject::SharedPtr& pObject, float timeOffset = 0);
 
         /** Detach a movable object from the path.
         */
@@ -100,6 +122,10 @@ namespace Falcor
         */
         uint32_t getAttachedObjectCount() const { return (uint32_t)mpObjects.size(); }
 
+        /** Get the time offset of an attached object.
+        */
+        float getAttachedObjectTimeOffset(uint32_t i) const { return mTimeOffsets[i]; }
+
         /** Set whether the animation should loop upon reaching the last key frame.
         */
         void setAnimationRepeat(bool repeatAnimation) { mRepeatAnimation = repeatAnimation; }
@@ -150,7 +176,7 @@ namespace Falcor
             \param[in] frameID Key frame index
             \param[in] pos Position
         */
-        void setFramePosition(uint32_t frameID, const glm::vec3& pos) { mDirty = true; mKeyFrames[frameID].position = pos; }
+        void setFramePosition(uint32_t frameID, const glm::vec3& pos);
 
         /** Set a key frame's look-at target.
             \param[in] frameID Key frame index
@@ -177,23 +203,65 @@ namespace Falcor
         */
         void getFrameAt(uint32_t frameID, float t, Frame& frameOut);
 
+        /** Get the interpolated frame at a time, without modifying the path's current state. Respects the path's interpolation, parameterization and repeat modes.
+            \param[in] currentTime Time in seconds
+            \param[out] frameOut Frame data struct to store output
+        */
+        void getFrameAtTime(double currentTime, Frame& frameOut);
+
+        /** Get the interpolated frames for multiple times at once.
+            \param[in] pTimes Array of times in seconds
+            \param[in] count Number of times
+            \param[out] pFramesOut Array of count frames to store output
+        */
+        void getFramesAtTimes(const double* pTimes, uint32_t count, Frame* pFramesOut);
+
     private:
         ObjectPath() = default;
 
+        static const uint32_t kAllSegments = -1;
+        static const uint32_t kArcLengthSamplesPerSegment = 16;
+        static const uint32_t kSplineInfluence = 6;     // Number of neighboring segments affected by moving a cubic spline key frame. The effect decays by ~0.27 per key frame
+
         float getInterpolationFactor(uint32_t frameID, double currentTime) const;
+        bool useCubicSpline() const { return mMode == Interpolation::CubicSpline && getKeyFrameCount() >= 3; }
+        void updateSplines();
+        glm::vec3 interpolatePosition(uint32_t segment, float t) const;
+        void markArcLengthDirty(uint32_t firstSegment, uint32_t lastSegment);
+        void updateArcLengthTable();
+        void findArcLengthParam(double fraction, uint32_t& segment, float& t) const;
+        void evaluateFrame(double currentTime, Frame& frameOut) const;
+        Frame interpolateFrame(uint32_t currentFrame, float t) const;
 
         Frame linearInterpolation(uint32_t currentFrame, float t) const;
-        Frame cubicSplineInterpolation(uint32_t currentFrame, float t);
+        Frame cubicSplineInterpolation(uint32_t currentFrame, float t) const;
 
         std::vector<Frame> mKeyFrames;
         std::vector<IMovableObject::SharedPtr> mpObjects;
+        std::vector<float> mTimeOffsets;
         std::string mName;
         bool mRepeatAnimation = false;
 
         Frame mCurrentFrame;
         Interpolation mMode = Interpolation::CubicSpline;
+        Parameterization mParameterization = Parameterization::KeyFrameTime;
         bool mDirty = false;
 
+        /** Arc-length data. Each segment between two key frames is sampled kArcLengthSamplesPerSegment times. The uniform table maps equally spaced distances
+            along the path to spline parameters (segment index + interpolation factor), so a constant-speed sample is a single table lookup.
+        */
+        struct
+        {
+            std::vector<float> segmentSamples;      // [Segment][Sample] Distance from the start of the segment. Sample 0 is at t = 1/kArcLengthSamplesPerSegment
+            std::vector<float> segmentStart;        // [Segment] Distance of the segment start from the start of the path. Has an extra entry with the total length
+            std::vector<float> uniformTable;        // Spline parameter at equally spaced distances
+            uint32_t dirtyBegin = 0;
+            uint32_t dirtyEnd = 0;
+        } mArcLength;
+
+        std::vector<double> mSampleTimes;
+        std::vector<Frame> mSampledFrames;
+
         std::unique_ptr<Vec3CubicSpline> mpPositionSpline;
         std::unique_ptr<Vec3CubicSpline> mpTargetSpline;
         std::unique_ptr<Vec3CubicSpline> mpUpSpline;
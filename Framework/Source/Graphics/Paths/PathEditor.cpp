@@ -112,6 +112,15 @@ namespace Falcor
         }
     }
 
+    void PathEditor::editPathSpeed(Gui* pGui)
+    {
+        bool constantSpeed = (mpPath->getParameterization() == ObjectPath::Parameterization::ConstantSpeed);
+        if (pGui->addCheckBox("Constant Speed", constantSpeed))
+        {
+            mpPath->setParameterization(constantSpeed ? ObjectPath::Parameterization::ConstantSpeed : ObjectPath::Parameterization::KeyFrameTime);
+        }
+    }
+
     void PathEditor::editPathName(Gui* pGui)
     {
         char buffer[1024];
@@ -152,6 +161,7 @@ namespace Falcor
         pGui->addSeparator();
         editPathName(pGui);
         editPathLoop(pGui);
+        editPathSpeed(pGui);
         editActiveFrameID(pGui);
 
         addFrame(pGui);
@@ -29,22 +29,12 @@
 #include "ParameterBlock.h"
 #include "API/Device.h"
 #include "Utils/StringUtils.h"
+#include <unordered_map>
 
 namespace Falcor
 {
-    bool verifyResourceVar(const ReflectionVar* pVar, ReflectionResourceType::Type type, ReflectionResourceType::ShaderAccess access, bool expectBuffer, const std::string& varName, const std::string& funcName)
+    bool verifyResourceType(const ReflectionResourceType* pType, ReflectionResourceType::Type type, ReflectionResourceType::ShaderAccess access, bool expectBuffer, const std::string& varName, const std::string& funcName)
     {
-        if (pVar == nullptr)
-        {
-            logWarning(to_string(type) + " \"" + varName + "\" was not found. Ignoring " + funcName + " call.");
-            return false;
-        }
-        const ReflectionResourceType* pType = pVar->getType()->unwrapArray()->asResourceType();
-        if (!pType)
-        {
-            logWarning(varName + " is not a resource. Ignoring " + funcName + " call.");
-            return false;
-        }
 #if _LOG_ENABLED
         if (pType->getType() != type)
         {
@@ -67,6 +57,33 @@ namespace Falcor
         return true;
     }
 
+    bool verifyResourceVar(const ReflectionVar* pVar, ReflectionResourceType::Type type, ReflectionResourceType::ShaderAccess access, bool expectBuffer, const std::string& varName, const std::string& funcName)
+    {
+        if (pVar == nullptr)
+        {
+            logWarning(to_string(type) + " \"" + varName + "\" was not found. Ignoring " + funcName + " call.");
+            return false;
+        }
+        const ReflectionResourceType* pType = pVar->getType()->unwrapArray()->asResourceType();
+        if (!pType)
+        {
+            logWarning(varName + " is not a resource. Ignoring " + funcName + " call.");
+            return false;
+        }
+        return verifyResourceType(pType, type, access, expectBuffer, varName, funcName);
+    }
+
+    // Unlike the name checks, this one runs in release builds as well. A handle from a different reflection would write into the wrong descriptor
+    static bool verifyResourceHandle(const ShaderVarHandle& handle, const ParameterBlockReflection* pReflector, ReflectionResourceType::Type type, ReflectionResourceType::ShaderAccess access, bool expectBuffer, const std::string& funcName)
+    {
+        if (handle.pReflector != pReflector)
+        {
+            logWarning("ParameterBlock::" + funcName + " was called with " + (handle.isValid() ? "a handle resolved against a different parameter-block reflection" : "an invalid handle") + ". Ignoring call");
+            return false;
+        }
+        return verifyResourceType(handle.pResourceType, type, access, expectBuffer, "<handle>", funcName);
+    }
+
     ParameterBlock::~ParameterBlock() = default;
 
     ParameterBlock::AssignedResource::AssignedResource() : pResource(nullptr), type(DescriptorSet::Type::Count), pCB(nullptr)
@@ -130,6 +147,27 @@ namespace Falcor
         }
     }
 
+    const void* ParameterBlock::AssignedResource::getView() const
+    {
+        switch (type)
+        {
+        case DescriptorSet::Type::Cbv:
+            return pCB.get();
+        case DescriptorSet::Type::Sampler:
+            return pSampler.get();
+        case DescriptorSet::Type::StructuredBufferSrv:
+        case DescriptorSet::Type::TypedBufferSrv:
+        case DescriptorSet::Type::TextureSrv:
+            return pSRV.get();
+        case DescriptorSet::Type::StructuredBufferUav:
+        case DescriptorSet::Type::TypedBufferUav:
+        case DescriptorSet::Type::TextureUav:
+            return pUAV.get();
+        default:
+            return nullptr;
+        }
+    }
+
     ParameterBlock::SharedPtr ParameterBlock::create(const ParameterBlockReflection::SharedConstPtr& pReflection, bool createBuffers)
     {
         return SharedPtr(new ParameterBlock(pReflection, createBuffers));
@@ -300,9 +338,9 @@ namespace Falcor
         return setConstantBuffer(loc, arrayIndex, pCB);
     }
 
-    static DescriptorSet::Type getSetTypeFromVar(const ReflectionVar::SharedConstPtr& pVar, DescriptorSet::Type srvType, DescriptorSet::Type uavType)
+    static DescriptorSet::Type getSetTypeFromType(const ReflectionResourceType* pType, DescriptorSet::Type srvType, DescriptorSet::Type uavType)
     {
-        switch (pVar->getType()->unwrapArray()->asResourceType()->getShaderAccess())
+        switch (pType->getShaderAccess())
         {
         case ReflectionResourceType::ShaderAccess::Read:
             return srvType;
@@ -314,12 +352,21 @@ namespace Falcor
         }
     }
 
+    static DescriptorSet::Type getSetTypeFromVar(const ReflectionVar::SharedConstPtr& pVar, DescriptorSet::Type srvType, DescriptorSet::Type uavType)
+    {
+        return getSetTypeFromType(pVar->getType()->unwrapArray()->asResourceType(), srvType, uavType);
+    }
+
     void ParameterBlock::setResourceSrvUavCommon(std::string name, uint32_t descOffset, DescriptorSet::Type type, const Resource::SharedPtr& pResource, const std::string& funcName)
     {
         uint32_t index;
         while (parseArrayIndex(name, name, index)) {};
 
-        ParameterBlockReflection::BindLocation bindLoc = mpReflector->getResourceBinding(name);
+        setResourceSrvUavCommon(mpReflector->getResourceBinding(name), descOffset, type, pResource, funcName);
+    }
+
+    void ParameterBlock::setResourceSrvUavCommon(const BindLocation& bindLoc, uint32_t descOffset, DescriptorSet::Type type, const Resource::SharedPtr& pResource, const std::string& funcName)
+    {
         if (checkResourceIndices(bindLoc, descOffset, type, funcName) == false) return;
         auto& desc = mAssignedResources[bindLoc.setIndex][bindLoc.rangeIndex][descOffset];
         if (desc.pResource == pResource) return;
@@ -356,16 +403,25 @@ namespace Falcor
     bool ParameterBlock::setRawBuffer(const std::string& name, Buffer::SharedPtr pBuf)
     {
         // Find the buffer
-        const ReflectionVar::SharedConstPtr pVar = mpReflector->getResource(name);
+        const ShaderVarHandle& handle = mpReflector->getResourceHandle(name);
 #if _LOG_ENABLED
-
-        if (verifyResourceVar(pVar.get(), ReflectionResourceType::Type::RawBuffer, ReflectionResourceType::ShaderAccess::Undefined, true, name, "setRawBuffer()") == false)
+        if (handle.isValid() == false)
         {
+            logWarning(to_string(ReflectionResourceType::Type::RawBuffer) + " \"" + name + "\" was not found. Ignoring setRawBuffer() call.");
             return false;
         }
 #endif
-        DescriptorSet::Type type = getSetTypeFromVar(pVar, DescriptorSet::Type::TextureSrv, DescriptorSet::Type::TextureUav);
-        setResourceSrvUavCommon(name, pVar->getDescOffset(), type, pBuf, "setRawBuffer()");
+        return setRawBuffer(handle, pBuf);
+    }
+
+    bool ParameterBlock::setRawBuffer(const ShaderVarHandle& handle, const Buffer::SharedPtr& pBuf)
+    {
+        if (verifyResourceHandle(handle, mpReflector.get(), ReflectionResourceType::Type::RawBuffer, ReflectionResourceType::ShaderAccess::Undefined, true, "setRawBuffer()") == false)
+        {
+            return false;
+        }
+        DescriptorSet::Type type = getSetTypeFromType(handle.pResourceType, DescriptorSet::Type::TextureSrv, DescriptorSet::Type::TextureUav);
+        setResourceSrvUavCommon(BindLocation(handle.setIndex, handle.rangeIndex), handle.descOffset, type, pBuf, "setRawBuffer()");
         return true;
     }
 
@@ -452,15 +508,24 @@ namespace Falcor
 
     bool ParameterBlock::setSampler(const std::string& name, const Sampler::SharedPtr& pSampler)
     {
-        const ReflectionVar::SharedConstPtr pVar = mpReflector->getResource(name);
+        const ShaderVarHandle& handle = mpReflector->getResourceHandle(name);
 #if _LOG_ENABLED
-        if (verifyResourceVar(pVar.get(), ReflectionResourceType::Type::Sampler, ReflectionResourceType::ShaderAccess::Read, false, name, "setSampler()") == false)
+        if (handle.isValid() == false)
         {
+            logWarning(to_string(ReflectionResourceType::Type::Sampler) + " \"" + name + "\" was not found. Ignoring setSampler() call.");
             return false;
         }
 #endif
-        ParameterBlockReflection::BindLocation bind = mpReflector->getResourceBinding(name);
-        return setSampler(bind, pVar->getDescOffset(), pSampler);
+        return setSampler(handle, pSampler);
+    }
+
+    bool ParameterBlock::setSampler(const ShaderVarHandle& handle, const Sampler::SharedPtr& pSampler)
+    {
+        if (verifyResourceHandle(handle, mpReflector.get(), ReflectionResourceType::Type::Sampler, ReflectionResourceType::ShaderAccess::Read, false, "setSampler()") == false)
+        {
+            return false;
+        }
+        return setSampler(BindLocation(handle.setIndex, handle.rangeIndex), handle.descOffset, pSampler);
     }
 
     Sampler::SharedPtr ParameterBlock::getSampler(const std::string& name) const
@@ -496,17 +561,25 @@ namespace Falcor
 
     bool ParameterBlock::setTexture(const std::string& name, const Texture::SharedPtr& pTexture)
     {
-        const ReflectionVar::SharedConstPtr pVar = mpReflector->getResource(name);
-
+        const ShaderVarHandle& handle = mpReflector->getResourceHandle(name);
 #if _LOG_ENABLED
-        if (verifyResourceVar(pVar.get(), ReflectionResourceType::Type::Texture, ReflectionResourceType::ShaderAccess::Undefined, false, name, "setTexture()") == false)
+        if (handle.isValid() == false)
         {
+            logWarning(to_string(ReflectionResourceType::Type::Texture) + " \"" + name + "\" was not found. Ignoring setTexture() call.");
             return false;
         }
 #endif
+        return setTexture(handle, pTexture);
+    }
 
-        DescriptorSet::Type type = getSetTypeFromVar(pVar, DescriptorSet::Type::TextureSrv, DescriptorSet::Type::TextureUav);
-        setResourceSrvUavCommon(name, pVar->getDescOffset(), type, pTexture, "setTexture()");
+    bool ParameterBlock::setTexture(const ShaderVarHandle& handle, const Texture::SharedPtr& pTexture)
+    {
+        if (verifyResourceHandle(handle, mpReflector.get(), ReflectionResourceType::Type::Texture, ReflectionResourceType::ShaderAccess::Undefined, false, "setTexture()") == false)
+        {
+            return false;
+        }
+        DescriptorSet::Type type = getSetTypeFromType(handle.pResourceType, DescriptorSet::Type::TextureSrv, DescriptorSet::Type::TextureUav);
+        setResourceSrvUavCommon(BindLocation(handle.setIndex, handle.rangeIndex), handle.descOffset, type, pTexture, "setTexture()");
         return true;
     }
 
@@ -642,29 +715,59 @@ namespace Falcor
             }
         }
 
-        // Allocate the missing sets
-        for (uint32_t i = 0; i < mRootSets.size(); i++)
+        // Find or create the missing sets
+        const auto& pCache = gpDevice->getDescriptorSetCache();
+        for (uint32_t s = 0; s < mRootSets.size(); s++)
         {
-            mRootSets[i].dirty = (mRootSets[i].pSet == nullptr);
-            if (mRootSets[i].pSet == nullptr)
+            mRootSets[s].dirty = (mRootSets[s].pSet == nullptr);
+            if (mRootSets[s].pSet) continue;
+
+            // The cache compares views, so blocks which bind the same resources share a set and skip the descriptor writes
+            const auto& layout = mpReflector->getDescriptorSetLayouts()[s];
+            const auto& set = mAssignedResources[s];
+            DescriptorSetCache::Key key(&layout, mpReflector);
+            for (const auto& range : set)
             {
-                DescriptorSet::Layout layout;
-                const auto& set = mpReflector->getDescriptorSetLayouts()[i];
-                mRootSets[i].pSet = DescriptorSet::create(gpDevice->getGpuDescriptorPool(), set);
-                if (mRootSets[i].pSet == nullptr)
+                for (const auto& desc : range)
                 {
-                    return false;
+                    switch (desc.type)
+                    {
+                    case DescriptorSet::Type::Cbv:
+                    {
+                        ConstantBuffer* pCB = dynamic_cast<ConstantBuffer*>(desc.pResource.get());
+                        key.addDescriptor(pCB ? pCB->getCbv() : ConstantBufferView::getNullView());
+                    }
+                    break;
+                    case DescriptorSet::Type::Sampler:
+                        key.addDescriptor(desc.pSampler);
+                        break;
+                    case DescriptorSet::Type::StructuredBufferSrv:
+                    case DescriptorSet::Type::TypedBufferSrv:
+                    case DescriptorSet::Type::TextureSrv:
+                        key.addDescriptor(desc.pSRV);
+                        break;
+                    case DescriptorSet::Type::StructuredBufferUav:
+                    case DescriptorSet::Type::TypedBufferUav:
+                    case DescriptorSet::Type::TextureUav:
+                        key.addDescriptor(desc.pUAV);
+                        break;
+                    default:
+                        should_not_get_here();
+                        return false;
+                    }
                 }
             }
-        }
 
-        // bind the resources
-        for (uint32_t s = 0; s < mAssignedResources.size(); s++)
-        {
-            if (mRootSets[s].dirty == false) continue;
-            const auto& pDescSet = mRootSets[s].pSet;
+            mRootSets[s].pSet = pCache->find(key);
+            if (mRootSets[s].pSet) continue;
 
-            const auto& set = mAssignedResources[s];
+            DescriptorSet::SharedPtr pDescSet = DescriptorSet::create(gpDevice->getGpuDescriptorPool(), layout);
+            if (pDescSet == nullptr)
+            {
+                return false;
+            }
+
+            // Bind the resources
             for (uint32_t r = 0 ; r < set.size() ; r++)
             {
                 const auto& range = set[r];
@@ -703,7 +806,122 @@ namespace Falcor
                     }
                 }
             }
+            pCache->insert(key, pDescSet);
+            mRootSets[s].pSet = pDescSet;
         }
          return true;
     }
+
+    static uint64_t hashBytes(uint64_t hash, const void* pData, size_t size)
+    {
+        // FNV-1a
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static const ConstantBuffer* getAssignedCB(const Resource::SharedPtr& pResource)
+    {
+        return dynamic_cast<const ConstantBuffer*>(pResource.get());
+    }
+
+    uint64_t ParameterBlock::hashContent() const
+    {
+        const ParameterBlockReflection* pReflector = mpReflector.get();
+        uint64_t hash = hashBytes(14695981039346656037ull, &pReflector, sizeof(pReflector));
+        for (const auto& set : mAssignedResources)
+        {
+            for (const auto& range : set)
+            {
+                for (const auto& desc : range)
+                {
+                    if (desc.type == DescriptorSet::Type::Cbv)
+                    {
+                        // Constant buffers are copied into the snapshot, so they are compared by content
+                        const ConstantBuffer* pCB = getAssignedCB(desc.pResource);
+                        if (pCB) hash = hashBytes(hash, pCB->getCpuData().data(), pCB->getCpuData().size());
+                    }
+                    else
+                    {
+                        const void* pView = desc.getView();
+                        hash = hashBytes(hash, &pView, sizeof(pView));
+                    }
+                }
+            }
+        }
+        return hash;
+    }
+
+    bool ParameterBlock::isContentEqual(const ParameterBlock& other) const
+    {
+        if (mpReflector != other.mpReflector) return false;
+        for (size_t s = 0; s < mAssignedResources.size(); s++)
+        {
+            for (size_t r = 0; r < mAssignedResources[s].size(); r++)
+            {
+                const auto& range = mAssignedResources[s][r];
+                const auto& otherRange = other.mAssignedResources[s][r];
+                for (size_t d = 0; d < range.size(); d++)
+                {
+                    if (range[d].type == DescriptorSet::Type::Cbv)
+                    {
+                        const ConstantBuffer* pCB = getAssignedCB(range[d].pResource);
+                        const ConstantBuffer* pOtherCB = getAssignedCB(otherRange[d].pResource);
+                        if ((pCB == nullptr) != (pOtherCB == nullptr)) return false;
+                        if (pCB && pCB->getCpuData() != pOtherCB->getCpuData()) return false;
+                    }
+                    else
+                    {
+                        if (range[d].pResource != otherRange[d].pResource || range[d].getView() != otherRange[d].getView()) return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    ParameterBlock::SharedConstPtr ParameterBlock::snapshot() const
+    {
+        if (mIsSnapshot) return std::const_pointer_cast<ParameterBlock>(shared_from_this());
+
+        static std::unordered_map<uint64_t, std::vector<std::weak_ptr<ParameterBlock>>> sSnapshots;
+        uint64_t hash = hashContent();
+        auto& bucket = sSnapshots[hash];
+        for (auto it = bucket.begin(); it != bucket.end();)
+        {
+            std::shared_ptr<ParameterBlock> pExisting = it->lock();
+            if (pExisting == nullptr)
+            {
+                it = bucket.erase(it);
+                continue;
+            }
+            if (isContentEqual(*pExisting)) return pExisting;
+            ++it;
+        }
+
+        // Copy the resources and replace the constant buffers with private copies. The views are shared, so the descriptor-set cache will usually find the sets of the source block
+        SharedPtr pSnapshot = SharedPtr(new ParameterBlock(*this));
+        for (uint32_t s = 0; s < pSnapshot->mAssignedResources.size(); s++)
+        {
+            for (auto& range : pSnapshot->mAssignedResources[s])
+            {
+                for (auto& desc : range)
+                {
+                    const ConstantBuffer* pCB = (desc.type == DescriptorSet::Type::Cbv) ? getAssignedCB(desc.pResource) : nullptr;
+                    if (pCB)
+                    {
+                        desc.pResource = pCB->clone();
+                        pSnapshot->mRootSets[s].pSet = nullptr;
+                    }
+                }
+            }
+        }
+        pSnapshot->mIsSnapshot = true;
+        bucket.push_back(pSnapshot);
+        return pSnapshot;
+    }
 }
\ No newline at end of file
@@ -105,6 +105,12 @@ namespace Falcor
         */
         bool setRawBuffer(const std::string& name, Buffer::SharedPtr pBuf);
 
+        /** Set a raw-buffer using a handle resolved with getResourceHandle(). This doesn't parse the name or allocate memory
+            \param[in] handle The resource handle
+            \param[in] pBuf The buffer object
+        */
+        bool setRawBuffer(const ShaderVarHandle& handle, const Buffer::SharedPtr& pBuf);
+
         /** Set a typed buffer. Based on the shader reflection, it will be bound as either an SRV or a UAV
             \param[in] name The name of the buffer
             \param[in] pBuf The buffer object
@@ -141,6 +147,12 @@ namespace Falcor
         */
         bool setTexture(const std::string& name, const Texture::SharedPtr& pTexture);
 
+        /** Bind a texture using a handle resolved with getResourceHandle(). This doesn't parse the name or allocate memory
+            \param[in] handle The resource handle
+            \param[in] pTexture The texture object to bind
+        */
+        bool setTexture(const ShaderVarHandle& handle, const Texture::SharedPtr& pTexture);
+
         /** Get a texture object.
             \param[in] name The name of the texture
             \return If the name is valid, a shared pointer to the texture object. Otherwise returns nullptr
@@ -182,6 +194,13 @@ namespace Falcor
         */
         bool setSampler(const std::string& name, const Sampler::SharedPtr& pSampler);
 
+        /** Bind a sampler using a handle resolved with getResourceHandle(). This doesn't parse the name or allocate memory
+            \param[in] handle The resource handle
+            \param[in] pSampler The sampler object to bind
+            \return false if the handle doesn't belong to this block's reflection, otherwise true
+        */
+        bool setSampler(const ShaderVarHandle& handle, const Sampler::SharedPtr& pSampler);
+
         /** Bind a sampler to the program in the global namespace.
             \param[in] bindLocation The bind-location in the block
             \param[in] arrayIndex The array index, or 0 for non-arrays
@@ -205,10 +224,25 @@ namespace Falcor
         */
         ParameterBlockReflection::SharedConstPtr getReflection() const { return mpReflector; }
 
+        /** Get a handle to a resource in the block. Resolve it once and use it in per-frame and per-draw code instead of the name. The handle is valid for any block created with the same reflection object
+        */
+        const ShaderVarHandle& getResourceHandle(const std::string& name) const { return mpReflector->getResourceHandle(name); }
+
         /** Prepare the block for draw. This call updates the descriptor-sets
             \return Returns true if successful, false otherwise
         */
         bool prepareForDraw(CopyContext* pContext);
+
+        /** Create an immutable snapshot of the block.
+            Constant buffers are copied, other resources are referenced. Snapshots are hash-consed - if a live snapshot with the same reflection, resources and constant-buffer data exists, it is returned instead of a new object, so identical blocks share their buffers and descriptor-sets.
+            Don't change the constant buffers of a snapshot, other owners may be using the same object.
+            \return A snapshot of the current state. If the block is already a snapshot, returns the block itself
+        */
+        SharedConstPtr snapshot() const;
+
+        /** Check if the block is an immutable snapshot
+        */
+        bool isSnapshot() const { return mIsSnapshot; }
        
         // Delete some functions. If they are not deleted, the compiler will try to convert the uints to string, resulting in runtime error
         Sampler::SharedPtr getSampler(uint32_t) const = delete;
@@ -230,7 +264,9 @@ namespace Falcor
         std::vector<RootSet>& getRootSets() { return mRootSets; }
     private:
         ParameterBlock(const ParameterBlockReflection::SharedConstPtr& pReflection, bool createBuffers);
+        ParameterBlock(const ParameterBlock& other) = default;
         ParameterBlockReflection::SharedConstPtr mpReflector;
+        bool mIsSnapshot = false;
         friend class ProgramVars;
 
         struct AssignedResource
@@ -239,6 +275,7 @@ namespace Falcor
             AssignedResource();
             AssignedResource(const AssignedResource& other);
             ~AssignedResource();
+            const void* getView() const;
 
             DescriptorSet::Type type;
             union
@@ -253,10 +290,13 @@ namespace Falcor
         using ResourceVec = std::vector<AssignedResource>;
         using SetResourceVec = std::vector<ResourceVec>;
         std::vector<SetResourceVec> mAssignedResources;
+        uint64_t hashContent() const;
+        bool isContentEqual(const ParameterBlock& other) const;
         bool checkResourceIndices(const BindLocation& bindLocation, uint32_t arrayIndex, DescriptorSet::Type type, const std::string& funcName) const;
 
         std::vector<RootSet> mRootSets;
         void setResourceSrvUavCommon(std::string name, uint32_t descOffset, DescriptorSet::Type type, const Resource::SharedPtr& pResource, const std::string& funcName);
+        void setResourceSrvUavCommon(const BindLocation& bindLoc, uint32_t descOffset, DescriptorSet::Type type, const Resource::SharedPtr& pResource, const std::string& funcName);
         template<typename ResourceType>
         typename ResourceType::SharedPtr getResourceSrvUavCommon(const std::string& name, uint32_t descOffset, DescriptorSet::Type type, const std::string& funcName) const;
     };
@@ -38,6 +38,15 @@
 #include "API/Sampler.h"
 #include "API/RenderContext.h"
 #include "Utils/StringUtils.h"
+#include "Graphics/Program/ShaderArchive.h"
+#include "Utils/Platform/FileWatcher.h"
+#include <deque>
+#include <map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 #include "ShaderLibrary.h"
 
 namespace Falcor
@@ -161,22 +170,280 @@ namespace Falcor
         return e.isValid() ? mSources[e.index].str : s;
     }
 
+    static uint64_t packDefine(Program::DefineSymbol name, Program::DefineSymbol value) { return ((uint64_t)name << 32) | value; }
+    static Program::DefineSymbol getDefineName(uint64_t define) { return (Program::DefineSymbol)(define >> 32); }
+    static Program::DefineSymbol getDefineValue(uint64_t define) { return (Program::DefineSymbol)(define & 0xffffffff); }
+
+    static size_t hashDefine(uint64_t define)
+    {
+        // splitmix64 finalizer. The key hash is the XOR of the define hashes
+        define ^= define >> 30;
+        define *= 0xbf58476d1ce4e5b9ull;
+        define ^= define >> 27;
+        define *= 0x94d049bb133111ebull;
+        define ^= define >> 31;
+        return (size_t)define;
+    }
+
     // Program
     std::vector<Program*> Program::sPrograms;
 
+    class Program::HotReload
+    {
+    public:
+        static HotReload& get()
+        {
+            static HotReload sInstance;
+            return sInstance;
+        }
+
+        static bool isAlive() { return sAlive; }
+
+        ~HotReload()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mCondition.notify_all();
+            for (auto& t : mWorkers) t.join();
+            sAlive = false;
+        }
+
+        void addDependencies(Program* pProgram, const std::vector<std::string>& files)
+        {
+            if (mWatcherCreated == false)
+            {
+                mpWatcher = FileWatcher::create();
+                mWatcherCreated = true;
+            }
+
+            for (const auto& f : files)
+            {
+                mDependents[f].insert(pProgram);
+                if (mFileTimes.find(f) == mFileTimes.end())
+                {
+                    mFileTimes[f] = getFileModifiedTime(f);
+                    if (mpWatcher) mpWatcher->watchFile(f);
+                }
+            }
+        }
+
+        void removeProgram(Program* pProgram)
+        {
+            for (auto& d : mDependents) d.second.erase(pProgram);
+        }
+
+        /** Stat every tracked file, for when notifications are not available
+        */
+        std::vector<std::string> getModifiedFiles()
+        {
+            std::vector<std::string> files;
+            for (auto& f : mFileTimes)
+            {
+                time_t t = getFileModifiedTime(f.first);
+                if (t != f.second)
+                {
+                    f.second = t;
+                    files.push_back(f.first);
+                }
+            }
+            return files;
+        }
+
+        std::vector<std::string> pollWatcher()
+        {
+            if (mpWatcher == nullptr) return {};
+            std::vector<std::string> files = mpWatcher->pollChanges();
+            for (const auto& f : files) mFileTimes[f] = getFileModifiedTime(f);
+            return files;
+        }
+
+        /** Queue a recompilation of every version which depends on one of the files
+        */
+        void invalidate(const std::vector<std::string>& files)
+        {
+            std::unordered_set<Program*> programs;
+            for (const auto& f : files)
+            {
+                logInfo("Shader file '" + f + "' changed");
+                auto it = mDependents.find(f);
+                if (it != mDependents.end()) programs.insert(it->second.begin(), it->second.end());
+            }
+            if (programs.empty()) return;
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            for (Program* pProgram : programs)
+            {
+                for (const auto& v : pProgram->mProgramVersions)
+                {
+                    bool affected = std::any_of(v.second.dependencies.begin(), v.second.dependencies.end(), [&files](const std::string& d) { return std::find(files.begin(), files.end(), d) != files.end(); });
+                    if (affected == false) continue;
+
+                    Job job;
+                    job.programId = pProgram->mId;
+                    job.key = v.first;
+                    job.desc = pProgram->mDesc;
+                    job.defines = getDefineList(v.first);
+                    job.generation = ++mGeneration;
+                    mLatest[{job.programId, job.key.defines}] = job.generation;
+                    mJobs.push_back(std::move(job));
+                }
+            }
+            lock.unlock();
+
+            startWorkers();
+            mCondition.notify_all();
+        }
+
+        /** Swap in the versions which finished compiling. Must be called from the thread which uses the programs
+        */
+        bool swapCompleted()
+        {
+            std::vector<Result> results;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mResults.empty()) return false;
+                results.swap(mResults);
+            }
+
+            bool updated = false;
+            for (auto& r : results)
+            {
+                // A newer compilation of the same version was queued after this one
+                auto latest = mLatest.find({ r.programId, r.key.defines });
+                if (latest == mLatest.end() || latest->second != r.generation) continue;
+                mLatest.erase(latest);
+
+                auto program = std::find_if(sPrograms.begin(), sPrograms.end(), [&r](const Program* p) { return p->mId == r.programId; });
+                if (program == sPrograms.end()) continue;
+                Program* pProgram = *program;
+                auto version = pProgram->mProgramVersions.find(r.key);
+                if (version == pProgram->mProgramVersions.end()) continue;
+
+                // On failure keep the previous version, so a typo doesn't take the program down
+                VersionData data;
+                if (r.success)
+                {
+                    data.reflectors = r.compiled.reflectors;
+                    data.dependencies = r.compiled.dependencies;
+                    data.pVersion = pProgram->createProgramVersion(r.log, r.compiled.shaderBlob, data.reflectors);
+                }
+                if (data.pVersion == nullptr)
+                {
+                    logError("Shader hot reload failed, keeping the previous version.\n\n" + pProgram->getProgramDescString() + "\n" + r.log);
+                    continue;
+                }
+
+                version->second = data;
+                addDependencies(pProgram, data.dependencies);
+                if (r.key == pProgram->mDefineKey) pProgram->mActiveProgram = data;
+                updated = true;
+            }
+            return updated;
+        }
+
+    private:
+        HotReload() = default;
+
+        struct Job
+        {
+            uint64_t programId;
+            DefineKey key;
+            Desc desc;
+            DefineList defines;
+            uint64_t generation;
+        };
+
+        struct Result
+        {
+            uint64_t programId;
+            DefineKey key;
+            uint64_t generation;
+            bool success;
+            CompiledVersion compiled;
+            std::string log;
+        };
+
+        static DefineList getDefineList(const DefineKey& key)
+        {
+            DefineList defines;
+            for (uint64_t define : key.defines)
+            {
+                defines[getDefineString(getDefineName(define))] = getDefineString(getDefineValue(define));
+            }
+            return defines;
+        }
+
+        void startWorkers()
+        {
+            // The threads are kept alive, so they reuse their Slang sessions
+            if (mWorkers.size()) return;
+            uint32_t count = std::min(4u, std::max(1u, std::thread::hardware_concurrency() / 2));
+            for (uint32_t i = 0; i < count; i++) mWorkers.push_back(std::thread(&HotReload::workerLoop, this));
+        }
+
+        void workerLoop()
+        {
+            while (true)
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mStop || mJobs.size(); });
+                if (mStop) return;
+                Job job = std::move(mJobs.front());
+                mJobs.pop_front();
+                lock.unlock();
+
+                Result r;
+                r.programId = job.programId;
+                r.key = job.key;
+                r.generation = job.generation;
+                // The job was queued because a source file changed, so the archived code is known to be stale
+                r.success = compileVersion(job.desc, job.defines, false, r.compiled, r.log);
+
+                lock.lock();
+                mResults.push_back(std::move(r));
+            }
+        }
+
+        static bool sAlive;
+
+        // Accessed only by the thread which uses the programs
+        FileWatcher::SharedPtr mpWatcher;
+        bool mWatcherCreated = false;
+        std::unordered_map<std::string, std::unordered_set<Program*>> mDependents;   ///< Reverse dependency index: file -> programs with a version which depends on it
+        std::unordered_map<std::string, time_t> mFileTimes;
+        std::map<std::pair<uint64_t, std::vector<uint64_t>>, uint64_t> mLatest;      ///< (program, defines) -> generation of the last queued compilation
+        uint64_t mGeneration = 0;
+
+        // Shared with the workers
+        std::vector<std::thread> mWorkers;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<Job> mJobs;
+        std::vector<Result> mResults;
+        bool mStop = false;
+    };
+
+    bool Program::HotReload::sAlive = true;
+
     Program::Program()
     {
+        static uint64_t sNextId = 0;
+        mId = sNextId++;
         sPrograms.push_back(this);
     }
 
     void Program::init(Desc const& desc, DefineList const& programDefines)
     {
         mDesc = desc;
-        mDefineList = programDefines;
+        replaceAllDefines(programDefines);
     }
 
     Program::~Program()
     {
+        if (HotReload::isAlive()) HotReload::get().removeProgram(this);
+
         // Remove the current program from the program vector
         for(auto it = sPrograms.begin() ; it != sPrograms.end() ; it++)
         {
@@ -220,19 +487,92 @@ namespace Falcor
         return desc;
     }
 
+    struct DefineStringTable
+    {
+        std::unordered_map<std::string, Program::DefineSymbol> symbols;
+        std::deque<std::string> strings;    // A deque, so references returned by getDefineString() stay valid
+        std::mutex mutex;                   // The hot-reload workers read the table while the main thread interns new defines
+
+        DefineStringTable()
+        {
+            symbols[""] = Program::kEmptyDefine;
+            strings.push_back("");
+        }
+    };
+
+    static DefineStringTable& getDefineStringTable()
+    {
+        static DefineStringTable table;
+        return table;
+    }
+
+    Program::DefineSymbol Program::internDefine(const std::string& str)
+    {
+        DefineStringTable& table = getDefineStringTable();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        const auto& it = table.symbols.find(str);
+        if (it != table.symbols.end()) return it->second;
+
+        DefineSymbol symbol = (DefineSymbol)table.strings.size();
+        table.strings.push_back(str);
+        table.symbols[str] = symbol;
+        return symbol;
+    }
+
+    const std::string& Program::getDefineString(DefineSymbol symbol)
+    {
+        DefineStringTable& table = getDefineStringTable();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        assert(symbol < table.strings.size());
+        return table.strings[symbol];
+    }
+
+    void Program::onDefinesChanged()
+    {
+        mLinkRequired = true;
+        mDefineListDirty = true;
+    }
+
+    const Program::DefineList& Program::getActiveDefinesList() const
+    {
+        if (mDefineListDirty)
+        {
+            mDefineList.clear();
+            for (uint64_t define : mDefineKey.defines)
+            {
+                mDefineList[getDefineString(getDefineName(define))] = getDefineString(getDefineValue(define));
+            }
+            mDefineListDirty = false;
+        }
+        return mDefineList;
+    }
+
     bool Program::addDefine(const std::string& name, const std::string& value)
     {
-        // Make sure that it doesn't exist already
-        if(mDefineList.find(name) != mDefineList.end())
+        return addDefine(internDefine(name), internDefine(value));
+    }
+
+    bool Program::addDefine(DefineSymbol name, DefineSymbol value)
+    {
+        auto& defines = mDefineKey.defines;
+        uint64_t define = packDefine(name, value);
+        auto it = std::lower_bound(defines.begin(), defines.end(), packDefine(name, 0));
+        if (it != defines.end() && getDefineName(*it) == name)
         {
-            if(mDefineList[name] == value)
+            if (*it == define)
             {
                 // Same define
                 return false;
             }
+            mDefineKey.hash ^= hashDefine(*it);
+            *it = define;
         }
-        mLinkRequired = true;
-        mDefineList[name] = value;
+        else
+        {
+            defines.insert(it, define);
+        }
+        mDefineKey.hash ^= hashDefine(define);
+        onDefinesChanged();
         return true;
     }
 
@@ -251,10 +591,30 @@ namespace Falcor
 
     bool Program::removeDefine(const std::string& name)
     {
-        if(mDefineList.find(name) != mDefineList.end())
+        return removeDefine(internDefine(name));
+    }
+
+    bool Program::removeDefine(DefineSymbol name)
+    {
+        auto& defines = mDefineKey.defines;
+        auto it = std::lower_bound(defines.begin(), defines.end(), packDefine(name, 0));
+        if (it != defines.end() && getDefineName(*it) == name)
+        {
+            mDefineKey.hash ^= hashDefine(*it);
+            defines.erase(it);
+            onDefinesChanged();
+            return true;
+        }
+        return false;
+    }
+
+    bool Program::getDefine(DefineSymbol name, DefineSymbol& value) const
+    {
+        const auto& defines = mDefineKey.defines;
+        auto it = std::lower_bound(defines.begin(), defines.end(), packDefine(name, 0));
+        if (it != defines.end() && getDefineName(*it) == name)
         {
-            mLinkRequired = true;
-            mDefineList.erase(name);
+            value = getDefineValue(*it);
             return true;
         }
         return false;
@@ -276,12 +636,14 @@ namespace Falcor
     bool Program::removeDefines(size_t pos, size_t len, const std::string& str)
     {
         bool dirty = false;
-        for (auto it = mDefineList.cbegin(); it != mDefineList.cend();)
+        auto& defines = mDefineKey.defines;
+        for (auto it = defines.begin(); it != defines.end();)
         {
-            if (pos < it->first.length() && it->first.compare(pos, len, str) == 0)
+            const std::string& name = getDefineString(getDefineName(*it));
+            if (pos < name.length() && name.compare(pos, len, str) == 0)
             {
-                mLinkRequired = true;
-                it = mDefineList.erase(it);
+                mDefineKey.hash ^= hashDefine(*it);
+                it = defines.erase(it);
                 dirty = true;
             }
             else
@@ -289,15 +651,16 @@ namespace Falcor
                 ++it;
             }
         }
+        if (dirty) onDefinesChanged();
         return dirty;
     }
 
     bool Program::clearDefines()
     {
-        if (!mDefineList.empty())
+        if (!mDefineKey.defines.empty())
         {
-            mLinkRequired = true;
-            mDefineList.clear();
+            mDefineKey = DefineKey();
+            onDefinesChanged();
             return true;
         }
         return false;
@@ -305,43 +668,44 @@ namespace Falcor
 
     bool Program::replaceAllDefines(const DefineList& dl)
     {
-        // TODO: re-link only if new macros differ from existing
-        if (!mDefineList.empty() || !dl.empty())
+        DefineKey key;
+        for (const auto& d : dl)
         {
-            mLinkRequired = true;
-            mDefineList = dl;
-            return true;
+            uint64_t define = packDefine(internDefine(d.first), internDefine(d.second));
+            key.defines.push_back(define);
+            key.hash ^= hashDefine(define);
         }
-        return false;
+        std::sort(key.defines.begin(), key.defines.end());
+
+        if (key == mDefineKey) return false;
+        mDefineKey = std::move(key);
+        onDefinesChanged();
+        return true;
     }
 
-    bool Program::checkIfFilesChanged()
+    Program::ScopedDefine::ScopedDefine(Program* pProgram, DefineSymbol name, DefineSymbol value) : mpProgram(pProgram), mName(name)
     {
-        if(mActiveProgram.pVersion == nullptr)
+        if (mpProgram)
         {
-            // We never linked, so nothing really changed
-            return false;
+            mHadValue = mpProgram->getDefine(name, mPrevValue);
+            mpProgram->addDefine(name, value);
         }
+    }
 
-        // Have any of the files we depend on changed?
-        for(auto& entry : mFileTimeMap)
+    Program::ScopedDefine::~ScopedDefine()
+    {
+        if (mpProgram)
         {
-            auto& path = entry.first;
-            auto& modifiedTime = entry.second;
-
-            if( modifiedTime != getFileModifiedTime(path) )
-            {
-                return true;
-            }
+            if (mHadValue) mpProgram->addDefine(mName, mPrevValue);
+            else mpProgram->removeDefine(mName);
         }
-        return false;
     }
 
     ProgramVersion::SharedConstPtr Program::getActiveVersion() const
     {
         if(mLinkRequired)
         {
-            const auto& it = mProgramVersions.find(mDefineList);
+            const auto& it = mProgramVersions.find(mDefineKey);
             if(it == mProgramVersions.end())
             {
                 if(link() == false)
@@ -350,28 +714,45 @@ namespace Falcor
                 }
                 else
                 {
-                    mProgramVersions[mDefineList] = mActiveProgram;
+                    mProgramVersions[mDefineKey] = mActiveProgram;
                 }
             }
             else
             {
-                mActiveProgram = mProgramVersions[mDefineList];
+                mActiveProgram = it->second;
             }
+            mLinkRequired = false;
         }
 
         return mActiveProgram.pVersion;
     }
 
+    static std::vector<std::pair<std::string, std::string>>& getSlangBuiltins()
+    {
+        static std::vector<std::pair<std::string, std::string>> builtins;
+        return builtins;
+    }
+
     SlangSession* getSlangSession()
     {
         // TODO: figure out a strategy for finalizing the Slang session, if desired
 
-        static SlangSession* slangSession = spCreateSession(NULL);
+        // Slang sessions are not thread-safe. Each thread which compiles programs (the offline precompiler uses worker threads) gets its own session
+        static thread_local SlangSession* slangSession = nullptr;
+        if (slangSession == nullptr)
+        {
+            slangSession = spCreateSession(NULL);
+            for (const auto& b : getSlangBuiltins())
+            {
+                spAddBuiltins(slangSession, b.first.c_str(), b.second.c_str());
+            }
+        }
         return slangSession;
     }
 
     void loadSlangBuiltins(char const* name, char const* text)
     {
+        getSlangBuiltins().push_back({ name, text });
         spAddBuiltins(getSlangSession(), name, text);
     }
 
@@ -411,10 +792,23 @@ namespace Falcor
 #endif
     }
 
-    Program::VersionData Program::preprocessAndCreateProgramVersion(std::string& log) const
+    static SlangCompileTarget getSlangTarget(const std::string& shaderModel)
     {
-        mFileTimeMap.clear();
+        // Pick the right target based on the current graphics API
+#ifdef FALCOR_VK
+        return SLANG_SPIRV;
+#elif defined FALCOR_D3D12
+        // If the profile string starts with a `4_` or a `5_`, use DXBC. Otherwise, use DXIL
+        if (hasPrefix(shaderModel, "4_") || hasPrefix(shaderModel, "5_")) return SLANG_DXBC;
+        else if (shaderModel == "6_3")                                    return SLANG_HLSL;   // TODO This is actually a hack for DXR, we need to fix it
+        else                                                              return SLANG_DXIL;
+#else
+#error unknown shader compilation target
+#endif
+    }
 
+    SlangCompileRequest* Program::createSlangRequest(const Desc& desc, const DefineList& defines)
+    {
         // Run all of the shaders through Slang, so that we can get final code,
         // reflection data, etc.
         //
@@ -436,35 +830,25 @@ namespace Falcor
         }
 
         // Enable/disable intermediates dump
-        bool dumpIR = is_set(mDesc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates);
+        bool dumpIR = is_set(desc.getCompilerFlags(), Shader::CompilerFlags::DumpIntermediates);
         spSetDumpIntermediates(slangRequest, dumpIR);
 
         // Pass any `#define` flags along to Slang, since we aren't doing our
         // own preprocessing any more.
-        for(auto shaderDefine : mDefineList)
+        for(const auto& shaderDefine : defines)
         {
             spAddPreprocessorDefine(slangRequest, shaderDefine.first.c_str(), shaderDefine.second.c_str());
         }
 
-        SlangCompileTarget slangTarget = SLANG_TARGET_UNKNOWN;
-        const char* preprocessorDefine;
-        // Pick the right target based on the current graphics API
 #ifdef FALCOR_VK
-        slangTarget = SLANG_SPIRV;
-        preprocessorDefine = "FALCOR_VK";
+        const char* preprocessorDefine = "FALCOR_VK";
 #elif defined FALCOR_D3D12
-        preprocessorDefine = "FALCOR_D3D";
-        // If the profile string starts with a `4_` or a `5_`, use DXBC. Otherwise, use DXIL
-        if (hasPrefix(mDesc.mShaderModel, "4_") || hasPrefix(mDesc.mShaderModel, "5_")) slangTarget = SLANG_DXBC;
-        else if (mDesc.mShaderModel == "6_3")                                           slangTarget = SLANG_HLSL;   // TODO This is actually a hack for DXR, we need to fix it
-        else                                                                            slangTarget = SLANG_DXIL;
-#else
-#error unknown shader compilation target
+        const char* preprocessorDefine = "FALCOR_D3D";
 #endif
-        spSetCodeGenTarget(slangRequest, slangTarget);
+        spSetCodeGenTarget(slangRequest, getSlangTarget(desc.mShaderModel));
         spAddPreprocessorDefine(slangRequest, preprocessorDefine, "1");
 
-        spSetTargetProfile(slangRequest, 0, spFindProfile(slangSession, getSlangProfileString(mDesc.mShaderModel).c_str()));
+        spSetTargetProfile(slangRequest, 0, spFindProfile(slangSession, getSlangProfileString(desc.mShaderModel).c_str()));
 
         // We always use row-major matrix layout (and when we invoke fxc/dxc we pass in the
         // appropriate flags to request this behavior), so we need to inform Slang that
@@ -477,12 +861,13 @@ namespace Falcor
 
         // Don't actually perform semantic checking: just pass through functions bodies to downstream compiler
         slangFlags |= SLANG_COMPILE_FLAG_NO_CHECKING | SLANG_COMPILE_FLAG_SPLIT_MIXED_TYPES;
+
         spSetCompileFlags(slangRequest, slangFlags);
 
         // Now lets add all our input shader code, one-by-one
         int translationUnitsAdded = 0;
 
-        for(auto src : mDesc.mSources)
+        for(auto src : desc.mSources)
         {
             // Register the translation unit with Slang
             int translationUnitIndex = spAddTranslationUnit(slangRequest, SLANG_SOURCE_LANGUAGE_SLANG, nullptr);
@@ -514,7 +899,7 @@ namespace Falcor
         // indices directly.
         for(uint32_t i = 0; i < kShaderCount; ++i)
         {
-            auto& entryPoint = mDesc.mEntryPoints[i];
+            auto& entryPoint = desc.mEntryPoints[i];
 
             // Skip unused entry points
             if(entryPoint.index < 0)
@@ -526,22 +911,18 @@ namespace Falcor
                 entryPoint.name.c_str(),
                 getSlangStage(ShaderType(i)));
         }
+        return slangRequest;
+    }
 
-        int anySlangErrors = spCompile(slangRequest);
-        log += spGetDiagnosticOutput(slangRequest);
-        if(anySlangErrors)
-        {
-            spDestroyCompileRequest(slangRequest);
-            return VersionData();
-        }
-
+    void Program::getSlangBlobs(SlangCompileRequest* pSlangRequest, const Desc& desc, Shader::Blob shaderBlob[kShaderCount])
+    {
         // Extract the generated code for each stage
+        SlangCompileTarget slangTarget = getSlangTarget(desc.mShaderModel);
         int entryPointCounter = 0;
-        Shader::Blob shaderBlob[kShaderCount];
 
         for (uint32_t i = 0; i < kShaderCount; i++)
         {
-            auto& entryPoint = mDesc.mEntryPoints[i];
+            auto& entryPoint = desc.mEntryPoints[i];
             // Skip unused entry points
             if(entryPoint.index < 0)
                 continue;
@@ -551,40 +932,148 @@ namespace Falcor
             if (slangTarget == SLANG_GLSL || slangTarget == SLANG_GLSL_VULKAN || slangTarget == SLANG_HLSL)
             {
                 shaderBlob[i].type = Shader::Blob::Type::String;
-                const char* data = spGetEntryPointSource(slangRequest, entryPointIndex);
+                const char* data = spGetEntryPointSource(pSlangRequest, entryPointIndex);
                 shaderBlob[i].data.assign(data, data + strlen(data));
             }
             else
             {
                 shaderBlob[i].type = Shader::Blob::Type::Bytecode;
                 size_t size = 0;
-                const uint8_t* data = (uint8_t*)spGetEntryPointCode(slangRequest, entryPointIndex, &size);
+                const uint8_t* data = (uint8_t*)spGetEntryPointCode(pSlangRequest, entryPointIndex, &size);
                 shaderBlob[i].data.assign(data, data + size);
             }
-            shaderBlob[i].shaderModel = mDesc.mShaderModel;
+            shaderBlob[i].shaderModel = desc.mShaderModel;
         }
+    }
 
-        VersionData programVersion;
+    bool Program::compileBlobs(const Desc& desc, const DefineList& defines, Shader::Blob shaderBlob[kShaderCount], ShaderArchive::ReflectionBlob reflection[ShaderArchive::kReflectorCount], ShaderArchive::DependencyList& dependencies, std::string& log)
+    {
+        CompiledVersion compiled;
+        if (compileVersion(desc, defines, false, compiled, log) == false) return false;
+
+        dependencies.clear();
+        for (const auto& file : compiled.dependencies)
+        {
+            // Sources created from strings show up under names which don't exist on disk. They are part of the permutation key already
+            std::string fullpath;
+            if (findFileInDataDirectories(file, fullpath) == false) continue;
+
+            ShaderArchive::Dependency d;
+            if (ShaderArchive::hashFile(fullpath, d.hash) == false)
+            {
+                log += "Can't read dependency " + file + "\n";
+                return false;
+            }
+            d.file = stripDataDirectories(fullpath);
+            dependencies.push_back(d);
+        }
+
+        for (uint32_t i = 0; i < kShaderCount; i++) shaderBlob[i] = compiled.shaderBlob[i];
+        compiled.reflectors.pReflector->serialize(reflection[0]);
+        compiled.reflectors.pLocalReflector->serialize(reflection[1]);
+        compiled.reflectors.pGlobalReflector->serialize(reflection[2]);
+        return true;
+    }
+
+    uint64_t Program::getPermutationKey(const Desc& desc, const DefineList& defines)
+    {
+        // Everything which affects the generated code, in a canonical order. Files are identified by the name used in the description, so an archive stays valid when the data directories move
+        std::string id;
+#ifdef FALCOR_VK
+        id += "VK;";
+#elif defined FALCOR_D3D12
+        id += "D3D12;";
+#endif
+        id += desc.mShaderModel + ";";
+        for (const auto& src : desc.mSources)
+        {
+            id += (src.type == Desc::Source::Type::File) ? "file:" + src.pLibrary->getFilename() : "string:" + src.str;
+            id += ";";
+        }
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            const auto& e = desc.mEntryPoints[i];
+            if (e.isValid()) id += std::to_string(i) + ":" + std::to_string(e.index) + ":" + e.name + ";";
+        }
+        for (const auto& d : defines)
+        {
+            id += d.first + "=" + d.second + ";";
+        }
+
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : id)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool Program::compileVersion(const Desc& desc, const DefineList& defines, bool useArchive, CompiledVersion& compiled, std::string& log)
+    {
+        // If the permutation was compiled offline, take the code and the reflection from the archive and skip Slang altogether
+        const ShaderArchive* pArchive = useArchive ? ShaderArchive::getActive().get() : nullptr;
+        ShaderArchive::ReflectionBlob reflection[ShaderArchive::kReflectorCount];
+        if (pArchive && pArchive->findPermutation(getPermutationKey(desc, defines), compiled.shaderBlob, reflection, compiled.dependencies))
+        {
+            compiled.reflectors.pReflector = ProgramReflection::createFromBlob(reflection[0]);
+            compiled.reflectors.pLocalReflector = ProgramReflection::createFromBlob(reflection[1]);
+            compiled.reflectors.pGlobalReflector = ProgramReflection::createFromBlob(reflection[2]);
+            if (compiled.reflectors.pReflector && compiled.reflectors.pLocalReflector && compiled.reflectors.pGlobalReflector)
+            {
+                return true;
+            }
+            compiled = CompiledVersion();
+        }
+
+        SlangCompileRequest* slangRequest = createSlangRequest(desc, defines);
+        int anySlangErrors = spCompile(slangRequest);
+        log += spGetDiagnosticOutput(slangRequest);
+        if(anySlangErrors)
+        {
+            spDestroyCompileRequest(slangRequest);
+            return false;
+        }
+
+        getSlangBlobs(slangRequest, desc, compiled.shaderBlob);
 
         // Extract the reflection data
-        programVersion.reflectors.pReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::All, log);
-        programVersion.reflectors.pLocalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Local, log);
-        programVersion.reflectors.pGlobalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Global, log);
+        compiled.reflectors.pReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::All, log);
+        compiled.reflectors.pLocalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Local, log);
+        compiled.reflectors.pGlobalReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), ProgramReflection::ResourceScope::Global, log);
 
         // Extract list of files referenced, for dependency-tracking purposes
         int depFileCount = spGetDependencyFileCount(slangRequest);
         for(int ii = 0; ii < depFileCount; ++ii)
         {
-            std::string depFilePath = spGetDependencyFilePath(slangRequest, ii);
-            mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            compiled.dependencies.push_back(spGetDependencyFilePath(slangRequest, ii));
         }
 
         spDestroyCompileRequest(slangRequest);
+        return true;
+    }
+
+    Program::VersionData Program::preprocessAndCreateProgramVersion(std::string& log) const
+    {
+        CompiledVersion compiled;
+        if (compileVersion(mDesc, getActiveDefinesList(), true, compiled, log) == false)
+        {
+            return VersionData();
+        }
+
+        VersionData programVersion;
+        programVersion.reflectors = compiled.reflectors;
+        programVersion.dependencies = compiled.dependencies;
 
         // Now that we've preprocessed things, dispatch to the actual program creation logic,
         // which may vary in subclasses of `Program`
-        programVersion.pVersion = createProgramVersion(log, shaderBlob, programVersion.reflectors);
+        programVersion.pVersion = createProgramVersion(log, compiled.shaderBlob, programVersion.reflectors);
 
+        if (programVersion.pVersion)
+        {
+            HotReload::get().addDependencies(const_cast<Program*>(this), programVersion.dependencies);
+        }
         return programVersion;
     }
 
@@ -653,22 +1142,16 @@ namespace Falcor
         }
     }
 
-    void Program::reset()
+    void Program::reloadAllPrograms()
     {
-        mActiveProgram = VersionData();
-        mProgramVersions.clear();
-        mFileTimeMap.clear();
-        mLinkRequired = true;
+        HotReload& hotReload = HotReload::get();
+        hotReload.invalidate(hotReload.getModifiedFiles());
     }
 
-    void Program::reloadAllPrograms()
+    bool Program::updateHotReload()
     {
-        for(auto& pProgram : sPrograms)
-        {
-            if(pProgram->checkIfFilesChanged())
-            {
-                pProgram->reset();
-            }
-        }
+        HotReload& hotReload = HotReload::get();
+        hotReload.invalidate(hotReload.pollWatcher());
+        return hotReload.swapCompleted();
     }
 }
@@ -29,7 +29,9 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include "Graphics/Program//ProgramVersion.h"
+#include "Graphics/Program/ShaderArchive.h"
 
 namespace Falcor
 {
@@ -51,6 +53,34 @@ namespace Falcor
 
         using DefineList = Shader::DefineList;
 
+        /** An interned macro name or value.
+            Interning hashes the string once. Adding and removing defines using symbols doesn't hash, compare or allocate strings, which makes it cheap enough for per-draw permutations.
+        */
+        using DefineSymbol = uint32_t;
+        static const DefineSymbol kEmptyDefine = 0;     ///< The symbol of the empty string, used as the value of defines without a value
+
+        /** Scoped macro override. Sets a define when constructed and restores the previous state of the define when destroyed.
+            Use it in draw loops instead of matching addDefine()/removeDefine() pairs. If a define was already set before the override, its value is restored rather than removed.
+        */
+        class ScopedDefine
+        {
+        public:
+            /** Set a define for the lifetime of the object
+                \param[in] pProgram The program. If this is nullptr, the object does nothing, which is useful for conditional overrides
+                \param[in] name The define name
+                \param[in] value Optional. The define value
+            */
+            ScopedDefine(Program* pProgram, DefineSymbol name, DefineSymbol value = kEmptyDefine);
+            ~ScopedDefine();
+            ScopedDefine(const ScopedDefine&) = delete;
+            ScopedDefine& operator=(const ScopedDefine&) = delete;
+        private:
+            Program* mpProgram;
+            DefineSymbol mName;
+            DefineSymbol mPrevValue = kEmptyDefine;
+            bool mHadValue = false;
+        };
+
         /** Description of a program to be created.
         */
         class Desc
@@ -170,6 +200,13 @@ namespace Falcor
         */
         bool addDefine(const std::string& name, const std::string& value = "");
 
+        /** Adds a macro definition to the program using interned symbols. If the macro already exists, it will be replaced.
+            \param[in] name The define name symbol.
+            \param[in] value Optional. The define value symbol.
+            \return True if any macro definitions were modified.
+        */
+        bool addDefine(DefineSymbol name, DefineSymbol value = kEmptyDefine);
+
         /** Add a list of macro definitions to the program. If a macro already exists, it will be replaced.
             \param[in] dl List of macro definitions to add.
             \return True if any macro definitions were modified.
@@ -182,6 +219,19 @@ namespace Falcor
         */
         bool removeDefine(const std::string& name);
 
+        /** Remove a macro definition from the program using an interned symbol. If the definition doesn't exist, the function call will be silently ignored.
+            \param[in] name The define name symbol.
+            \return True if any macro definitions were modified.
+        */
+        bool removeDefine(DefineSymbol name);
+
+        /** Check if a macro is defined
+            \param[in] name The define name symbol.
+            \param[out] value If the macro is defined, will hold the value symbol
+            \return True if the macro is defined, otherwise false
+        */
+        bool getDefine(DefineSymbol name, DefineSymbol& value) const;
+
         /** Removes a list of macro definitions from the program. If a macro doesn't exist, it is silently ignored.
             \param[in] dl List of macro definitions to remove.
             \return True if any macro definitions were modified.
@@ -208,12 +258,42 @@ namespace Falcor
 
         /** Get the macro definition string of the active program version
         */
-        const DefineList& getActiveDefinesList() const { return mDefineList; }
+        const DefineList& getActiveDefinesList() const;
+
+        /** Intern a macro name or value. The same string always returns the same symbol. Thread-safe
+        */
+        static DefineSymbol internDefine(const std::string& str);
+
+        /** Get the string of an interned symbol
+        */
+        static const std::string& getDefineString(DefineSymbol symbol);
 
-        /** Reload and relink all programs.
+        /** Check the files all programs depend on, and recompile the affected program versions in the background.
+            Programs keep using the previous versions until the new ones are swapped in by updateHotReload().
         */
         static void reloadAllPrograms();
 
+        /** Process shader file changes reported by the file watcher, and swap in the program versions which finished recompiling in the background. Sample calls it once per frame
+            \return true if any program version was replaced
+        */
+        static bool updateHotReload();
+
+        /** Compile a program permutation to shader code and serialized reflection, without creating any API objects. Used by the offline shader precompiler
+            \param[in] desc The program description
+            \param[in] defines The macro definitions of the permutation
+            \param[out] shaderBlob The generated code of each stage. Unused stages are left empty
+            \param[out] reflection The serialized reflection of the All, Local and Global resource scopes
+            \param[out] dependencies The files the permutation was compiled from, including the included files
+            \param[out] log The compiler diagnostics
+            \return true if the compilation succeeded, otherwise false
+        */
+        static bool compileBlobs(const Desc& desc, const DefineList& defines, Shader::Blob shaderBlob[kShaderCount], ShaderArchive::ReflectionBlob reflection[ShaderArchive::kReflectorCount], ShaderArchive::DependencyList& dependencies, std::string& log);
+
+        /** Get a stable key identifying a program permutation, used to look it up in a ShaderArchive. The key covers the sources, entry points, shader model, graphics API and defines.
+            Source files are identified by name. ShaderArchive validates their content separately
+        */
+        static uint64_t getPermutationKey(const Desc& desc, const DefineList& defines);
+
         const ProgramReflection::SharedConstPtr getReflector() const { getActiveVersion(); return mActiveProgram.reflectors.pReflector; }
         const ProgramReflection::SharedConstPtr getLocalReflector() const { getActiveVersion(); return mActiveProgram.reflectors.pLocalReflector; }
         const ProgramReflection::SharedConstPtr getGlobalReflector() const { getActiveVersion(); return mActiveProgram.reflectors.pGlobalReflector; }
@@ -235,29 +315,63 @@ namespace Falcor
         {
             ProgramVersion::SharedConstPtr pVersion;
             ProgramReflectors reflectors;
+            std::vector<std::string> dependencies;  ///< The files the version was compiled from, including the included files
+        };
+
+        /** The result of compiling a version. Creating it doesn't touch any API object, so it can be done on a worker thread
+        */
+        struct CompiledVersion
+        {
+            Shader::Blob shaderBlob[kShaderCount];
+            ProgramReflectors reflectors;
+            std::vector<std::string> dependencies;
         };
 
         bool link() const;
         VersionData preprocessAndCreateProgramVersion(std::string& log) const;
+        /** Compile a version. If useArchive is true and the permutation is found in the active ShaderArchive, the archived code is used
+        */
+        static bool compileVersion(const Desc& desc, const DefineList& defines, bool useArchive, CompiledVersion& compiled, std::string& log);
+        static SlangCompileRequest* createSlangRequest(const Desc& desc, const DefineList& defines);
+        static void getSlangBlobs(SlangCompileRequest* pSlangRequest, const Desc& desc, Shader::Blob shaderBlob[kShaderCount]);
         virtual ProgramVersion::SharedPtr createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount], const ProgramReflectors& reflectors) const;
 
         // The description used to create this program
         Desc mDesc;
 
-        DefineList mDefineList;
+        /** The permutation key. Each define is packed as (name << 32 | value), sorted by name. The hash is order-independent, so it's updated in O(1) when a define changes
+        */
+        struct DefineKey
+        {
+            std::vector<uint64_t> defines;
+            size_t hash = 0;
+            bool operator==(const DefineKey& other) const { return hash == other.hash && defines == other.defines; }
+        };
+
+        struct DefineKeyHash
+        {
+            size_t operator()(const DefineKey& key) const { return key.hash; }
+        };
+
+        DefineKey mDefineKey;
+        void onDefinesChanged();
+
+        // Rebuilt from the key when requested, so changing defines doesn't touch strings
+        mutable DefineList mDefineList;
+        mutable bool mDefineListDirty = false;
 
         // We are doing lazy compilation, so these are mutable
         mutable bool mLinkRequired = true;
-        mutable std::map<const DefineList, VersionData> mProgramVersions;
+        mutable std::unordered_map<DefineKey, VersionData, DefineKeyHash> mProgramVersions;
         mutable VersionData mActiveProgram;
 
         std::string getProgramDescString() const;
         static std::vector<Program*> sPrograms;
 
-        using string_time_map = std::unordered_map<std::string, time_t>;
-        mutable string_time_map mFileTimeMap;
+        // Unique ID, used by background recompilation to find the program without holding a pointer to it
+        uint64_t mId;
 
-        bool checkIfFilesChanged();
-        void reset();
+        // Tracks the files program versions depend on, and recompiles the versions when the files change. Defined in Program.cpp
+        class HotReload;
     };
 }
\ No newline at end of file
@@ -28,6 +28,9 @@
 #include "Framework.h"
 #include "ProgramReflection.h"
 #include "Utils/StringUtils.h"
+#include <mutex>
+#include <algorithm>
+#include <cstring>
 using namespace slang;
 
 namespace Falcor
@@ -621,7 +624,9 @@ namespace Falcor
 
     ProgramReflection::SharedPtr ProgramReflection::create(slang::ShaderReflection* pSlangReflector, ResourceScope scopeToReflect, std::string& log)
     {
-        return SharedPtr(new ProgramReflection(pSlangReflector, scopeToReflect, log));
+        SharedPtr pReflector = SharedPtr(new ProgramReflection(pSlangReflector, scopeToReflect, log));
+        // Empty reflectors are modified by merge(), so they can't be shared
+        return pSlangReflector ? intern(pReflector) : pReflector;
     }
 
     ProgramReflection::BindType getBindTypeFromSetType(DescriptorSet::Type type)
@@ -680,7 +685,15 @@ namespace Falcor
             // See if this block exists
             if (mParameterBlocksIndices.find(blockName) == mParameterBlocksIndices.end())
             {
-                // New block, just add it
+                // New block, just add it. The default block is modified by later merges, so it's copied rather than shared with the other reflector
+                if (blockName == "")
+                {
+                    ParameterBlockReflection::SharedPtr pCopy = ParameterBlockReflection::create("");
+                    for (const auto& pVar : pBlock->mTopLevelResources) pCopy->addResource(pVar);
+                    pCopy->finalize();
+                    pBlock = pCopy;
+                    defaultChanged = true;
+                }
                 addParameterBlock(pBlock);
             }
             else if (blockName == "")
@@ -966,11 +979,37 @@ namespace Falcor
         return mpResourceVars->findMember(name);
     }
 
+    const ShaderVarHandle& ParameterBlockReflection::getResourceHandle(const std::string& name) const
+    {
+        const auto& it = mResourceHandles.find(name);
+        if (it != mResourceHandles.end()) return it->second;
+
+        ShaderVarHandle& handle = mResourceHandles[name];
+        const ReflectionVar::SharedConstPtr pVar = getResource(name);
+        const ReflectionResourceType* pType = pVar ? pVar->getType()->unwrapArray()->asResourceType() : nullptr;
+        if (pType)
+        {
+            // The bindings are stored by the resource name, without the array indices
+            std::string nonArray = name;
+            uint32_t index;
+            while (parseArrayIndex(nonArray, nonArray, index)) {};
+            BindLocation bindLoc = getResourceBinding(nonArray);
+
+            handle.pReflector = this;
+            handle.pResourceType = pType;
+            handle.setIndex = bindLoc.setIndex;
+            handle.rangeIndex = bindLoc.rangeIndex;
+            handle.descOffset = pVar->getDescOffset();
+        }
+        return handle;
+    }
+
     void ParameterBlockReflection::addResource(const ReflectionVar::SharedConstPtr& pVar)
     {
         const ReflectionResourceType* pResourceType = pVar->getType()->unwrapArray()->asResourceType();
         assert(pResourceType);
         uint32_t elementCount = max(1u, pVar->getType()->getTotalArraySize());
+        mTopLevelResources.push_back(pVar);
         mResources.push_back(getResourceDesc(pVar, elementCount, pVar->getName()));
         mpResourceVars->addMember(pVar);
 
@@ -1452,10 +1491,350 @@ namespace Falcor
         return getShaderAttribute(name, mPsOut, "getPixelShaderOutput()");
     }
 
+    const ShaderVarHandle& ReflectionResourceType::getVariableHandle(const std::string& name) const
+    {
+        const auto& it = mVarHandles.find(name);
+        if (it != mVarHandles.end()) return it->second;
+
+        ShaderVarHandle& handle = mVarHandles[name];
+        const ReflectionVar::SharedConstPtr pVar = findMember(name);
+        if (pVar)
+        {
+            const ReflectionBasicType* pBasicType = pVar->getType()->asBasicType();
+            handle.pReflector = this;
+            handle.offset = pVar->getOffset();
+            handle.type = pBasicType ? pBasicType->getType() : ReflectionBasicType::Type::Unknown;
+        }
+        return handle;
+    }
+
     const ReflectionResourceType::OffsetDesc& ReflectionResourceType::getOffsetDesc(size_t offset) const
     {
         static const ReflectionResourceType::OffsetDesc empty;
         const auto& offsetIt = mOffsetDescMap.find(offset);
         return (offsetIt == mOffsetDescMap.end()) ? empty : offsetIt->second;
     }
+
+    /** Serializes reflection objects into a byte stream. The layout is written in a canonical order, so identical layouts generate identical data, which is what interning compares
+    */
+    class ReflectionSerializer
+    {
+    public:
+        static void write(const ProgramReflection* pReflector, std::vector<uint8_t>& blob)
+        {
+            ReflectionSerializer w;
+            w.writeU32(kVersion);
+            w.writeU32((uint32_t)pReflector->mpParameterBlocks.size());
+            for (const auto& pBlock : pReflector->mpParameterBlocks)
+            {
+                w.writeString(pBlock->getName());
+                w.writeU32((uint32_t)pBlock->mTopLevelResources.size());
+                for (const auto& pVar : pBlock->mTopLevelResources) w.writeVar(pVar.get());
+            }
+
+            w.writeU32(pReflector->mThreadGroupSize.x);
+            w.writeU32(pReflector->mThreadGroupSize.y);
+            w.writeU32(pReflector->mThreadGroupSize.z);
+            w.writeU32(pReflector->mIsSampleFrequency ? 1 : 0);
+            w.writeVarMap(pReflector->mPsOut);
+            w.writeVarMap(pReflector->mVertAttr);
+            w.writeVarMap(pReflector->mVertAttrBySemantic);
+            blob = std::move(w.mData);
+        }
+
+        static ProgramReflection::SharedPtr read(const std::vector<uint8_t>& blob)
+        {
+            ReflectionSerializer r;
+            r.mData = blob;
+            if (r.readU32() != kVersion) return nullptr;
+
+            std::string log;
+            ProgramReflection::SharedPtr pReflector = ProgramReflection::SharedPtr(new ProgramReflection(nullptr, ProgramReflection::ResourceScope::All, log));
+            uint32_t blockCount = r.readU32();
+            for (uint32_t b = 0; b < blockCount && r.mValid; b++)
+            {
+                ParameterBlockReflection::SharedPtr pBlock = ParameterBlockReflection::create(r.readString());
+                uint32_t varCount = r.readU32();
+                for (uint32_t v = 0; v < varCount && r.mValid; v++)
+                {
+                    ReflectionVar::SharedConstPtr pVar = r.readVar();
+                    if (pVar) pBlock->addResource(pVar);
+                }
+                pBlock->finalize();
+                pReflector->addParameterBlock(pBlock);
+            }
+
+            pReflector->mThreadGroupSize.x = r.readU32();
+            pReflector->mThreadGroupSize.y = r.readU32();
+            pReflector->mThreadGroupSize.z = r.readU32();
+            pReflector->mIsSampleFrequency = r.readU32() != 0;
+            r.readVarMap(pReflector->mPsOut);
+            r.readVarMap(pReflector->mVertAttr);
+            r.readVarMap(pReflector->mVertAttrBySemantic);
+
+            if (r.mValid == false || pReflector->mpDefaultBlock == nullptr) return nullptr;
+            pReflector->updateDefaultBlockResourceBindings();
+            return pReflector;
+        }
+
+    private:
+        static const uint32_t kVersion = 1;
+
+        enum class TypeTag : uint32_t
+        {
+            Basic,
+            Struct,
+            Array,
+            Resource
+        };
+
+        std::vector<uint8_t> mData;
+        size_t mReadOffset = 0;
+        bool mValid = true;
+
+        void writeU32(uint32_t v) { mData.insert(mData.end(), (const uint8_t*)&v, (const uint8_t*)&v + sizeof(v)); }
+        void writeU64(uint64_t v) { mData.insert(mData.end(), (const uint8_t*)&v, (const uint8_t*)&v + sizeof(v)); }
+        void writeString(const std::string& str)
+        {
+            writeU32((uint32_t)str.size());
+            mData.insert(mData.end(), str.begin(), str.end());
+        }
+
+        bool readBytes(void* pDst, size_t size)
+        {
+            if (mValid == false || mReadOffset + size > mData.size())
+            {
+                mValid = false;
+                return false;
+            }
+            std::memcpy(pDst, mData.data() + mReadOffset, size);
+            mReadOffset += size;
+            return true;
+        }
+
+        uint32_t readU32() { uint32_t v = 0; readBytes(&v, sizeof(v)); return v; }
+        uint64_t readU64() { uint64_t v = 0; readBytes(&v, sizeof(v)); return v; }
+        std::string readString()
+        {
+            // Check the length before allocating, corrupt data could claim gigabytes
+            uint32_t size = readU32();
+            if (mValid == false || mReadOffset + size > mData.size())
+            {
+                mValid = false;
+                return "";
+            }
+            std::string str(size, '\0');
+            if (size) readBytes(&str[0], size);
+            return str;
+        }
+
+        void writeType(const ReflectionType* pType)
+        {
+            writeU64(pType->mOffset);
+            if (const ReflectionBasicType* pBasic = pType->asBasicType())
+            {
+                writeU32((uint32_t)TypeTag::Basic);
+                writeU32((uint32_t)pBasic->getType());
+                writeU32(pBasic->isRowMajor() ? 1 : 0);
+                writeU64(pBasic->getSize());
+            }
+            else if (const ReflectionStructType* pStruct = pType->asStructType())
+            {
+                writeU32((uint32_t)TypeTag::Struct);
+                writeU64(pStruct->getSize());
+                writeString(pStruct->getName());
+                writeU32(pStruct->getMemberCount());
+                for (const auto& pMember : *pStruct) writeVar(pMember.get());
+            }
+            else if (const ReflectionArrayType* pArray = pType->asArrayType())
+            {
+                writeU32((uint32_t)TypeTag::Array);
+                writeU32(pArray->getArraySize());
+                writeU32(pArray->getArrayStride());
+                writeType(pArray->getType().get());
+            }
+            else
+            {
+                const ReflectionResourceType* pResource = pType->asResourceType();
+                assert(pResource);
+                writeU32((uint32_t)TypeTag::Resource);
+                writeU32((uint32_t)pResource->getType());
+                writeU32((uint32_t)pResource->getDimensions());
+                writeU32((uint32_t)pResource->getStructuredBufferType());
+                writeU32((uint32_t)pResource->getReturnType());
+                writeU32((uint32_t)pResource->getShaderAccess());
+                writeU32(pResource->getStructType() ? 1 : 0);
+                if (pResource->getStructType()) writeType(pResource->getStructType().get());
+            }
+        }
+
+        ReflectionType::SharedConstPtr readType()
+        {
+            size_t offset = (size_t)readU64();
+            TypeTag tag = (TypeTag)readU32();
+            if (mValid == false) return nullptr;
+
+            switch (tag)
+            {
+            case TypeTag::Basic:
+            {
+                auto type = (ReflectionBasicType::Type)readU32();
+                bool isRowMajor = readU32() != 0;
+                size_t size = (size_t)readU64();
+                return ReflectionBasicType::create(offset, type, isRowMajor, size);
+            }
+            case TypeTag::Struct:
+            {
+                size_t size = (size_t)readU64();
+                std::string name = readString();
+                ReflectionStructType::SharedPtr pStruct = ReflectionStructType::create(offset, size, name);
+                uint32_t memberCount = readU32();
+                for (uint32_t m = 0; m < memberCount && mValid; m++)
+                {
+                    ReflectionVar::SharedConstPtr pMember = readVar();
+                    if (pMember) pStruct->addMember(pMember);
+                }
+                return pStruct;
+            }
+            case TypeTag::Array:
+            {
+                uint32_t arraySize = readU32();
+                uint32_t arrayStride = readU32();
+                ReflectionType::SharedConstPtr pElement = readType();
+                return pElement ? ReflectionArrayType::create(offset, arraySize, arrayStride, pElement) : nullptr;
+            }
+            case TypeTag::Resource:
+            {
+                auto type = (ReflectionResourceType::Type)readU32();
+                auto dims = (ReflectionResourceType::Dimensions)readU32();
+                auto structuredType = (ReflectionResourceType::StructuredType)readU32();
+                auto retType = (ReflectionResourceType::ReturnType)readU32();
+                auto access = (ReflectionResourceType::ShaderAccess)readU32();
+                ReflectionResourceType::SharedPtr pResource = ReflectionResourceType::create(type, dims, structuredType, retType, access);
+                if (readU32())
+                {
+                    ReflectionType::SharedConstPtr pStruct = readType();
+                    if (pStruct) pResource->setStructType(pStruct);
+                }
+                return pResource;
+            }
+            default:
+                mValid = false;
+                return nullptr;
+            }
+        }
+
+        void writeVar(const ReflectionVar* pVar)
+        {
+            writeString(pVar->getName());
+            writeU64(pVar->getOffset());
+            writeU32(pVar->getDescOffset());
+            writeU32(pVar->getRegisterSpace());
+            writeU32((uint32_t)pVar->getModifier());
+            writeType(pVar->getType().get());
+        }
+
+        ReflectionVar::SharedConstPtr readVar()
+        {
+            std::string name = readString();
+            size_t offset = (size_t)readU64();
+            uint32_t descOffset = readU32();
+            uint32_t regSpace = readU32();
+            auto modifier = (ReflectionVar::Modifier)readU32();
+            ReflectionType::SharedConstPtr pType = readType();
+            return pType ? ReflectionVar::create(name, pType, offset, descOffset, regSpace, modifier) : nullptr;
+        }
+
+        void writeVarMap(const ProgramReflection::VariableMap& varMap)
+        {
+            // Sort by name, unordered_map iteration order isn't stable
+            std::vector<const ProgramReflection::VariableMap::value_type*> sorted;
+            for (const auto& v : varMap) sorted.push_back(&v);
+            std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+            writeU32((uint32_t)sorted.size());
+            for (const auto* pVar : sorted)
+            {
+                writeString(pVar->first);
+                writeU32(pVar->second.bindLocation);
+                writeString(pVar->second.semanticName);
+                writeU32((uint32_t)pVar->second.type);
+            }
+        }
+
+        void readVarMap(ProgramReflection::VariableMap& varMap)
+        {
+            uint32_t count = readU32();
+            for (uint32_t i = 0; i < count && mValid; i++)
+            {
+                std::string name = readString();
+                ProgramReflection::ShaderVariable& var = varMap[name];
+                var.bindLocation = readU32();
+                var.semanticName = readString();
+                var.type = (ReflectionBasicType::Type)readU32();
+            }
+        }
+    };
+
+    static uint64_t hashBlob(const std::vector<uint8_t>& blob)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (uint8_t b : blob)
+        {
+            hash ^= b;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    ProgramReflection::SharedPtr ProgramReflection::intern(const SharedPtr& pReflector)
+    {
+        struct Entry
+        {
+            std::vector<uint8_t> blob;
+            std::weak_ptr<ProgramReflection> pReflector;
+        };
+        // Reflectors are created on the hot-reload worker threads as well as the main thread
+        static std::mutex sMutex;
+        static std::unordered_map<uint64_t, std::vector<Entry>> sTable;
+
+        std::vector<uint8_t> blob;
+        pReflector->serialize(blob);
+        uint64_t hash = hashBlob(blob);
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        auto& bucket = sTable[hash];
+        for (auto it = bucket.begin(); it != bucket.end();)
+        {
+            SharedPtr pExisting = it->pReflector.lock();
+            if (pExisting == nullptr)
+            {
+                it = bucket.erase(it);
+                continue;
+            }
+            if (it->blob == blob) return pExisting;
+            ++it;
+        }
+
+        pReflector->mLayoutHash = hash;
+        bucket.push_back({ std::move(blob), pReflector });
+        return pReflector;
+    }
+
+    ProgramReflection::SharedPtr ProgramReflection::createFromBlob(const std::vector<uint8_t>& blob, bool shareInterned)
+    {
+        SharedPtr pReflector = ReflectionSerializer::read(blob);
+        if (pReflector == nullptr)
+        {
+            logError("ProgramReflection::createFromBlob() - invalid reflection data");
+            return nullptr;
+        }
+        return shareInterned ? intern(pReflector) : pReflector;
+    }
+
+    void ProgramReflection::serialize(std::vector<uint8_t>& blob) const
+    {
+        ReflectionSerializer::write(this, blob);
+    }
 }
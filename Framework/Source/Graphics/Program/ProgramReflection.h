@@ -39,6 +39,7 @@ namespace Falcor
     class ReflectionBasicType;
     class ReflectionStructType;
     class ReflectionArrayType;
+    class ReflectionSerializer;
 
     /** Base class for reflection types
     */
@@ -88,6 +89,7 @@ namespace Falcor
         virtual bool operator==(const ReflectionType& other) const = 0;
         virtual bool operator!=(const ReflectionType& other) const { return !(*this == other); }
     protected:
+        friend class ReflectionSerializer;
         ReflectionType(size_t offset) : mOffset(offset) {}
         size_t mOffset;
     };
@@ -272,6 +274,26 @@ namespace Falcor
         virtual std::shared_ptr<const ReflectionVar> findMemberInternal(const std::string& name, size_t strPos, size_t offset, uint32_t regIndex, uint32_t regSpace, uint32_t descOffset) const override;
     };
 
+    /** A shader variable resolved once against a reflection object.
+        Looking up a variable by name parses the name and allocates a new ReflectionVar for every array element or struct member along the way. A handle stores the result of that lookup, so setting the variable through it is a direct offset or bind-location access.
+        Handles are cached by the reflection object which resolved them and are only valid for buffers and blocks created from that reflection.
+    */
+    struct ShaderVarHandle
+    {
+        static const size_t kInvalidOffset = -1;
+        static const uint32_t kInvalidIndex = -1;
+
+        const void* pReflector = nullptr;                                       ///< The reflection object the handle was resolved against, or nullptr if the variable wasn't found
+        size_t offset = kInvalidOffset;                                         ///< Buffer variables only. The byte offset of the variable inside the buffer
+        ReflectionBasicType::Type type = ReflectionBasicType::Type::Unknown;    ///< Buffer variables only. The basic type of the variable, or Unknown for structs
+        const ReflectionResourceType* pResourceType = nullptr;                  ///< Resources only. The resource type
+        uint32_t setIndex = kInvalidIndex;                                      ///< Resources only. The set-index in the parameter-block
+        uint32_t rangeIndex = kInvalidIndex;                                    ///< Resources only. The range-index in the selected set
+        uint32_t descOffset = 0;                                                ///< Resources only. The array index inside the range
+
+        bool isValid() const { return pReflector != nullptr; }
+    };
+
     /** Reflection object for resources
     */
     class ReflectionResourceType : public ReflectionType, public inherit_shared_from_this<ReflectionType, ReflectionResourceType>
@@ -392,6 +414,11 @@ namespace Falcor
         */
         const OffsetDesc& getOffsetDesc(size_t offset) const;
 
+        /** For structured- and constant-buffers, get a handle to a variable in the buffer. The name follows the same rules as findMember().
+            The result is cached, so only the first call for each name walks the reflection. If the variable doesn't exist, the returned handle is invalid
+        */
+        const ShaderVarHandle& getVariableHandle(const std::string& name) const;
+
         bool operator==(const ReflectionResourceType& other) const;
         bool operator==(const ReflectionType& other) const override;
     private:
@@ -403,6 +430,7 @@ namespace Falcor
         Type mType;
         ReflectionType::SharedConstPtr mpStructType;   // For constant- and structured-buffers
         OffsetDescMap mOffsetDescMap;
+        mutable std::unordered_map<std::string, ShaderVarHandle> mVarHandles;
 
         virtual std::shared_ptr<const ReflectionVar> findMemberInternal(const std::string& name, size_t strPos, size_t offset, uint32_t regIndex, uint32_t regSpace, uint32_t descOffset) const override;
     };
@@ -533,6 +561,10 @@ namespace Falcor
         */
         BindLocation getResourceBinding(const std::string& name) const;
 
+        /** Get a handle to a resource in the block. The result is cached, so only the first call for each name walks the reflection. If the resource doesn't exist, the returned handle is invalid
+        */
+        const ShaderVarHandle& getResourceHandle(const std::string& name) const;
+
         /** Get a vector with all the resources in the block
         */
         const ResourceVec& getResourceVec() const { return mResources; }
@@ -547,13 +579,16 @@ namespace Falcor
         bool merge(const ParameterBlockReflection* pOther);
     private:
         friend class ProgramReflection;
+        friend class ReflectionSerializer;
         void addResource(const ReflectionVar::SharedConstPtr& pVar);
         void finalize();
         ParameterBlockReflection(const std::string& name);
+        std::vector<ReflectionVar::SharedConstPtr> mTopLevelResources;  // The variables passed to addResource(). Everything else in the block is derived from them
         ResourceVec mResources;
         ReflectionStructType::SharedPtr mpResourceVars;
         std::string mName;
         std::unordered_map<std::string, BindLocation> mResourceBindings;
+        mutable std::unordered_map<std::string, ShaderVarHandle> mResourceHandles;
 
         SetLayoutVec mSetLayouts;
     };
@@ -586,10 +621,26 @@ namespace Falcor
             All = 0xFFFFFFFF
         };
 
-        /** Create a new object for a Slang reflector object
+        /** Create a new object for a Slang reflector object.
+            Reflectors are interned by their layout, so permutations with identical layouts share the same object. An object created from a nullptr reflector is empty, used for merging, and is never shared
         */
         static SharedPtr create(slang::ShaderReflection* pSlangReflector, ResourceScope scopeToReflect, std::string& log);
 
+        /** Create a new object from data generated by serialize(). The object is interned the same way as objects created from Slang reflection
+            \param[in] blob The serialized data
+            \param[in] shareInterned If false, a new object is always returned. Used to validate the data against the reflector it was generated from
+            \return A new object, or nullptr if the data is invalid
+        */
+        static SharedPtr createFromBlob(const std::vector<uint8_t>& blob, bool shareInterned = true);
+
+        /** Serialize the reflection data, for storing it alongside compiled shaders
+        */
+        void serialize(std::vector<uint8_t>& blob) const;
+
+        /** Get a hash of the layout. Interned reflectors with the same hash are the same object
+        */
+        uint64_t getLayoutHash() const { return mLayoutHash; }
+
         /** Get the index of a parameter block
         */
         uint32_t getParameterBlockIndex(const std::string& name) const;
@@ -650,10 +701,14 @@ namespace Falcor
 
         bool merge(const ProgramReflection* pOther);
     private:
+        friend class ReflectionSerializer;
         ProgramReflection(slang::ShaderReflection* pSlangReflector, ResourceScope scopeToReflect, std::string& log);
+        static SharedPtr intern(const SharedPtr& pReflector);
         void addParameterBlock(const ParameterBlockReflection::SharedConstPtr& pBlock);
         void updateDefaultBlockResourceBindings();
 
+        uint64_t mLayoutHash = 0;
+
         std::vector<ParameterBlockReflection::SharedConstPtr> mpParameterBlocks;
         std::unordered_map<std::string, size_t> mParameterBlocksIndices;
 
@@ -0,0 +1,347 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShaderArchive.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Platform/OS.h"
+
+namespace Falcor
+{
+    static const uint32_t kArchiveMagic = 0x52415346;  // 'FSAR'
+    static const uint32_t kArchiveVersion = 3;
+
+#ifdef FALCOR_VK
+    static const uint32_t kArchiveApi = 1;
+#elif defined FALCOR_D3D12
+    static const uint32_t kArchiveApi = 0;
+#endif
+
+    static ShaderArchive::SharedConstPtr& activeArchive()
+    {
+        static ShaderArchive::SharedConstPtr pArchive;
+        return pArchive;
+    }
+
+    // FNV-1a
+    static void hashBytes(uint64_t& hash, const uint8_t* pData, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pData[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    static uint64_t hashBlob(const Shader::Blob& blob)
+    {
+        // The code, the type and the shader model
+        uint64_t hash = 14695981039346656037ull;
+        hashBytes(hash, blob.data.data(), blob.data.size());
+        hashBytes(hash, (const uint8_t*)&blob.type, sizeof(blob.type));
+        hashBytes(hash, (const uint8_t*)blob.shaderModel.data(), blob.shaderModel.size());
+        return hash;
+    }
+
+    static uint64_t hashBlob(const ShaderArchive::ReflectionBlob& blob)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hashBytes(hash, blob.data(), blob.size());
+        return hash;
+    }
+
+    ShaderArchive::SharedPtr ShaderArchive::create()
+    {
+        return SharedPtr(new ShaderArchive());
+    }
+
+    ShaderArchive::SharedPtr ShaderArchive::createFromFile(const std::string& filename)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("Can't find shader archive file " + filename);
+            return nullptr;
+        }
+
+        BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+        uint32_t magic = 0, version = 0, api = 0, blobCount = 0, reflectionCount = 0, dependencyCount = 0, permutationCount = 0;
+        stream >> magic >> version >> api >> blobCount >> reflectionCount >> dependencyCount >> permutationCount;
+        if (stream.isFail() || magic != kArchiveMagic || version != kArchiveVersion)
+        {
+            logError("File " + filename + " is not a valid shader archive");
+            return nullptr;
+        }
+        if (api != kArchiveApi)
+        {
+            logError("Shader archive " + filename + " was generated for a different graphics API");
+            return nullptr;
+        }
+
+        SharedPtr pArchive = create();
+        pArchive->mBlobs.resize(blobCount);
+        for (uint32_t i = 0; i < blobCount; i++)
+        {
+            Shader::Blob& blob = pArchive->mBlobs[i];
+            uint32_t type = 0, smLength = 0, dataSize = 0;
+            stream >> type >> smLength;
+            blob.type = (Shader::Blob::Type)type;
+            blob.shaderModel.resize(smLength);
+            stream.read(&blob.shaderModel[0], smLength);
+            stream >> dataSize;
+            blob.data.resize(dataSize);
+            stream.read(blob.data.data(), dataSize);
+            pArchive->mBlobLookup[hashBlob(blob)].push_back(i);
+        }
+
+        pArchive->mReflections.resize(reflectionCount);
+        for (uint32_t i = 0; i < reflectionCount; i++)
+        {
+            ReflectionBlob& blob = pArchive->mReflections[i];
+            uint32_t size = 0;
+            stream >> size;
+            blob.resize(size);
+            stream.read(blob.data(), size);
+            pArchive->mReflectionLookup[hashBlob(blob)].push_back(i);
+        }
+
+        pArchive->mDependencies.resize(dependencyCount);
+        for (uint32_t i = 0; i < dependencyCount; i++)
+        {
+            Dependency& d = pArchive->mDependencies[i];
+            uint32_t length = 0;
+            stream >> length;
+            d.file.resize(length);
+            stream.read(&d.file[0], length);
+            stream >> d.hash;
+            pArchive->mDependencyLookup[d.file] = i;
+        }
+
+        for (uint32_t i = 0; i < permutationCount; i++)
+        {
+            uint64_t key = 0;
+            uint32_t count = 0;
+            Permutation p;
+            stream >> key;
+            stream.read(p.blob, sizeof(p.blob));
+            stream.read(p.reflection, sizeof(p.reflection));
+            stream >> count;
+            if (stream.isFail()) break;
+            p.dependencies.resize(count);
+            stream.read(p.dependencies.data(), count * sizeof(uint32_t));
+            for (uint32_t d : p.dependencies)
+            {
+                if (d >= dependencyCount)
+                {
+                    logError("Shader archive " + filename + " is corrupted");
+                    return nullptr;
+                }
+            }
+            pArchive->mPermutations[key] = std::move(p);
+        }
+
+        if (stream.isFail())
+        {
+            logError("Shader archive " + filename + " is truncated");
+            return nullptr;
+        }
+        return pArchive;
+    }
+
+    bool ShaderArchive::writeToFile(const std::string& filename) const
+    {
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kArchiveMagic << kArchiveVersion << kArchiveApi << (uint32_t)mBlobs.size() << (uint32_t)mReflections.size() << (uint32_t)mDependencies.size() << (uint32_t)mPermutations.size();
+
+        for (const auto& blob : mBlobs)
+        {
+            stream << (uint32_t)blob.type << (uint32_t)blob.shaderModel.size();
+            stream.write(blob.shaderModel.data(), blob.shaderModel.size());
+            stream << (uint32_t)blob.data.size();
+            stream.write(blob.data.data(), blob.data.size());
+        }
+
+        for (const auto& blob : mReflections)
+        {
+            stream << (uint32_t)blob.size();
+            stream.write(blob.data(), blob.size());
+        }
+
+        for (const auto& d : mDependencies)
+        {
+            stream << (uint32_t)d.file.size();
+            stream.write(d.file.data(), d.file.size());
+            stream << d.hash;
+        }
+
+        for (const auto& p : mPermutations)
+        {
+            stream << p.first;
+            stream.write(p.second.blob, sizeof(p.second.blob));
+            stream.write(p.second.reflection, sizeof(p.second.reflection));
+            stream << (uint32_t)p.second.dependencies.size();
+            stream.write(p.second.dependencies.data(), p.second.dependencies.size() * sizeof(uint32_t));
+        }
+
+        if (stream.isFail())
+        {
+            logError("Failed to write shader archive " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    static bool operator==(const Shader::Blob& a, const Shader::Blob& b)
+    {
+        return a.type == b.type && a.shaderModel == b.shaderModel && a.data == b.data;
+    }
+
+    template<typename BlobType>
+    static uint32_t addBlob(const BlobType& blob, std::vector<BlobType>& blobs, std::unordered_map<uint64_t, std::vector<uint32_t>>& lookup, bool& isDuplicate)
+    {
+        auto& candidates = lookup[hashBlob(blob)];
+        for (uint32_t c : candidates)
+        {
+            if (blobs[c] == blob)
+            {
+                isDuplicate = true;
+                return c;
+            }
+        }
+
+        isDuplicate = false;
+        candidates.push_back((uint32_t)blobs.size());
+        blobs.push_back(blob);
+        return candidates.back();
+    }
+
+    size_t ShaderArchive::addPermutation(uint64_t key, const Shader::Blob shaderBlob[kShaderCount], const ReflectionBlob reflection[kReflectorCount], const DependencyList& dependencies)
+    {
+        size_t savedBytes = 0;
+        Permutation p;
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            p.blob[i] = kInvalidBlob;
+            const Shader::Blob& blob = shaderBlob[i];
+            if (blob.data.empty()) continue;
+
+            bool isDuplicate;
+            p.blob[i] = addBlob(blob, mBlobs, mBlobLookup, isDuplicate);
+            if (isDuplicate) savedBytes += blob.data.size();
+        }
+
+        for (uint32_t i = 0; i < kReflectorCount; i++)
+        {
+            bool isDuplicate;
+            p.reflection[i] = addBlob(reflection[i], mReflections, mReflectionLookup, isDuplicate);
+            if (isDuplicate) savedBytes += reflection[i].size();
+        }
+
+        for (const auto& d : dependencies)
+        {
+            auto it = mDependencyLookup.find(d.file);
+            if (it == mDependencyLookup.end())
+            {
+                it = mDependencyLookup.insert(std::make_pair(d.file, (uint32_t)mDependencies.size())).first;
+                mDependencies.push_back(d);
+            }
+            else if (mDependencies[it->second].hash != d.hash)
+            {
+                logWarning("ShaderArchive::addPermutation() - file " + d.file + " changed while the archive was generated");
+            }
+            p.dependencies.push_back(it->second);
+        }
+        mPermutations[key] = std::move(p);
+        return savedBytes;
+    }
+
+    bool ShaderArchive::hashFile(const std::string& fullpath, uint64_t& hash)
+    {
+        std::string content;
+        if (readFileToString(fullpath, content) == false) return false;
+        hash = 14695981039346656037ull;
+        hashBytes(hash, (const uint8_t*)content.data(), content.size());
+        return true;
+    }
+
+    bool ShaderArchive::isDependencyCurrent(uint32_t dependency, std::string& fullpath) const
+    {
+        const Dependency& d = mDependencies[dependency];
+        if (findFileInDataDirectories(d.file, fullpath) == false) return false;
+
+        time_t modifiedTime = getFileModifiedTime(fullpath);
+        std::lock_guard<std::mutex> lock(mDependencyStatusMutex);
+        auto it = mDependencyStatus.find(dependency);
+        if (it != mDependencyStatus.end() && it->second.modifiedTime == modifiedTime)
+        {
+            return it->second.current;
+        }
+
+        uint64_t hash;
+        bool current = hashFile(fullpath, hash) && hash == d.hash;
+        mDependencyStatus[dependency] = { modifiedTime, current };
+        return current;
+    }
+
+    bool ShaderArchive::findPermutation(uint64_t key, Shader::Blob shaderBlob[kShaderCount], ReflectionBlob reflection[kReflectorCount], std::vector<std::string>& dependencies) const
+    {
+        auto it = mPermutations.find(key);
+        if (it == mPermutations.end()) return false;
+
+        // The key only identifies the sources by name. If one of the files was edited, the permutation is compiled from source
+        std::vector<std::string> fullpaths;
+        for (uint32_t d : it->second.dependencies)
+        {
+            std::string fullpath;
+            if (isDependencyCurrent(d, fullpath) == false) return false;
+            fullpaths.push_back(fullpath);
+        }
+        dependencies = std::move(fullpaths);
+
+        for (uint32_t i = 0; i < kShaderCount; i++)
+        {
+            uint32_t b = it->second.blob[i];
+            shaderBlob[i] = (b == kInvalidBlob) ? Shader::Blob() : mBlobs[b];
+        }
+
+        for (uint32_t i = 0; i < kReflectorCount; i++)
+        {
+            reflection[i] = mReflections[it->second.reflection[i]];
+        }
+        return true;
+    }
+
+    void ShaderArchive::setActive(const SharedConstPtr& pArchive)
+    {
+        activeArchive() = pArchive;
+    }
+
+    const ShaderArchive::SharedConstPtr& ShaderArchive::getActive()
+    {
+        return activeArchive();
+    }
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Shader.h"
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+
+namespace Falcor
+{
+    /** A packed archive of precompiled program permutations, with their serialized reflection.
+        Generated offline by the ShaderPrecompiler utility. When an archive is active, programs take the code and reflection of permutations found in the archive instead of running Slang and the downstream compiler.
+        Identical blobs are stored once, so permutations which generate the same code or layout (for example, when a define doesn't affect a stage) share the data.
+        Each permutation records the content hash of the files it was compiled from, including the included files. A permutation whose sources changed since the archive was generated is not used.
+    */
+    class ShaderArchive
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ShaderArchive>;
+        using SharedConstPtr = std::shared_ptr<const ShaderArchive>;
+        static const uint32_t kShaderCount = (uint32_t)ShaderType::Count;
+        static const uint32_t kReflectorCount = 3;  ///< The reflection of each permutation, for the All, Local and Global resource scopes
+        using ReflectionBlob = std::vector<uint8_t>;
+
+        /** A source file a permutation was compiled from
+        */
+        struct Dependency
+        {
+            std::string file;   ///< The path relative to the data directories, see stripDataDirectories()
+            uint64_t hash;      ///< The content hash, from hashFile()
+        };
+        using DependencyList = std::vector<Dependency>;
+
+        /** Create an empty archive
+        */
+        static SharedPtr create();
+
+        /** Load an archive from a file
+            \param[in] filename The archive file. Searched for in the data directories
+            \return A new object, or nullptr if the file doesn't exist or isn't a valid archive for the current graphics API
+        */
+        static SharedPtr createFromFile(const std::string& filename);
+
+        /** Write the archive into a file
+            \return true if the file was written, otherwise false
+        */
+        bool writeToFile(const std::string& filename) const;
+
+        /** Add a permutation. Stages with an empty blob are treated as unused
+            \param[in] key The permutation key, from Program::getPermutationKey()
+            \param[in] shaderBlob The code of each stage
+            \param[in] reflection The serialized reflection, from ProgramReflection::serialize()
+            \param[in] dependencies The files the permutation was compiled from
+            \return The number of bytes which were not added because an identical blob already exists in the archive
+        */
+        size_t addPermutation(uint64_t key, const Shader::Blob shaderBlob[kShaderCount], const ReflectionBlob reflection[kReflectorCount], const DependencyList& dependencies);
+
+        /** Find a permutation
+            \param[in] key The permutation key, from Program::getPermutationKey()
+            \param[out] shaderBlob If the permutation was found, the code of each stage
+            \param[out] reflection If the permutation was found, the serialized reflection
+            \param[out] dependencies If the permutation was found, the full paths of the files it was compiled from, including the included files
+            \return true if the permutation was found and none of its source files changed, otherwise false
+        */
+        bool findPermutation(uint64_t key, Shader::Blob shaderBlob[kShaderCount], ReflectionBlob reflection[kReflectorCount], std::vector<std::string>& dependencies) const;
+
+        /** Get the number of permutations
+        */
+        size_t getPermutationCount() const { return mPermutations.size(); }
+
+        /** Get the number of unique shader blobs
+        */
+        size_t getBlobCount() const { return mBlobs.size(); }
+
+        /** Get the number of unique reflection blobs
+        */
+        size_t getReflectionCount() const { return mReflections.size(); }
+
+        /** Set the archive used by programs when creating new versions. Pass nullptr to always compile from source
+        */
+        static void setActive(const SharedConstPtr& pArchive);
+
+        /** Get the active archive. Can be nullptr
+        */
+        static const SharedConstPtr& getActive();
+
+        /** Hash the content of a file
+            \param[in] fullpath The file
+            \param[out] hash On success, the hash
+            \return false if the file can't be read
+        */
+        static bool hashFile(const std::string& fullpath, uint64_t& hash);
+
+    private:
+        ShaderArchive() = default;
+
+        static const uint32_t kInvalidBlob = uint32_t(-1);
+
+        struct Permutation
+        {
+            uint32_t blob[kShaderCount];            ///< Index into mBlobs for each stage, or kInvalidBlob if the stage is unused
+            uint32_t reflection[kReflectorCount];   ///< Index into mReflections
+            std::vector<uint32_t> dependencies;     ///< Indices into mDependencies
+        };
+
+        bool isDependencyCurrent(uint32_t dependency, std::string& fullpath) const;
+
+        std::vector<Shader::Blob> mBlobs;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> mBlobLookup;  ///< Content hash -> indices of the blobs with that hash
+        std::vector<ReflectionBlob> mReflections;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> mReflectionLookup;
+        std::unordered_map<uint64_t, Permutation> mPermutations;
+        DependencyList mDependencies;
+        std::unordered_map<std::string, uint32_t> mDependencyLookup;   ///< File -> index into mDependencies
+
+        // Checking a file requires hashing it, so the result is cached until the file's modification time changes
+        struct DependencyStatus
+        {
+            time_t modifiedTime;
+            bool current;
+        };
+        mutable std::unordered_map<uint32_t, DependencyStatus> mDependencyStatus;
+        mutable std::mutex mDependencyStatusMutex;
+    };
+}
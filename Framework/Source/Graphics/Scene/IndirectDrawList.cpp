@@ -0,0 +1,440 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "IndirectDrawList.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Material/MaterialTable.h"
+#include "Graphics/Camera/Camera.h"
+#include "API/RenderContext.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Falcor
+{
+    static const char* kCullShaderFilename = "Data/Framework/Shaders/CullInstances.cs.slang";
+    static const char* kHiZShaderFilename = "Data/Framework/Shaders/BuildHiZ.cs.slang";
+
+    static const char* kInstancesName = "gIndirectInstances";
+    static const char* kVisibleName = "gVisibleInstances";
+    static const char* kTransformsName = "gTransformNodes";
+
+    static const uint32_t kCullGroupSize = 64;  // Must match CullInstances.cs.slang
+    static const uint32_t kHiZGroupSize = 8;    // Must match BuildHiZ.cs.slang
+
+    IndirectDrawList::SharedPtr IndirectDrawList::create()
+    {
+        SharedPtr pList = SharedPtr(new IndirectDrawList());
+        return pList->init() ? pList : nullptr;
+    }
+
+    bool IndirectDrawList::init()
+    {
+        mCullPass.pProgram = ComputeProgram::createFromFile(kCullShaderFilename, "main");
+        mHiZPass.pProgram = ComputeProgram::createFromFile(kHiZShaderFilename, "main");
+        if (mCullPass.pProgram == nullptr || mHiZPass.pProgram == nullptr)
+        {
+            logError("IndirectDrawList - failed to create the culling programs");
+            return false;
+        }
+
+        for (auto* pPass : { &mCullPass, &mHiZPass })
+        {
+            pPass->pVars = ComputeVars::create(pPass->pProgram->getReflector());
+            pPass->pState = ComputeState::create();
+            pPass->pState->setProgram(pPass->pProgram);
+        }
+        return true;
+    }
+
+    bool IndirectDrawList::isStale(Scene* pScene, const MaterialTable* pMaterialTable)
+    {
+        if (pScene->getStructureVersion() != mStructureVersion) return true;
+        if (pMaterialTable != mpMaterialTable) return true;
+        if (pMaterialTable && pMaterialTable->getIndexVersion() != mMaterialTableVersion) return true;
+
+        // The visibility counters are global, so a change in another scene rebuilds the list as well. That's rare and keeps this check O(1)
+        return Scene::ModelInstance::getVisibilityVersion() != mModelVisibilityVersion || Model::MeshInstance::getVisibilityVersion() != mMeshVisibilityVersion;
+    }
+
+    bool IndirectDrawList::update(Scene* pScene, const MaterialTable* pMaterialTable)
+    {
+        if (isStale(pScene, pMaterialTable) == false) return false;
+        rebuild(pScene, pMaterialTable);
+        return true;
+    }
+
+    void IndirectDrawList::rebuild(Scene* pScene, const MaterialTable* pMaterialTable)
+    {
+        mStructureVersion = pScene->getStructureVersion();
+        mpMaterialTable = pMaterialTable;
+        mMaterialTableVersion = pMaterialTable ? pMaterialTable->getIndexVersion() : 0;
+        mModelVisibilityVersion = Scene::ModelInstance::getVisibilityVersion();
+        mMeshVisibilityVersion = Model::MeshInstance::getVisibilityVersion();
+
+        mDraws.clear();
+        mInstances.clear();
+        std::vector<uint32_t> args;
+
+        auto addDraw = [&](Draw& draw)
+        {
+            if (draw.instanceCount == 0) return;
+            // The instance count is written by the culling pass. Meshes packed into a GeometryArena are drawn from their range of the shared buffers
+            uint32_t drawArgs[] = { draw.pMesh->getIndexCount(), 0, draw.pMesh->getStartIndex(), (uint32_t)draw.pMesh->getBaseVertex(), 0 };
+            args.insert(args.end(), std::begin(drawArgs), std::end(drawArgs));
+            mDraws.push_back(draw);
+        };
+
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+
+                Draw draw;
+                draw.pModel = pModel;
+                draw.pMesh = pMesh;
+                draw.modelID = modelID;
+                draw.meshID = meshID;
+                // Same rules as SceneRenderer::renderMeshInstances()
+                draw.useVsSkinning = pMesh->hasBones() && (!pModel->getSkinningCache() || pModel->hasInstancedAnimation());
+                draw.pVao = draw.useVsSkinning ? pMesh->getVao() : pModel->getMeshVao(pMesh);
+
+                // The bones of models with per-instance animation are set per model instance, so each model instance needs its own draw
+                bool drawPerModelInstance = draw.useVsSkinning && pModel->hasInstancedAnimation();
+
+                uint32_t materialIndex = pMaterialTable ? pMaterialTable->getMaterialIndex(pMesh->getMaterial().get()) : 0;
+                if (materialIndex == MaterialTable::kInvalidIndex) materialIndex = 0;
+
+                draw.visibleBase = (uint32_t)mInstances.size();
+                for (uint32_t modelInstanceID = 0; modelInstanceID < pScene->getModelInstanceCount(modelID); modelInstanceID++)
+                {
+                    if (pScene->getModelInstance(modelID, modelInstanceID)->isVisible() == false) continue;
+
+                    if (drawPerModelInstance)
+                    {
+                        draw.modelInstanceID = modelInstanceID;
+                        draw.visibleBase = (uint32_t)mInstances.size();
+                        draw.instanceCount = 0;
+                    }
+
+                    for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, i).get();
+                        if (pMeshInstance->isVisible() == false) continue;
+
+                        // The transform node of skinned meshes doesn't include the mesh instance transform. See SceneRenderer::getMeshInstanceBounds()
+                        const BoundingBox& bounds = pMesh->hasBones() ? pMeshInstance->getBoundingBox() : pMesh->getBoundingBox();
+
+                        IndirectInstanceData instance;
+                        instance.boundsCenter = bounds.center;
+                        instance.boundsExtent = bounds.extent;
+                        instance.transformNode = pScene->getMeshInstanceTransformId(modelID, modelInstanceID, meshID, i);
+                        instance.drawIndex = (uint32_t)mDraws.size();
+                        instance.visibleBase = draw.visibleBase;
+                        instance.materialIndex = materialIndex;
+                        instance.drawId = (uint32_t)mInstances.size();
+                        mInstances.push_back(instance);
+                        draw.instanceCount++;
+                    }
+
+                    if (drawPerModelInstance) addDraw(draw);
+                }
+                if (drawPerModelInstance == false) addDraw(draw);
+            }
+        }
+
+        // Upload. Buffers are never empty, so that they can always be bound
+        uint32_t instanceCount = std::max(1u, (uint32_t)mInstances.size());
+        if (mpInstanceBuffer == nullptr || mpInstanceBuffer->getElementCount() < instanceCount)
+        {
+            mpInstanceBuffer = StructuredBuffer::create(mCullPass.pProgram, "gInstances", instanceCount, Resource::BindFlags::ShaderResource);
+            assert(mpInstanceBuffer->getElementSize() == sizeof(IndirectInstanceData));
+            mpVisibleBuffer = Buffer::create(instanceCount * sizeof(uint32_t), Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess, Buffer::CpuAccess::None);
+        }
+        if (mInstances.size())
+        {
+            mpInstanceBuffer->setBlob(mInstances.data(), 0, mInstances.size() * sizeof(IndirectInstanceData));
+        }
+
+        if (args.empty()) args.resize(kDrawArgsSize / sizeof(uint32_t), 0);
+        size_t argsSize = args.size() * sizeof(uint32_t);
+        mpInitialArgBuffer = Buffer::create(argsSize, Resource::BindFlags::None, Buffer::CpuAccess::None, args.data());
+        if (mpArgBuffer == nullptr || mpArgBuffer->getSize() < argsSize)
+        {
+            mpArgBuffer = Buffer::create(argsSize, Resource::BindFlags::IndirectArg | Resource::BindFlags::UnorderedAccess, Buffer::CpuAccess::None);
+        }
+    }
+
+    // Same as Camera::calculateCameraParameters(). A point p is inside a plane if dot(p, plane.xyz) > -plane.w
+    static void extractFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+    {
+        glm::mat4 tempMat = glm::transpose(viewProj);
+        for (int i = 0; i < 6; i++)
+        {
+            planes[i] = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+            if (i != 5)
+            {
+                planes[i] += tempMat[3];
+            }
+        }
+    }
+
+    void IndirectDrawList::setCullData(const Camera* pCamera)
+    {
+        glm::vec4 planes[6];
+        extractFrustumPlanes(pCamera->getViewProjMatrix(), planes);
+
+        ConstantBuffer* pCB = mCullPass.pVars->getConstantBuffer("CullCB").get();
+        pCB->setVariableArray("gFrustumPlanes", planes, 6);
+        pCB->setVariable("gPrevViewProjMat", pCamera->getData().prevViewProjMat);
+        pCB->setVariable("gInstanceCount", (uint32_t)mInstances.size());
+        pCB->setVariable("gHiZMipCount", mpHiZ ? mpHiZ->getMipCount() : 0u);
+        pCB->setVariable("gHiZSize", mpHiZ ? vec2(mpHiZ->getWidth(), mpHiZ->getHeight()) : vec2(0));
+
+        mCullPass.pVars->setStructuredBuffer("gInstances", mpInstanceBuffer);
+        mCullPass.pVars->setRawBuffer("gTransformNodes", mpTransformBuffer);
+        mCullPass.pVars->setRawBuffer("gDrawArgs", mpArgBuffer);
+        mCullPass.pVars->setRawBuffer("gVisibleInstances", mpVisibleBuffer);
+        mCullPass.pVars->setTexture("gHiZ", mpHiZ);
+    }
+
+    void IndirectDrawList::cull(RenderContext* pContext, const Camera* pCamera, const Buffer::SharedPtr& pTransformBuffer)
+    {
+        mpTransformBuffer = pTransformBuffer;
+        if (mpArgBuffer == nullptr) return;
+
+        // The argument buffer is only reallocated when it grows, so it can be larger than the initial arguments
+        pContext->copyBufferRegion(mpArgBuffer.get(), 0, mpInitialArgBuffer.get(), 0, mpInitialArgBuffer->getSize());
+        if (mInstances.empty()) return;
+
+        setCullData(pCamera);
+        pContext->pushComputeState(mCullPass.pState);
+        pContext->pushComputeVars(mCullPass.pVars);
+        pContext->dispatch(((uint32_t)mInstances.size() + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+        pContext->popComputeVars();
+        pContext->popComputeState();
+    }
+
+    void IndirectDrawList::buildHiZ(RenderContext* pContext, const Texture::SharedPtr& pDepth)
+    {
+        assert(pDepth->getSampleCount() == 1);
+        uint32_t width = pDepth->getWidth();
+        uint32_t height = pDepth->getHeight();
+        if (mpHiZ == nullptr || mpHiZ->getWidth() != width || mpHiZ->getHeight() != height)
+        {
+            mpHiZ = Texture::create2D(width, height, ResourceFormat::R32Float, 1, Texture::kMaxPossible, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+        }
+
+        const ParameterBlockReflection* pReflector = mHiZPass.pProgram->getReflector()->getDefaultParameterBlock().get();
+        ParameterBlockReflection::BindLocation srcLoc = pReflector->getResourceBinding("gSrc");
+        ParameterBlockReflection::BindLocation dstLoc = pReflector->getResourceBinding("gDst");
+        ParameterBlock* pBlock = mHiZPass.pVars->getDefaultBlock().get();
+        ConstantBuffer* pCB = mHiZPass.pVars->getConstantBuffer("HiZCB").get();
+
+        pContext->pushComputeState(mHiZPass.pState);
+        pContext->pushComputeVars(mHiZPass.pVars);
+        // Mip 0 is a copy of the depth buffer, each following mip reduces the previous one
+        for (uint32_t mip = 0; mip < mpHiZ->getMipCount(); mip++)
+        {
+            const Texture* pSrc = mip ? mpHiZ.get() : pDepth.get();
+            uint32_t srcMip = mip ? mip - 1 : 0;
+            uvec2 srcSize(pSrc->getWidth(srcMip), pSrc->getHeight(srcMip));
+            uvec2 dstSize(mpHiZ->getWidth(mip), mpHiZ->getHeight(mip));
+
+            pCB->setVariable("gSrcSize", srcSize);
+            pCB->setVariable("gDstSize", dstSize);
+            pBlock->setSrv(srcLoc, 0, pSrc->getSRV(srcMip, 1));
+            pBlock->setUav(dstLoc, 0, mpHiZ->getUAV(mip));
+            pContext->dispatch((dstSize.x + kHiZGroupSize - 1) / kHiZGroupSize, (dstSize.y + kHiZGroupSize - 1) / kHiZGroupSize, 1);
+        }
+        pContext->popComputeVars();
+        pContext->popComputeState();
+    }
+
+    bool IndirectDrawList::isDeclared(const ProgramVars* pVars)
+    {
+        return pVars->getReflection()->getDefaultParameterBlock()->getResource(kInstancesName) != nullptr;
+    }
+
+    bool IndirectDrawList::setIntoProgramVars(ProgramVars* pVars)
+    {
+        if (isDeclared(pVars) == false)
+        {
+            logWarning("IndirectDrawList::setIntoProgramVars() - the program doesn't declare the indirect-draw resources. Compile it with _INDIRECT_DRAW");
+            return false;
+        }
+        pVars->setStructuredBuffer(kInstancesName, mpInstanceBuffer);
+        pVars->setRawBuffer(kVisibleName, mpVisibleBuffer);
+        pVars->setRawBuffer(kTransformsName, mpTransformBuffer);
+        return true;
+    }
+
+    /** CPU emulation of CullInstances.cs.slang
+    */
+    class CpuCuller
+    {
+    public:
+        CpuCuller(const Camera* pCamera, const Texture* pHiZ, RenderContext* pContext) : mPrevViewProj(pCamera->getData().prevViewProjMat)
+        {
+            extractFrustumPlanes(pCamera->getViewProjMatrix(), mPlanes);
+            if (pHiZ)
+            {
+                mHiZSize = vec2(pHiZ->getWidth(), pHiZ->getHeight());
+                mHiZMips.resize(pHiZ->getMipCount());
+                for (uint32_t mip = 0; mip < pHiZ->getMipCount(); mip++)
+                {
+                    std::vector<uint8> data = pContext->readTextureSubresource(pHiZ, pHiZ->getSubresourceIndex(0, mip));
+                    mHiZMips[mip].resize(data.size() / sizeof(float));
+                    std::memcpy(mHiZMips[mip].data(), data.data(), data.size());
+                }
+            }
+        }
+
+        bool isVisible(const BoundingBox& box) const
+        {
+            if (isFrustumCulled(box)) return false;
+            return mHiZMips.empty() || isOccluded(box) == false;
+        }
+
+    private:
+        bool isFrustumCulled(const BoundingBox& box) const
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                glm::vec3 n = glm::vec3(mPlanes[i]);
+                glm::vec3 signedExtent = box.extent * glm::sign(n);
+                if (glm::dot(box.center + signedExtent, n) <= -mPlanes[i].w) return true;
+            }
+            return false;
+        }
+
+        bool isOccluded(const BoundingBox& box) const
+        {
+            glm::vec3 ndcMin(1);
+            glm::vec3 ndcMax(-1);
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                glm::vec3 corner = box.center + box.extent * glm::vec3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+                glm::vec4 posH = mPrevViewProj * glm::vec4(corner, 1);
+                if (posH.w <= 0) return false;
+                glm::vec3 ndc = glm::vec3(posH) / posH.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+
+#ifdef FALCOR_VK
+            const vec2 ndcScale(0.5f, 0.5f);
+#else
+            const vec2 ndcScale(0.5f, -0.5f);
+#endif
+            vec2 uvA = glm::clamp(vec2(ndcMin) * ndcScale + 0.5f, vec2(0), vec2(1));
+            vec2 uvB = glm::clamp(vec2(ndcMax) * ndcScale + 0.5f, vec2(0), vec2(1));
+            vec2 uvMin = glm::min(uvA, uvB);
+            vec2 uvMax = glm::max(uvA, uvB);
+
+            vec2 texels = (uvMax - uvMin) * mHiZSize;
+            uint32_t mip = std::min((uint32_t)std::ceil(std::log2(std::max(std::max(texels.x, texels.y), 1.0f))), (uint32_t)mHiZMips.size() - 1);
+            uvec2 mipSize = glm::max(uvec2(mHiZSize) >> mip, uvec2(1));
+            uvec2 t0 = glm::min(uvec2(uvMin * mHiZSize) >> mip, mipSize - 1u);
+            uvec2 t1 = glm::min(uvec2(uvMax * mHiZSize) >> mip, mipSize - 1u);
+
+            float maxDepth = 0;
+            for (uint32_t y = t0.y; y <= t1.y; y++)
+            {
+                for (uint32_t x = t0.x; x <= t1.x; x++)
+                {
+                    maxDepth = std::max(maxDepth, mHiZMips[mip][y * mipSize.x + x]);
+                }
+            }
+            return ndcMin.z > maxDepth;
+        }
+
+        glm::vec4 mPlanes[6];
+        glm::mat4 mPrevViewProj;
+        vec2 mHiZSize;
+        std::vector<std::vector<float>> mHiZMips;
+    };
+
+    std::vector<std::vector<uint32_t>> IndirectDrawList::cullOnCpu(RenderContext* pContext, const Camera* pCamera) const
+    {
+        std::vector<std::vector<uint32_t>> visible(mDraws.size());
+        if (mpTransformBuffer == nullptr || mInstances.empty()) return visible;
+
+        const auto* pNodes = reinterpret_cast<const TransformHierarchy::NodeMatrices*>(mpTransformBuffer->map(Buffer::MapType::Read));
+        std::vector<TransformHierarchy::NodeMatrices> nodes(pNodes, pNodes + mpTransformBuffer->getSize() / sizeof(TransformHierarchy::NodeMatrices));
+        mpTransformBuffer->unmap();
+
+        CpuCuller culler(pCamera, mpHiZ.get(), pContext);
+        for (uint32_t instanceID = 0; instanceID < (uint32_t)mInstances.size(); instanceID++)
+        {
+            const IndirectInstanceData& instance = mInstances[instanceID];
+            BoundingBox box = BoundingBox::fromMinMax(instance.boundsCenter - instance.boundsExtent, instance.boundsCenter + instance.boundsExtent);
+            if (culler.isVisible(box.transform(nodes[instance.transformNode].world)))
+            {
+                visible[instance.drawIndex].push_back(instanceID);
+            }
+        }
+        return visible;
+    }
+
+    bool IndirectDrawList::validate(RenderContext* pContext, const Camera* pCamera)
+    {
+        std::vector<std::vector<uint32_t>> expected = cullOnCpu(pContext, pCamera);
+
+        std::vector<uint32_t> args(mpArgBuffer->getSize() / sizeof(uint32_t));
+        std::memcpy(args.data(), mpArgBuffer->map(Buffer::MapType::Read), args.size() * sizeof(uint32_t));
+        mpArgBuffer->unmap();
+        std::vector<uint32_t> visibleList(mpVisibleBuffer->getSize() / sizeof(uint32_t));
+        std::memcpy(visibleList.data(), mpVisibleBuffer->map(Buffer::MapType::Read), visibleList.size() * sizeof(uint32_t));
+        mpVisibleBuffer->unmap();
+
+        mStats = Stats();
+        mStats.instanceCount = (uint32_t)mInstances.size();
+        for (uint32_t drawID = 0; drawID < (uint32_t)mDraws.size(); drawID++)
+        {
+            // The order of the visible instances depends on the thread scheduling
+            uint32_t count = args[drawID * 5 + 1];
+            auto begin = visibleList.begin() + mDraws[drawID].visibleBase;
+            std::vector<uint32_t> gpuVisible(begin, begin + std::min(count, mDraws[drawID].instanceCount));
+            std::sort(gpuVisible.begin(), gpuVisible.end());
+
+            mStats.visibleInstanceCount += count;
+            if (count != expected[drawID].size() || gpuVisible != expected[drawID])
+            {
+                mStats.mismatchCount++;
+            }
+        }
+
+        if (mStats.mismatchCount)
+        {
+            logWarning("IndirectDrawList::validate() - the GPU culling results of " + std::to_string(mStats.mismatchCount) + " out of " + std::to_string(mDraws.size()) + " draws don't match the CPU emulation");
+        }
+        return mStats.mismatchCount == 0;
+    }
+}
@@ -0,0 +1,183 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "API/Buffer.h"
+#include "API/StructuredBuffer.h"
+#include "API/Texture.h"
+#include "API/VAO.h"
+#include "Graphics/Program/ComputeProgram.h"
+#include "Graphics/ComputeState.h"
+#include "Graphics/Program/ProgramVars.h"
+#include "Data/HostDeviceData.h"
+
+namespace Falcor
+{
+    class Scene;
+    class Model;
+    class Mesh;
+    class Camera;
+    class MaterialTable;
+    class RenderContext;
+
+    /** GPU-culled indirect draws of all the mesh instances in a scene.
+        The instance table (bounds, transform node and material index per mesh instance) and the draw arguments are uploaded when the scene structure changes. Each frame, cull() runs a
+        compute pass which tests every instance against the camera frustum, and optionally against a Hi-Z buffer of the previous frame, and compacts the visible instances of each draw.
+        The instance counts in the argument buffer are written by the GPU, so the CPU issues one indirect draw per draw record regardless of the number of instances.
+        World matrices are read from the scene's transform hierarchy GPU buffer, so moving instances only upload their matrices.
+        Programs opt-in by compiling with the _INDIRECT_DRAW define. See getIndirectInstance() in ShaderCommon.slang.
+    */
+    class IndirectDrawList
+    {
+    public:
+        using SharedPtr = std::shared_ptr<IndirectDrawList>;
+        using SharedConstPtr = std::shared_ptr<const IndirectDrawList>;
+        static const uint32_t kInvalidInstance = -1;
+
+        /** A single indirect draw. Covers all the instances of a mesh, or the instances of a mesh inside a single model instance for models with per-instance animation
+        */
+        struct Draw
+        {
+            const Model* pModel = nullptr;
+            const Mesh* pMesh = nullptr;
+            Vao::SharedPtr pVao;
+            uint32_t modelID = 0;
+            uint32_t meshID = 0;
+            uint32_t modelInstanceID = kInvalidInstance;    ///< The model instance whose bones the draw uses, or kInvalidInstance if the draw covers all the model instances
+            uint32_t visibleBase = 0;                       ///< First slot of the draw in the visible-instance list
+            uint32_t instanceCount = 0;                     ///< Number of instances before culling
+            bool useVsSkinning = false;                     ///< The mesh is skinned in the vertex shader
+        };
+
+        /** Culling statistics, only updated by validate()
+        */
+        struct Stats
+        {
+            uint32_t instanceCount = 0;
+            uint32_t visibleInstanceCount = 0;
+            uint32_t mismatchCount = 0;         ///< Number of draws where the GPU and CPU results differ
+        };
+
+        /** Create an empty list
+        */
+        static SharedPtr create();
+
+        /** Rebuild the instance table and the draw arguments if the scene structure, the visibility of the instances or the material table changed.
+            Call after Scene::updateTransforms().
+            \param[in] pScene The scene
+            \param[in] pMaterialTable Optional. The table to take the material indices from
+            \return true if the list was rebuilt
+        */
+        bool update(Scene* pScene, const MaterialTable* pMaterialTable);
+
+        /** Run the culling pass. Resets the instance counts in the argument buffer and writes the visible instances of each draw.
+            \param[in] pContext The render context
+            \param[in] pCamera The camera to cull against
+            \param[in] pTransformBuffer The transform hierarchy matrices. See TransformHierarchy::getGpuBuffer() and SceneSnapshot::getTransformGpuBuffer()
+        */
+        void cull(RenderContext* pContext, const Camera* pCamera, const Buffer::SharedPtr& pTransformBuffer);
+
+        /** Set a Hi-Z buffer used for occlusion culling. Each texel of mip N holds the farthest depth of the texels it covers in mip N-1.
+            The buffer is expected to hold the depth of the previous frame, and is tested with the camera's previous-frame view-projection matrix. Pass nullptr to disable occlusion culling.
+        */
+        void setHiZ(const Texture::SharedPtr& pHiZ) { mpHiZ = pHiZ; }
+
+        /** Build a Hi-Z buffer from a depth buffer, and use it for occlusion culling. Call after rendering the frame, so that the next frame culls against it.
+            \param[in] pContext The render context
+            \param[in] pDepth The depth buffer. Must not be multisampled
+        */
+        void buildHiZ(RenderContext* pContext, const Texture::SharedPtr& pDepth);
+
+        const Texture::SharedPtr& getHiZ() const { return mpHiZ; }
+
+        /** Get the transform buffer passed to the last cull() call
+        */
+        const Buffer::SharedPtr& getTransformBuffer() const { return mpTransformBuffer; }
+
+        /** Bind the instance table and the culling results into a program-vars object. The program must be compiled with the _INDIRECT_DRAW define
+            \return false if the program doesn't declare the indirect-draw resources, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        /** Check if a program-vars object was created from a program which declares the indirect-draw resources
+        */
+        static bool isDeclared(const ProgramVars* pVars);
+
+        const std::vector<Draw>& getDraws() const { return mDraws; }
+
+        /** Get the buffer holding a D3D12_DRAW_INDEXED_ARGUMENTS/VkDrawIndexedIndirectCommand struct per draw
+        */
+        const Buffer::SharedPtr& getArgBuffer() const { return mpArgBuffer; }
+
+        static const uint32_t kDrawArgsSize = 5 * sizeof(uint32_t);
+
+        /** Run the culling kernel on the CPU. Uses the same math as the culling pass, with the transforms and the Hi-Z buffer of the last cull() call read back from the GPU.
+            \param[in] pContext The render context, used to read back the Hi-Z buffer
+            \param[in] pCamera The camera to cull against
+            \return The visible instances of each draw, as indices into the instance table, sorted
+        */
+        std::vector<std::vector<uint32_t>> cullOnCpu(RenderContext* pContext, const Camera* pCamera) const;
+
+        /** Compare the results of the last cull() call with the CPU emulation. This reads back the results and stalls the GPU, only use it for debugging.
+            \return true if the results match
+        */
+        bool validate(RenderContext* pContext, const Camera* pCamera);
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        IndirectDrawList() = default;
+        bool init();
+        bool isStale(Scene* pScene, const MaterialTable* pMaterialTable);
+        void rebuild(Scene* pScene, const MaterialTable* pMaterialTable);
+        void setCullData(const Camera* pCamera);
+
+        struct
+        {
+            ComputeProgram::SharedPtr pProgram;
+            ComputeVars::SharedPtr pVars;
+            ComputeState::SharedPtr pState;
+        } mCullPass, mHiZPass;
+
+        std::vector<Draw> mDraws;
+        std::vector<IndirectInstanceData> mInstances;
+        uint32_t mModelVisibilityVersion = -1;  // ObjectInstance::getVisibilityVersion() of the model and mesh instances when the list was built
+        uint32_t mMeshVisibilityVersion = -1;
+        uint32_t mStructureVersion = -1;
+        uint32_t mMaterialTableVersion = 0;
+        const MaterialTable* mpMaterialTable = nullptr;
+
+        StructuredBuffer::SharedPtr mpInstanceBuffer;
+        Buffer::SharedPtr mpArgBuffer;
+        Buffer::SharedPtr mpInitialArgBuffer;   // The arguments with zero instance counts, copied into mpArgBuffer before culling
+        Buffer::SharedPtr mpVisibleBuffer;
+        Buffer::SharedPtr mpTransformBuffer;
+        Texture::SharedPtr mpHiZ;
+        Stats mStats;
+    };
+}
@@ -28,6 +28,8 @@
 #include "Framework.h"
 #include "Scene.h"
 #include "SceneImporter.h"
+#include "ScenePackage.h"
+#include "Utils/StringUtils.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
@@ -37,12 +39,14 @@ namespace Falcor
 
     const Scene::UserVariable Scene::kInvalidVar;
 
-    const char* Scene::kFileFormatString = "Scene files\0*.fscene\0\0";
+    const char* Scene::kFileFormatString = "Scene files\0*.fscene;*.fscenepkg\0\0";
 
     Scene::SharedPtr Scene::loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
     {
         Scene::SharedPtr pScene = create();
-        if (SceneImporter::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags) == false)
+        bool isPackage = hasSuffix(filename, ScenePackage::kFileExtension, false);
+        bool loaded = isPackage ? ScenePackage::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags) : SceneImporter::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags);
+        if (loaded == false)
         {
             pScene = nullptr;
         }
@@ -54,7 +58,7 @@ namespace Falcor
         return SharedPtr(new Scene());
     }
 
-    Scene::Scene() : mId(sSceneCounter++)
+    Scene::Scene() : mId(sSceneCounter++), mpTransforms(TransformHierarchy::create())
     {
         // Reset all global id counters recursively
         Model::resetGlobalIdCounter();
@@ -115,7 +119,7 @@ namespace Falcor
 
         for (uint32_t i = 0; i < mModels.size(); i++)
         {
-            if (mModels[i][0]->getObject()->animate(currentTime))
+            if (mModels[i][0]->getObject()->animate(currentTime, mDeferModelGpuUpdates == false))
             {
                 changed = true;
             }
@@ -123,6 +127,9 @@ namespace Falcor
 
         mExtentsDirty = mExtentsDirty || changed;
 
+        mpTransforms->beginFrame();
+        updateTransforms();
+
         if (getCameraCount() > 0)
         {
             getActiveCamera()->beginFrame();
@@ -144,12 +151,16 @@ namespace Falcor
         // Delete entire vector of instances
         mModels.erase(mModels.begin() + modelID);
         mExtentsDirty = true;
+        mTransformHierarchyDirty = true;
+        mStructureVersion++;
     }
 
     void Scene::deleteAllModels()
     {
         mModels.clear();
         mExtentsDirty = true;
+        mTransformHierarchyDirty = true;
+        mStructureVersion++;
     }
 
     uint32_t Scene::getModelInstanceCount(uint32_t modelID) const
@@ -166,6 +177,9 @@ namespace Falcor
 
     void Scene::addModelInstance(const ModelInstance::SharedPtr& pInstance)
     {
+        mTransformHierarchyDirty = true;
+        mStructureVersion++;
+
         // Checking for existing instance list for model
         for (uint32_t modelID = 0; modelID < (uint32_t)mModels.size(); modelID++)
         {
@@ -173,6 +187,10 @@ namespace Falcor
             if (getModel(modelID) == pInstance->getObject())
             {
                 mModels[modelID].push_back(pInstance);
+                if (pInstance->getObject()->hasInstancedAnimation())
+                {
+                    pInstance->getObject()->addAnimationInstance();
+                }
                 return;
             }
         }
@@ -199,10 +217,44 @@ namespace Falcor
         {
             //  Erase the instance.
             instances.erase(instances.begin() + instanceID);
+
+            //  Animation instances are stored in the same order as the model instances.
+            const auto& pModel = getModel(modelID);
+            if (pModel->hasInstancedAnimation())
+            {
+                pModel->removeAnimationInstance(instanceID);
+            }
         }
 
         //  Extents will be dirty in either case.
         mExtentsDirty = true;
+        mTransformHierarchyDirty = true;
+        mStructureVersion++;
+    }
+
+    void Scene::setModelInstanceAnimation(uint32_t modelID, uint32_t instanceID, const AnimationController::InstanceState& state)
+    {
+        const auto& pModel = getModel(modelID);
+        assert(pModel->hasBones());
+        assert(instanceID < getModelInstanceCount(modelID));
+
+        if (pModel->hasInstancedAnimation() == false)
+        {
+            for (uint32_t i = 0; i < getModelInstanceCount(modelID); i++)
+            {
+                pModel->addAnimationInstance();
+            }
+        }
+
+        assert(pModel->getAnimationInstanceCount() == getModelInstanceCount(modelID));
+        pModel->setAnimationInstanceState(instanceID, state);
+    }
+
+    const AnimationController::InstanceState& Scene::getModelInstanceAnimation(uint32_t modelID, uint32_t instanceID) const
+    {
+        static const AnimationController::InstanceState kDefaultState;
+        const auto& pModel = getModel(modelID);
+        return pModel->hasInstancedAnimation() ? pModel->getAnimationInstanceState(instanceID) : kDefaultState;
     }
 
     const Scene::UserVariable& Scene::getUserVariable(const std::string& name) const
@@ -320,6 +372,8 @@ namespace Falcor
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
         mExtentsDirty = true;
+        mTransformHierarchyDirty = true;
+        mStructureVersion++;
     }
 
     void Scene::createAreaLights()
@@ -352,6 +406,26 @@ namespace Falcor
         }
     }
 
+    GeometryArena::Stats Scene::mergeGeometryBuffers()
+    {
+        std::vector<Mesh*> meshes;
+        for (auto& model : mModels)
+        {
+            std::vector<Mesh*> modelMeshes = model[0]->getObject()->getUniqueMeshes();
+            meshes.insert(meshes.end(), modelMeshes.begin(), modelMeshes.end());
+        }
+
+        GeometryArena::Stats stats = GeometryArena::merge(meshes);
+
+        // Update the models' buffer counts, and let the renderers know the VAOs changed
+        for (auto& model : mModels)
+        {
+            model[0]->getObject()->calculateModelProperties();
+        }
+        mStructureVersion++;
+        return stats;
+    }
+
     void Scene::attachSkinningCacheToModels(SkinningCache::SharedPtr pSkinningCache)
     {
         for (auto& model : mModels)
@@ -359,4 +433,128 @@ namespace Falcor
             model[0]->getObject()->attachSkinningCache(pSkinningCache);
         }
     }
+
+    void Scene::rebuildTransformHierarchy()
+    {
+        mpTransforms->clear();
+        mModelTransforms.resize(mModels.size());
+
+        for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            const Model* pModel = getModel(modelID).get();
+            ModelTransforms& modelTransforms = mModelTransforms[modelID];
+
+            // Flatten the model's mesh instances
+            modelTransforms.meshInstanceOffsets.resize(pModel->getMeshCount());
+            modelTransforms.meshInstanceVersions.clear();
+            std::vector<glm::mat4> meshTransforms;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                modelTransforms.meshInstanceOffsets[meshID] = (uint32_t)meshTransforms.size();
+                bool skinned = pModel->getMesh(meshID)->hasBones();
+                for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                {
+                    const auto& pMeshInstance = pModel->getMeshInstance(meshID, i);
+                    modelTransforms.meshInstanceVersions.push_back(pMeshInstance->getTransformVersion());
+                    meshTransforms.push_back(skinned ? glm::mat4() : pMeshInstance->getTransformMatrix());
+                }
+            }
+
+            modelTransforms.instanceNodes.resize(getModelInstanceCount(modelID));
+            modelTransforms.instanceVersions.resize(getModelInstanceCount(modelID));
+            for (uint32_t instanceID = 0; instanceID < getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto& pInstance = getModelInstance(modelID, instanceID);
+                uint32_t node = mpTransforms->addNode(TransformHierarchy::kInvalidNode, pInstance->getTransformMatrix());
+                modelTransforms.instanceNodes[instanceID] = node;
+                modelTransforms.instanceVersions[instanceID] = pInstance->getTransformVersion();
+
+                for (const auto& meshTransform : meshTransforms)
+                {
+                    mpTransforms->addNode(node, meshTransform);
+                }
+            }
+        }
+
+        mTransformHierarchyDirty = false;
+    }
+
+    void Scene::updateTransforms()
+    {
+        if (mTransformHierarchyDirty)
+        {
+            rebuildTransformHierarchy();
+            return;
+        }
+
+        for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+        {
+            const Model* pModel = getModel(modelID).get();
+            ModelTransforms& modelTransforms = mModelTransforms[modelID];
+
+            // Meshes might have been removed from the model since the hierarchy was built
+            if (modelTransforms.meshInstanceOffsets.size() != pModel->getMeshCount())
+            {
+                rebuildTransformHierarchy();
+                return;
+            }
+
+            uint32_t meshInstanceCount = 0;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                if (modelTransforms.meshInstanceOffsets[meshID] != meshInstanceCount)
+                {
+                    rebuildTransformHierarchy();
+                    return;
+                }
+                meshInstanceCount += pModel->getMeshInstanceCount(meshID);
+            }
+
+            if (meshInstanceCount != modelTransforms.meshInstanceVersions.size())
+            {
+                rebuildTransformHierarchy();
+                return;
+            }
+
+            for (uint32_t instanceID = 0; instanceID < getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto& pInstance = getModelInstance(modelID, instanceID);
+                uint32_t version = pInstance->getTransformVersion();
+                if (version != modelTransforms.instanceVersions[instanceID])
+                {
+                    modelTransforms.instanceVersions[instanceID] = version;
+                    mpTransforms->setLocalTransform(modelTransforms.instanceNodes[instanceID], pInstance->getTransformMatrix());
+                }
+            }
+
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                if (pModel->getMesh(meshID)->hasBones()) continue;
+
+                const uint32_t offset = modelTransforms.meshInstanceOffsets[meshID];
+                for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                {
+                    const auto& pMeshInstance = pModel->getMeshInstance(meshID, i);
+                    uint32_t version = pMeshInstance->getTransformVersion();
+                    if (version != modelTransforms.meshInstanceVersions[offset + i])
+                    {
+                        modelTransforms.meshInstanceVersions[offset + i] = version;
+                        for (uint32_t node : modelTransforms.instanceNodes)
+                        {
+                            mpTransforms->setLocalTransform(node + 1 + offset + i, pMeshInstance->getTransformMatrix());
+                        }
+                    }
+                }
+            }
+        }
+
+        mpTransforms->update();
+    }
+
+    uint32_t Scene::getMeshInstanceTransformId(uint32_t modelID, uint32_t modelInstanceID, uint32_t meshID, uint32_t meshInstanceID) const
+    {
+        assert(mTransformHierarchyDirty == false);
+        const ModelTransforms& modelTransforms = mModelTransforms[modelID];
+        return modelTransforms.instanceNodes[modelInstanceID] + 1 + modelTransforms.meshInstanceOffsets[meshID] + meshInstanceID;
+    }
 }
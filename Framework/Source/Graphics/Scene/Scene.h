@@ -37,6 +37,7 @@
 #include "Graphics/Paths/ObjectPath.h"
 #include "Graphics/Model/ObjectInstance.h"
 #include "Graphics/Model/SkinningCache.h"
+#include "Graphics/Scene/TransformHierarchy.h"
 
 namespace Falcor
 {
@@ -97,10 +98,13 @@ namespace Falcor
         */
         enum class LoadFlags
         {
-            None                =   0x0,
-            GenerateAreaLights  =   0x1,    ///< Create area light(s) for meshes that have emissive material
+            None                    =   0x0,
+            GenerateAreaLights      =   0x1,    ///< Create area light(s) for meshes that have emissive material
+            MergeGeometryBuffers    =   0x2,    ///< Pack the vertices and indices of the meshes of all the models into shared buffers, see mergeGeometryBuffers()
         };
 
+        /** Load a scene from a .fscene file or a binary scene package (see ScenePackage).
+        */
         static Scene::SharedPtr loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
         static Scene::SharedPtr create();
 
@@ -120,6 +124,12 @@ namespace Falcor
         const ModelInstance::SharedPtr& getModelInstance(uint32_t modelID, uint32_t instanceID) const { return mModels[modelID][instanceID]; };
         void deleteModelInstance(uint32_t modelID, uint32_t instanceID);
 
+        /** Set the animation state of a model instance. By default, all instances of a model play the model's active animation.
+            The first call for a model creates an animation state for each of its instances. The mesh data and animation clips stay shared between the instances.
+        */
+        void setModelInstanceAnimation(uint32_t modelID, uint32_t instanceID, const AnimationController::InstanceState& state);
+        const AnimationController::InstanceState& getModelInstanceAnimation(uint32_t modelID, uint32_t instanceID) const;
+
         // Light Sources
         uint32_t addLight(const Light::SharedPtr& pLight);
         void deleteLight(uint32_t lightID);
@@ -209,9 +219,37 @@ namespace Falcor
         */
         void bindSampler(Sampler::SharedPtr pSampler);
 
+        /** Pack the vertices and indices of the meshes of all the models into shared buffers, so that meshes with the same vertex layout are drawn from a single VAO. See GeometryArena.
+            Unlike Model::LoadFlags::MergeGeometryBuffers, meshes of different models share buffers. Models shared with other scenes are affected as well.
+            \return Statistics about the buffers before and after merging
+        */
+        GeometryArena::Stats mergeGeometryBuffers();
+
         /** Attach skinning cache to all models in scene.
         */
         void attachSkinningCacheToModels(SkinningCache::SharedPtr pSkinningCache);
+
+        /** Skip the GPU work of model updates, such as compute skinning, in update(). Used when the scene is updated on a simulation thread, in which case SceneSnapshot runs it on the render thread.
+        */
+        void setDeferModelGpuUpdates(bool defer) { mDeferModelGpuUpdates = defer; }
+
+        /** Get a counter which changes every time models or model instances are added or removed, or the mesh geometry is merged
+        */
+        uint32_t getStructureVersion() const { return mStructureVersion; }
+
+        /** Copy changed model and mesh instance transforms into the transform hierarchy and update the world matrices. Called from update(), and by scene renderers before rendering.
+        */
+        void updateTransforms();
+
+        /** Get the scene's transform hierarchy. Holds one node per model instance, with a child node per mesh instance.
+            Call updateTransforms() before using it, otherwise the hierarchy might be out of date.
+        */
+        const TransformHierarchy::SharedPtr& getTransformHierarchy() const { return mpTransforms; }
+
+        /** Get the index of the transform hierarchy node of a mesh instance inside a model instance.
+            The node's world matrix combines the model instance and mesh instance transforms. For skinned meshes, the mesh instance transform is not applied.
+        */
+        uint32_t getMeshInstanceTransformId(uint32_t modelID, uint32_t modelInstanceID, uint32_t meshID, uint32_t meshInstanceID) const;
     protected:
 
         Scene();
@@ -242,6 +280,24 @@ namespace Falcor
 
         bool mExtentsDirty = true;
 
+        /** Transform hierarchy bookkeeping. For each model, the node of model instance i is instanceNodes[i]. It is followed by the nodes of the model's mesh instances,
+            in the order given by meshInstanceOffsets. Mesh instances are shared by all instances of a model, so their versions are tracked once per model.
+        */
+        struct ModelTransforms
+        {
+            std::vector<uint32_t> instanceNodes;
+            std::vector<uint32_t> instanceVersions;
+            std::vector<uint32_t> meshInstanceOffsets;
+            std::vector<uint32_t> meshInstanceVersions;
+        };
+
+        void rebuildTransformHierarchy();
+        TransformHierarchy::SharedPtr mpTransforms;
+        std::vector<ModelTransforms> mModelTransforms;
+        bool mTransformHierarchyDirty = true;
+        uint32_t mStructureVersion = 0;
+        bool mDeferModelGpuUpdates = false;
+
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
         static const UserVariable kInvalidVar;
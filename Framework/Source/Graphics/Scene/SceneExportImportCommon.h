@@ -77,6 +77,7 @@ namespace Falcor
         static const char* kCamDepthRange = "depth_range";
         static const char* kCamAspectRatio = "aspect_ratio";
         static const char* kPathLoop = "loop";
+        static const char* kPathConstantSpeed = "constant_speed";
         static const char* kPathFrames = "frames";
         static const char* kFrameTime = "time";
 
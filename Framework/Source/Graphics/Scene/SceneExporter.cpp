@@ -33,7 +33,9 @@
 #include "SceneExporter.h"
 #include <fstream>
 #include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
+#include "Graphics/Scene/ScenePackage.h"
 
 #define SCENE_EXPORTER
 #include "SceneExportImportCommon.h"
@@ -46,10 +48,21 @@ namespace Falcor
 
     bool SceneExporter::saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions)
     {
+        if (hasSuffix(filename, ScenePackage::kFileExtension, false))
+        {
+            return ScenePackage::save(filename, pScene, exportOptions);
+        }
+
         SceneExporter exporter(filename, pScene);
         return exporter.save(exportOptions);
     }
 
+    std::string SceneExporter::exportSceneToString(const Scene::SharedPtr& pScene, uint32_t exportOptions)
+    {
+        SceneExporter exporter("", pScene);
+        return exporter.exportToString(exportOptions);
+    }
+
     template<typename T>
     void addLiteral(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const std::string& key, const T& value)
     {
@@ -98,6 +111,23 @@ namespace Falcor
     }
 
     bool SceneExporter::save(uint32_t exportOptions)
+    {
+        std::string str = exportToString(exportOptions);
+
+        // Output the file
+        std::ofstream outputStream(mFilename.c_str());
+        if (outputStream.fail())
+        {
+            logError("Can't open output scene file " + mFilename + ".\nExporting failed.");
+            return false;
+        }
+        outputStream << str;
+        outputStream.close();
+
+        return true;
+    }
+
+    std::string SceneExporter::exportToString(uint32_t exportOptions)
     {
         mExportOptions = exportOptions;
 
@@ -123,19 +153,7 @@ namespace Falcor
         rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
         writer.SetIndent(' ', 4);
         mJDoc.Accept(writer);
-        std::string str(buffer.GetString(), buffer.GetSize());
-
-        // Output the file
-        std::ofstream outputStream(mFilename.c_str());
-        if (outputStream.fail())
-        {
-            logError("Can't open output scene file " + mFilename + ".\nExporting failed.");
-            return false;
-        }
-        outputStream << str;
-        outputStream.close();
-
-        return true;
+        return std::string(buffer.GetString(), buffer.GetSize());
     }
 
     void SceneExporter::writeGlobalSettings(bool writeActivePath)
@@ -342,6 +360,7 @@ namespace Falcor
             jsonPath.SetObject();
             addString(jsonPath, allocator, SceneKeys::kName, pPath->getName());
             addBool(jsonPath, allocator, SceneKeys::kPathLoop, pPath->isRepeatOn());
+            addBool(jsonPath, allocator, SceneKeys::kPathConstantSpeed, pPath->getParameterization() == ObjectPath::Parameterization::ConstantSpeed);
 
             // Add the keyframes
             rapidjson::Value jsonFramesArray(rapidjson::kArrayType);
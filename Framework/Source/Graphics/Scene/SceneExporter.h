@@ -53,8 +53,14 @@ namespace Falcor
             ExportAll = 0xFFFFFFFF
         };
 
+        /** Save a scene. Files with the ScenePackage::kFileExtension extension are saved as a binary scene package, which embeds the models and textures.
+        */
         static bool saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
 
+        /** Get the .fscene representation of a scene as a string.
+        */
+        static std::string exportSceneToString(const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
+
         static const uint32_t kVersion = 2;
 
     private:
@@ -63,6 +69,7 @@ namespace Falcor
             : mpScene(pScene), mFilename(filename) {}
 
         bool save(uint32_t exportOptions);
+        std::string exportToString(uint32_t exportOptions);
 
         void writeModels();
         void writeLights();
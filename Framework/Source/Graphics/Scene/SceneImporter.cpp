@@ -33,6 +33,8 @@
 #include "rapidjson/error/en.h"
 #include "Scene.h"
 #include "Utils/Platform/OS.h"
+#include "Utils/CpuTimer.h"
+#include "ScenePackage.h"
 #include <sstream>
 #include <fstream>
 #include <algorithm>
@@ -108,6 +110,23 @@ namespace Falcor
         return importer.load(filename, modelLoadFlags, sceneLoadFlags);
     }
 
+    bool SceneImporter::loadScenePackage(Scene& scene, ScenePackage& package, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
+    {
+        SceneImporter importer(scene);
+        importer.mFilename = package.getFilename();
+        importer.mDirectory = package.getCacheDirectory();
+        importer.mModelLoadFlags = modelLoadFlags;
+        importer.mSceneLoadFlags = sceneLoadFlags;
+        importer.mpPackage = &package;
+
+        if (is_set(sceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
+        {
+            importer.mModelLoadFlags |= Model::LoadFlags::BuffersAsShaderResource;
+        }
+
+        return importer.loadFromString(package.getSceneDescription());
+    }
+
     bool SceneImporter::createModelInstances(const rapidjson::Value& jsonVal, const Model::SharedPtr& pModel)
     {
         if(jsonVal.IsArray() == false)
@@ -178,7 +197,45 @@ namespace Falcor
         return true;
     }
 
-    bool SceneImporter::createModel(const rapidjson::Value& jsonModel)
+    std::string SceneImporter::getModelFile(const rapidjson::Value& jsonModel) const
+    {
+        const auto& modelFile = jsonModel.FindMember(SceneKeys::kFilename);
+        if(modelFile == jsonModel.MemberEnd() || modelFile->value.IsString() == false)
+        {
+            return "";
+        }
+
+        // Models embedded in a package are written to the package's cache directory when they are loaded, see ScenePackage::materializeFile()
+        std::string file = mDirectory + '/' + modelFile->value.GetString();
+        if ((mpPackage == nullptr || mpPackage->hasFile(modelFile->value.GetString()) == false) && doesFileExist(file) == false)
+        {
+            file = modelFile->value.GetString();
+        }
+        return file;
+    }
+
+    Model::LoadFlags SceneImporter::getModelLoadFlags(const rapidjson::Value& jsonModel) const
+    {
+        // Parse additional properties that affect loading
+        Model::LoadFlags modelFlags = mModelLoadFlags;
+        const auto& materialSettings = jsonModel.FindMember(SceneKeys::kMaterial);
+        if (materialSettings != jsonModel.MemberEnd() && materialSettings->value.IsObject())
+        {
+            for (auto m = materialSettings->value.MemberBegin(); m != materialSettings->value.MemberEnd(); m++)
+            {
+                if (m->name == SceneKeys::kShadingModel)
+                {
+                    if (m->value == SceneKeys::kShadingSpecGloss)
+                    {
+                        modelFlags |= Model::LoadFlags::UseSpecGlossMaterials;
+                    }
+                }
+            }
+        }
+        return modelFlags;
+    }
+
+    bool SceneImporter::createModel(const rapidjson::Value& jsonModel, uint32_t modelIndex)
     {
         // Model must have at least a filename
         if(jsonModel.HasMember(SceneKeys::kFilename) == false)
@@ -193,36 +250,35 @@ namespace Falcor
             return error("Model filename must be a string");
         }
 
-        std::string file = mDirectory + '/' + modelFile.GetString();
-        if (doesFileExist(file) == false)
+        const bool preloaded = modelIndex < mModelPreloads.size();
+        std::string file = preloaded ? mModelPreloads[modelIndex].filename : getModelFile(jsonModel);
+        if (jsonModel.HasMember(SceneKeys::kMaterial) && jsonModel[SceneKeys::kMaterial].IsObject() == false)
         {
-            file = modelFile.GetString();
+            return error("Material properties for \"" + file + "\" must be a JSON object");
         }
 
-        // Parse additional properties that affect loading
-        Model::LoadFlags modelFlags = mModelLoadFlags;
-        if (jsonModel.HasMember(SceneKeys::kMaterial))
+        // Load the model. The file was already parsed on a worker thread, only the GPU resources are created here
+        Model::SharedPtr pModel;
+        if(preloaded)
         {
-            const auto& materialSettings = jsonModel[SceneKeys::kMaterial];
-            if (materialSettings.IsObject() == false)
+            // The future holds the exception if parsing failed on the worker thread
+            Model::PreloadedFilePtr pPreloaded;
+            try
             {
-                return error("Material properties for \"" + file + "\" must be a JSON object");
+                pPreloaded = mModelPreloads[modelIndex].future.get();
             }
-
-            for (auto m = materialSettings.MemberBegin(); m != materialSettings.MemberEnd(); m++)
+            catch(const std::exception& e)
             {
-                if (m->name == SceneKeys::kShadingModel)
-                {
-                    if (m->value == SceneKeys::kShadingSpecGloss)
-                    {
-                        modelFlags |= Model::LoadFlags::UseSpecGlossMaterials;
-                    }
-                }
+                logError("Exception while loading model " + file + ": " + e.what());
             }
+            advanceModelPreloadWindow(modelIndex);
+            pModel = Model::createFromPreloadedFile(pPreloaded);
+        }
+        else if(mpPackage == nullptr || mpPackage->hasFile(modelFile.GetString()) == false || mpPackage->materializeFile(modelFile.GetString()))
+        {
+            pModel = Model::createFromFile(file.c_str(), getModelLoadFlags(jsonModel));
         }
 
-        // Load the model
-        auto pModel = Model::createFromFile(file.c_str(), modelFlags);
         if(pModel == nullptr)
         {
             return error("Could not load model: " + file);
@@ -302,7 +358,7 @@ namespace Falcor
         // Loop over the array
         for(uint32_t i = 0; i < jsonVal.Size(); i++)
         {
-            if(createModel(jsonVal[i]) == false)
+            if(createModel(jsonVal[i], i) == false)
             {
                 return false;
             }
@@ -310,6 +366,97 @@ namespace Falcor
         return true;
     }
 
+    void SceneImporter::preloadModels()
+    {
+        const auto& jsonModels = mJDoc.FindMember(SceneKeys::kModels);
+        if(jsonModels == mJDoc.MemberEnd() || jsonModels->value.IsArray() == false || jsonModels->value.Size() == 0)
+        {
+            return;
+        }
+
+        // Collect the files. Invalid entries are skipped here and reported by createModel()
+        const auto& models = jsonModels->value;
+        mModelPreloads.resize(models.Size());
+        for(uint32_t i = 0; i < models.Size(); i++)
+        {
+            auto& preload = mModelPreloads[i];
+            if(models[i].IsObject())
+            {
+                preload.filename = getModelFile(models[i]);
+                preload.flags = getModelLoadFlags(models[i]);
+                const auto& modelFile = models[i].FindMember(SceneKeys::kFilename);
+                if(mpPackage && preload.filename.size() && mpPackage->hasFile(modelFile->value.GetString()))
+                {
+                    preload.packageName = modelFile->value.GetString();
+                }
+            }
+            preload.future = preload.promise.get_future();
+        }
+
+        mModelPreloadWindowEnd = kMaxPreloadedModels;
+        uint32_t threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), (uint32_t)mModelPreloads.size());
+        for(uint32_t i = 0; i < threadCount; i++)
+        {
+            mPreloadThreads.emplace_back(&SceneImporter::preloadModelsThread, this);
+        }
+    }
+
+    void SceneImporter::preloadModelsThread()
+    {
+        for(uint32_t i = mNextModelPreload++; i < (uint32_t)mModelPreloads.size(); i = mNextModelPreload++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mModelPreloadWindowMutex);
+                mModelPreloadWindowCond.wait(lock, [this, i]() { return mCancelModelPreload || i < mModelPreloadWindowEnd; });
+            }
+
+            // An exception escaping the thread would terminate the application. Hand it to createModel() instead.
+            auto& preload = mModelPreloads[i];
+            try
+            {
+                bool skip = preload.filename.empty() || mCancelModelPreload;
+                if(skip == false && preload.packageName.size())
+                {
+                    skip = (mpPackage->materializeFile(preload.packageName) == false);
+                }
+                preload.promise.set_value(skip ? nullptr : Model::preloadFromFile(preload.filename.c_str(), preload.flags));
+            }
+            catch(...)
+            {
+                preload.promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    void SceneImporter::advanceModelPreloadWindow(uint32_t createdModelIndex)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mModelPreloadWindowMutex);
+            mModelPreloadWindowEnd = std::max(mModelPreloadWindowEnd, createdModelIndex + 1 + kMaxPreloadedModels);
+        }
+        mModelPreloadWindowCond.notify_all();
+    }
+
+    void SceneImporter::stopPreloadingModels()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mModelPreloadWindowMutex);
+            mCancelModelPreload = true;
+        }
+        mModelPreloadWindowCond.notify_all();
+        for(auto& t : mPreloadThreads)
+        {
+            t.join();
+        }
+        mPreloadThreads.clear();
+    }
+
+    SceneImporter::~SceneImporter()
+    {
+        // Loading might have failed before all of the preloaded models were used
+        stopPreloadingModels();
+    }
+
     bool SceneImporter::createDirLight(const rapidjson::Value& jsonLight)
     {
         auto pDirLight = DirectionalLight::create();
@@ -668,6 +815,16 @@ namespace Falcor
                 bool b = value.GetBool();
                 pPath->setAnimationRepeat(b);
             }
+            else if(key == SceneKeys::kPathConstantSpeed)
+            {
+                if(value.IsBool() == false)
+                {
+                    error("Path constant speed should be a boolean value");
+                    return nullptr;
+                }
+
+                pPath->setParameterization(value.GetBool() ? ObjectPath::Parameterization::ConstantSpeed : ObjectPath::Parameterization::KeyFrameTime);
+            }
             else if(key == SceneKeys::kPathFrames)
             {
                 if(createPathFrames(pPath.get(), value) == false)
@@ -898,43 +1055,63 @@ namespace Falcor
 
         if(findFileInDataDirectories(filename, fullpath))
         {
-            // Load the file
-            std::ifstream fileStream(fullpath);
-            std::stringstream strStream;
-            strStream << fileStream.rdbuf();
-            std::string jsonData = strStream.str();
-            rapidjson::StringStream JStream(jsonData.c_str());
+            // Load the file directly into a string
+            std::ifstream fileStream(fullpath, std::ios::binary);
+            fileStream.seekg(0, std::ios::end);
+            std::string jsonData(size_t(std::max(std::streamoff(fileStream.tellg()), std::streamoff(0))), '\0');
+            fileStream.seekg(0, std::ios::beg);
+            fileStream.read(&jsonData[0], jsonData.size());
 
             // Get the file directory
             auto last = fullpath.find_last_of("/\\");
             mDirectory = fullpath.substr(0, last);
 
-            // create the DOM
-            mJDoc.ParseStream(JStream);
+            return loadFromString(jsonData);
+        }
+        else
+        {
+            return error("File not found.");
+        }
+    }
+
+    bool SceneImporter::loadFromString(const std::string& jsonData)
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
 
-            if(mJDoc.HasParseError())
-            {
-                size_t line;
-                line = std::count(jsonData.begin(), jsonData.begin() + mJDoc.GetErrorOffset(), '\n');
-                return error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
-            }
+        // create the DOM
+        mJDoc.Parse(jsonData.c_str());
 
-            if(topLevelLoop() == false)
-            {
-                return false;
-            }
+        if(mJDoc.HasParseError())
+        {
+            size_t line;
+            line = std::count(jsonData.begin(), jsonData.begin() + mJDoc.GetErrorOffset(), '\n');
+            return error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
+        }
+        logInfo("Scene \"" + mFilename + "\": parsed JSON in " + std::to_string(CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint())) + " ms");
 
-            if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
-            {
-                mScene.createAreaLights();
-            }
+        // Start reading the model files before anything else, so that file IO overlaps with the rest of the scene creation
+        if(validateSceneFile() == false)
+        {
+            return false;
+        }
+        preloadModels();
 
-            return true;
+        if(topLevelLoop() == false)
+        {
+            return false;
         }
-        else
+
+        if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
         {
-            return error("File not found.");
+            mScene.createAreaLights();
+        }
+
+        if(is_set(mSceneLoadFlags, Scene::LoadFlags::MergeGeometryBuffers))
+        {
+            logInfo("Scene \"" + mFilename + "\": " + mScene.mergeGeometryBuffers().toString());
         }
+
+        return true;
     }
 
     bool SceneImporter::parseAmbientIntensity(const rapidjson::Value& jsonVal)
@@ -1224,24 +1401,23 @@ namespace Falcor
 
     bool SceneImporter::topLevelLoop()
     {
-        if(validateSceneFile() == false)
-        {
-            return false;
-        }
-
+        std::string timings;
         for(uint32_t i = 0; i < arraysize(kFunctionTable); i++)
         {
             const auto& jsonMember = mJDoc.FindMember(kFunctionTable[i].token.c_str());
             if(jsonMember != mJDoc.MemberEnd())
             {
+                auto startTime = CpuTimer::getCurrentTimePoint();
                 auto a = kFunctionTable[i].func;
                 if((this->*a)(jsonMember->value) == false)
                 {
                     return false;
                 }
+                timings += "\n    " + kFunctionTable[i].token + ": " + std::to_string(CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint())) + " ms";
             }
         }
 
+        logInfo("Scene \"" + mFilename + "\" load times:" + timings);
         return true;
     }
 }
\ No newline at end of file
@@ -27,6 +27,11 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Externals/RapidJson/include/rapidjson/document.h"
 #include "Graphics/Material/Material.h"
 #include "glm/vec2.hpp"
@@ -36,15 +41,23 @@
 
 namespace Falcor
 {
+    class ScenePackage;
+
     class SceneImporter
     {
     public:
         static bool loadScene(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
 
+        /** Load a scene from a binary scene package. Models are materialized from the package when they are loaded.
+        */
+        static bool loadScenePackage(Scene& scene, ScenePackage& package, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+
     private:
 
         SceneImporter(Scene& scene) : mScene(scene) {}
+        ~SceneImporter();
         bool load(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+        bool loadFromString(const std::string& jsonData);
 
         bool parseVersion(const rapidjson::Value& jsonVal);
         bool parseModels(const rapidjson::Value& jsonVal);
@@ -64,7 +77,13 @@ namespace Falcor
 
         bool loadIncludeFile(const std::string& Include);
 
-        bool createModel(const rapidjson::Value& jsonModel);
+        bool createModel(const rapidjson::Value& jsonModel, uint32_t modelIndex);
+        std::string getModelFile(const rapidjson::Value& jsonModel) const;
+        Model::LoadFlags getModelLoadFlags(const rapidjson::Value& jsonModel) const;
+
+        void preloadModels();
+        void preloadModelsThread();
+        void stopPreloadingModels();
         bool createModelInstances(const rapidjson::Value& jsonVal, const Model::SharedPtr& pModel);
         bool createPointLight(const rapidjson::Value& jsonLight);
         bool createDirLight(const rapidjson::Value& jsonLight);
@@ -83,11 +102,33 @@ namespace Falcor
         std::string mDirectory;
         Model::LoadFlags mModelLoadFlags;
         Scene::LoadFlags mSceneLoadFlags;
+        ScenePackage* mpPackage = nullptr;
 
         using ObjectMap = std::map<std::string, IMovableObject::SharedPtr>;
         bool isNameDuplicate(const std::string& name, const ObjectMap& objectMap, const std::string& objectType) const;
         IMovableObject::SharedPtr getMovableObject(const std::string& type, const std::string& name) const;
 
+        /** Model files are read and parsed on worker threads before the scene is processed. The GPU resources are created on the main thread by createModel().
+            Workers stay at most kMaxPreloadedModels models ahead of createModel(), so that a large scene doesn't hold all of its parsed models in memory at once.
+        */
+        struct ModelPreload
+        {
+            std::string filename;
+            std::string packageName;                // Set when the model is embedded in a scene package. The worker materializes it before loading
+            Model::LoadFlags flags = Model::LoadFlags::None;
+            std::promise<Model::PreloadedFilePtr> promise;
+            std::future<Model::PreloadedFilePtr> future;
+        };
+        std::vector<ModelPreload> mModelPreloads;   // Indexed by the model's position in the models array
+        std::vector<std::thread> mPreloadThreads;
+        std::atomic<uint32_t> mNextModelPreload{0};
+        std::atomic<bool> mCancelModelPreload{false};
+        static const uint32_t kMaxPreloadedModels = 8;
+        uint32_t mModelPreloadWindowEnd = 0;        // Workers may only start preloading models below this index
+        std::mutex mModelPreloadWindowMutex;
+        std::condition_variable mModelPreloadWindowCond;
+        void advanceModelPreloadWindow(uint32_t createdModelIndex);
+
         ObjectMap mInstanceMap;
         ObjectMap mCameraMap;
         ObjectMap mLightMap;
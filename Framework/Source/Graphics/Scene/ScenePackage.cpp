@@ -0,0 +1,532 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "Framework.h"
+#include "ScenePackage.h"
+#include "SceneExporter.h"
+#include "SceneImporter.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
+#include "Utils/CpuTimer.h"
+#include <fstream>
+#include <cstring>
+#include <set>
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+#include "SceneExportImportCommon.h"
+
+namespace Falcor
+{
+    const char* ScenePackage::kFileExtension = ".fscenepkg";
+
+    /** Package layout:
+        PackageHeader
+        Payloads, each aligned to kPayloadAlignment bytes
+        PackageTocEntry[entryCount]
+        Names, referenced by the TOC entries
+        All values are little-endian.
+    */
+    static const uint32_t kPackageMagic = 0x4B505346;  // "FSPK"
+    static const uint32_t kPackageVersion = 1;
+    static const uint64_t kPayloadAlignment = 16;
+
+    // Entry types
+    static const uint32_t kSceneDescriptionEntry = 0;   // The scene in the .fscene format
+    static const uint32_t kModelEntry = 1;              // A model file. Followed by dependencyCount entries holding the files it references
+    static const uint32_t kDependencyEntry = 2;         // A file referenced by a model, such as a texture
+
+    struct PackageHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t tocOffset;
+        uint64_t namesOffset;
+        uint64_t namesSize;
+    };
+
+    struct PackageTocEntry
+    {
+        uint64_t hash;
+        uint64_t offset;
+        uint64_t size;
+        uint32_t type;
+        uint32_t dependencyCount;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    static const char* kSceneDescriptionName = "scene.fscene";
+
+    // FNV-1a
+    static uint64_t hashContent(const void* pData, size_t size)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    static std::string toHexString(uint64_t value)
+    {
+        static const char* kDigits = "0123456789abcdef";
+        std::string s(16, '0');
+        for (int i = 15; i >= 0; i--)
+        {
+            s[i] = kDigits[value & 0xf];
+            value >>= 4;
+        }
+        return s;
+    }
+
+    static bool readFile(const std::string& fullpath, std::vector<uint8_t>& data)
+    {
+        std::ifstream stream(fullpath, std::ios::binary | std::ios::ate);
+        if (stream.fail()) return false;
+        data.resize((size_t)stream.tellg());
+        stream.seekg(0, std::ios::beg);
+        stream.read((char*)data.data(), data.size());
+        return stream.good() || data.empty();
+    }
+
+    static std::string toForwardSlashes(const std::string& path)
+    {
+        return replaceSubstring(path, "\\", "/");
+    }
+
+    /** Converts a filename into a relative path inside the package, so that the package can be extracted anywhere
+    */
+    static std::string getPackageName(const std::string& filename)
+    {
+        std::string name = toForwardSlashes(filename);
+        name = replaceSubstring(name, ":", "");
+        name = replaceSubstring(name, "../", "");
+        while (name.size() && name[0] == '/') name.erase(0, 1);
+        return name;
+    }
+
+    static void collectModelDependencies(const Model* pModel, const std::string& modelFullpath, std::set<std::string>& dependencies)
+    {
+        for (uint32_t i = 0; i < pModel->getMeshCount(); i++)
+        {
+            const Material* pMaterial = pModel->getMesh(i)->getMaterial().get();
+            const Texture::SharedPtr textures[] =
+            {
+                pMaterial->getBaseColorTexture(), pMaterial->getSpecularTexture(), pMaterial->getEmissiveTexture(), pMaterial->getNormalMap(),
+                pMaterial->getOcclusionMap(), pMaterial->getLightMap(), pMaterial->getHeightMap()
+            };
+
+            for (const auto& pTexture : textures)
+            {
+                std::string fullpath;
+                if (pTexture && pTexture->getSourceFilename().size() && findFileInDataDirectories(pTexture->getSourceFilename(), fullpath))
+                {
+                    dependencies.insert(toForwardSlashes(canonicalizeFilename(fullpath)));
+                }
+            }
+        }
+
+        // OBJ files keep the materials in a separate file
+        if (hasSuffix(modelFullpath, ".obj", false))
+        {
+            std::string mtl = swapFileExtension(modelFullpath, ".obj", ".mtl");
+            if (doesFileExist(mtl))
+            {
+                dependencies.insert(toForwardSlashes(canonicalizeFilename(mtl)));
+            }
+        }
+    }
+
+    bool ScenePackage::save(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions)
+    {
+        struct PendingEntry
+        {
+            uint32_t type;
+            std::string name;
+            std::vector<uint8_t> data;
+            uint32_t dependencyCount = 0;
+        };
+        std::vector<PendingEntry> entries(1);
+        std::unordered_map<std::string, std::string> modelNames;    // The name used in the scene description -> the name in the package
+
+        if (exportOptions & SceneExporter::ExportModels)
+        {
+            for (uint32_t i = 0; i < pScene->getModelCount(); i++)
+            {
+                const Model* pModel = pScene->getModel(i).get();
+                std::string sceneName = stripDataDirectories(pModel->getFilename());
+                if (modelNames.count(sceneName))
+                {
+                    continue;
+                }
+
+                std::string fullpath;
+                if (findFileInDataDirectories(pModel->getFilename(), fullpath) == false)
+                {
+                    logError("Can't find model file " + pModel->getFilename() + " when saving scene package " + filename);
+                    return false;
+                }
+                fullpath = toForwardSlashes(canonicalizeFilename(fullpath));
+
+                PendingEntry modelEntry;
+                modelEntry.type = kModelEntry;
+                modelEntry.name = getPackageName(sceneName);
+                if (readFile(fullpath, modelEntry.data) == false)
+                {
+                    logError("Can't read model file " + fullpath + " when saving scene package " + filename);
+                    return false;
+                }
+                modelNames[sceneName] = modelEntry.name;
+
+                // Dependencies are stored relative to the model, since that's how the model file references them
+                std::set<std::string> dependencies;
+                collectModelDependencies(pModel, fullpath, dependencies);
+                std::string modelDir = getDirectoryFromFile(fullpath) + '/';
+                size_t namePos = modelEntry.name.find_last_of('/');
+                std::string packageDir = (namePos == std::string::npos) ? "" : modelEntry.name.substr(0, namePos + 1);
+
+                std::vector<PendingEntry> dependencyEntries;
+                for (const auto& dependency : dependencies)
+                {
+                    if (hasPrefix(dependency, modelDir, false) == false)
+                    {
+                        logWarning("File " + dependency + " is outside of the directory of model " + fullpath + ". It will not be stored in scene package " + filename);
+                        continue;
+                    }
+
+                    PendingEntry dependencyEntry;
+                    dependencyEntry.type = kDependencyEntry;
+                    dependencyEntry.name = packageDir + dependency.substr(modelDir.size());
+                    if (readFile(dependency, dependencyEntry.data) == false)
+                    {
+                        logError("Can't read file " + dependency + " when saving scene package " + filename);
+                        return false;
+                    }
+                    dependencyEntries.push_back(std::move(dependencyEntry));
+                }
+
+                modelEntry.dependencyCount = (uint32_t)dependencyEntries.size();
+                entries.push_back(std::move(modelEntry));
+                for (auto& e : dependencyEntries) entries.push_back(std::move(e));
+            }
+        }
+
+        // Export the scene and point the models at their names in the package
+        rapidjson::Document jdoc;
+        std::string sceneDesc = SceneExporter::exportSceneToString(pScene, exportOptions);
+        jdoc.Parse(sceneDesc.c_str());
+        auto jmodels = jdoc.FindMember(SceneKeys::kModels);
+        if (jmodels != jdoc.MemberEnd())
+        {
+            for (uint32_t i = 0; i < jmodels->value.Size(); i++)
+            {
+                auto& jfile = jmodels->value[i][SceneKeys::kFilename];
+                const auto& name = modelNames.find(jfile.GetString());
+                if (name != modelNames.end())
+                {
+                    jfile.SetString(name->second.c_str(), (uint32_t)name->second.size(), jdoc.GetAllocator());
+                }
+            }
+        }
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        jdoc.Accept(writer);
+        entries[0].type = kSceneDescriptionEntry;
+        entries[0].name = kSceneDescriptionName;
+        entries[0].data.assign((const uint8_t*)buffer.GetString(), (const uint8_t*)buffer.GetString() + buffer.GetSize());
+
+        // Write the payloads. Identical files are only stored once
+        std::ofstream stream(filename, std::ios::binary);
+        if (stream.fail())
+        {
+            logError("Can't open output scene package " + filename + ".\nExporting failed.");
+            return false;
+        }
+
+        PackageHeader header = {};
+        stream.write((const char*)&header, sizeof(header));
+
+        std::vector<PackageTocEntry> toc(entries.size());
+        std::string names;
+        std::unordered_map<uint64_t, uint32_t> hashToEntry;
+        uint64_t offset = sizeof(header);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const auto& entry = entries[i];
+            auto& tocEntry = toc[i];
+            tocEntry.hash = hashContent(entry.data.data(), entry.data.size());
+            tocEntry.size = entry.data.size();
+            tocEntry.type = entry.type;
+            tocEntry.dependencyCount = entry.dependencyCount;
+            tocEntry.nameOffset = (uint32_t)names.size();
+            tocEntry.nameLength = (uint32_t)entry.name.size();
+            names += entry.name;
+
+            // The hash only selects the candidate, the content must match as well
+            auto existing = hashToEntry.find(tocEntry.hash);
+            if (existing != hashToEntry.end() && entries[existing->second].data == entry.data)
+            {
+                tocEntry.offset = toc[existing->second].offset;
+                continue;
+            }
+
+            uint64_t padding = (kPayloadAlignment - (offset % kPayloadAlignment)) % kPayloadAlignment;
+            static const char kZeros[kPayloadAlignment] = {};
+            stream.write(kZeros, padding);
+            offset += padding;
+
+            tocEntry.offset = offset;
+            stream.write((const char*)entry.data.data(), entry.data.size());
+            offset += entry.data.size();
+            hashToEntry.insert(std::make_pair(tocEntry.hash, (uint32_t)i));
+        }
+
+        header.magic = kPackageMagic;
+        header.version = kPackageVersion;
+        header.entryCount = (uint32_t)toc.size();
+        header.tocOffset = offset;
+        header.namesOffset = offset + toc.size() * sizeof(PackageTocEntry);
+        header.namesSize = names.size();
+        stream.write((const char*)toc.data(), toc.size() * sizeof(PackageTocEntry));
+        stream.write(names.data(), names.size());
+        stream.seekp(0);
+        stream.write((const char*)&header, sizeof(header));
+
+        if (stream.fail())
+        {
+            logError("Failed writing scene package " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    ScenePackage::SharedPtr ScenePackage::open(const std::string& filename, const std::string& cacheDirectory)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("Can't find scene package " + filename);
+            return nullptr;
+        }
+
+        SharedPtr pPackage = SharedPtr(new ScenePackage());
+        pPackage->mFilename = fullpath;
+        pPackage->mpData = (const uint8_t*)mapFileToMemory(fullpath, pPackage->mSize);
+        if (pPackage->mpData == nullptr)
+        {
+            logError("Can't open scene package " + fullpath);
+            return nullptr;
+        }
+
+        // Validate the header and the table of contents. The TOC follows the payloads and is not aligned, so the structs are copied out of the mapped file
+        const uint8_t* pData = pPackage->mpData;
+        const size_t size = pPackage->mSize;
+        auto invalid = [&fullpath](const std::string& msg) { logError("Invalid scene package " + fullpath + ". " + msg); return nullptr; };
+        PackageHeader header;
+        if (size < sizeof(PackageHeader))
+        {
+            return invalid("Bad header");
+        }
+        std::memcpy(&header, pData, sizeof(header));
+        if (header.magic != kPackageMagic)
+        {
+            return invalid("Bad header");
+        }
+        if (header.version != kPackageVersion)
+        {
+            return invalid("Unsupported version " + std::to_string(header.version));
+        }
+        if (header.tocOffset + uint64_t(header.entryCount) * sizeof(PackageTocEntry) > size || header.namesOffset + header.namesSize > size)
+        {
+            return invalid("Table of contents is out of bounds");
+        }
+
+        const uint8_t* pToc = pData + header.tocOffset;
+        const char* pNames = (const char*)(pData + header.namesOffset);
+        pPackage->mEntries.resize(header.entryCount);
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            PackageTocEntry tocEntry;
+            std::memcpy(&tocEntry, pToc + i * sizeof(PackageTocEntry), sizeof(tocEntry));
+            if (tocEntry.offset + tocEntry.size > size || uint64_t(tocEntry.nameOffset) + tocEntry.nameLength > header.namesSize)
+            {
+                return invalid("Entry " + std::to_string(i) + " is out of bounds");
+            }
+
+            Entry& entry = pPackage->mEntries[i];
+            entry.type = tocEntry.type;
+            entry.name = std::string(pNames + tocEntry.nameOffset, tocEntry.nameLength);
+            entry.hash = tocEntry.hash;
+            entry.offset = tocEntry.offset;
+            entry.size = tocEntry.size;
+            entry.dependencyCount = tocEntry.dependencyCount;
+
+            if (entry.type == kSceneDescriptionEntry)
+            {
+                pPackage->mSceneEntry = i;
+            }
+            else if (entry.type == kModelEntry && i + entry.dependencyCount >= header.entryCount)
+            {
+                return invalid("Model " + entry.name + " has too many dependencies");
+            }
+
+            // A dependency can appear once for each model which uses it. Keep the first one
+            pPackage->mNameToEntry.insert(std::make_pair(entry.name, i));
+        }
+
+        if (pPackage->mSceneEntry == uint32_t(-1))
+        {
+            return invalid("The package doesn't contain a scene description");
+        }
+
+        // Packages with different content get different cache directories, so files materialized by previous runs can be reused
+        pPackage->mCacheDirectory = cacheDirectory;
+        if (pPackage->mCacheDirectory.empty())
+        {
+            uint64_t tocHash = hashContent(pToc, header.entryCount * sizeof(PackageTocEntry));
+            pPackage->mCacheDirectory = getExecutableDirectory() + "/ScenePackageCache/" + toHexString(tocHash);
+        }
+
+        return pPackage;
+    }
+
+    ScenePackage::~ScenePackage()
+    {
+        if (mpData)
+        {
+            unmapFile(mpData, mSize);
+        }
+    }
+
+    std::string ScenePackage::getSceneDescription() const
+    {
+        const Entry& entry = mEntries[mSceneEntry];
+        return std::string((const char*)mpData + entry.offset, (size_t)entry.size);
+    }
+
+    bool ScenePackage::writeEntry(Entry& entry)
+    {
+        if (entry.materialized)
+        {
+            return true;
+        }
+
+        fs::path path = fs::path(mCacheDirectory) / entry.name;
+
+        // A file with the same size in the cache directory comes from a previous run with the same package
+        std::error_code ec;
+        if (fs::exists(path, ec) == false || fs::file_size(path, ec) != entry.size)
+        {
+            fs::create_directories(path.parent_path(), ec);
+            std::ofstream stream(path.string(), std::ios::binary);
+            stream.write((const char*)mpData + entry.offset, (size_t)entry.size);
+            if (stream.fail())
+            {
+                logError("Can't write " + path.string() + " when materializing scene package " + mFilename);
+                return false;
+            }
+        }
+
+        entry.materialized = true;
+        return true;
+    }
+
+    bool ScenePackage::materializeFile(const std::string& name)
+    {
+        auto it = mNameToEntry.find(name);
+        if (it == mNameToEntry.end())
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mMaterializeMutex);
+        uint32_t first = it->second;
+        uint32_t count = (mEntries[first].type == kModelEntry) ? mEntries[first].dependencyCount + 1 : 1;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            if (writeEntry(mEntries[i]) == false)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ScenePackage::materializeAll()
+    {
+        std::lock_guard<std::mutex> lock(mMaterializeMutex);
+        for (auto& entry : mEntries)
+        {
+            if (entry.type != kSceneDescriptionEntry && writeEntry(entry) == false)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ScenePackage::extract(const std::string& filename, const std::string& directory, std::string& sceneFile)
+    {
+        SharedPtr pPackage = open(filename, directory);
+        if (pPackage == nullptr || pPackage->materializeAll() == false)
+        {
+            return false;
+        }
+
+        std::string sceneName = getFilenameFromPath(filename);
+        sceneFile = directory + '/' + swapFileExtension(sceneName, kFileExtension, ".fscene");
+        std::ofstream stream(sceneFile);
+        stream << pPackage->getSceneDescription();
+        if (stream.fail())
+        {
+            logError("Can't write " + sceneFile + " when extracting scene package " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    bool ScenePackage::loadScene(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
+    {
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        SharedPtr pPackage = open(filename);
+        if (pPackage == nullptr)
+        {
+            return false;
+        }
+        logInfo("Scene package \"" + filename + "\": opened in " + std::to_string(CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint())) + " ms");
+
+        return SceneImporter::loadScenePackage(scene, *pPackage, modelLoadFlags, sceneLoadFlags);
+    }
+}
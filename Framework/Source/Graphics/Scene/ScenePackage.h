@@ -0,0 +1,134 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "Scene.h"
+
+namespace Falcor
+{
+    /** A single-file binary scene container.
+        A package holds the scene description together with the models and textures it references, addressed through a table of contents.
+        Each payload is stored once per content hash, so files which are referenced by multiple models are not duplicated.
+        The package is memory-mapped when opened. Models are materialized lazily - a model and its dependencies are only written to the package's cache directory when the scene importer requests them.
+    */
+    class ScenePackage
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ScenePackage>;
+        using SharedConstPtr = std::shared_ptr<const ScenePackage>;
+
+        /** The package file extension
+        */
+        static const char* kFileExtension;
+
+        /** Open a package.
+            \param[in] filename The package file. Can include a full path or a relative path from a data directory
+            \param[in] cacheDirectory The directory the embedded files are materialized into. If empty, a directory next to the executable is used
+            \return A new object, or nullptr if the package couldn't be opened
+        */
+        static SharedPtr open(const std::string& filename, const std::string& cacheDirectory = "");
+        ~ScenePackage();
+
+        /** Save a scene as a package.
+            \param[in] filename The output file
+            \param[in] pScene The scene to save
+            \param[in] exportOptions SceneExporter flags selecting which parts of the scene are saved
+            \return Whether the package was saved successfully
+        */
+        static bool save(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions);
+
+        /** Extract a package into a .fscene file and the files it references.
+            \param[in] filename The package file
+            \param[in] directory The output directory
+            \param[out] sceneFile On successful return, the path of the extracted .fscene file
+            \return Whether the package was extracted successfully
+        */
+        static bool extract(const std::string& filename, const std::string& directory, std::string& sceneFile);
+
+        /** Load a scene from a package.
+        */
+        static bool loadScene(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+
+        /** Get the scene description, in the .fscene format.
+        */
+        std::string getSceneDescription() const;
+
+        /** Check if a file is embedded in the package.
+            \param[in] name The file name, as referenced by the scene description
+        */
+        bool hasFile(const std::string& name) const { return mNameToEntry.count(name) != 0; }
+
+        /** Write an embedded file to the cache directory. If the file is a model, all of the model's dependencies are written as well.
+            This function is thread-safe, so models can be materialized by the threads which load them.
+            \param[in] name The file name, as referenced by the scene description
+            \return Whether the file was found in the package and written successfully
+        */
+        bool materializeFile(const std::string& name);
+
+        /** Write all of the embedded files to the cache directory.
+        */
+        bool materializeAll();
+
+        /** Get the directory the embedded files are materialized into.
+        */
+        const std::string& getCacheDirectory() const { return mCacheDirectory; }
+
+        /** Get the package filename.
+        */
+        const std::string& getFilename() const { return mFilename; }
+
+    private:
+        ScenePackage() = default;
+
+        struct Entry
+        {
+            uint32_t type;
+            std::string name;
+            uint64_t hash;
+            uint64_t offset;
+            uint64_t size;
+            uint32_t dependencyCount;
+            bool materialized = false;
+        };
+
+        bool writeEntry(Entry& entry);
+
+        std::vector<Entry> mEntries;
+        std::unordered_map<std::string, uint32_t> mNameToEntry;
+        uint32_t mSceneEntry = -1;
+
+        const uint8_t* mpData = nullptr;
+        size_t mSize = 0;
+        std::string mFilename;
+        std::string mCacheDirectory;
+        std::mutex mMaterializeMutex;   // Models can share dependencies, so entries are written one at a time
+    };
+}
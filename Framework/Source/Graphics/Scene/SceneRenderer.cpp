@@ -32,6 +32,7 @@
 #include "API/ConstantBuffer.h"
 #include "API/RenderContext.h"
 #include "Scene.h"
+#include "Graphics/TextureStreamer.h"
 #include "Utils/Platform/OS.h"
 #include "VR/OpenVR/VRSystem.h"
 #include "API/Device.h"
@@ -47,6 +48,8 @@ namespace Falcor
     size_t SceneRenderer::sPrevWorldMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPosDequantScaleOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPosDequantOffsetOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
@@ -59,6 +62,9 @@ namespace Falcor
     const char* SceneRenderer::kProbeSharedVarName = "gProbeShared";
     const char* SceneRenderer::kAreaLightCbName = "InternalAreaLightCB";
 
+    static const Program::DefineSymbol kMaterialFlagsDefine = Program::internDefine("_MS_STATIC_MATERIAL_FLAGS");
+    static const Program::DefineSymbol kVertexBlendingDefine = Program::internDefine("_VERTEX_BLENDING");
+
 
     SceneRenderer::SharedPtr SceneRenderer::create(const Scene::SharedPtr& pScene)
     {
@@ -92,6 +98,12 @@ namespace Falcor
                 sMeshIdOffset = pType->findMember("gMeshId")->getOffset();
                 sDrawIDOffset = pType->findMember("gDrawId[0]")->getOffset();
                 sPrevWorldMatOffset = pType->findMember("gPrevWorldMat[0]")->getOffset();
+
+                // Programs using their own per-mesh CB might not declare the dequantization constants
+                const auto& pScale = pType->findMember("gPosDequantScale");
+                const auto& pOffset = pType->findMember("gPosDequantOffset");
+                sPosDequantScaleOffset = pScale ? pScale->getOffset() : ConstantBuffer::kInvalidOffset;
+                sPosDequantOffsetOffset = pOffset ? pOffset->getOffset() : ConstantBuffer::kInvalidOffset;
             }
         }
 
@@ -124,7 +136,15 @@ namespace Falcor
             }
 
             // Set lights
-            if (sLightArrayOffset != ConstantBuffer::kInvalidOffset)
+            if (mpSnapshot && sLightArrayOffset != ConstantBuffer::kInvalidOffset)
+            {
+                assert(mpSnapshot->getLightCount() <= MAX_LIGHT_SOURCES);
+                for (uint_t i = 0; i < mpSnapshot->getLightCount(); i++)
+                {
+                    pCB->setBlob(&mpSnapshot->getLightData(i), sLightArrayOffset + (i * Light::getShaderStructSize()), Light::getShaderStructSize());
+                }
+            }
+            else if (sLightArrayOffset != ConstantBuffer::kInvalidOffset)
             {
                 assert(mpScene->getLightCount() <= MAX_LIGHT_SOURCES);  // Max array size in the shader
                 for (uint_t i = 0; i < mpScene->getLightCount(); i++)
@@ -134,7 +154,7 @@ namespace Falcor
             }
             if (sLightCountOffset != ConstantBuffer::kInvalidOffset)
             {
-                pCB->setVariable(sLightCountOffset, mpScene->getLightCount());
+                pCB->setVariable(sLightCountOffset, mpSnapshot ? mpSnapshot->getLightCount() : mpScene->getLightCount());
             }
             if (mpScene->getLightProbeCount() > 0)
             {
@@ -165,25 +185,37 @@ namespace Falcor
         }
     }
 
+    void SceneRenderer::setBones(const CurrentWorkingData& currentData, const mat4* pBoneMat, const mat4* pInvTransposeBoneMat, uint32_t boneCount)
+    {
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kBoneCbName).get();
+        if (pCB != nullptr)
+        {
+            if (sBonesOffset == ConstantBuffer::kInvalidOffset || sBonesInvTransposeOffset == ConstantBuffer::kInvalidOffset)
+            {
+                sBonesOffset = pCB->getVariableOffset("gBoneMat[0]");
+                sBonesInvTransposeOffset = pCB->getVariableOffset("gInvTransposeBoneMat[0]");
+            }
+
+            assert(boneCount <= MAX_BONES);
+            pCB->setVariableArray(sBonesOffset, pBoneMat, boneCount);
+            pCB->setVariableArray(sBonesInvTransposeOffset, pInvTransposeBoneMat, boneCount);
+        }
+    }
+
     bool SceneRenderer::setPerModelData(const CurrentWorkingData& currentData)
     {
         const Model* pModel = currentData.pModel;
 
-        // Set bones
-        if (pModel->hasBones())
+        // Set bones. Models with per-instance animation set them per model instance.
+        if (pModel->hasBones() && pModel->hasInstancedAnimation() == false)
         {
-            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kBoneCbName).get();
-            if (pCB != nullptr)
+            if (mpSnapshot)
             {
-                if (sBonesOffset == ConstantBuffer::kInvalidOffset || sBonesInvTransposeOffset == ConstantBuffer::kInvalidOffset)
-                {
-                    sBonesOffset = pCB->getVariableOffset("gBoneMat[0]");
-                    sBonesInvTransposeOffset = pCB->getVariableOffset("gInvTransposeBoneMat[0]");
-                }
-
-                assert(pModel->getBoneCount() <= MAX_BONES);
-                pCB->setVariableArray(sBonesOffset, pModel->getBoneMatrices(), pModel->getBoneCount());
-                pCB->setVariableArray(sBonesInvTransposeOffset, pModel->getBoneInvTransposeMatrices(), pModel->getBoneCount());
+                setBones(currentData, mpSnapshot->getBoneMatrices(currentData.modelID), mpSnapshot->getBoneInvTransposeMatrices(currentData.modelID), pModel->getBoneCount());
+            }
+            else
+            {
+                setBones(currentData, pModel->getBoneMatrices(), pModel->getBoneInvTransposeMatrices(), pModel->getBoneCount());
             }
         }
         return true;
@@ -191,6 +223,19 @@ namespace Falcor
 
     bool SceneRenderer::setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID)
     {
+        const Model* pModel = currentData.pModel;
+
+        if (pModel->hasInstancedAnimation())
+        {
+            if (mpSnapshot)
+            {
+                setBones(currentData, mpSnapshot->getInstanceBoneMatrices(currentData.modelID, instanceID), mpSnapshot->getInstanceBoneInvTransposeMatrices(currentData.modelID, instanceID), pModel->getBoneCount());
+            }
+            else
+            {
+                setBones(currentData, pModel->getInstanceBoneMatrices(instanceID), pModel->getInstanceBoneInvTransposeMatrices(instanceID), pModel->getBoneCount());
+            }
+        }
         return true;
     }
 
@@ -199,6 +244,19 @@ namespace Falcor
         return true;
     }
 
+    void SceneRenderer::setMeshConstants(ConstantBuffer* pCB, const Mesh* pMesh)
+    {
+        pCB->setVariable(sMeshIdOffset, pMesh->getId());
+
+        // Quantized positions are stored relative to the mesh's bounding-box, see Model::LoadFlags::QuantizePositions
+        if (sPosDequantScaleOffset != ConstantBuffer::kInvalidOffset)
+        {
+            const BoundingBox& box = pMesh->getBoundingBox();
+            pCB->setVariable(sPosDequantScaleOffset, box.extent * 2.f);
+            pCB->setVariable(sPosDequantOffsetOffset, box.center - box.extent);
+        }
+    }
+
     bool SceneRenderer::setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID)
     {
         ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
@@ -206,13 +264,30 @@ namespace Falcor
         {
             const Mesh* pMesh = pMeshInstance->getObject().get();
 
-            glm::mat4 worldMat = pModelInstance->getTransformMatrix();
-            glm::mat4 prevWorldMat = pModelInstance->getPrevTransformMatrix();
+            glm::mat4 worldMat;
+            glm::mat4 prevWorldMat;
 
-            if (pMesh->hasBones() == false)
+            if (mpSnapshot)
+            {
+                worldMat = mpSnapshot->getWorldMatrix(currentData.transformID);
+                prevWorldMat = mpSnapshot->getPrevWorldMatrix(currentData.transformID);
+            }
+            else if (currentData.transformID != TransformHierarchy::kInvalidNode)
             {
-                worldMat = worldMat * pMeshInstance->getTransformMatrix();
-                prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                const TransformHierarchy* pTransforms = mpScene->getTransformHierarchy().get();
+                worldMat = pTransforms->getWorldMatrix(currentData.transformID);
+                prevWorldMat = pTransforms->getPrevWorldMatrix(currentData.transformID);
+            }
+            else
+            {
+                worldMat = pModelInstance->getTransformMatrix();
+                prevWorldMat = pModelInstance->getPrevTransformMatrix();
+
+                if (pMesh->hasBones() == false)
+                {
+                    worldMat = worldMat * pMeshInstance->getTransformMatrix();
+                    prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+                }
             }
 
             glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
@@ -222,8 +297,14 @@ namespace Falcor
             pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
             pCB->setBlob(&prevWorldMat, sPrevWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
 
-            // Set mesh id
-            pCB->setVariable(sMeshIdOffset, pMesh->getId());
+            setMeshConstants(pCB, pMesh);
+
+            if (currentData.useMaterialTable)
+            {
+                // HLSL places each element of a CB array in its own 16B register
+                uint32_t materialIndex = mpMaterialTable->getMaterialIndex(pMesh->getMaterial().get());
+                pCB->setVariable(currentData.materialIndexOffset + drawInstanceID * 16, materialIndex);
+            }
         }
 
         return true;
@@ -231,17 +312,36 @@ namespace Falcor
 
     bool SceneRenderer::setPerMaterialData(const CurrentWorkingData& currentData, const Material* pMaterial)
     {
+        // With the material table the material is selected by the per-instance index, nothing to bind
+        if (currentData.useMaterialTable) return true;
+
         currentData.pVars->setParameterBlock("gMaterial", pMaterial->getParameterBlock());
         return true;
     }
 
-    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount)
+    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex)
     {
         // Draw
-        currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
+        currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, 0);
+        mStats.drawCount++;
     }
 
-    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
+    void SceneRenderer::executeIndirectDraw(const CurrentWorkingData& currentData, const Buffer* pArgBuffer, uint64_t argBufferOffset)
+    {
+        currentData.pContext->drawIndexedIndirect(pArgBuffer, argBufferOffset);
+        mStats.drawCount++;
+    }
+
+    void SceneRenderer::setVao(const CurrentWorkingData& currentData, const Vao::SharedPtr& pVao)
+    {
+        if (currentData.pState->getVao() != pVao)
+        {
+            currentData.pState->setVao(pVao);
+            mStats.vaoChangeCount++;
+        }
+    }
+
+    bool SceneRenderer::bindMaterial(CurrentWorkingData& currentData, const Mesh* pMesh)
     {
         currentData.pMaterial = pMesh->getMaterial().get();
         // Bind material
@@ -249,19 +349,31 @@ namespace Falcor
         {
             if (setPerMaterialData(currentData, currentData.pMaterial) == false)
             {
-                return;
+                return false;
             }
             mpLastMaterial = pMesh->getMaterial().get();
 
-            if(mCompileMaterialWithProgram)
+            if(mCompileMaterialWithProgram && currentData.useMaterialTable == false)
             {
-                currentData.pState->getProgram()->addDefine("_MS_STATIC_MATERIAL_FLAGS", std::to_string(mpLastMaterial->getFlags()));
+                mMaterialFlagsValue = Program::internDefine(std::to_string(mpLastMaterial->getFlags()));
             }
         }
+        return true;
+    }
 
-        executeDraw(currentData, pMesh->getIndexCount(), instanceCount);
+    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
+    {
+        if (bindMaterial(currentData, pMesh) == false)
+        {
+            return;
+        }
+
+        // The material define only applies to this draw
+        // The material table reads the flags at runtime, so draws with different materials share a program version
+        bool staticMaterial = mCompileMaterialWithProgram && currentData.useMaterialTable == false;
+        Program::ScopedDefine materialDefine(staticMaterial ? currentData.pState->getProgram().get() : nullptr, kMaterialFlagsDefine, mMaterialFlagsValue);
+        executeDraw(currentData, pMesh->getIndexCount(), instanceCount, pMesh->getStartIndex(), pMesh->getBaseVertex());
         postFlushDraw(currentData);
-        currentData.pState->getProgram()->removeDefine("_MS_STATIC_MATERIAL_FLAGS");
     }
 
     void SceneRenderer::postFlushDraw(const CurrentWorkingData& currentData)
@@ -269,10 +381,43 @@ namespace Falcor
 
     }
 
+    BoundingBox SceneRenderer::getMeshInstanceBounds(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance) const
+    {
+        // The simulation thread modifies the live instances while a snapshot is rendered, so only the captured matrices are read.
+        // The nodes of skinned meshes hold the model-instance transform, see Scene::rebuildTransformHierarchy()
+        if (mpSnapshot && currentData.transformID != TransformHierarchy::kInvalidNode)
+        {
+            return pMeshInstance->getObject()->getBoundingBox().transform(mpSnapshot->getWorldMatrix(currentData.transformID));
+        }
+
+        if (currentData.transformID != TransformHierarchy::kInvalidNode && pMeshInstance->getObject()->hasBones() == false)
+        {
+            return pMeshInstance->getObject()->getBoundingBox().transform(mpScene->getTransformHierarchy()->getWorldMatrix(currentData.transformID));
+        }
+        else
+        {
+            return pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+        }
+    }
+
     bool SceneRenderer::cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance)
     {
-        BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
-        return currentData.pCamera->isObjectCulled(box);
+        return currentData.pCamera->isObjectCulled(getMeshInstanceBounds(currentData, pModelInstance, pMeshInstance));
+    }
+
+    void SceneRenderer::reportTextureUsage(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, TextureStreamer* pStreamer)
+    {
+        // Approximate the projected size of the instance from its bounding sphere
+        BoundingBox box = getMeshInstanceBounds(currentData, pModelInstance, pMeshInstance);
+        float radius = glm::length(box.extent);
+        float distance = glm::length(box.center - currentData.pCamera->getPosition());
+        float viewportHeight = currentData.pState->getViewport(0).height;
+        float screenSize = viewportHeight;
+        if (distance > radius)
+        {
+            screenSize = std::min(viewportHeight, radius / distance * currentData.pCamera->getProjMatrix()[1][1] * viewportHeight);
+        }
+        pStreamer->reportMaterialUsage(currentData.pMaterial, screenSize);
     }
 
     void SceneRenderer::renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID)
@@ -283,16 +428,15 @@ namespace Falcor
         if (setPerMeshData(currentData, pMesh))
         {
             Program* pProgram = currentData.pState->getProgram().get();
-            bool useVsSkinning = pMesh->hasBones() && !pModel->getSkinningCache();
-            if (useVsSkinning)
-            {
-                pProgram->addDefine("_VERTEX_BLENDING");
-            }
+            // The skinning cache holds a single pose per mesh, so models with per-instance animation are skinned in the vertex shader
+            bool useVsSkinning = pMesh->hasBones() && (!pModel->getSkinningCache() || pModel->hasInstancedAnimation());
+            Program::ScopedDefine vertexBlendingDefine(useVsSkinning ? pProgram : nullptr, kVertexBlendingDefine);
 
             // Bind VAO and set topology            
-            currentData.pState->setVao(useVsSkinning ? pMesh->getVao() : pModel->getMeshVao(pMesh));
+            setVao(currentData, useVsSkinning ? pMesh->getVao() : pModel->getMeshVao(pMesh));
 
             uint32_t activeInstances = 0;
+            TextureStreamer* pStreamer = TextureStreamer::getActive().get();
 
             const uint32_t instanceCount = pModel->getMeshInstanceCount(meshID);
             for (uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
@@ -301,8 +445,15 @@ namespace Falcor
 
                 if (pMeshInstance->isVisible())
                 {
+                    currentData.transformID = mpScene->getMeshInstanceTransformId(currentData.modelID, currentData.modelInstanceID, meshID, instanceID);
+
                     if ((mCullEnabled == false) || (cullMeshInstance(currentData, pModelInstance, pMeshInstance) == false))
                     {
+                        if (pStreamer)
+                        {
+                            reportTextureUsage(currentData, pModelInstance, pMeshInstance, pStreamer);
+                        }
+
                         if (setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, activeInstances))
                         {
                             currentData.drawID++;
@@ -323,12 +474,50 @@ namespace Falcor
             {
                 draw(currentData, pMesh, activeInstances);
             }
+        }
+    }
+
+    void SceneRenderer::renderIndirectDraws(CurrentWorkingData& currentData)
+    {
+        mpLastMaterial = nullptr;
+        const Buffer* pArgBuffer = mpIndirectDrawList->getArgBuffer().get();
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+        Program* pProgram = currentData.pState->getProgram().get();
+        bool staticMaterial = mCompileMaterialWithProgram && currentData.useMaterialTable == false;
+
+        const auto& draws = mpIndirectDrawList->getDraws();
+        uint32_t modelID = -1;
+        bool modelEnabled = false;
+        for (uint32_t drawIndex = 0; drawIndex < (uint32_t)draws.size(); drawIndex++)
+        {
+            const IndirectDrawList::Draw& draw = draws[drawIndex];
+            if (draw.modelID != modelID)
+            {
+                modelID = draw.modelID;
+                currentData.modelID = modelID;
+                currentData.pModel = draw.pModel;
+                modelEnabled = setPerModelData(currentData);
+            }
+            if (modelEnabled == false) continue;
 
-            // Restore the program state
-            if (useVsSkinning)
+            if (draw.modelInstanceID != IndirectDrawList::kInvalidInstance)
             {
-                pProgram->removeDefine("_VERTEX_BLENDING");
+                currentData.modelInstanceID = draw.modelInstanceID;
+                if (setPerModelInstanceData(currentData, mpScene->getModelInstance(modelID, draw.modelInstanceID).get(), draw.modelInstanceID) == false) continue;
             }
+
+            if (setPerMeshData(currentData, draw.pMesh) == false) continue;
+            if (bindMaterial(currentData, draw.pMesh) == false) continue;
+
+            setVao(currentData, draw.pVao);
+            setMeshConstants(pCB, draw.pMesh);
+            pCB->setVariable(currentData.indirectDrawBaseOffset, draw.visibleBase);
+            currentData.drawID = draw.visibleBase;
+
+            Program::ScopedDefine vertexBlendingDefine(draw.useVsSkinning ? pProgram : nullptr, kVertexBlendingDefine);
+            Program::ScopedDefine materialDefine(staticMaterial ? pProgram : nullptr, kMaterialFlagsDefine, mMaterialFlagsValue);
+            executeIndirectDraw(currentData, pArgBuffer, drawIndex * IndirectDrawList::kDrawArgsSize);
+            postFlushDraw(currentData);
         }
     }
 
@@ -345,21 +534,56 @@ namespace Falcor
 
     bool SceneRenderer::update(double currentTime)
     {
+        if (TextureStreamer::getActive())
+        {
+            TextureStreamer::getActive()->update();
+        }
         return mpScene->update(currentTime, mpCameraController.get());
     }
 
+    bool SceneRenderer::simulate(double currentTime, uint64_t frameID, SceneSnapshot* pSnapshot)
+    {
+        mpScene->setDeferModelGpuUpdates(true);
+        bool changed = mpScene->update(currentTime, mpCameraController.get());
+        mpScene->setDeferModelGpuUpdates(false);
+        pSnapshot->capture(mpScene.get(), currentTime, frameID);
+        return changed;
+    }
+
+    void SceneRenderer::setSnapshot(const SceneSnapshot::SharedPtr& pSnapshot)
+    {
+        assert(pSnapshot == nullptr || pSnapshot->getScene() == mpScene.get());
+        mpSnapshot = pSnapshot;
+        if (mpSnapshot)
+        {
+            mpSnapshot->updateGpuData();
+        }
+    }
+
+    Camera::SharedPtr SceneRenderer::getActiveCamera() const
+    {
+        return mpSnapshot ? mpSnapshot->getCamera() : mpScene->getActiveCamera();
+    }
+
     void SceneRenderer::renderScene(RenderContext* pContext)
     {
-        renderScene(pContext, mpScene->getActiveCamera().get());
+        renderScene(pContext, getActiveCamera().get());
     }
 
     void SceneRenderer::renderScene(CurrentWorkingData& currentData)
     {
         setPerFrameData(currentData);
 
+        if (currentData.useIndirectDraw)
+        {
+            renderIndirectDraws(currentData);
+            return;
+        }
+
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
         {
             currentData.pModel = mpScene->getModel(modelID).get();
+            currentData.modelID = modelID;
 
             if (setPerModelData(currentData))
             {
@@ -368,6 +592,7 @@ namespace Falcor
                     const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
                     if (pInstance->isVisible())
                     {
+                        currentData.modelInstanceID = instanceID;
                         if (setPerModelInstanceData(currentData, pInstance, instanceID))
                         {
                             renderModelInstance(currentData, pInstance);
@@ -382,6 +607,12 @@ namespace Falcor
     {
         updateVariableOffsets(pContext->getGraphicsVars()->getReflection().get());
 
+        // The simulation thread owns the live transforms while rendering from a snapshot
+        if (mpSnapshot == nullptr)
+        {
+            mpScene->updateTransforms();
+        }
+
         CurrentWorkingData currentData;
         currentData.pContext = pContext;
         currentData.pState = pContext->getGraphicsState().get();
@@ -390,6 +621,31 @@ namespace Falcor
         currentData.pMaterial = nullptr;
         currentData.pModel = nullptr;
         currentData.drawID = 0;
+        mStats = Stats();
+
+        if (mMaterialTableEnabled && MaterialTable::isDeclared(currentData.pVars))
+        {
+            if (mpMaterialTable == nullptr) mpMaterialTable = MaterialTable::create();
+            mpMaterialTable->update(mpScene.get());
+            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+            currentData.materialIndexOffset = pCB ? pCB->getVariableOffset("gMaterialIndex[0]") : ConstantBuffer::kInvalidOffset;
+            currentData.useMaterialTable = (currentData.materialIndexOffset != ConstantBuffer::kInvalidOffset) && mpMaterialTable->setIntoProgramVars(currentData.pVars);
+        }
+
+        if (mIndirectDrawEnabled && IndirectDrawList::isDeclared(currentData.pVars))
+        {
+            if (mpIndirectDrawList == nullptr) mpIndirectDrawList = IndirectDrawList::create();
+            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+            currentData.indirectDrawBaseOffset = pCB ? pCB->getVariableOffset("gIndirectDrawBase") : ConstantBuffer::kInvalidOffset;
+            if (mpIndirectDrawList && currentData.indirectDrawBaseOffset != ConstantBuffer::kInvalidOffset)
+            {
+                // The instance table and the draw arguments are only rebuilt when the scene changes. Only the transforms which moved are uploaded
+                mpIndirectDrawList->update(mpScene.get(), currentData.useMaterialTable ? mpMaterialTable.get() : nullptr);
+                const Buffer::SharedPtr& pTransforms = mpSnapshot ? mpSnapshot->getTransformGpuBuffer() : mpScene->getTransformHierarchy()->getGpuBuffer();
+                mpIndirectDrawList->cull(pContext, pCamera, pTransforms);
+                currentData.useIndirectDraw = mpIndirectDrawList->setIntoProgramVars(currentData.pVars);
+            }
+        }
         renderScene(currentData);
     }
 
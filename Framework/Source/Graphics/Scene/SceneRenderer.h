@@ -30,9 +30,12 @@
 #include "Utils/Gui.h"
 #include "Graphics/Camera/CameraController.h"
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/SceneSnapshot.h"
 #include "Utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
 #include "Utils/DebugDrawer.h"
+#include "Graphics/Material/MaterialTable.h"
+#include "Graphics/Scene/IndirectDrawList.h"
 
 namespace Falcor
 {
@@ -42,6 +45,7 @@ namespace Falcor
     class Material;
     class Mesh;
     class Camera;
+    class TextureStreamer;
 
     class SceneRenderer
     {
@@ -65,11 +69,32 @@ namespace Falcor
         */
         virtual void renderScene(RenderContext* pContext, const Camera* pCamera);
 
-        /** Update the camera and model animation.
+        /** Update the camera, model animation and the active texture streamer.
             Should be called before renderScene(), unless not animations are used and you update the camera manually
         */
         bool update(double currentTime);
 
+        /** Update the scene without any GPU work and capture the result. Use instead of update() when the scene is updated on a simulation thread.
+            The skinning and texture streaming work is done by setSnapshot() on the render thread.
+            \param[in] currentTime The time to update the scene to
+            \param[in] frameID The frame the snapshot will be rendered in
+            \param[in] pSnapshot The snapshot to capture the scene into. It must not be in use by the render thread
+            \return true if the scene changed
+        */
+        bool simulate(double currentTime, uint64_t frameID, SceneSnapshot* pSnapshot);
+
+        /** Render from a snapshot instead of the live scene. Call on the render thread once per frame, before renderScene(). Pass nullptr to render the live scene again.
+        */
+        void setSnapshot(const SceneSnapshot::SharedPtr& pSnapshot);
+
+        /** Get the snapshot set with setSnapshot()
+        */
+        const SceneSnapshot::SharedPtr& getSnapshot() const { return mpSnapshot; }
+
+        /** Get the camera renderScene() uses. This is the snapshot camera if a snapshot is set, otherwise the scene's active camera.
+        */
+        Camera::SharedPtr getActiveCamera() const;
+
         bool onKeyEvent(const KeyboardEvent& keyEvent);
         bool onMouseEvent(const MouseEvent& mouseEvent);
 
@@ -100,6 +125,46 @@ namespace Falcor
 
         void toggleStaticMaterialCompilation(bool on) { mCompileMaterialWithProgram = on; }
 
+        /** Enable/disable the scene material table. When enabled and the program is compiled with _MATERIAL_TABLE, all the scene materials are bound once per renderScene() call and draws only pass a material index.
+            Programs which don't declare the table use the per-material parameter-block
+        */
+        void toggleMaterialTable(bool enable) { mMaterialTableEnabled = enable; }
+
+        /** Check if the scene material table is enabled
+        */
+        bool isMaterialTableEnabled() const { return mMaterialTableEnabled; }
+
+        /** Get the scene material table. Valid after the first renderScene() call which used it
+        */
+        const MaterialTable::SharedPtr& getMaterialTable() const { return mpMaterialTable; }
+
+        /** Enable/disable GPU-driven indirect draws. When enabled and the program is compiled with _INDIRECT_DRAW, the mesh instances are culled on the GPU against the camera frustum, and
+            optionally against the previous frame's Hi-Z buffer, and each mesh is drawn with a single indirect call whose instance count is written by the GPU. See IndirectDrawList.
+            The per-instance callbacks (cullMeshInstance() and setPerMeshInstanceData()) are not called for indirect draws, and instances are always culled.
+            Programs which don't declare the indirect-draw resources use the CPU path
+        */
+        void toggleIndirectDraw(bool enable) { mIndirectDrawEnabled = enable; }
+
+        /** Check if indirect draws are enabled
+        */
+        bool isIndirectDrawEnabled() const { return mIndirectDrawEnabled; }
+
+        /** Get the indirect draw list. Valid after the first renderScene() call which used it. Use it to set or build the Hi-Z buffer and to validate the culling results
+        */
+        const IndirectDrawList::SharedPtr& getIndirectDrawList() const { return mpIndirectDrawList; }
+
+        /** Statistics of the last renderScene() call
+        */
+        struct Stats
+        {
+            uint32_t drawCount = 0;         ///< Number of draw calls, direct and indirect
+            uint32_t vaoChangeCount = 0;    ///< Number of times the VAO changed between draws. Meshes packed into the same GeometryArena share a VAO
+        };
+
+        /** Get the statistics of the last renderScene() call
+        */
+        const Stats& getStats() const { return mStats; }
+
     protected:
 
         struct CurrentWorkingData
@@ -112,6 +177,13 @@ namespace Falcor
             const Material* pMaterial = nullptr;
 
             uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
+            uint32_t modelID = 0;
+            uint32_t modelInstanceID = 0;
+            uint32_t transformID = TransformHierarchy::kInvalidNode; // Node of the current mesh instance in the scene's transform hierarchy
+            bool useMaterialTable = false; // The program declares the material table and it's bound
+            size_t materialIndexOffset = ConstantBuffer::kInvalidOffset; // Offset of gMaterialIndex[0] in the per-mesh CB
+            bool useIndirectDraw = false; // The program declares the indirect-draw resources and the culling pass ran
+            size_t indirectDrawBaseOffset = ConstantBuffer::kInvalidOffset; // Offset of gIndirectDrawBase in the per-mesh CB
         };
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -135,32 +207,53 @@ namespace Falcor
         static size_t sPrevWorldMatOffset;
         static size_t sWorldInvTransposeMatOffset;
         static size_t sMeshIdOffset;
+        static size_t sPosDequantScaleOffset;
+        static size_t sPosDequantOffsetOffset;
         static size_t sDrawIDOffset;
 
         static void updateVariableOffsets(const ProgramReflection* pReflector);
 
+        /** Set the mesh id and the position dequantization constants into the per-mesh CB
+        */
+        void setMeshConstants(ConstantBuffer* pCB, const Mesh* pMesh);
+
         virtual void setPerFrameData(const CurrentWorkingData& currentData);
         virtual bool setPerModelData(const CurrentWorkingData& currentData);
         virtual bool setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID);
         virtual bool setPerMeshData(const CurrentWorkingData& currentData, const Mesh* pMesh);
         virtual bool setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID);
         virtual bool setPerMaterialData(const CurrentWorkingData& currentData, const Material* pMaterial);
-        virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount);
+        virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex);
+        virtual void executeIndirectDraw(const CurrentWorkingData& currentData, const Buffer* pArgBuffer, uint64_t argBufferOffset);
         virtual void postFlushDraw(const CurrentWorkingData& currentData);
         virtual bool cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance);
 
+        BoundingBox getMeshInstanceBounds(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance) const;
+        void reportTextureUsage(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, TextureStreamer* pStreamer);
+
+        void setBones(const CurrentWorkingData& currentData, const mat4* pBoneMat, const mat4* pInvTransposeBoneMat, uint32_t boneCount);
         void renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance);
         void renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID);
         void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
+        bool bindMaterial(CurrentWorkingData& currentData, const Mesh* pMesh);
+        void renderIndirectDraws(CurrentWorkingData& currentData);
+        void setVao(const CurrentWorkingData& currentData, const Vao::SharedPtr& pVao);
 
         void renderScene(CurrentWorkingData& currentData);
 
+        SceneSnapshot::SharedPtr mpSnapshot;
         CameraControllerType mCamControllerType = CameraControllerType::SixDof;
         CameraController::SharedPtr mpCameraController;
 
         uint32_t mMaxInstanceCount = 64;
         const Material* mpLastMaterial = nullptr;
+        Program::DefineSymbol mMaterialFlagsValue = Program::kEmptyDefine;
         bool mCullEnabled = true;
         bool mCompileMaterialWithProgram = true;
+        bool mMaterialTableEnabled = true;
+        MaterialTable::SharedPtr mpMaterialTable;
+        bool mIndirectDrawEnabled = true;
+        IndirectDrawList::SharedPtr mpIndirectDrawList;
+        Stats mStats;
     };
 }
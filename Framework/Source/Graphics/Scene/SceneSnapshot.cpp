@@ -0,0 +1,161 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneSnapshot.h"
+#include "Graphics/TextureStreamer.h"
+
+namespace Falcor
+{
+    SceneSnapshot::SharedPtr SceneSnapshot::create()
+    {
+        return SharedPtr(new SceneSnapshot);
+    }
+
+    static void copyBones(std::vector<glm::mat4>& dst, size_t offset, const glm::mat4* pSrc, uint32_t boneCount)
+    {
+        if (pSrc)
+        {
+            std::copy(pSrc, pSrc + boneCount, dst.begin() + offset);
+        }
+    }
+
+    void SceneSnapshot::capture(const Scene* pScene, double currentTime, uint64_t frameID)
+    {
+        mpScene = pScene;
+        mStructureVersion = pScene->getStructureVersion();
+        mTime = currentTime;
+        mFrameID = frameID;
+        mCaptureTime = CpuTimer::getCurrentTimePoint();
+        mGpuDataUpdated = false;
+
+        // Camera. Calling getData() makes sure the matrices are computed here, and not lazily on the render thread
+        if (pScene->getCameraCount() > 0)
+        {
+            if (mpCamera == nullptr) mpCamera = Camera::create();
+            const Camera* pCamera = pScene->getActiveCamera().get();
+            pCamera->getData();
+            *mpCamera = *pCamera;
+        }
+        else
+        {
+            mpCamera = nullptr;
+        }
+
+        mNodeMatrices = pScene->getTransformHierarchy()->getNodeMatrices();
+        mTransformBufferDirty = true;
+
+        // Bones
+        mModelBones.resize(pScene->getModelCount());
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            ModelBones& bones = mModelBones[modelID];
+            bones.boneCount = pModel->hasBones() ? pModel->getBoneCount() : 0;
+            if (bones.boneCount == 0) continue;
+
+            uint32_t poseCount = 1 + pModel->getAnimationInstanceCount();
+            bones.matrices.resize(poseCount * bones.boneCount);
+            bones.invTransposeMatrices.resize(poseCount * bones.boneCount);
+            copyBones(bones.matrices, 0, pModel->getBoneMatrices(), bones.boneCount);
+            copyBones(bones.invTransposeMatrices, 0, pModel->getBoneInvTransposeMatrices(), bones.boneCount);
+            for (uint32_t i = 0; i < pModel->getAnimationInstanceCount(); i++)
+            {
+                size_t offset = (1 + i) * bones.boneCount;
+                copyBones(bones.matrices, offset, pModel->getInstanceBoneMatrices(i), bones.boneCount);
+                copyBones(bones.invTransposeMatrices, offset, pModel->getInstanceBoneInvTransposeMatrices(i), bones.boneCount);
+            }
+        }
+
+        // Lights
+        mLights.resize(pScene->getLightCount());
+        for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+        {
+            mLights[i] = pScene->getLight(i)->getData();
+        }
+    }
+
+    void SceneSnapshot::updateGpuData()
+    {
+        if (mGpuDataUpdated) return;
+        mGpuDataUpdated = true;
+
+        if (TextureStreamer::getActive())
+        {
+            TextureStreamer::getActive()->update();
+        }
+
+        for (uint32_t modelID = 0; modelID < (uint32_t)mModelBones.size(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            SkinningCache::SharedPtr pCache = pModel->getSkinningCache();
+            if (pCache && mModelBones[modelID].boneCount)
+            {
+                pCache->update(pModel, getBoneMatrices(modelID), getBoneInvTransposeMatrices(modelID));
+            }
+        }
+    }
+
+    const Buffer::SharedPtr& SceneSnapshot::getTransformGpuBuffer()
+    {
+        const size_t requiredSize = std::max<size_t>(1, mNodeMatrices.size()) * sizeof(TransformHierarchy::NodeMatrices);
+        if (mpTransformBuffer == nullptr || mpTransformBuffer->getSize() < requiredSize)
+        {
+            mpTransformBuffer = Buffer::create(requiredSize, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mNodeMatrices.empty() ? nullptr : mNodeMatrices.data());
+        }
+        else if (mTransformBufferDirty && mNodeMatrices.size())
+        {
+            mpTransformBuffer->updateData(mNodeMatrices.data(), 0, mNodeMatrices.size() * sizeof(TransformHierarchy::NodeMatrices));
+        }
+        mTransformBufferDirty = false;
+        return mpTransformBuffer;
+    }
+
+    const glm::mat4* SceneSnapshot::getBoneMatrices(uint32_t modelID) const
+    {
+        const ModelBones& bones = mModelBones[modelID];
+        return bones.boneCount ? bones.matrices.data() : nullptr;
+    }
+
+    const glm::mat4* SceneSnapshot::getBoneInvTransposeMatrices(uint32_t modelID) const
+    {
+        const ModelBones& bones = mModelBones[modelID];
+        return bones.boneCount ? bones.invTransposeMatrices.data() : nullptr;
+    }
+
+    const glm::mat4* SceneSnapshot::getInstanceBoneMatrices(uint32_t modelID, uint32_t animationInstanceID) const
+    {
+        const ModelBones& bones = mModelBones[modelID];
+        return bones.boneCount ? bones.matrices.data() + (1 + animationInstanceID) * bones.boneCount : nullptr;
+    }
+
+    const glm::mat4* SceneSnapshot::getInstanceBoneInvTransposeMatrices(uint32_t modelID, uint32_t animationInstanceID) const
+    {
+        const ModelBones& bones = mModelBones[modelID];
+        return bones.boneCount ? bones.invTransposeMatrices.data() + (1 + animationInstanceID) * bones.boneCount : nullptr;
+    }
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Graphics/Scene/Scene.h"
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    /** Copy of the scene state a SceneRenderer reads while rendering a frame.
+        When the scene is updated on a simulation thread, the simulation thread captures a snapshot after each update and the render thread renders the previous snapshot, while the next update modifies the live scene. Snapshots are double-buffered by their owner.
+        Only the state that changes during an update is copied: transform hierarchy matrices, bone matrices, the active camera and the light data. Models, meshes, materials and the scene structure are shared with the live scene and may only be changed while the simulation thread is idle.
+        The render thread owns the snapshot camera and may modify it, for example to set the TAA jitter.
+    */
+    class SceneSnapshot
+    {
+    public:
+        using SharedPtr = std::shared_ptr<SceneSnapshot>;
+        using SharedConstPtr = std::shared_ptr<const SceneSnapshot>;
+
+        static SharedPtr create();
+
+        /** Copy the state of an updated scene. Called on the simulation thread, after Scene::update()
+            \param[in] pScene The scene
+            \param[in] currentTime The time the scene was updated to
+            \param[in] frameID The frame the snapshot will be rendered in
+        */
+        void capture(const Scene* pScene, double currentTime, uint64_t frameID);
+
+        /** Check if the snapshot was captured from the current structure of a scene
+        */
+        bool isCurrent(const Scene* pScene) const { return pScene && pScene == mpScene && pScene->getStructureVersion() == mStructureVersion; }
+
+        /** Run the GPU work the update deferred: compute skinning of the captured pose and the active texture streamer update. Only the first call after capture() does anything.
+            Called on the render thread by SceneRenderer::setSnapshot()
+        */
+        void updateGpuData();
+
+        const Scene* getScene() const { return mpScene; }
+        double getTime() const { return mTime; }
+        uint64_t getFrameID() const { return mFrameID; }
+
+        /** Get the CPU time at which capture() was called
+        */
+        CpuTimer::TimePoint getCaptureTime() const { return mCaptureTime; }
+
+        /** Get the copy of the scene's active camera
+        */
+        const Camera::SharedPtr& getCamera() const { return mpCamera; }
+
+        /** Get the matrices of a transform hierarchy node. See Scene::getMeshInstanceTransformId()
+        */
+        const glm::mat4& getWorldMatrix(uint32_t node) const { return mNodeMatrices[node].world; }
+        const glm::mat4& getPrevWorldMatrix(uint32_t node) const { return mNodeMatrices[node].prevWorld; }
+
+        /** Get a GPU buffer holding the captured transform hierarchy matrices, laid out like TransformHierarchy::getGpuBuffer(). Uploaded on the first call after capture()
+        */
+        const Buffer::SharedPtr& getTransformGpuBuffer();
+
+        /** Get the bone matrices of a model, or of one of its animation instances. Return nullptr if the model has no bones.
+        */
+        const glm::mat4* getBoneMatrices(uint32_t modelID) const;
+        const glm::mat4* getBoneInvTransposeMatrices(uint32_t modelID) const;
+        const glm::mat4* getInstanceBoneMatrices(uint32_t modelID, uint32_t animationInstanceID) const;
+        const glm::mat4* getInstanceBoneInvTransposeMatrices(uint32_t modelID, uint32_t animationInstanceID) const;
+
+        uint32_t getLightCount() const { return (uint32_t)mLights.size(); }
+        const LightData& getLightData(uint32_t lightID) const { return mLights[lightID]; }
+
+    private:
+        SceneSnapshot() = default;
+
+        // The model's pose comes first, followed by the pose of each animation instance
+        struct ModelBones
+        {
+            uint32_t boneCount = 0;
+            std::vector<glm::mat4> matrices;
+            std::vector<glm::mat4> invTransposeMatrices;
+        };
+
+        const Scene* mpScene = nullptr;
+        uint32_t mStructureVersion = 0;
+        double mTime = 0;
+        uint64_t mFrameID = 0;
+        CpuTimer::TimePoint mCaptureTime;
+        bool mGpuDataUpdated = true;
+
+        Camera::SharedPtr mpCamera;
+        std::vector<TransformHierarchy::NodeMatrices> mNodeMatrices;
+        Buffer::SharedPtr mpTransformBuffer;
+        bool mTransformBufferDirty = true;
+        std::vector<ModelBones> mModelBones;
+        std::vector<LightData> mLights;
+    };
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TransformHierarchy.h"
+
+namespace Falcor
+{
+    TransformHierarchy::SharedPtr TransformHierarchy::create()
+    {
+        return SharedPtr(new TransformHierarchy());
+    }
+
+    uint32_t TransformHierarchy::addNode(uint32_t parent, const glm::mat4& localTransform)
+    {
+        uint32_t node = getNodeCount();
+        assert(parent == kInvalidNode || parent < node);
+
+        NodeMatrices matrices;
+        matrices.world = (parent == kInvalidNode) ? localTransform : mMatrices[parent].world * localTransform;
+        matrices.prevWorld = matrices.world;
+
+        mParents.push_back(parent);
+        mLocalTransforms.push_back(localTransform);
+        mMatrices.push_back(matrices);
+        mDirty.push_back(0);
+        mMoved.push_back(0);
+
+        // The parent might be dirty, in which case the node's world matrix is recalculated in update()
+        mGpuDirtyBegin = std::min(mGpuDirtyBegin, node);
+        mGpuDirtyEnd = std::max(mGpuDirtyEnd, node + 1);
+        return node;
+    }
+
+    void TransformHierarchy::clear()
+    {
+        mParents.clear();
+        mLocalTransforms.clear();
+        mMatrices.clear();
+        mDirty.clear();
+        mMoved.clear();
+        mMovedNodes.clear();
+        mGpuDirtyBegin = kInvalidNode;
+        mGpuDirtyEnd = 0;
+        mHasDirtyNodes = false;
+    }
+
+    void TransformHierarchy::setLocalTransform(uint32_t node, const glm::mat4& localTransform)
+    {
+        assert(node < getNodeCount());
+        mLocalTransforms[node] = localTransform;
+        mDirty[node] = 1;
+        mHasDirtyNodes = true;
+    }
+
+    void TransformHierarchy::markChanged(uint32_t node)
+    {
+        if (mMoved[node] == 0)
+        {
+            mMoved[node] = 1;
+            mMovedNodes.push_back(node);
+        }
+        mGpuDirtyBegin = std::min(mGpuDirtyBegin, node);
+        mGpuDirtyEnd = std::max(mGpuDirtyEnd, node + 1);
+    }
+
+    void TransformHierarchy::beginFrame()
+    {
+        for (uint32_t node : mMovedNodes)
+        {
+            mMatrices[node].prevWorld = mMatrices[node].world;
+            mMoved[node] = 0;
+            mGpuDirtyBegin = std::min(mGpuDirtyBegin, node);
+            mGpuDirtyEnd = std::max(mGpuDirtyEnd, node + 1);
+        }
+        mMovedNodes.clear();
+    }
+
+    bool TransformHierarchy::update()
+    {
+        if (mHasDirtyNodes == false)
+        {
+            return false;
+        }
+
+        // Parents come before their children, so a dirty flag propagates down to the whole subtree in one pass.
+        // mDirty is reused to mark the nodes recalculated in this pass.
+        uint32_t begin = 0;
+        while (mDirty[begin] == 0) begin++;
+
+        for (uint32_t node = begin; node < getNodeCount(); node++)
+        {
+            uint32_t parent = mParents[node];
+            bool parentDirty = (parent != kInvalidNode) && mDirty[parent];
+            if (mDirty[node] || parentDirty)
+            {
+                mMatrices[node].world = (parent == kInvalidNode) ? mLocalTransforms[node] : mMatrices[parent].world * mLocalTransforms[node];
+                mDirty[node] = 1;
+                markChanged(node);
+            }
+        }
+
+        std::fill(mDirty.begin() + begin, mDirty.end(), 0);
+        mHasDirtyNodes = false;
+        return true;
+    }
+
+    const Buffer::SharedPtr& TransformHierarchy::getGpuBuffer()
+    {
+        const size_t requiredSize = std::max<size_t>(1, mMatrices.size()) * sizeof(NodeMatrices);
+        if (mpGpuBuffer == nullptr || mpGpuBuffer->getSize() < requiredSize)
+        {
+            mpGpuBuffer = Buffer::create(requiredSize, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, mMatrices.empty() ? nullptr : mMatrices.data());
+        }
+        else if (mGpuDirtyBegin < mGpuDirtyEnd)
+        {
+            const uint32_t end = std::min(mGpuDirtyEnd, getNodeCount());
+            if (mGpuDirtyBegin < end)
+            {
+                mpGpuBuffer->updateData(&mMatrices[mGpuDirtyBegin], mGpuDirtyBegin * sizeof(NodeMatrices), (end - mGpuDirtyBegin) * sizeof(NodeMatrices));
+            }
+        }
+
+        mGpuDirtyBegin = kInvalidNode;
+        mGpuDirtyEnd = 0;
+        return mpGpuBuffer;
+    }
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "API/Buffer.h"
+
+namespace Falcor
+{
+    /** Flattened transform hierarchy.
+        Local transforms are stored in contiguous arrays together with the parent index of each node. Nodes are sorted so that a parent always comes before its children,
+        which allows update() to propagate changes through dirty subtrees in a single linear pass.
+        World matrices and previous-frame world matrices are stored side by side, and can be uploaded to the GPU as a single buffer.
+    */
+    class TransformHierarchy
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TransformHierarchy>;
+        using SharedConstPtr = std::shared_ptr<const TransformHierarchy>;
+
+        static const uint32_t kInvalidNode = -1;
+
+        /** Matrices of a node, as laid out in the GPU buffer
+        */
+        struct NodeMatrices
+        {
+            glm::mat4 world;
+            glm::mat4 prevWorld;
+        };
+
+        static SharedPtr create();
+
+        /** Add a node.
+            \param[in] parent Index of the parent node, or kInvalidNode for root nodes. The parent must have been added before the node.
+            \param[in] localTransform Transform relative to the parent
+            \return The node index
+        */
+        uint32_t addNode(uint32_t parent, const glm::mat4& localTransform);
+
+        /** Remove all nodes
+        */
+        void clear();
+
+        /** Set the local transform of a node. The world matrices of the node and its subtree are updated on the next call to update().
+        */
+        void setLocalTransform(uint32_t node, const glm::mat4& localTransform);
+
+        /** Start a new frame. The previous-frame matrices of the nodes that moved since the last call are set to their current world matrices.
+        */
+        void beginFrame();
+
+        /** Update the world matrices of the dirty nodes and their subtrees.
+            \return true if any node moved
+        */
+        bool update();
+
+        uint32_t getNodeCount() const { return (uint32_t)mParents.size(); }
+        uint32_t getParent(uint32_t node) const { return mParents[node]; }
+        const glm::mat4& getLocalTransform(uint32_t node) const { return mLocalTransforms[node]; }
+        const glm::mat4& getWorldMatrix(uint32_t node) const { return mMatrices[node].world; }
+        const glm::mat4& getPrevWorldMatrix(uint32_t node) const { return mMatrices[node].prevWorld; }
+        const std::vector<NodeMatrices>& getNodeMatrices() const { return mMatrices; }
+
+        /** Get the GPU buffer holding an array of NodeMatrices. Uploads the range of nodes that changed since the last call.
+        */
+        const Buffer::SharedPtr& getGpuBuffer();
+
+    private:
+        TransformHierarchy() = default;
+        void markChanged(uint32_t node);
+
+        std::vector<uint32_t> mParents;
+        std::vector<glm::mat4> mLocalTransforms;
+        std::vector<NodeMatrices> mMatrices;
+        std::vector<uint8_t> mDirty;        // Local transform changed since the last update
+        std::vector<uint8_t> mMoved;        // World matrix changed since the last call to beginFrame()
+        std::vector<uint32_t> mMovedNodes;
+
+        Buffer::SharedPtr mpGpuBuffer;
+        uint32_t mGpuDirtyBegin = kInvalidNode;
+        uint32_t mGpuDirtyEnd = 0;
+        bool mHasDirtyNodes = false;
+    };
+}
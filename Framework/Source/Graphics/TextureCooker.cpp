@@ -0,0 +1,327 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureCooker.h"
+#include "TextureHelper.h"
+#include "Utils/BlockCompression.h"
+#include "Utils/MipGenerator.h"
+#include "Utils/DDSHeader.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
+#include "Utils/CpuTimer.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    // Bump this when the cooked output changes, so stale cache entries are not used
+    static const uint32_t kCookerVersion = 2;
+    static const uint32_t kDdsMagicNumber = 0x20534444;
+    static const uint32_t kDX10FourCC = 0x30315844;    // "DX10"
+
+    static TextureCooker::Settings sSettings;
+
+    void TextureCooker::setSettings(const Settings& settings)
+    {
+        sSettings = settings;
+    }
+
+    const TextureCooker::Settings& TextureCooker::getSettings()
+    {
+        return sSettings;
+    }
+
+    static uint64_t hashContent(const void* pData, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        // FNV-1a
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    static std::string getCacheDirectory()
+    {
+        return sSettings.cacheDirectory.empty() ? getExecutableDirectory() + "/TextureCache" : sSettings.cacheDirectory;
+    }
+
+    static bool isHdrImage(const std::string& filename)
+    {
+        std::string lower = filename;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        return hasSuffix(lower, ".hdr") || hasSuffix(lower, ".exr") || hasSuffix(lower, ".pfm");
+    }
+
+    /** Convert a bitmap to tightly packed RGBA8. Returns false if the bitmap format can't be cooked
+    */
+    static bool convertToRgba(const Bitmap* pBitmap, std::vector<uint8_t>& rgba)
+    {
+        size_t texelCount = (size_t)pBitmap->getWidth() * pBitmap->getHeight();
+        const uint8_t* pSrc = pBitmap->getData();
+        rgba.resize(texelCount * 4);
+
+        switch (pBitmap->getFormat())
+        {
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRX8Unorm:
+        {
+            bool hasAlpha = pBitmap->getFormat() == ResourceFormat::BGRA8Unorm;
+            for (size_t i = 0; i < texelCount; i++)
+            {
+                rgba[i * 4 + 0] = pSrc[i * 4 + 2];
+                rgba[i * 4 + 1] = pSrc[i * 4 + 1];
+                rgba[i * 4 + 2] = pSrc[i * 4 + 0];
+                rgba[i * 4 + 3] = hasAlpha ? pSrc[i * 4 + 3] : 0xFF;
+            }
+            return true;
+        }
+        case ResourceFormat::RG8Unorm:
+            for (size_t i = 0; i < texelCount; i++)
+            {
+                rgba[i * 4 + 0] = pSrc[i * 2 + 0];
+                rgba[i * 4 + 1] = pSrc[i * 2 + 1];
+                rgba[i * 4 + 2] = 0;
+                rgba[i * 4 + 3] = 0xFF;
+            }
+            return true;
+        case ResourceFormat::R8Unorm:
+            for (size_t i = 0; i < texelCount; i++)
+            {
+                rgba[i * 4 + 0] = pSrc[i];
+                rgba[i * 4 + 1] = 0;
+                rgba[i * 4 + 2] = 0;
+                rgba[i * 4 + 3] = 0xFF;
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static ResourceFormat selectCompressedFormat(ResourceFormat srcFormat, const std::vector<uint8_t>& rgba)
+    {
+        switch (srcFormat)
+        {
+        case ResourceFormat::R8Unorm:
+            return ResourceFormat::BC4Unorm;
+        case ResourceFormat::RG8Unorm:
+            return ResourceFormat::BC5Unorm;
+        default:
+            break;
+        }
+
+        if (sSettings.quality == TextureCooker::Quality::High)
+        {
+            return ResourceFormat::BC7Unorm;
+        }
+
+        for (size_t i = 3; i < rgba.size(); i += 4)
+        {
+            if (rgba[i] != 0xFF) return ResourceFormat::BC3Unorm;
+        }
+        return ResourceFormat::BC1Unorm;
+    }
+
+    static DXFormat getDxFormat(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::BC1Unorm:
+            return FORMAT_BC1_UNORM;
+        case ResourceFormat::BC3Unorm:
+            return FORMAT_BC3_UNORM;
+        case ResourceFormat::BC4Unorm:
+            return FORMAT_BC4_UNORM;
+        case ResourceFormat::BC5Unorm:
+            return FORMAT_BC5_UNORM;
+        case ResourceFormat::BC7Unorm:
+            return FORMAT_BC7_UNORM;
+        default:
+            should_not_get_here();
+            return FORMAT_UNKNOWN;
+        }
+    }
+
+    static uint32_t getCompressedChannelCount(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::BC4Unorm:
+            return 1;
+        case ResourceFormat::BC5Unorm:
+            return 2;
+        case ResourceFormat::BC1Unorm:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+
+    static bool writeDdsFile(const std::string& filename, ResourceFormat format, uint32_t width, uint32_t height, uint32_t mipCount, const std::vector<uint8_t>& data)
+    {
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kMipCountMask | DdsHeader::kLinearSizeMask;
+        header.height = height;
+        header.width = width;
+        header.linearSize = (uint32_t)BlockCompression::getCompressedSize(format, width, height);
+        header.depth = 1;
+        header.mipCount = mipCount;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = kDX10FourCC;
+        header.caps[0] = DdsHeader::kCapsTextureMask | ((mipCount > 1) ? (DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask) : 0);
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = getDxFormat(format);
+        dx10Header.resourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        std::ofstream stream(filename, std::ios::binary);
+        stream.write((const char*)&kDdsMagicNumber, sizeof(kDdsMagicNumber));
+        stream.write((const char*)&header, sizeof(header));
+        stream.write((const char*)&dx10Header, sizeof(dx10Header));
+        stream.write((const char*)data.data(), data.size());
+        return stream.good();
+    }
+
+    std::string TextureCooker::getCookedFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, const Bitmap* pBitmap)
+    {
+        if (sSettings.enabled == false || isHdrImage(filename))
+        {
+            return "";
+        }
+
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            return "";
+        }
+
+        // The cache key is the content of the source file and everything which affects the cooked output
+        std::ifstream source(fullpath, std::ios::binary);
+        std::vector<char> sourceData((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+        uint32_t options[] = { kCookerVersion, (uint32_t)sSettings.quality, (uint32_t)sSettings.mipFilter, sSettings.preserveAlphaCoverage ? 1u : 0u, generateMipLevels ? 1u : 0u, loadAsSrgb ? 1u : 0u };
+        uint64_t hash = hashContent(sourceData.data(), sourceData.size());
+        hash = hashContent(options, sizeof(options), hash);
+
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash;
+        std::string cacheDirectory = getCacheDirectory();
+        std::string cookedFile = cacheDirectory + "/" + name.str() + ".dds";
+        if (doesFileExist(cookedFile))
+        {
+            return cookedFile;
+        }
+
+        // Not in the cache. Cook it
+        Bitmap::UniqueConstPtr pLoadedBitmap;
+        if (pBitmap == nullptr)
+        {
+            pLoadedBitmap = loadTextureBitmap(fullpath);
+            pBitmap = pLoadedBitmap.get();
+            if (pBitmap == nullptr)
+            {
+                return "";
+            }
+        }
+
+        uint32_t width = pBitmap->getWidth();
+        uint32_t height = pBitmap->getHeight();
+        std::vector<uint8_t> rgba;
+        if ((width % 4) != 0 || (height % 4) != 0 || convertToRgba(pBitmap, rgba) == false)
+        {
+            return "";
+        }
+
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        ResourceFormat format = selectCompressedFormat(pBitmap->getFormat(), rgba);
+
+        MipGenerator::Options mipOptions;
+        mipOptions.filter = sSettings.mipFilter;
+        mipOptions.isSrgb = loadAsSrgb;
+        mipOptions.preserveAlphaCoverage = sSettings.preserveAlphaCoverage;
+        mipOptions.maxLevels = generateMipLevels ? 0 : 1;
+        MipGenerator::MipChain mipChain;
+        MipGenerator::generate(ResourceFormat::RGBA8Unorm, rgba.data(), width, height, mipOptions, mipChain);
+        uint32_t mipCount = (uint32_t)mipChain.levels.size();
+
+        std::vector<uint8_t> data;
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            const MipGenerator::Level& level = mipChain.levels[mip];
+            size_t offset = data.size();
+            data.resize(offset + BlockCompression::getCompressedSize(format, level.width, level.height));
+            BlockCompression::compress(format, mipChain.getLevelData(mip), level.width, level.height, data.data() + offset);
+        }
+        double cookTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        // Write to a temporary file first, so other threads and processes never see a partially written file
+        std::error_code ec;
+        fs::create_directories(cacheDirectory, ec);
+        std::stringstream tempFile;
+        tempFile << cookedFile << "." << std::this_thread::get_id() << ".tmp";
+        if (writeDdsFile(tempFile.str(), format, width, height, mipCount, data) == false)
+        {
+            logWarning("TextureCooker: can't write " + tempFile.str() + ". Loading " + filename + " uncompressed");
+            fs::remove(tempFile.str(), ec);
+            return "";
+        }
+
+        fs::rename(tempFile.str(), cookedFile, ec);
+        if (ec)
+        {
+            fs::remove(tempFile.str(), ec);
+            if (doesFileExist(cookedFile) == false)
+            {
+                return "";
+            }
+        }
+
+        if (sSettings.logStats)
+        {
+            std::vector<uint8_t> decoded(rgba.size());
+            BlockCompression::decompress(format, data.data(), width, height, decoded.data());
+            float psnr = BlockCompression::calcPSNR(rgba.data(), decoded.data(), width, height, getCompressedChannelCount(format));
+            double mpixPerSec = (cookTime > 0) ? ((double)width * height / 1e6) / (cookTime / 1000.0) : 0;
+            logInfo("TextureCooker: cooked " + stripDataDirectories(fullpath) + " (" + std::to_string(width) + "x" + std::to_string(height) + ", " + std::to_string(mipCount) + " mips) to " +
+                to_string(format) + " in " + std::to_string(cookTime) + " ms (" + std::to_string(mpixPerSec) + " MPix/s). PSNR " + std::to_string(psnr) + " dB");
+        }
+
+        return cookedFile;
+    }
+}
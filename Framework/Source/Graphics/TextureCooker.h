@@ -0,0 +1,79 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "Utils/Bitmap.h"
+#include "Utils/MipGenerator.h"
+
+namespace Falcor
+{
+    /** Offline texture cooking.
+        Converts 8-bit images into block-compressed DDS files with a full mip-chain and stores them in a cache directory, keyed by the content of the source image.
+        When enabled, createTextureFromFile() and the model importers load the cooked files instead of decoding the source images.
+        Floating-point images and images whose dimensions are not a multiple of 4 are not cooked.
+    */
+    class TextureCooker
+    {
+    public:
+        enum class Quality
+        {
+            Fast,   ///< BC1 for opaque color textures, BC3 for textures with alpha
+            High,   ///< BC7 for color textures
+        };
+
+        struct Settings
+        {
+            bool enabled = false;           ///< Cooking is opt-in
+            std::string cacheDirectory;     ///< Where to store the cooked files. If empty, a 'TextureCache' directory next to the executable is used
+            Quality quality = Quality::Fast;
+            MipGenerator::Filter mipFilter = MipGenerator::Filter::Box;
+            bool preserveAlphaCoverage = false;   ///< Keep the alpha-test coverage of the mip levels. See MipGenerator::Options
+            bool logStats = false;          ///< Log the compression time and PSNR of every cooked texture
+        };
+
+        /** Set the cooker settings. Should be called before loading textures, the settings are read by the loader threads.
+        */
+        static void setSettings(const Settings& settings);
+
+        /** Get the cooker settings
+        */
+        static const Settings& getSettings();
+
+        /** Get the cooked version of an image, cooking it if it isn't in the cache yet. This function doesn't access the GPU and can be called from any thread.
+            \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+            \param[in] generateMipLevels Whether the cooked file should contain the mip-chain
+            \param[in] loadAsSrgb Whether the texture will be used as sRGB. Affects the mip-chain filtering
+            \param[in] pBitmap Optional. The already decoded image. If nullptr and the image isn't in the cache, the file will be decoded
+            \return The full path of the cooked DDS file, or an empty string if cooking is disabled or the image can't be cooked
+        */
+        static std::string getCookedFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, const Bitmap* pBitmap = nullptr);
+
+    private:
+        TextureCooker() = delete;
+    };
+}
@@ -27,12 +27,14 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "TextureHelper.h"
+#include "TextureCooker.h"
 #include "API/Texture.h"
 #include "Utils/Bitmap.h"
 #include "Utils/DDSHeader.h"
 #include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
 #include <cstring>
+#include <fstream>
 
 static const bool kTopDown = true;
 
@@ -697,6 +699,81 @@ namespace Falcor
         return nullptr;
     }
 
+    bool loadDdsMipLevels(const std::string& filename, uint32_t maxDimension, DdsMipLevels& levels)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("Can't find DDS file " + filename);
+            return false;
+        }
+
+        std::ifstream stream(fullpath, std::ios::binary);
+        uint32_t ddsIdentifier = 0;
+        DdsData ddsData;
+        stream.read((char*)&ddsIdentifier, sizeof(ddsIdentifier));
+        stream.read((char*)&ddsData.header, sizeof(ddsData.header));
+        if (stream.good() == false || ddsIdentifier != kDdsMagicNumber)
+        {
+            logError(std::string("The dds file ") + filename + std::string(" is not a valid dds file"));
+            return false;
+        }
+
+        ddsData.hasDX10Header = (ddsData.header.pixelFormat.flags & DdsHeader::PixelFormat::kFourCCFlag) && (makeFourCC("DX10") == ddsData.header.pixelFormat.fourCC);
+        bool is2D;
+        if (ddsData.hasDX10Header)
+        {
+            stream.read((char*)&ddsData.dx10Header, sizeof(ddsData.dx10Header));
+            is2D = (ddsData.dx10Header.resourceDimension == DXResourceDimension::RESOURCE_DIMENSION_TEXTURE2D) && (ddsData.dx10Header.arraySize == 1) && ((ddsData.dx10Header.miscFlag & DdsHeaderDX10::kCubeMapMask) == 0);
+        }
+        else
+        {
+            is2D = ((ddsData.header.flags & DdsHeader::kDepthMask) == 0) && ((ddsData.header.caps[1] & DdsHeader::kCaps2CubeMapMask) == 0);
+        }
+
+        levels.format = getDdsResourceFormat(ddsData);
+        if (is2D == false || levels.format == ResourceFormat::Unknown)
+        {
+            logError("loadDdsMipLevels() only supports single 2D textures. Can't load " + filename);
+            return false;
+        }
+
+        levels.width = ddsData.header.width;
+        levels.height = ddsData.header.height;
+        levels.totalMipCount = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
+
+        uint32_t firstMip = 0;
+        while (firstMip + 1 < levels.totalMipCount && max(levels.width >> firstMip, levels.height >> firstMip) > maxDimension)
+        {
+            firstMip++;
+        }
+
+        // The most detailed level of a compressed texture must be a multiple of the block size
+        while (firstMip > 0 && (((levels.width >> firstMip) % getFormatWidthCompressionRatio(levels.format)) || ((levels.height >> firstMip) % getFormatHeightCompressionRatio(levels.format))))
+        {
+            firstMip--;
+        }
+        levels.firstMip = firstMip;
+
+        size_t offset = 0;
+        size_t size = 0;
+        for (uint32_t mip = 0; mip < levels.totalMipCount; mip++)
+        {
+            size_t levelSize = getFormatImageSize(levels.format, max(levels.width >> mip, 1U), max(levels.height >> mip, 1U));
+            (mip < firstMip ? offset : size) += levelSize;
+        }
+
+        stream.seekg(offset, std::ios::cur);
+        levels.data.resize(size);
+        stream.read((char*)levels.data.data(), size);
+        if (stream.good() == false)
+        {
+            logError("Error when reading mip-levels from DDS file " + filename);
+            return false;
+        }
+        return true;
+    }
+
     Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
     {
 #define no_srgb()   \
@@ -712,16 +789,18 @@ namespace Falcor
         }
         else
         {
-            Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-            if(pBitmap)
+            std::string cookedFile = TextureCooker::getCookedFile(filename, generateMipLevels, loadAsSrgb);
+            if (cookedFile.size())
+            {
+                pTex = createTextureFromDDSFile(cookedFile, false, loadAsSrgb, bindFlags);
+            }
+            else
             {
-                ResourceFormat texFormat = pBitmap->getFormat();
-                if(loadAsSrgb)
+                Bitmap::UniqueConstPtr pBitmap = loadTextureBitmap(filename);
+                if (pBitmap)
                 {
-                    texFormat = linearToSrgbFormat(texFormat);
+                    return createTextureFromBitmap(pBitmap.get(), filename, generateMipLevels, loadAsSrgb, bindFlags);
                 }
-
-                pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
             }
         }
 
@@ -733,4 +812,39 @@ namespace Falcor
         return pTex;
     }
 #undef no_srgb
+
+    Bitmap::UniqueConstPtr loadTextureBitmap(const std::string& filename)
+    {
+        assert(hasSuffix(filename, ".dds") == false);
+        return Bitmap::createFromFile(filename, kTopDown);
+    }
+
+    Texture::SharedPtr createTextureFromBitmap(const Bitmap* pBitmap, const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        Texture::SharedPtr pTex;
+        std::string cookedFile = TextureCooker::getCookedFile(filename, generateMipLevels, loadAsSrgb, pBitmap);
+        if (cookedFile.size())
+        {
+            pTex = createTextureFromDDSFile(cookedFile, false, loadAsSrgb, bindFlags);
+            if (pTex != nullptr)
+            {
+                pTex->setSourceFilename(stripDataDirectories(filename));
+            }
+            return pTex;
+        }
+
+        ResourceFormat texFormat = pBitmap->getFormat();
+        if(loadAsSrgb)
+        {
+            texFormat = linearToSrgbFormat(texFormat);
+        }
+
+        pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+        if (pTex != nullptr)
+        {
+            pTex->setSourceFilename(stripDataDirectories(filename));
+        }
+
+        return pTex;
+    }
 }
@@ -28,6 +28,7 @@
 #pragma once
 #include <string>
 #include "API/Texture.h"
+#include "Utils/Bitmap.h"
 namespace Falcor
 {
     /*!
@@ -43,5 +44,41 @@ namespace Falcor
     */
     Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
 
+    /** Decode an image file into a bitmap which can later be passed to createTextureFromBitmap(). This function doesn't access the GPU and can be called from any thread.
+        DDS files are not supported, use createTextureFromFile() for them.
+        \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+        \return The decoded bitmap, or nullptr on failure
+    */
+    Bitmap::UniqueConstPtr loadTextureBitmap(const std::string& filename);
+
+    /** Create a new texture object from a bitmap returned by loadTextureBitmap().
+        \param[in] pBitmap The decoded image
+        \param[in] filename The filename the bitmap was loaded from. Stored as the texture's source filename
+        \param[in] generateMipLevels Whether the mip-chain should be generated
+        \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
+        \param[in] bindFlags The bind flags to create the texture with
+    */
+    Texture::SharedPtr createTextureFromBitmap(const Bitmap* pBitmap, const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** A range of mip-levels read from a DDS file
+    */
+    struct DdsMipLevels
+    {
+        ResourceFormat format = ResourceFormat::Unknown;
+        uint32_t width = 0;             ///< The width of level 0 in the file
+        uint32_t height = 0;            ///< The height of level 0 in the file
+        uint32_t totalMipCount = 0;     ///< The number of levels in the file
+        uint32_t firstMip = 0;          ///< The most detailed level stored in data
+        std::vector<uint8_t> data;      ///< Levels firstMip to totalMipCount - 1, in the layout expected by Texture::create2D()
+    };
+
+    /** Read the less detailed levels of a 2D DDS file, without reading the rest of the file. This function doesn't access the GPU and can be called from any thread.
+        \param[in] filename Filename of the DDS file. Can also include a full path or relative path from a data directory
+        \param[in] maxDimension The first level read is the most detailed one whose width and height are not larger than this value. For compressed formats, the level is adjusted so its size is a multiple of the block size
+        \param[out] levels The levels read
+        \return Whether the file was read successfully. Cube-maps, volume textures and arrays are not supported
+    */
+    bool loadDdsMipLevels(const std::string& filename, uint32_t maxDimension, DdsMipLevels& levels);
+
     /*! @} */
 }
\ No newline at end of file
@@ -0,0 +1,434 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureStreamer.h"
+#include "Utils/Gui.h"
+#include "Utils/StringUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Falcor
+{
+    static TextureStreamer::SharedPtr sActiveStreamer;
+
+    /** Check if a level can be the most detailed level of a texture. Compressed textures require it to be a multiple of the block size
+    */
+    static bool isValidFirstMip(ResourceFormat format, uint32_t width, uint32_t height, uint32_t mip)
+    {
+        return (((width >> mip) % getFormatWidthCompressionRatio(format)) == 0) && (((height >> mip) % getFormatHeightCompressionRatio(format)) == 0);
+    }
+
+    TextureStreamer::SharedPtr TextureStreamer::create(const Settings& settings)
+    {
+        return SharedPtr(new TextureStreamer(settings));
+    }
+
+    TextureStreamer::TextureStreamer(const Settings& settings) : mSettings(settings)
+    {
+        mThread = std::thread(&TextureStreamer::loaderThread, this);
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    void TextureStreamer::setActive(const SharedPtr& pStreamer)
+    {
+        sActiveStreamer = pStreamer;
+    }
+
+    const TextureStreamer::SharedPtr& TextureStreamer::getActive()
+    {
+        return sActiveStreamer;
+    }
+
+    Texture::SharedPtr TextureStreamer::createTexture(const std::string& ddsFilename, bool loadAsSrgb, const std::string& sourceFilename)
+    {
+        std::string key = ddsFilename + (loadAsSrgb ? "|srgb" : "");
+        auto it = mFileToEntry.find(key);
+        if (it != mFileToEntry.end())
+        {
+            return mEntries[it->second].pTexture;
+        }
+
+        DdsMipLevels levels;
+        if (loadDdsMipLevels(ddsFilename, mSettings.tailSize, levels) == false)
+        {
+            return nullptr;
+        }
+
+        Entry entry;
+        entry.ddsFilename = ddsFilename;
+        entry.sourceFilename = stripDataDirectories(sourceFilename.empty() ? ddsFilename : sourceFilename);
+        entry.isSrgb = loadAsSrgb;
+        entry.format = loadAsSrgb ? linearToSrgbFormat(levels.format) : levels.format;
+        entry.width = levels.width;
+        entry.height = levels.height;
+        entry.mipCount = levels.totalMipCount;
+        entry.tailMip = levels.firstMip;
+        entry.residentMip = levels.firstMip;
+        entry.targetMip = levels.firstMip;
+        entry.requestedMip = levels.firstMip;
+        entry.lastUsedFrame = mFrame;
+
+        entry.pTexture = Texture::create2D(max(levels.width >> levels.firstMip, 1U), max(levels.height >> levels.firstMip, 1U), entry.format, 1, levels.totalMipCount - levels.firstMip, levels.data.data());
+        if (entry.pTexture == nullptr)
+        {
+            return nullptr;
+        }
+        entry.pTexture->setSourceFilename(entry.sourceFilename);
+
+        uint32_t entryID = (uint32_t)mEntries.size();
+        mFileToEntry[key] = entryID;
+        mTextureToEntry[entry.pTexture.get()] = entryID;
+        mEntries.push_back(std::move(entry));
+        return mEntries[entryID].pTexture;
+    }
+
+    void TextureStreamer::registerMaterial(const Material::SharedPtr& pMaterial)
+    {
+        Texture::SharedPtr textures[(uint32_t)Slot::Count] =
+        {
+            pMaterial->getBaseColorTexture(),
+            pMaterial->getSpecularTexture(),
+            pMaterial->getEmissiveTexture(),
+            pMaterial->getNormalMap(),
+            pMaterial->getOcclusionMap(),
+            pMaterial->getLightMap(),
+            pMaterial->getHeightMap(),
+        };
+
+        std::vector<uint32_t>& materialEntries = mMaterialEntries[pMaterial.get()];
+        materialEntries.clear();
+        for (uint32_t slot = 0; slot < (uint32_t)Slot::Count; slot++)
+        {
+            auto it = textures[slot] ? mTextureToEntry.find(textures[slot].get()) : mTextureToEntry.end();
+            if (it != mTextureToEntry.end())
+            {
+                mEntries[it->second].users.push_back({ pMaterial, (Slot)slot });
+                if (std::find(materialEntries.begin(), materialEntries.end(), it->second) == materialEntries.end())
+                {
+                    materialEntries.push_back(it->second);
+                }
+            }
+        }
+
+        if (materialEntries.empty())
+        {
+            mMaterialEntries.erase(pMaterial.get());
+        }
+    }
+
+    void TextureStreamer::reportMaterialUsage(const Material* pMaterial, float screenSize)
+    {
+        auto it = mMaterialEntries.find(pMaterial);
+        if (it == mMaterialEntries.end())
+        {
+            return;
+        }
+
+        for (uint32_t entryID : it->second)
+        {
+            Entry& entry = mEntries[entryID];
+            if (entry.lastUsedFrame == mFrame && screenSize <= entry.maxScreenSize)
+            {
+                continue;
+            }
+
+            // Assume the texture is mapped once over the draw. One texel per pixel is reached at log2(textureSize / screenSize)
+            float textureSize = (float)max(entry.width, entry.height);
+            float mip = std::log2(textureSize / std::max(screenSize, 1.0f)) + mSettings.mipBias;
+            uint32_t requestedMip = (uint32_t)std::min(std::max(std::floor(mip), 0.0f), (float)entry.tailMip);
+            while (requestedMip > 0 && isValidFirstMip(entry.format, entry.width, entry.height, requestedMip) == false)
+            {
+                requestedMip--;
+            }
+
+            // Larger sizes always request the same or more detailed levels
+            entry.lastUsedFrame = mFrame;
+            entry.requestedMip = requestedMip;
+            entry.maxScreenSize = screenSize;
+        }
+    }
+
+    uint64_t TextureStreamer::getResidentSize(const Entry& entry, uint32_t mip) const
+    {
+        uint64_t size = 0;
+        for (uint32_t i = mip; i < entry.mipCount; i++)
+        {
+            size += getFormatImageSize(entry.format, max(entry.width >> i, 1U), max(entry.height >> i, 1U));
+        }
+        return size;
+    }
+
+    void TextureStreamer::update()
+    {
+        processCompletedLoads();
+
+        // Convert the feedback of the last frame into target levels
+        for (auto& entry : mEntries)
+        {
+            if (entry.lastUsedFrame == mFrame)
+            {
+                entry.targetMip = entry.requestedMip;
+            }
+            else if (mFrame - entry.lastUsedFrame > mSettings.unusedFrameCount)
+            {
+                entry.targetMip = entry.tailMip;
+                entry.maxScreenSize = 0;
+            }
+        }
+
+        applyBudget();
+        issueLoads();
+
+        mStats.textureCount = (uint32_t)mEntries.size();
+        mStats.fullyResidentCount = 0;
+        mStats.residentBytes = 0;
+        for (const auto& entry : mEntries)
+        {
+            mStats.residentBytes += getResidentSize(entry, entry.residentMip);
+            if (entry.residentMip == 0) mStats.fullyResidentCount++;
+        }
+
+        mFrame++;
+    }
+
+    void TextureStreamer::applyBudget()
+    {
+        uint64_t total = 0;
+        for (const auto& entry : mEntries) total += getResidentSize(entry, entry.targetMip);
+        mStats.requestedBytes = total;
+        if (total <= mSettings.memoryBudget)
+        {
+            return;
+        }
+
+        // Reduce the least recently used textures first, then the ones which are the smallest on screen
+        std::vector<uint32_t> order(mEntries.size());
+        for (uint32_t i = 0; i < (uint32_t)order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+        {
+            const Entry& entryA = mEntries[a];
+            const Entry& entryB = mEntries[b];
+            if (entryA.lastUsedFrame != entryB.lastUsedFrame) return entryA.lastUsedFrame < entryB.lastUsedFrame;
+            return entryA.maxScreenSize < entryB.maxScreenSize;
+        });
+
+        // Drop one level at a time, so the memory is spread between the visible textures
+        bool changed = true;
+        while (total > mSettings.memoryBudget && changed)
+        {
+            changed = false;
+            for (uint32_t entryID : order)
+            {
+                Entry& entry = mEntries[entryID];
+                uint32_t mip = entry.targetMip + 1;
+                while (mip < entry.tailMip && isValidFirstMip(entry.format, entry.width, entry.height, mip) == false) mip++;
+                if (mip > entry.tailMip) continue;
+
+                total -= getResidentSize(entry, entry.targetMip) - getResidentSize(entry, mip);
+                entry.targetMip = mip;
+                changed = true;
+                if (total <= mSettings.memoryBudget) break;
+            }
+        }
+    }
+
+    void TextureStreamer::issueLoads()
+    {
+        // Evictions first since they free memory, then the largest textures on screen
+        std::vector<uint32_t> evictions;
+        std::vector<uint32_t> loads;
+        for (uint32_t i = 0; i < (uint32_t)mEntries.size(); i++)
+        {
+            const Entry& entry = mEntries[i];
+            if (entry.isLoading || entry.targetMip == entry.residentMip) continue;
+            (entry.targetMip > entry.residentMip ? evictions : loads).push_back(i);
+        }
+        std::sort(loads.begin(), loads.end(), [this](uint32_t a, uint32_t b) { return mEntries[a].maxScreenSize > mEntries[b].maxScreenSize; });
+        evictions.insert(evictions.end(), loads.begin(), loads.end());
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Keep the queue short, so requests reflect recent feedback
+        uint32_t maxPendingLoads = 2 * mSettings.maxUploadsPerFrame;
+        for (uint32_t entryID : evictions)
+        {
+            if (mStats.pendingLoads >= maxPendingLoads) break;
+
+            Entry& entry = mEntries[entryID];
+            entry.isLoading = true;
+            mRequests.push_back({ entryID, entry.ddsFilename, max(entry.width >> entry.targetMip, entry.height >> entry.targetMip) });
+            mStats.pendingLoads++;
+        }
+        mCondition.notify_one();
+    }
+
+    void TextureStreamer::processCompletedLoads()
+    {
+        std::deque<LoadResult> results;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            uint32_t count = std::min((uint32_t)mResults.size(), mSettings.maxUploadsPerFrame);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                results.push_back(std::move(mResults.front()));
+                mResults.pop_front();
+            }
+        }
+
+        for (auto& result : results)
+        {
+            Entry& entry = mEntries[result.entryID];
+            entry.isLoading = false;
+            mStats.pendingLoads--;
+            if (result.success == false)
+            {
+                // Don't retry. Keep the current levels
+                entry.targetMip = entry.residentMip;
+                entry.tailMip = entry.residentMip;
+                continue;
+            }
+
+            const DdsMipLevels& levels = result.levels;
+            Texture::SharedPtr pTexture = Texture::create2D(max(levels.width >> levels.firstMip, 1U), max(levels.height >> levels.firstMip, 1U), entry.format, 1, levels.totalMipCount - levels.firstMip, levels.data.data());
+            if (pTexture == nullptr)
+            {
+                continue;
+            }
+
+            pTexture->setSourceFilename(entry.sourceFilename);
+            (levels.firstMip < entry.residentMip ? mStats.loadCount : mStats.evictionCount)++;
+            entry.residentMip = levels.firstMip;
+            replaceTexture(result.entryID, pTexture);
+        }
+    }
+
+    void TextureStreamer::replaceTexture(uint32_t entryID, const Texture::SharedPtr& pTexture)
+    {
+        Entry& entry = mEntries[entryID];
+        mTextureToEntry.erase(entry.pTexture.get());
+        mTextureToEntry[pTexture.get()] = entryID;
+        entry.pTexture = pTexture;
+
+        Texture::SharedPtr pTex = pTexture;
+        for (size_t i = 0; i < entry.users.size();)
+        {
+            Material::SharedPtr pMaterial = entry.users[i].first.lock();
+            if (pMaterial == nullptr)
+            {
+                entry.users.erase(entry.users.begin() + i);
+                continue;
+            }
+
+            switch (entry.users[i].second)
+            {
+            case Slot::BaseColor:
+                pMaterial->setBaseColorTexture(pTex);
+                break;
+            case Slot::Specular:
+                pMaterial->setSpecularTexture(pTex);
+                break;
+            case Slot::Emissive:
+                pMaterial->setEmissiveTexture(pTex);
+                break;
+            case Slot::NormalMap:
+                pMaterial->setNormalMap(pTex);
+                break;
+            case Slot::OcclusionMap:
+                pMaterial->setOcclusionMap(pTex);
+                break;
+            case Slot::LightMap:
+                pMaterial->setLightMap(pTex);
+                break;
+            case Slot::HeightMap:
+                pMaterial->setHeightMap(pTex);
+                break;
+            default:
+                should_not_get_here();
+            }
+            i++;
+        }
+    }
+
+    void TextureStreamer::loaderThread()
+    {
+        while (true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mTerminate || mRequests.empty() == false; });
+                if (mTerminate)
+                {
+                    return;
+                }
+                request = std::move(mRequests.front());
+                mRequests.pop_front();
+            }
+
+            LoadResult result;
+            result.entryID = request.entryID;
+            result.success = loadDdsMipLevels(request.ddsFilename, request.maxDimension, result.levels);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mResults.push_back(std::move(result));
+        }
+    }
+
+    void TextureStreamer::renderUI(Gui* pGui, const char* group)
+    {
+        if (group == nullptr || pGui->beginGroup(group))
+        {
+            int32_t budgetMB = (int32_t)(mSettings.memoryBudget / (1024 * 1024));
+            if (pGui->addIntVar("Memory Budget (MB)", budgetMB, 1))
+            {
+                mSettings.memoryBudget = (uint64_t)budgetMB * 1024 * 1024;
+            }
+            pGui->addFloatVar("Mip Bias", mSettings.mipBias, -4.0f, 4.0f, 0.25f);
+
+            std::string stats = "Textures: " + std::to_string(mStats.textureCount) + " (" + std::to_string(mStats.fullyResidentCount) + " fully resident)\n";
+            stats += "Resident: " + std::to_string(mStats.residentBytes / (1024 * 1024)) + " MB\n";
+            stats += "Requested: " + std::to_string(mStats.requestedBytes / (1024 * 1024)) + " MB\n";
+            stats += "Pending loads: " + std::to_string(mStats.pendingLoads) + "\n";
+            stats += "Loads: " + std::to_string(mStats.loadCount) + ", evictions: " + std::to_string(mStats.evictionCount);
+            pGui->addText(stats.c_str());
+
+            if (group != nullptr)
+            {
+                pGui->endGroup();
+            }
+        }
+    }
+}
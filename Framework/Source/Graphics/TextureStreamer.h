@@ -0,0 +1,189 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "API/Texture.h"
+#include "Graphics/Material/Material.h"
+#include "Graphics/TextureHelper.h"
+
+namespace Falcor
+{
+    class Gui;
+
+    /** Streams the mip-levels of textures stored in DDS files.
+        Textures are created with only their mip-tail resident. The renderer reports how large on screen each material is drawn, and the streamer loads the more detailed levels a material needs on a background thread.
+        Textures which are not used, or which don't fit in the memory budget, are reduced back to fewer levels.
+        Changing the resident levels re-creates the texture and updates the materials using it, so materials must be registered with registerMaterial().
+        Streamed textures must come from DDS files. When texture cooking is enabled, the model loaders stream the cooked files.
+    */
+    class TextureStreamer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TextureStreamer>;
+
+        struct Settings
+        {
+            uint64_t memoryBudget = 512ull * 1024 * 1024;   ///< The maximum memory, in bytes, used by the streamed textures. The mip-tails are always resident and are not limited by the budget
+            uint32_t tailSize = 64;                         ///< The largest dimension of the levels loaded when a texture is created
+            uint32_t maxUploadsPerFrame = 4;                ///< The maximum number of textures re-created in a single update() call
+            uint32_t unusedFrameCount = 60;                 ///< Number of frames without use after which a texture is reduced to its mip-tail
+            float mipBias = 0;                              ///< Added to the required mip-level estimated from the screen size. Positive values reduce memory usage
+        };
+
+        struct Stats
+        {
+            uint32_t textureCount = 0;          ///< The number of streamed textures
+            uint32_t fullyResidentCount = 0;    ///< The number of textures with all of their levels resident
+            uint64_t residentBytes = 0;         ///< The memory used by the resident levels
+            uint64_t requestedBytes = 0;        ///< The memory needed to satisfy the current requests, before applying the budget
+            uint32_t pendingLoads = 0;          ///< The number of loads queued or in flight
+            uint64_t loadCount = 0;             ///< The total number of textures re-created with more levels
+            uint64_t evictionCount = 0;         ///< The total number of textures re-created with fewer levels
+        };
+
+        /** Create a new streamer
+        */
+        static SharedPtr create(const Settings& settings = Settings());
+        ~TextureStreamer();
+
+        /** Set the streamer used by the model loaders and the scene renderers. Pass nullptr to disable streaming
+        */
+        static void setActive(const SharedPtr& pStreamer);
+
+        /** Get the active streamer. Can be nullptr
+        */
+        static const SharedPtr& getActive();
+
+        /** Create a streamed texture, with only its mip-tail resident. Calling this function again with the same file returns the same texture.
+            \param[in] ddsFilename The DDS file holding the mip-chain
+            \param[in] loadAsSrgb Load the texture using sRGB format
+            \param[in] sourceFilename The filename to store as the texture's source filename. If empty, the DDS filename is used
+            \return A new texture, or nullptr if the file can't be streamed
+        */
+        Texture::SharedPtr createTexture(const std::string& ddsFilename, bool loadAsSrgb, const std::string& sourceFilename = "");
+
+        /** Register a material, so its streamed textures are replaced when their resident levels change. Textures of the material which are not streamed are ignored
+        */
+        void registerMaterial(const Material::SharedPtr& pMaterial);
+
+        /** Report that a material was drawn. Call for every draw, the largest size in the frame is used
+            \param[in] pMaterial The material
+            \param[in] screenSize The approximate size of the draw, in pixels, along its largest screen axis
+        */
+        void reportMaterialUsage(const Material* pMaterial, float screenSize);
+
+        /** Process the feedback of the last frame, issue new loads and replace the textures whose loads completed. Call once per frame
+        */
+        void update();
+
+        /** Render the UI
+        */
+        void renderUI(Gui* pGui, const char* group = nullptr);
+
+        void setSettings(const Settings& settings) { mSettings = settings; }
+        const Settings& getSettings() const { return mSettings; }
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        TextureStreamer(const Settings& settings);
+
+        enum class Slot
+        {
+            BaseColor,
+            Specular,
+            Emissive,
+            NormalMap,
+            OcclusionMap,
+            LightMap,
+            HeightMap,
+            Count
+        };
+
+        struct Entry
+        {
+            std::string ddsFilename;
+            std::string sourceFilename;
+            bool isSrgb = false;
+            ResourceFormat format = ResourceFormat::Unknown;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t mipCount = 0;
+            uint32_t tailMip = 0;           ///< The most detailed level of the mip-tail
+            uint32_t residentMip = 0;       ///< The most detailed resident level
+            uint32_t targetMip = 0;         ///< The level the streamer is converging to
+            uint32_t requestedMip = 0;      ///< The most detailed level requested by the feedback of the current frame
+            float maxScreenSize = 0;        ///< The largest screen size reported in the current frame
+            uint64_t lastUsedFrame = 0;
+            bool isLoading = false;
+            Texture::SharedPtr pTexture;
+            std::vector<std::pair<std::weak_ptr<Material>, Slot>> users;
+        };
+
+        struct LoadRequest
+        {
+            uint32_t entryID;
+            std::string ddsFilename;
+            uint32_t maxDimension;
+        };
+
+        struct LoadResult
+        {
+            uint32_t entryID;
+            bool success;
+            DdsMipLevels levels;
+        };
+
+        uint64_t getResidentSize(const Entry& entry, uint32_t mip) const;
+        void applyBudget();
+        void issueLoads();
+        void processCompletedLoads();
+        void replaceTexture(uint32_t entryID, const Texture::SharedPtr& pTexture);
+        void loaderThread();
+
+        Settings mSettings;
+        Stats mStats;
+        uint64_t mFrame = 0;
+
+        std::vector<Entry> mEntries;
+        std::unordered_map<std::string, uint32_t> mFileToEntry;                     // Keyed by DDS filename and sRGB-ness
+        std::unordered_map<const Texture*, uint32_t> mTextureToEntry;
+        std::unordered_map<const Material*, std::vector<uint32_t>> mMaterialEntries;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<LoadRequest> mRequests;
+        std::deque<LoadResult> mResults;
+        bool mTerminate = false;
+        std::thread mThread;
+    };
+}
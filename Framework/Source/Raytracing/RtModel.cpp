@@ -204,7 +204,7 @@ namespace Falcor
 
                 const Buffer* pVB = pVao->getVertexBuffer(elemDesc.vbIndex).get();
                 pContext->resourceBarrier(pVB, Resource::State::NonPixelShader);
-                desc.Triangles.VertexBuffer.StartAddress = pVB->getGpuAddress() + pVbLayout->getElementOffset(elemDesc.elementIndex);
+                desc.Triangles.VertexBuffer.StartAddress = pVB->getGpuAddress() + pVbLayout->getStride() * pMesh->getBaseVertex() + pVbLayout->getElementOffset(elemDesc.elementIndex);
                 desc.Triangles.VertexBuffer.StrideInBytes = pVbLayout->getStride();
                 desc.Triangles.VertexCount = pMesh->getVertexCount();
                 desc.Triangles.VertexFormat = getDxgiFormat(pVbLayout->getElementFormat(elemDesc.elementIndex));
@@ -212,7 +212,7 @@ namespace Falcor
                 // Get the IB
                 const Buffer* pIB = pVao->getIndexBuffer().get();
                 pContext->resourceBarrier(pIB, Resource::State::NonPixelShader);
-                desc.Triangles.IndexBuffer = pIB->getGpuAddress();
+                desc.Triangles.IndexBuffer = pIB->getGpuAddress() + getFormatBytesPerBlock(pVao->getIndexBufferFormat()) * pMesh->getStartIndex();
                 desc.Triangles.IndexCount = pMesh->getIndexCount();
                 desc.Triangles.IndexFormat = getDxgiFormat(pVao->getIndexBufferFormat());
 
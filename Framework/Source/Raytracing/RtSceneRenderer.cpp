@@ -44,6 +44,10 @@ namespace Falcor
         data.currentData.pVars = pRtVars->getHitVars(data.progId)[instanceId].get();
         if(data.currentData.pVars)
         {
+            data.currentData.modelID = data.model;
+            data.currentData.modelInstanceID = data.modelInstance;
+            data.currentData.transformID = mpScene->getMeshInstanceTransformId(data.model, data.modelInstance, data.mesh, data.meshInstance);
+
             const Model* pModel = mpScene->getModel(data.model).get();
             const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(data.model, data.modelInstance).get();
             const Mesh* pMesh = pModel->getMesh(data.mesh).get();
@@ -100,6 +104,13 @@ namespace Falcor
             pVars->getDefaultBlock()->setSrv(mMeshBufferLocations.indices, 0, pSrv);
         }
 
+        ConstantBuffer::SharedPtr pDxrPerMesh = pVars->getConstantBuffer("DxrPerMesh");
+        if (pDxrPerMesh)
+        {
+            pDxrPerMesh["gFirstIndex"] = pMesh->getStartIndex();
+            pDxrPerMesh["gBaseVertex"] = (uint32_t)pMesh->getBaseVertex();
+        }
+
         setVertexBuffer(mMeshBufferLocations.lightmapUVs, VERTEX_LIGHTMAP_UV_LOC, pVao, pVars);
         setVertexBuffer(mMeshBufferLocations.texC, VERTEX_TEXCOORD_LOC, pVao, pVars);
         setVertexBuffer(mMeshBufferLocations.normal, VERTEX_NORMAL_LOC, pVao, pVars);
@@ -160,6 +171,7 @@ namespace Falcor
     {
         InstanceData data;
         data.currentData.pCamera = pCamera;
+        mpScene->updateTransforms();
         uint32_t hitCount = pRtVars->getHitProgramsCount();
         if (hitCount)
         {   
@@ -34,6 +34,7 @@ namespace Falcor
     class RenderContext;
     class Fbo;
     class SampleTest;
+    class SampleBenchmark;
     class ArgList;
 
     class SampleCallbacks
@@ -103,6 +104,10 @@ namespace Falcor
         */
         virtual std::string captureScreen(const std::string explicitFilename = "", const std::string explicitOutputDirectory = "") = 0;
 
+        /** Wait until the screenshots taken with captureScreen() are written to disk
+        */
+        virtual void flushScreenCaptures() = 0;
+
         /* Shutdown the app 
         */
         virtual void shutdown() = 0;
@@ -112,6 +117,14 @@ namespace Falcor
         */
         virtual void onTestShutdown() = 0;
 
+        /** Check if Renderer::onFrameSimulate() runs on a simulation thread
+        */
+        virtual bool isSimulationPipelined() = 0;
+
+        /** Wait until the simulation thread is idle. Does nothing if simulation pipelining is disabled
+        */
+        virtual void waitForSimulation() = 0;
+
         /** Stop the timer
         */
         virtual void freezeTime(bool timeFrozen) = 0;
@@ -136,6 +149,14 @@ namespace Falcor
         */
         virtual void onFrameRender(SampleCallbacks* pSample, RenderContext::SharedPtr pRenderContext, Fbo::SharedPtr pTargetFbo) {}
 
+        /** Called on the simulation thread when simulation pipelining is enabled (SampleConfig::Flags::PipelineSimulation), one frame ahead of onFrameRender().
+            Update the scene here and publish the result in the snapshot with index frameID % SimulationThread::kSnapshotCount. onFrameRender() renders the snapshot of SampleCallbacks::getFrameID().
+            The simulation of frame N+1 runs while onFrameRender() records frame N, and is done before onGuiRender() or any input callback is called.
+            \param[in] currentTime The time to simulate to. With a fixed time delta it matches the time onFrameRender() sees, otherwise it is predicted from the last frame time
+            \param[in] frameID The frame the result will be rendered in
+        */
+        virtual void onFrameSimulate(SampleCallbacks* pSample, float currentTime, uint64_t frameID) {}
+
         /** Called right before the context is destroyed.
         */
         virtual void onShutdown(SampleCallbacks* pSample) {}
@@ -144,7 +165,7 @@ namespace Falcor
         */
         virtual void onResizeSwapChain(SampleCallbacks* pSample, uint32_t width, uint32_t height) {}
 
-        /** Called every time the user requests shader recompilation (by pressing F5)
+        /** Called every time the user requests shader recompilation (by pressing F5), and when modified shaders finish recompiling in the background
         */
         virtual void onDataReload(SampleCallbacks* pSample) {}
 
@@ -186,6 +207,10 @@ namespace Falcor
         */
         virtual void onTestShutdown(SampleTest* pSampleTest) {};
 
+        /** Callback for anything the renderer needs to do to initialize benchmarking, such as loading a scene and attaching the camera to the path returned by SampleBenchmark::getCameraPathIndex()
+        */
+        virtual void onInitializeBenchmark(SampleCallbacks* pSample, SampleBenchmark* pBenchmark) {};
+
         // Deleted copy operators (copy a pointer type!)
         Renderer(const Renderer&) = delete;
         Renderer& operator=(const Renderer &) = delete;
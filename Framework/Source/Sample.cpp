@@ -31,6 +31,7 @@
 #include <fstream>
 #include "API/Window.h"
 #include "Graphics/Program/Program.h"
+#include "Graphics/Program/ShaderArchive.h"
 #include "Utils/Platform/OS.h"
 #include "API/FBO.h"
 #include "VR/OpenVR/VRSystem.h"
@@ -170,6 +171,7 @@ namespace Falcor
         {
             endVideoCapture();
         }
+        mpScreenCapture.reset();
 
         VRSystem::cleanup();
 
@@ -265,31 +267,77 @@ namespace Falcor
             mArgList.parseCommandLine(concatCommandLine(argc, argv));
         }
 
+        // Use the precompiled shader permutations, if an archive was provided
+        if (mArgList.argExists("shaderarchive"))
+        {
+            auto values = mArgList.getValues("shaderarchive");
+            if (values.empty()) logError("Missing the file name of the shader archive");
+            else ShaderArchive::setActive(ShaderArchive::createFromFile(values[0].asString()));
+        }
+
         // Load and run
         mpRenderer->onLoad(this, mpRenderContext);
         initializeTesting();
+        initializeBenchmark();
+        if (is_set(config.flags, SampleConfig::Flags::PipelineSimulation) || mArgList.argExists("simthread"))
+        {
+            mpSimulation = SimulationThread::create([this](float currentTime, uint64_t frameID) { mpRenderer->onFrameSimulate(this, currentTime, frameID); });
+        }
         pBar = nullptr;
 
         mFrameRate.resetClock();
         mpWindow->msgLoop();
 
+        mpSimulation = nullptr;
         mpRenderer->onShutdown(this);
         gpDevice->flushAndSync();
         mpRenderer = nullptr;
         Logger::shutdown();
     }
 
-    void Sample::calculateTime()
+    float Sample::getTimeStep() const
     {
         if (mFixedTimeDelta > 0.0f)
         {
-            mCurrentTime += mFixedTimeDelta * mTimeScale;
+            return mFixedTimeDelta * mTimeScale;
         }
         else if (mFreezeTime == false)
         {
-            float elapsedTime = mFrameRate.getLastFrameTime() * mTimeScale;
-            mCurrentTime += elapsedTime;
+            return mFrameRate.getLastFrameTime() * mTimeScale;
+        }
+        return 0;
+    }
+
+    void Sample::calculateTime()
+    {
+        mCurrentTime += getTimeStep();
+    }
+
+    void Sample::kickSimulation()
+    {
+        // The frame about to be recorded must have been simulated. This only happens here for the first frame, or after the frame counter was reset
+        uint64_t frameID = getFrameID();
+        if (mpSimulation->getLastFrameID() != frameID)
+        {
+            mpSimulation->kick(mCurrentTime, frameID);
         }
+
+        // Simulate the next frame while this one is recorded. Its time step isn't known yet, so assume it matches the current one
+        mpSimulation->kick(mCurrentTime + getTimeStep(), frameID + 1);
+    }
+
+    void Sample::updateSimulationStats(const CpuTimer::TimePoint& frameStart)
+    {
+        // Without pipelining, the simulation of a frame starts with the frame itself. Anything before that is added latency
+        CpuTimer::TimePoint simulationStart = mpSimulation->getKickTime(getFrameID());
+        float latency = CpuTimer::calcDuration(simulationStart, CpuTimer::getCurrentTimePoint());
+        float addedLatency = std::max(0.0f, CpuTimer::calcDuration(simulationStart, frameStart));
+
+        const float kSmoothing = 0.05f;
+        mSimulationStats.latency += (latency - mSimulationStats.latency) * kSmoothing;
+        mSimulationStats.addedLatency += (addedLatency - mSimulationStats.addedLatency) * kSmoothing;
+        mSimulationStats.simulationTime += (mpSimulation->getSimulationTime() - mSimulationStats.simulationTime) * kSmoothing;
+        mSimulationStats.stallTime += (mpSimulation->getStallTime() - mSimulationStats.stallTime) * kSmoothing;
     }
 
     void Sample::setDefaultGuiSize(uint32_t width, uint32_t height)
@@ -390,6 +438,18 @@ namespace Falcor
         }
     }
 
+    bool Sample::initializeBenchmark()
+    {
+        mpBenchmark = SampleBenchmark::create(mArgList);
+        if (mpBenchmark)
+        {
+            mpBenchmark->initialize(this);
+            mpRenderer->onInitializeBenchmark(this, mpBenchmark.get());
+            return true;
+        }
+        return false;
+    }
+
     void Sample::beginTestFrame()
     { 
         if (mpSampleTest != nullptr) 
@@ -416,7 +476,19 @@ namespace Falcor
         }
 
         mFrameRate.newFrame();
+        CpuTimer::TimePoint frameStart = CpuTimer::getCurrentTimePoint();
+        if (mpBenchmark)
+        {
+            mpBenchmark->beginFrame(this);
+        }
         beginTestFrame();
+
+        // Swap in shaders which were modified and recompiled in the background
+        if (Program::updateHotReload())
+        {
+            mpRenderer->onDataReload(this);
+        }
+
         {
             PROFILE(onFrameRender);
             // The swap-chain FBO might have changed between frames, so get it
@@ -429,9 +501,20 @@ namespace Falcor
                 mpRenderContext->setGraphicsState(mpDefaultPipelineState);
             }
             calculateTime();
+            if (mpSimulation)
+            {
+                kickSimulation();
+            }
             mpRenderer->onFrameRender(this, mpRenderContext, mpTargetFBO);
         }
 
+        // The GUI and input callbacks may change the scene, so the simulation of the next frame must be done by now
+        if (mpSimulation)
+        {
+            PROFILE(waitForSimulation);
+            mpSimulation->wait();
+        }
+
         if (gpDevice)
         {
             //blits the temp fbo given to user's renderer onto the backbuffer
@@ -469,6 +552,19 @@ namespace Falcor
                 PROFILE(present);
                 gpDevice->present();
             }
+
+            if (mpScreenCapture) mpScreenCapture->endFrame();
+            if (mVideoCapture.pFrameCapture) mVideoCapture.pFrameCapture->endFrame();
+
+            if (mpSimulation)
+            {
+                updateSimulationStats(frameStart);
+            }
+
+            if (mpBenchmark)
+            {
+                mpBenchmark->endFrame(this);
+            }
         }
     }
 
@@ -480,16 +576,49 @@ namespace Falcor
         std::string outputDirectory = explicitOutputDirectory != "" ? explicitOutputDirectory : getExecutableDirectory();
 
         std::string pngFile;
-        if (findAvailableFilename(filename, outputDirectory, "png", pngFile))
+        bool foundFilename = false;
+        {
+            // Reserve the name until the image is written
+            std::lock_guard<std::mutex> lock(mPendingScreenCapturesMutex);
+            for (uint32_t i = 0; i < (uint32_t)-1 && foundFilename == false; i++)
+            {
+                pngFile = outputDirectory + '/' + filename + '.' + std::to_string(i) + ".png";
+                foundFilename = (mPendingScreenCaptures.count(pngFile) == 0) && (doesFileExist(pngFile) == false);
+            }
+            if (foundFilename)
+            {
+                mPendingScreenCaptures.insert(pngFile);
+            }
+        }
+
+        if (foundFilename)
         {
             Texture::SharedPtr pTexture;
             pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
-            pTexture->captureToFile(0, 0, pngFile);
+
+            // Screenshots are never dropped. The image is written on the capture thread once the GPU finished the frame
+            if (mpScreenCapture == nullptr)
+            {
+                FrameCapture::Desc captureDesc;
+                captureDesc.allowFrameDrops = false;
+                mpScreenCapture = FrameCapture::create(captureDesc);
+            }
+
+            uint32_t width = pTexture->getWidth();
+            uint32_t height = pTexture->getHeight();
+            ResourceFormat format = pTexture->getFormat();
+            auto saveFunc = [=](const std::vector<uint8_t>& data)
+            {
+                Bitmap::saveImage(pngFile, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, format, true, (void*)data.data());
+                std::lock_guard<std::mutex> lock(mPendingScreenCapturesMutex);
+                mPendingScreenCaptures.erase(pngFile);
+            };
+            mpScreenCapture->captureFrame(mpRenderContext.get(), pTexture.get(), 0, saveFunc);
         }
         else
         {
             logError("Could not find available filename when capturing screen");
-            return "";
+            pngFile = "";
         }
 
          return pngFile;
@@ -511,6 +640,13 @@ namespace Falcor
             std::string msStr = std::to_string(msPerFrame);
             s = std::to_string(int(ceil(1000 / msPerFrame))) + " FPS (" + msStr.erase(msStr.size() - 4) + " ms/frame)";
             if (mVsyncOn) s += std::string(", VSync");
+            if (mpSimulation)
+            {
+                char msg[256];
+                std::snprintf(msg, arraysize(msg), "\nSimulation thread: %.2f ms/step, %.2f ms stall, %.2f ms simulation-to-present latency (+%.2f ms pipelined)",
+                    mSimulationStats.simulationTime, mSimulationStats.stallTime, mSimulationStats.latency, mSimulationStats.addedLatency);
+                s += msg;
+            }
         }
         return s;
     }
@@ -553,7 +689,14 @@ namespace Falcor
         {
             std::string profileMsg;
             Profiler::endFrame(profileMsg);
-            renderText(profileMsg, glm::vec2(10, 300));
+            if (mpBenchmark)
+            {
+                mpBenchmark->recordProfilerEvents();
+            }
+            else
+            {
+                renderText(profileMsg, glm::vec2(10, 300));
+            }
         }
 #endif
     }
@@ -583,7 +726,10 @@ namespace Falcor
         mVideoCapture.pVideoCapture = VideoEncoder::create(desc);
 
         assert(mVideoCapture.pVideoCapture);
-        mVideoCapture.pFrame = new uint8_t[desc.width*desc.height * 4];
+        // Lossless captures are intermediates which must contain every frame, so they wait for the encoder instead of dropping frames
+        FrameCapture::Desc captureDesc;
+        captureDesc.allowFrameDrops = (VideoEncoder::isLosslessCodec(desc.codec) == false);
+        mVideoCapture.pFrameCapture = FrameCapture::create(captureDesc);
 
         mVideoCapture.sampleTimeDelta = mFixedTimeDelta;
         mFixedTimeDelta = 1.0f / (float)desc.fps;
@@ -602,12 +748,19 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
+            // Encode the frames still in flight before closing the file
+            mVideoCapture.pFrameCapture->flush();
+            FrameCapture::Stats stats = mVideoCapture.pFrameCapture->getStats();
+            if (stats.droppedFrames)
+            {
+                logWarning("Video capture dropped " + std::to_string(stats.droppedFrames) + " of " + std::to_string(stats.capturedFrames + stats.droppedFrames) + " frames because the encoder couldn't keep up");
+            }
             mVideoCapture.pVideoCapture->endCapture();
             mShowUI = true;
         }
         mVideoCapture.pUI = nullptr;
+        mVideoCapture.pFrameCapture = nullptr;
         mVideoCapture.pVideoCapture = nullptr;
-        safe_delete_array(mVideoCapture.pFrame);
         mFixedTimeDelta = mVideoCapture.sampleTimeDelta;
     }
 
@@ -615,7 +768,9 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
-            mVideoCapture.pVideoCapture->appendFrame(mpRenderContext->readTextureSubresource(mpBackBufferFBO->getColorTexture(0).get(), 0).data());
+            VideoEncoder* pEncoder = mVideoCapture.pVideoCapture.get();
+            auto encodeFunc = [pEncoder](const std::vector<uint8_t>& data) { pEncoder->appendFrame(data.data()); };
+            mVideoCapture.pFrameCapture->captureFrame(mpRenderContext.get(), mpBackBufferFBO->getColorTexture(0).get(), 0, encodeFunc);
 
             if (mVideoCapture.pUI->useTimeRange())
             {
@@ -29,6 +29,7 @@
 #include "glm/glm.hpp"
 #include <set>
 #include <string>
+#include <mutex>
 #include <stdint.h>
 #include "API/Window.h"
 #include "Utils/FrameRate.h"
@@ -36,11 +37,14 @@
 #include "Utils/TextRenderer.h"
 #include "API/RenderContext.h"
 #include "Utils/Video/VideoEncoderUI.h"
+#include "Utils/Video/FrameCapture.h"
+#include "Utils/SimulationThread.h"
 #include "API/Device.h"
 #include "ArgList.h"
 #include "Utils/PixelZoom.h"
 #include "Renderer.h"
 #include "SampleTest.h"
+#include "SampleBenchmark.h"
 
 namespace Falcor
 {
@@ -54,6 +58,7 @@ namespace Falcor
         {
             None              = 0x0,  ///< No flags 
             DoNotCreateDevice = 0x1,  ///< Do not create a device. Services that depends on the device - such as GUI text - will be disabled. Use this only if you are writing raw-API sample
+            PipelineSimulation = 0x2, ///< Call Renderer::onFrameSimulate() on a simulation thread, one frame ahead of Renderer::onFrameRender(). Can also be enabled with the 'simthread' command line argument
         };
 
         Window::Desc windowDesc;                                    ///< Controls window creation
@@ -113,7 +118,10 @@ namespace Falcor
         void freezeTime(bool timeFrozen) override { mFreezeTime = timeFrozen; }
         bool isTimeFrozen() override { return mFreezeTime; }
         std::string captureScreen(const std::string explicitFilename = "", const std::string explicitOutputDirectory = "") override;
+        void flushScreenCaptures() override { if (mpScreenCapture) { mpScreenCapture->flush(); } }
         void shutdown() override { if (mpWindow) { mpWindow->shutdown(); } }
+        bool isSimulationPipelined() override { return mpSimulation != nullptr; }
+        void waitForSimulation() override { if (mpSimulation) { mpSimulation->wait(); } }
         
         //Any cleanup required by renderer if its being shut down early via testing 
         void onTestShutdown() override { mpRenderer->onTestShutdown(mpSampleTest.get()); }
@@ -122,6 +130,7 @@ namespace Falcor
         bool initializeTesting();
         void beginTestFrame();
         void endTestFrame();
+        bool initializeBenchmark();
 
         /** Internal data structures
         */
@@ -147,7 +156,10 @@ namespace Falcor
         // Private functions
         void initUI();
         void printProfileData();
+        float getTimeStep() const;
         void calculateTime();
+        void kickSimulation();
+        void updateSimulationStats(const CpuTimer::TimePoint& frameStart);
 
         void startVideoCapture();
         void endVideoCapture();
@@ -168,12 +180,17 @@ namespace Falcor
         {
             VideoEncoderUI::UniquePtr pUI;
             VideoEncoder::UniquePtr pVideoCapture;
-            uint8_t* pFrame = nullptr;
+            FrameCapture::UniquePtr pFrameCapture;  // Reads back the frames and feeds them to the encoder on a worker thread
             float sampleTimeDelta; // Saves the sample's fixed time delta because video capture overwrites it while recording
         };
 
         VideoCaptureData mVideoCapture;
 
+        // Screenshots are written asynchronously, so their files don't exist yet when the next capture looks for an available filename
+        std::set<std::string> mPendingScreenCaptures;
+        std::mutex mPendingScreenCapturesMutex;
+        FrameCapture::UniquePtr mpScreenCapture;
+
         FrameRate mFrameRate;
         
         float mFixedTimeDelta;
@@ -192,6 +209,17 @@ namespace Falcor
         Fbo::SharedPtr mpBackBufferFBO;     ///< The FBO for the back buffer
         //Testing
         SampleTest::UniquePtr mpSampleTest = nullptr;
+        //Benchmarking
+        SampleBenchmark::UniquePtr mpBenchmark = nullptr;
+        //Simulation pipeline
+        SimulationThread::UniquePtr mpSimulation;
+        struct
+        {
+            float latency = 0;          ///< Average time from the start of a frame's simulation to its present, in milliseconds
+            float addedLatency = 0;     ///< Average part of the latency caused by simulating one frame ahead
+            float simulationTime = 0;   ///< Average simulation step time
+            float stallTime = 0;        ///< Average time the render thread waited for the simulation
+        } mSimulationStats;
     };
     enum_class_operators(SampleConfig::Flags);
 };
\ No newline at end of file
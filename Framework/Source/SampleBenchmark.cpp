@@ -0,0 +1,281 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SampleBenchmark.h"
+#include "Renderer.h"
+#include "ArgList.h"
+#include "API/Device.h"
+#include "Utils/Profiler.h"
+#include "Utils/Platform/OS.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct Summary
+        {
+            float mean = 0;
+            float min = 0;
+            float max = 0;
+            float stdDev = 0;
+            float p50 = 0;
+            float p90 = 0;
+            float p95 = 0;
+            float p99 = 0;
+        };
+
+        // Nearest-rank percentile of a sorted array
+        float percentile(const std::vector<float>& sorted, float p)
+        {
+            size_t rank = (size_t)std::ceil(p / 100.0f * sorted.size());
+            return sorted[std::max<size_t>(rank, 1) - 1];
+        }
+
+        Summary summarize(std::vector<float> values)
+        {
+            Summary s;
+            if (values.empty()) return s;
+
+            std::sort(values.begin(), values.end());
+            double sum = 0;
+            for (float v : values) sum += v;
+            double mean = sum / values.size();
+            double variance = 0;
+            for (float v : values) variance += (v - mean) * (v - mean);
+
+            s.mean = (float)mean;
+            s.min = values.front();
+            s.max = values.back();
+            s.stdDev = (float)std::sqrt(variance / values.size());
+            s.p50 = percentile(values, 50);
+            s.p90 = percentile(values, 90);
+            s.p95 = percentile(values, 95);
+            s.p99 = percentile(values, 99);
+            return s;
+        }
+
+        rapidjson::Value summaryToJson(const Summary& s, rapidjson::Document::AllocatorType& allocator)
+        {
+            rapidjson::Value v(rapidjson::kObjectType);
+            v.AddMember("mean", s.mean, allocator);
+            v.AddMember("min", s.min, allocator);
+            v.AddMember("max", s.max, allocator);
+            v.AddMember("stdDev", s.stdDev, allocator);
+            v.AddMember("p50", s.p50, allocator);
+            v.AddMember("p90", s.p90, allocator);
+            v.AddMember("p95", s.p95, allocator);
+            v.AddMember("p99", s.p99, allocator);
+            return v;
+        }
+
+        // Replace characters that would break the CSV header
+        std::string csvColumnName(std::string name)
+        {
+            std::replace(name.begin(), name.end(), ',', '_');
+            std::replace(name.begin(), name.end(), ' ', '_');
+            return name;
+        }
+    }
+
+    SampleBenchmark::UniquePtr SampleBenchmark::create(const ArgList& args)
+    {
+        if (args.argExists("benchmark") == false) return nullptr;
+
+        Desc desc;
+        std::vector<ArgList::Arg> values;
+        if ((values = args.getValues("benchwarmup")).size()) desc.warmupFrames = values[0].asUint();
+        if ((values = args.getValues("benchframes")).size()) desc.measuredFrames = std::max(1u, values[0].asUint());
+        if ((values = args.getValues("benchtimedelta")).size()) desc.timeDelta = values[0].asFloat();
+        if ((values = args.getValues("benchpath")).size()) desc.cameraPathIndex = values[0].asUint();
+
+        std::string exeName = getExecutableName();
+        desc.outputFilename = exeName.substr(0, exeName.size() - 4) + "_benchmark";
+        if ((values = args.getValues("benchoutput")).size()) desc.outputFilename = values[0].asString();
+        if ((values = args.getValues("outputdir")).size()) desc.outputFilename = values[0].asString() + "/" + desc.outputFilename;
+
+        if (desc.timeDelta <= 0)
+        {
+            logWarning("SampleBenchmark: invalid time delta " + std::to_string(desc.timeDelta) + ", using 1/60 seconds");
+            desc.timeDelta = 1.0f / 60.0f;
+        }
+
+        return UniquePtr(new SampleBenchmark(desc));
+    }
+
+    void SampleBenchmark::initialize(SampleCallbacks* pSample)
+    {
+        pSample->setFixedTimeDelta(mDesc.timeDelta);
+        pSample->setCurrentTime(0);
+        pSample->freezeTime(false);
+        pSample->toggleUI(false);
+        pSample->toggleText(false);
+        gpDevice->toggleVSync(false);
+        gProfileEnabled = true;
+        mRecords.reserve(mDesc.measuredFrames);
+    }
+
+    void SampleBenchmark::beginFrame(SampleCallbacks* pSample)
+    {
+        // The frame time of a frame is only known when the next one starts
+        CpuTimer::TimePoint now = CpuTimer::getCurrentTimePoint();
+        if (mFrame > mDesc.warmupFrames)
+        {
+            mRecords.back().frameTime = (float)CpuTimer::calcDuration(mFrameStart, now);
+        }
+        mFrameStart = now;
+        mCurrentFrame = FrameRecord();
+    }
+
+    void SampleBenchmark::recordProfilerEvents()
+    {
+        if (isRecording() == false) return;
+
+        FrameRecord& record = mCurrentFrame;
+        const auto& events = Profiler::getEvents();
+        // Events may be added while recording. The CSV pads missing columns of earlier frames
+        for (size_t i = mEventNames.size(); i < events.size(); i++)
+        {
+            mEventNames.push_back(events[i]->name);
+        }
+        record.cpuTimes.resize(events.size());
+        record.gpuTimes.resize(events.size());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            record.cpuTimes[i] = events[i]->cpuLastFrame;
+            record.gpuTimes[i] = events[i]->gpuLastFrame;
+        }
+    }
+
+    void SampleBenchmark::endFrame(SampleCallbacks* pSample)
+    {
+        if (isRecording())
+        {
+            mRecords.push_back(std::move(mCurrentFrame));
+        }
+
+        mFrame++;
+        if (mFrame == mDesc.warmupFrames + mDesc.measuredFrames)
+        {
+            // There is no next frame, so close the last one here
+            mRecords.back().frameTime = (float)CpuTimer::calcDuration(mFrameStart, CpuTimer::getCurrentTimePoint());
+            writeReports();
+            pSample->shutdown();
+        }
+    }
+
+    void SampleBenchmark::writeReports() const
+    {
+        std::vector<float> frameTimes;
+        frameTimes.reserve(mRecords.size());
+        for (const auto& r : mRecords) frameTimes.push_back(r.frameTime);
+
+        // JSON summary
+        rapidjson::Document doc;
+        doc.SetObject();
+        auto& allocator = doc.GetAllocator();
+
+        rapidjson::Value config(rapidjson::kObjectType);
+        config.AddMember("warmupFrames", mDesc.warmupFrames, allocator);
+        config.AddMember("measuredFrames", (uint32_t)mRecords.size(), allocator);
+        config.AddMember("timeDelta", mDesc.timeDelta, allocator);
+        config.AddMember("cameraPathIndex", mDesc.cameraPathIndex, allocator);
+        doc.AddMember("config", config, allocator);
+        doc.AddMember("frameTimeMs", summaryToJson(summarize(frameTimes), allocator), allocator);
+
+        rapidjson::Value events(rapidjson::kArrayType);
+        for (size_t e = 0; e < mEventNames.size(); e++)
+        {
+            std::vector<float> cpu, gpu;
+            for (const auto& r : mRecords)
+            {
+                if (e < r.cpuTimes.size())
+                {
+                    cpu.push_back(r.cpuTimes[e]);
+                    gpu.push_back(r.gpuTimes[e]);
+                }
+            }
+            rapidjson::Value event(rapidjson::kObjectType);
+            event.AddMember("name", rapidjson::Value(mEventNames[e].c_str(), allocator), allocator);
+            event.AddMember("cpuMs", summaryToJson(summarize(cpu), allocator), allocator);
+            event.AddMember("gpuMs", summaryToJson(summarize(gpu), allocator), allocator);
+            events.PushBack(event, allocator);
+        }
+        doc.AddMember("events", events, allocator);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.SetIndent(' ', 4);
+        doc.Accept(writer);
+
+        std::string jsonFilename = mDesc.outputFilename + ".json";
+        std::ofstream jsonStream(jsonFilename);
+        if (jsonStream.fail())
+        {
+            logError("SampleBenchmark: cannot write to " + jsonFilename);
+        }
+        else
+        {
+            jsonStream << std::string(buffer.GetString(), buffer.GetSize());
+        }
+
+        // Per-frame CSV
+        std::string csvFilename = mDesc.outputFilename + ".csv";
+        std::ofstream csvStream(csvFilename);
+        if (csvStream.fail())
+        {
+            logError("SampleBenchmark: cannot write to " + csvFilename);
+            return;
+        }
+
+        csvStream << "frame,frameTimeMs";
+        for (const auto& name : mEventNames)
+        {
+            std::string column = csvColumnName(name);
+            csvStream << "," << column << "_cpuMs," << column << "_gpuMs";
+        }
+        csvStream << "\n";
+
+        for (size_t f = 0; f < mRecords.size(); f++)
+        {
+            const auto& r = mRecords[f];
+            csvStream << (mDesc.warmupFrames + f) << "," << r.frameTime;
+            for (size_t e = 0; e < mEventNames.size(); e++)
+            {
+                if (e < r.cpuTimes.size()) csvStream << "," << r.cpuTimes[e] << "," << r.gpuTimes[e];
+                else csvStream << ",,";
+            }
+            csvStream << "\n";
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    class SampleCallbacks;
+    class ArgList;
+
+    /** Deterministic benchmark mode for samples.
+        Enabled with the 'benchmark' command line argument. The sample runs with a fixed time step, without vsync, GUI or text. After a number of warm-up frames, the frame time and the CPU/GPU time of every profiler event are recorded for a fixed number of frames.
+        Then a JSON report with percentile summaries and a CSV file with the per-frame timings are written, and the sample shuts down.
+        Arguments: -benchwarmup <frames>, -benchframes <frames>, -benchtimedelta <seconds>, -benchpath <camera path index>, -benchoutput <filename without extension>, -outputdir <directory>.
+    */
+    class SampleBenchmark
+    {
+    public:
+        using UniquePtr = std::unique_ptr<SampleBenchmark>;
+
+        struct Desc
+        {
+            uint32_t warmupFrames = 60;         ///< Frames rendered before recording starts
+            uint32_t measuredFrames = 600;      ///< Frames recorded
+            float timeDelta = 1.0f / 60.0f;     ///< Fixed time step, in seconds
+            uint32_t cameraPathIndex = 0;       ///< Index of the path the renderer should attach the camera to
+            std::string outputFilename;         ///< Report filename, without extension. Both <filename>.json and <filename>.csv are written
+        };
+
+        /** Create a benchmark from command line arguments
+            \return A new object, or nullptr if the 'benchmark' argument is not set
+        */
+        static UniquePtr create(const ArgList& args);
+
+        /** Configure the sample for deterministic rendering
+        */
+        void initialize(SampleCallbacks* pSample);
+
+        /** Get the benchmark settings
+        */
+        const Desc& getDesc() const { return mDesc; }
+
+        /** Get the index of the scene path the camera should follow. Renderers attach their camera to it in Renderer::onInitializeBenchmark()
+        */
+        uint32_t getCameraPathIndex() const { return mDesc.cameraPathIndex; }
+
+        /** Check if the current frame is recorded
+        */
+        bool isRecording() const { return mFrame >= mDesc.warmupFrames; }
+
+        /** Called at the start of every frame
+        */
+        void beginFrame(SampleCallbacks* pSample);
+
+        /** Record the profiler events of the frame. Called right after Profiler::endFrame()
+        */
+        void recordProfilerEvents();
+
+        /** Called at the end of every frame, after present. Writes the reports and shuts down the sample after the last frame
+        */
+        void endFrame(SampleCallbacks* pSample);
+
+    private:
+        SampleBenchmark(const Desc& desc) : mDesc(desc) {}
+        void writeReports() const;
+
+        struct FrameRecord
+        {
+            float frameTime = 0;            // Milliseconds between the start of this frame and the start of the next one
+            std::vector<float> cpuTimes;    // Per profiler event, in milliseconds
+            std::vector<float> gpuTimes;
+        };
+
+        Desc mDesc;
+        uint32_t mFrame = 0;
+        CpuTimer::TimePoint mFrameStart;
+        std::vector<std::string> mEventNames;
+        std::vector<FrameRecord> mRecords;
+        FrameRecord mCurrentFrame;
+    };
+}
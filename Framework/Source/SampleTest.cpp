@@ -246,6 +246,12 @@ namespace Falcor
 
         // Write the Screen Capture Results.
         writeScreenCaptureResults(jsonTestResults);
+
+        // Write the Image Comparison Results.
+        if (mHasReferenceDirectory)
+        {
+            writeImageComparisonResults(jsonTestResults);
+        }
     }
 
     // Write Load Time.
@@ -360,6 +366,43 @@ namespace Falcor
         jsonTestResults.AddMember("Time Screen Captures", sctArray, jsonAllocator);
     }
 
+    void SampleTest::writeImageComparisonResults(rapidjson::Document & jsonTestResults)
+    {
+        // Each capture is compared with the Reference Image of the same name. The heatmap is written next to the capture.
+        std::vector<ImageCompare::FilePair> files;
+        auto addCapture = [&](const std::string& filepath, const std::string& filename)
+        {
+            if (filename.empty()) return;
+            ImageCompare::FilePair pair;
+            pair.reference = mReferenceDirectory + "/" + filename;
+            pair.image = filepath + "/" + filename;
+            pair.heatmap = filepath + "/" + filename.substr(0, filename.find_last_of('.')) + "_diff.png";
+            files.push_back(pair);
+        };
+
+        for (const auto& pTask : mFrameTasks)
+        {
+            std::shared_ptr<ScreenCaptureFrameTask> scfTask = std::dynamic_pointer_cast<ScreenCaptureFrameTask>(pTask);
+            if (scfTask != nullptr) addCapture(scfTask->mCaptureFilepath, scfTask->mCaptureFilename);
+        }
+
+        for (const auto& pTask : mTimeTasks)
+        {
+            std::shared_ptr<ScreenCaptureTimeTask> sctTask = std::dynamic_pointer_cast<ScreenCaptureTimeTask>(pTask);
+            if (sctTask != nullptr) addCapture(sctTask->mCaptureFilepath, sctTask->mCaptureFilename);
+        }
+
+        std::vector<ImageCompare::Result> results = ImageCompare::compareFiles(files, mCompareTolerance);
+
+        auto & jsonAllocator = jsonTestResults.GetAllocator();
+        rapidjson::Value comparisonArray;
+        ImageCompare::writeJson(results, comparisonArray, jsonAllocator);
+        jsonTestResults.AddMember("Image Comparisons", comparisonArray, jsonAllocator);
+
+        bool passed = std::all_of(results.begin(), results.end(), [](const ImageCompare::Result& r) { return r.passed; });
+        writeJsonBool(jsonTestResults, jsonAllocator, "Image Comparisons Passed", passed);
+    }
+
     // Initialize the Tests.
     void SampleTest::initializeTests(SampleCallbacks* pSample)
     {
@@ -386,6 +429,17 @@ namespace Falcor
             }
         }
 
+        // Check for a Reference Image Directory.
+        if (argList.argExists("refdir"))
+        {
+            std::vector<ArgList::Arg> rdArgs = argList.getValues("refdir");
+            if (!rdArgs.empty())
+            {
+                mHasReferenceDirectory = true;
+                mReferenceDirectory = rdArgs[0].asString();
+            }
+        }
+
         if (argList.argExists("fixedtimedelta"))
         {
             std::vector<ArgList::Arg> ftdArgs = argList.getValues("fixedtimedelta");
@@ -709,6 +763,9 @@ namespace Falcor
 
     void SampleTest::ShutdownFrameTask::onFrameEnd(SampleCallbacks* pSample, SampleTest* pSampleTest)
     {
+        // Wait for the Screen Captures to be written.
+        pSample->flushScreenCaptures();
+
         // Write the json Test Results.
         pSampleTest->writeJsonTestResults();
 
@@ -805,6 +862,9 @@ namespace Falcor
     {
         if (mShutdownTime <= pSample->getCurrentTime() && !mIsTaskComplete)
         {
+            // Wait for the Screen Captures to be written.
+            pSample->flushScreenCaptures();
+
             // Write the json Test Results.
             pSampleTest->writeJsonTestResults();
 
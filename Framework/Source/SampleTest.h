@@ -29,6 +29,7 @@
 #include "Externals/RapidJson/include/rapidjson/document.h"
 #include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
 #include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+#include "Utils/ImageCompare.h"
 
 namespace Falcor
 {
@@ -337,6 +338,10 @@ namespace Falcor
         */
         void writeScreenCaptureResults(rapidjson::Document & jsonTestResults);
 
+        /** Compare the Screen Captures against the Reference Images and write the Results.
+        */
+        void writeImageComparisonResults(rapidjson::Document & jsonTestResults);
+
         
         /** Initialize the Frame Tests.
         */
@@ -352,6 +357,11 @@ namespace Falcor
         bool mHasSetFilename = false;
         std::string mTestOutputFilename = "";
 
+        // Reference Images the Screen Captures are compared against.
+        bool mHasReferenceDirectory = false;
+        std::string mReferenceDirectory = "";
+        ImageCompare::Tolerance mCompareTolerance;
+
         // The Memory Check Between Frames.
         struct MemoryCheckRange
         {
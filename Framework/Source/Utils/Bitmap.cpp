@@ -32,6 +32,7 @@
 #include "API/Device.h"
 #include <cstring>
 #include "StringUtils.h"
+#include "BitmapCodec.h"
 
 namespace Falcor
 {
@@ -42,15 +43,8 @@ namespace Falcor
         return nullptr;
     }
 
-    Bitmap::UniqueConstPtr Bitmap::createFromFile(const std::string& filename, bool isTopDown)
+    static bool loadWithFreeImage(const std::string& fullpath, const std::string& filename, bool isTopDown, const Bitmap::AllocFunc& allocFunc)
     {
-        std::string fullpath;
-        if(findFileInDataDirectories(filename, fullpath) == false)
-        {
-            msgBox("Error when loading image file " + filename + "\n. Can't find the file");
-            return nullptr;
-        }
-
         FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
         
         fifFormat = FreeImage_GetFileType(fullpath.c_str(), 0);
@@ -61,65 +55,70 @@ namespace Falcor
 
             if(fifFormat == FIF_UNKNOWN)
             {
-                return UniqueConstPtr(genError("Image Type unknown", filename));
+                genError("Image Type unknown", filename);
+                return false;
             }
         }
 
         // Check the the library supports loading this image Type
         if(FreeImage_FIFSupportsReading(fifFormat) == false)
         {
-            return UniqueConstPtr(genError("Library doesn't support the file format", filename));
+            genError("Library doesn't support the file format", filename);
+            return false;
         }
 
         // Read the DIB
         FIBITMAP* pDib = FreeImage_Load(fifFormat, fullpath.c_str());
         if(pDib == nullptr)
         {
-            return UniqueConstPtr(genError("Can't read image file", filename));
+            genError("Can't read image file", filename);
+            return false;
         }
 
-        // create the bitmap
-        auto pBmp = new Bitmap;
-        pBmp->mHeight = FreeImage_GetHeight(pDib);
-        pBmp->mWidth = FreeImage_GetWidth(pDib);
+        uint32_t height = FreeImage_GetHeight(pDib);
+        uint32_t width = FreeImage_GetWidth(pDib);
 
-        if(pBmp->mHeight == 0 || pBmp->mWidth == 0 || FreeImage_GetBits(pDib) == nullptr)
+        if(height == 0 || width == 0 || FreeImage_GetBits(pDib) == nullptr)
         {
-            return UniqueConstPtr(genError("Invalid image", filename));
+            FreeImage_Unload(pDib);
+            genError("Invalid image", filename);
+            return false;
         }
 
         uint32_t bpp = FreeImage_GetBPP(pDib);
         bool rgb32FloatSupported = gpDevice->isRgb32FloatSupported();
+        ResourceFormat format;
 
         switch(bpp)
         {
         case 128:
-            pBmp->mFormat = ResourceFormat::RGBA32Float;  // 4xfloat32 HDR format
+            format = ResourceFormat::RGBA32Float;  // 4xfloat32 HDR format
             break;
         case 96:
-            pBmp->mFormat = rgb32FloatSupported ? ResourceFormat::RGB32Float : ResourceFormat::RGBA32Float;  // 4xfloat32 HDR format
+            format = rgb32FloatSupported ? ResourceFormat::RGB32Float : ResourceFormat::RGBA32Float;  // 4xfloat32 HDR format
             break;
         case 64:
-            pBmp->mFormat = ResourceFormat::RGBA16Float;  // 4xfloat16 HDR format
+            format = ResourceFormat::RGBA16Float;  // 4xfloat16 HDR format
             break;
         case 48:
-            pBmp->mFormat = ResourceFormat::RGB16Float;  // 3xfloat16 HDR format
+            format = ResourceFormat::RGB16Float;  // 3xfloat16 HDR format
             break;
         case 32:
-            pBmp->mFormat = ResourceFormat::BGRA8Unorm;
+            format = ResourceFormat::BGRA8Unorm;
             break;
         case 24:
-            pBmp->mFormat = ResourceFormat::BGRX8Unorm;
+            format = ResourceFormat::BGRX8Unorm;
             break;
         case 16:
-            pBmp->mFormat = ResourceFormat::RG8Unorm;
+            format = ResourceFormat::RG8Unorm;
             break;
         case 8:
-            pBmp->mFormat = ResourceFormat::R8Unorm;
+            format = ResourceFormat::R8Unorm;
             break;
         default:
+            FreeImage_Unload(pDib);
             genError("Unknown bits-per-pixel", filename);
-            return nullptr;
+            return false;
         }
 
         // Convert the image to RGBX image
@@ -142,12 +141,53 @@ namespace Falcor
         }
 
         uint32_t bytesPerPixel = bpp / 8;
-
-        pBmp->mpData = new uint8_t[pBmp->mHeight * pBmp->mWidth * bytesPerPixel];
-        FreeImage_ConvertToRawBits(pBmp->mpData, pDib, pBmp->mWidth * bytesPerPixel, bpp, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+        uint8_t* pData = allocFunc(width, height, format);
+        if(pData)
+        {
+            FreeImage_ConvertToRawBits(pData, pDib, width * bytesPerPixel, bpp, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+        }
 
         FreeImage_Unload(pDib);
-        return UniqueConstPtr(pBmp);
+        return pData != nullptr;
+    }
+
+    bool Bitmap::loadImage(const std::string& filename, bool isTopDown, const AllocFunc& allocFunc)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath) == false)
+        {
+            msgBox("Error when loading image file " + filename + "\n. Can't find the file");
+            return false;
+        }
+
+        // Native codecs decode straight into the destination. If one fails, FreeImage gets a chance to read the file
+        const BitmapCodec* pCodec = BitmapCodec::findDecoder(fullpath);
+        if(pCodec && pCodec->decode(fullpath, isTopDown, allocFunc))
+        {
+            return true;
+        }
+        return loadWithFreeImage(fullpath, filename, isTopDown, allocFunc);
+    }
+
+    Bitmap::UniqueConstPtr Bitmap::createFromFile(const std::string& filename, bool isTopDown)
+    {
+        UniquePtr pBmp = UniquePtr(new Bitmap);
+        auto allocFunc = [&pBmp](uint32_t width, uint32_t height, ResourceFormat format)
+        {
+            // Can be called again if a codec failed after allocating
+            delete[] pBmp->mpData;
+            pBmp->mWidth = width;
+            pBmp->mHeight = height;
+            pBmp->mFormat = format;
+            pBmp->mpData = new uint8_t[(size_t)width * height * getFormatBytesPerBlock(format)];
+            return pBmp->mpData;
+        };
+
+        if(loadImage(filename, isTopDown, allocFunc) == false)
+        {
+            return nullptr;
+        }
+        return UniqueConstPtr(pBmp.release());
     }
 
     Bitmap::~Bitmap()
@@ -208,6 +248,16 @@ namespace Falcor
             return;
         }
 
+        const BitmapCodec* pCodec = BitmapCodec::findEncoder(fileFormat, resourceFormat, exportFlags);
+        if(pCodec)
+        {
+            if(pCodec->encode(filename, width, height, fileFormat, exportFlags, resourceFormat, isTopDown, pData) == false)
+            {
+                logError("Bitmap::saveImage: " + std::string(pCodec->getName()) + " codec failed to write " + filename);
+            }
+            return;
+        }
+
         int flags = 0;
         FIBITMAP* pImage = nullptr;
         uint32_t bytesPerPixel = getFormatBytesPerBlock(resourceFormat);
@@ -27,6 +27,7 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <functional>
 
 namespace Falcor
 {
@@ -56,6 +57,10 @@ namespace Falcor
         using UniquePtr = std::unique_ptr<Bitmap>;
         using UniqueConstPtr = std::unique_ptr<const Bitmap>;
 
+        /** Provides the destination buffer when loading an image. The buffer must hold width * height pixels of the given format, with tightly packed rows. Return nullptr to cancel loading
+        */
+        using AllocFunc = std::function<uint8_t*(uint32_t width, uint32_t height, ResourceFormat format)>;
+
         /** Create a new object from file
             \param[in] filename Filename, including a path. If the file can't be found relative to the current directory, Falcor will search for it in the common directories.
             \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel is the first pixel in the buffer, otherwise the bottom-left pixel is first.
@@ -63,6 +68,14 @@ namespace Falcor
         */
         static UniqueConstPtr createFromFile(const std::string& filename, bool isTopDown);
 
+        /** Load an image into a caller-provided buffer. Files handled by a registered BitmapCodec are decoded directly into the buffer, other files are loaded with FreeImage.
+            \param[in] filename Filename, including a path. If the file can't be found relative to the current directory, Falcor will search for it in the common directories.
+            \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel is the first pixel in the buffer, otherwise the bottom-left pixel is first.
+            \param[in] allocFunc Called once the image dimensions and format are known, to get the destination buffer
+            \return true if the image was loaded, otherwise false
+        */
+        static bool loadImage(const std::string& filename, bool isTopDown, const AllocFunc& allocFunc);
+
         /** Store a memory buffer to a PNG file.
             \param[in] filename Output filename. Can include a path - absolute or relative to the executable directory.
             \param[in] width The width of the image.
@@ -0,0 +1,316 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BitmapCodec.h"
+#include "API/Device.h"
+#include <fstream>
+#include <mutex>
+#include <algorithm>
+#include <cctype>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Uncompressed true-color and grayscale TGA files. RLE-compressed and color-mapped files are left to FreeImage
+        */
+        class TgaCodec : public BitmapCodec
+        {
+        public:
+            const char* getName() const override { return "TGA"; }
+
+            bool canDecode(const std::string& extension, const uint8_t* pHeader, size_t headerSize) const override
+            {
+                if(extension != "tga" || headerSize < kTgaHeaderSize) return false;
+                uint8_t imageType = pHeader[2];
+                uint8_t bpp = pHeader[16];
+                bool supportedType = (imageType == 2 && (bpp == 24 || bpp == 32)) || (imageType == 3 && bpp == 8);
+                bool rightToLeft = (pHeader[17] & 0x10) != 0;
+                return pHeader[1] == 0 && supportedType && rightToLeft == false && getWidth(pHeader) > 0 && getHeight(pHeader) > 0;
+            }
+
+            bool decode(const std::string& filename, bool isTopDown, const Bitmap::AllocFunc& allocFunc) const override
+            {
+                std::ifstream file(filename, std::ios::binary);
+                uint8_t header[kTgaHeaderSize];
+                if(file.read((char*)header, kTgaHeaderSize).fail()) return false;
+                file.seekg(kTgaHeaderSize + header[0]);
+
+                uint32_t width = getWidth(header);
+                uint32_t height = getHeight(header);
+                uint32_t bpp = header[16];
+                bool fileTopDown = (header[17] & 0x20) != 0;
+                ResourceFormat format = (bpp == 8) ? ResourceFormat::R8Unorm : ((bpp == 32) ? ResourceFormat::BGRA8Unorm : ResourceFormat::BGRX8Unorm);
+
+                uint8_t* pDst = allocFunc(width, height, format);
+                if(pDst == nullptr) return false;
+
+                // TGA stores pixels as BGR(A), which matches the destination formats. Only 24-bit pixels need to be expanded
+                uint32_t srcPitch = width * bpp / 8;
+                uint32_t dstPitch = width * getFormatBytesPerBlock(format);
+                bool flip = (fileTopDown != isTopDown);
+                if(bpp != 24 && flip == false)
+                {
+                    return file.read((char*)pDst, (size_t)srcPitch * height).good();
+                }
+
+                std::vector<uint8_t> row(bpp == 24 ? srcPitch : 0);
+                for(uint32_t y = 0; y < height; y++)
+                {
+                    uint8_t* pDstRow = pDst + (size_t)(flip ? height - 1 - y : y) * dstPitch;
+                    if(bpp == 24)
+                    {
+                        if(file.read((char*)row.data(), srcPitch).fail()) return false;
+                        for(uint32_t x = 0; x < width; x++)
+                        {
+                            pDstRow[x * 4 + 0] = row[x * 3 + 0];
+                            pDstRow[x * 4 + 1] = row[x * 3 + 1];
+                            pDstRow[x * 4 + 2] = row[x * 3 + 2];
+                            pDstRow[x * 4 + 3] = 0xff;
+                        }
+                    }
+                    else if(file.read((char*)pDstRow, srcPitch).fail())
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool canEncode(Bitmap::FileFormat fileFormat, ResourceFormat resourceFormat, Bitmap::ExportFlags exportFlags) const override
+            {
+                if(fileFormat != Bitmap::FileFormat::TgaFile || is_set(exportFlags, Bitmap::ExportFlags::Lossy)) return false;
+                switch(resourceFormat)
+                {
+                case ResourceFormat::RGBA8Unorm:
+                case ResourceFormat::RGBA8UnormSrgb:
+                case ResourceFormat::BGRA8Unorm:
+                case ResourceFormat::BGRA8UnormSrgb:
+                case ResourceFormat::BGRX8Unorm:
+                case ResourceFormat::BGRX8UnormSrgb:
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            bool encode(const std::string& filename, uint32_t width, uint32_t height, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, const void* pData) const override
+            {
+                bool exportAlpha = is_set(exportFlags, Bitmap::ExportFlags::ExportAlpha);
+                bool swapRB = (resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb);
+                uint32_t dstBytesPerPixel = exportAlpha ? 4 : 3;
+
+                uint8_t header[kTgaHeaderSize] = {};
+                header[2] = 2;
+                header[12] = uint8_t(width);
+                header[13] = uint8_t(width >> 8);
+                header[14] = uint8_t(height);
+                header[15] = uint8_t(height >> 8);
+                header[16] = uint8_t(dstBytesPerPixel * 8);
+                header[17] = uint8_t((exportAlpha ? 8 : 0) | (isTopDown ? 0x20 : 0));
+
+                std::ofstream file(filename, std::ios::binary);
+                file.write((const char*)header, kTgaHeaderSize);
+
+                // Rows are written in memory order, the header tells readers which row comes first
+                std::vector<uint8_t> row(width * dstBytesPerPixel);
+                const uint8_t* pSrc = (const uint8_t*)pData;
+                for(uint32_t y = 0; y < height; y++)
+                {
+                    for(uint32_t x = 0; x < width; x++, pSrc += 4)
+                    {
+                        uint8_t* pDst = &row[x * dstBytesPerPixel];
+                        pDst[0] = swapRB ? pSrc[2] : pSrc[0];
+                        pDst[1] = pSrc[1];
+                        pDst[2] = swapRB ? pSrc[0] : pSrc[2];
+                        if(exportAlpha) pDst[3] = pSrc[3];
+                    }
+                    file.write((const char*)row.data(), row.size());
+                }
+                return file.good();
+            }
+
+        private:
+            static const size_t kTgaHeaderSize = 18;
+            static uint32_t getWidth(const uint8_t* pHeader) { return pHeader[12] | (pHeader[13] << 8); }
+            static uint32_t getHeight(const uint8_t* pHeader) { return pHeader[14] | (pHeader[15] << 8); }
+        };
+
+        /** Portable float map files, with one or three 32-bit float channels. Rows are stored bottom-up
+        */
+        class PfmCodec : public BitmapCodec
+        {
+        public:
+            const char* getName() const override { return "PFM"; }
+
+            bool canDecode(const std::string& extension, const uint8_t* pHeader, size_t headerSize) const override
+            {
+                return headerSize >= 3 && pHeader[0] == 'P' && (pHeader[1] == 'F' || pHeader[1] == 'f') && isspace(pHeader[2]);
+            }
+
+            bool decode(const std::string& filename, bool isTopDown, const Bitmap::AllocFunc& allocFunc) const override
+            {
+                std::ifstream file(filename, std::ios::binary);
+                std::string magic;
+                int32_t width = 0, height = 0;
+                float scale = 0;
+                file >> magic >> width >> height >> scale;
+                file.get(); // The single whitespace character before the data
+                if(file.fail() || width <= 0 || height <= 0 || scale == 0) return false;
+
+                uint32_t channels = (magic == "PF") ? 3 : 1;
+                bool bigEndian = scale > 0;
+                ResourceFormat format = ResourceFormat::R32Float;
+                if(channels == 3)
+                {
+                    format = gpDevice->isRgb32FloatSupported() ? ResourceFormat::RGB32Float : ResourceFormat::RGBA32Float;
+                }
+
+                uint8_t* pDst = allocFunc(width, height, format);
+                if(pDst == nullptr) return false;
+
+                uint32_t dstChannels = getFormatChannelCount(format);
+                size_t srcPitch = width * channels * sizeof(float);
+                size_t dstPitch = width * dstChannels * sizeof(float);
+                std::vector<float> row(dstChannels != channels ? width * channels : 0);
+                for(int32_t y = 0; y < height; y++)
+                {
+                    float* pDstRow = (float*)(pDst + (isTopDown ? height - 1 - y : y) * dstPitch);
+                    float* pRead = row.empty() ? pDstRow : row.data();
+                    if(file.read((char*)pRead, srcPitch).fail()) return false;
+
+                    if(bigEndian)
+                    {
+                        uint32_t* pWords = (uint32_t*)pRead;
+                        for(size_t i = 0; i < width * channels; i++)
+                        {
+                            uint32_t v = pWords[i];
+                            pWords[i] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+                        }
+                    }
+
+                    if(row.empty() == false)
+                    {
+                        for(int32_t x = 0; x < width; x++)
+                        {
+                            pDstRow[x * 4 + 0] = row[x * 3 + 0];
+                            pDstRow[x * 4 + 1] = row[x * 3 + 1];
+                            pDstRow[x * 4 + 2] = row[x * 3 + 2];
+                            pDstRow[x * 4 + 3] = 1.0f;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            bool canEncode(Bitmap::FileFormat fileFormat, ResourceFormat resourceFormat, Bitmap::ExportFlags exportFlags) const override
+            {
+                // Alpha and lossy export are errors, which the FreeImage path reports
+                bool supportedFlags = is_set(exportFlags, Bitmap::ExportFlags::ExportAlpha) == false && is_set(exportFlags, Bitmap::ExportFlags::Lossy) == false;
+                bool supportedFormat = (resourceFormat == ResourceFormat::RGB32Float || resourceFormat == ResourceFormat::RGBA32Float);
+                return fileFormat == Bitmap::FileFormat::PfmFile && supportedFlags && supportedFormat;
+            }
+
+            bool encode(const std::string& filename, uint32_t width, uint32_t height, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, const void* pData) const override
+            {
+                std::ofstream file(filename, std::ios::binary);
+                file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+                uint32_t srcChannels = getFormatChannelCount(resourceFormat);
+                std::vector<float> row(width * 3);
+                for(uint32_t y = 0; y < height; y++)
+                {
+                    const float* pSrcRow = (const float*)pData + (size_t)(isTopDown ? height - 1 - y : y) * width * srcChannels;
+                    if(srcChannels == 3)
+                    {
+                        file.write((const char*)pSrcRow, width * 3 * sizeof(float));
+                        continue;
+                    }
+
+                    for(uint32_t x = 0; x < width; x++)
+                    {
+                        row[x * 3 + 0] = pSrcRow[x * 4 + 0];
+                        row[x * 3 + 1] = pSrcRow[x * 4 + 1];
+                        row[x * 3 + 2] = pSrcRow[x * 4 + 2];
+                    }
+                    file.write((const char*)row.data(), row.size() * sizeof(float));
+                }
+                return file.good();
+            }
+        };
+
+        std::mutex gCodecMutex;
+
+        std::vector<BitmapCodec::SharedPtr>& getCodecs()
+        {
+            static std::vector<BitmapCodec::SharedPtr> codecs = { std::make_shared<TgaCodec>(), std::make_shared<PfmCodec>() };
+            return codecs;
+        }
+    }
+
+    void BitmapCodec::registerCodec(const SharedPtr& pCodec)
+    {
+        std::lock_guard<std::mutex> lock(gCodecMutex);
+        getCodecs().push_back(pCodec);
+    }
+
+    const BitmapCodec* BitmapCodec::findDecoder(const std::string& filename)
+    {
+        uint8_t header[kHeaderSize];
+        std::ifstream file(filename, std::ios::binary);
+        file.read((char*)header, kHeaderSize);
+        size_t headerSize = (size_t)file.gcount();
+
+        std::string extension;
+        size_t extPos = filename.find_last_of('.');
+        if(extPos != std::string::npos)
+        {
+            extension = filename.substr(extPos + 1);
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        }
+
+        std::lock_guard<std::mutex> lock(gCodecMutex);
+        const auto& codecs = getCodecs();
+        for(auto it = codecs.rbegin(); it != codecs.rend(); it++)
+        {
+            if((*it)->canDecode(extension, header, headerSize)) return it->get();
+        }
+        return nullptr;
+    }
+
+    const BitmapCodec* BitmapCodec::findEncoder(Bitmap::FileFormat fileFormat, ResourceFormat resourceFormat, Bitmap::ExportFlags exportFlags)
+    {
+        std::lock_guard<std::mutex> lock(gCodecMutex);
+        const auto& codecs = getCodecs();
+        for(auto it = codecs.rbegin(); it != codecs.rend(); it++)
+        {
+            if((*it)->canEncode(fileFormat, resourceFormat, exportFlags)) return it->get();
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "API/Formats.h"
+#include "Utils/Bitmap.h"
+
+namespace Falcor
+{
+    /** Native image file reader/writer used by Bitmap.
+        Bitmap asks the registered codecs first, in the reverse order of registration, and uses FreeImage for the files and formats none of them handle.
+        Codecs decode straight into the buffer returned by Bitmap::AllocFunc, without intermediate images. Falcor registers uncompressed TGA and PFM codecs.
+    */
+    class BitmapCodec
+    {
+    public:
+        using SharedPtr = std::shared_ptr<BitmapCodec>;
+
+        virtual ~BitmapCodec() = default;
+
+        /** Get the codec's name, used in log messages
+        */
+        virtual const char* getName() const = 0;
+
+        /** Check if the codec can read a file
+            \param[in] extension The lowercase file extension, without the dot
+            \param[in] pHeader The first bytes of the file
+            \param[in] headerSize Number of bytes in pHeader. Can be less than kHeaderSize for small files
+        */
+        virtual bool canDecode(const std::string& extension, const uint8_t* pHeader, size_t headerSize) const = 0;
+
+        /** Decode a file. Should only be called for files canDecode() accepted
+            \param[in] filename The full path of the file
+            \param[in] isTopDown If true, the top row is written first, otherwise the bottom row is written first
+            \param[in] allocFunc Provides the destination buffer
+            \return false if the file couldn't be decoded. Bitmap then falls back to FreeImage
+        */
+        virtual bool decode(const std::string& filename, bool isTopDown, const Bitmap::AllocFunc& allocFunc) const = 0;
+
+        /** Check if the codec can write an image
+        */
+        virtual bool canEncode(Bitmap::FileFormat fileFormat, ResourceFormat resourceFormat, Bitmap::ExportFlags exportFlags) const { return false; }
+
+        /** Write an image. Should only be called for images canEncode() accepted. The arguments match Bitmap::saveImage()
+            \return false if writing the file failed
+        */
+        virtual bool encode(const std::string& filename, uint32_t width, uint32_t height, Bitmap::FileFormat fileFormat, Bitmap::ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, const void* pData) const { return false; }
+
+        /** Number of file bytes passed to canDecode()
+        */
+        static const size_t kHeaderSize = 32;
+
+        /** Register a codec. Codecs registered later take precedence
+        */
+        static void registerCodec(const SharedPtr& pCodec);
+
+        /** Find a codec which can read a file
+            \param[in] filename The full path of the file
+            \return The codec, or nullptr if the file should be loaded with FreeImage
+        */
+        static const BitmapCodec* findDecoder(const std::string& filename);
+
+        /** Find a codec which can write an image
+            \return The codec, or nullptr if the image should be written with FreeImage
+        */
+        static const BitmapCodec* findEncoder(Bitmap::FileFormat fileFormat, ResourceFormat resourceFormat, Bitmap::ExportFlags exportFlags);
+    };
+}
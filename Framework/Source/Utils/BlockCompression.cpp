@@ -0,0 +1,750 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlockCompression.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <limits>
+
+namespace Falcor
+{
+    namespace BlockCompression
+    {
+        using EncodeFunc = void(*)(const uint8_t block[64], uint8_t* pOut);
+        using DecodeFunc = void(*)(const uint8_t* pIn, uint8_t block[64]);
+
+        static const uint32_t kBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        static const uint32_t kMinBlocksPerThread = 1024;
+
+        static float clamp255(float v)
+        {
+            return std::min(std::max(v, 0.0f), 255.0f);
+        }
+
+        /** Find the endpoints of the line which best fits the block's texels, using the principal axis of the texel distribution
+        */
+        static void findEndpoints(const uint8_t block[64], uint32_t channels, float e0[4], float e1[4])
+        {
+            float mean[4] = {};
+            float minVal[4] = { 255, 255, 255, 255 };
+            float maxVal[4] = {};
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    float v = block[i * 4 + c];
+                    mean[c] += v;
+                    minVal[c] = std::min(minVal[c], v);
+                    maxVal[c] = std::max(maxVal[c], v);
+                }
+            }
+            for (uint32_t c = 0; c < channels; c++) mean[c] /= 16.0f;
+
+            float cov[4][4] = {};
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                float d[4];
+                for (uint32_t c = 0; c < channels; c++) d[c] = block[i * 4 + c] - mean[c];
+                for (uint32_t r = 0; r < channels; r++)
+                {
+                    for (uint32_t c = 0; c < channels; c++) cov[r][c] += d[r] * d[c];
+                }
+            }
+
+            // Power iteration, starting from the bounding box diagonal
+            float axis[4] = {};
+            float lengthSq = 0;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                axis[c] = maxVal[c] - minVal[c];
+                lengthSq += axis[c] * axis[c];
+            }
+
+            if (lengthSq == 0)
+            {
+                for (uint32_t c = 0; c < 4; c++) e0[c] = e1[c] = (c < channels) ? mean[c] : 255.0f;
+                return;
+            }
+
+            for (uint32_t iter = 0; iter < 8; iter++)
+            {
+                float v[4] = {};
+                float maxAbs = 0;
+                for (uint32_t r = 0; r < channels; r++)
+                {
+                    for (uint32_t c = 0; c < channels; c++) v[r] += cov[r][c] * axis[c];
+                    maxAbs = std::max(maxAbs, std::abs(v[r]));
+                }
+                if (maxAbs == 0) break;
+                for (uint32_t c = 0; c < channels; c++) axis[c] = v[c] / maxAbs;
+            }
+
+            lengthSq = 0;
+            for (uint32_t c = 0; c < channels; c++) lengthSq += axis[c] * axis[c];
+            float invLength = 1.0f / std::sqrt(lengthSq);
+            for (uint32_t c = 0; c < channels; c++) axis[c] *= invLength;
+
+            // Project the texels on the axis
+            float tMin = std::numeric_limits<float>::max();
+            float tMax = -tMin;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                float t = 0;
+                for (uint32_t c = 0; c < channels; c++) t += (block[i * 4 + c] - mean[c]) * axis[c];
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+
+            // Inset the endpoints. The interpolated values usually represent the extremes well enough
+            float inset = (tMax - tMin) / 16.0f;
+            tMin += inset;
+            tMax -= inset;
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                e0[c] = (c < channels) ? clamp255(mean[c] + axis[c] * tMax) : 255.0f;
+                e1[c] = (c < channels) ? clamp255(mean[c] + axis[c] * tMin) : 255.0f;
+            }
+        }
+
+        /** Least-squares fit of the endpoints to a fixed set of texel weights. weights[i] is the contribution of e1 to texel i.
+        */
+        static bool refineEndpoints(const uint8_t block[64], uint32_t channels, const float weights[16], float e0[4], float e1[4])
+        {
+            float aa = 0, ab = 0, bb = 0;
+            float ax[4] = {}, bx[4] = {};
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                float b = weights[i];
+                float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    ax[c] += a * block[i * 4 + c];
+                    bx[c] += b * block[i * 4 + c];
+                }
+            }
+
+            float det = aa * bb - ab * ab;
+            if (std::abs(det) < 1e-6f) return false;
+
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                e0[c] = clamp255((bb * ax[c] - ab * bx[c]) / det);
+                e1[c] = clamp255((aa * bx[c] - ab * ax[c]) / det);
+            }
+            return true;
+        }
+
+        /** Select the closest palette entry for each texel. Returns the total squared error.
+        */
+        static uint32_t findIndices(const uint8_t block[64], uint32_t channels, const int palette[][4], uint32_t paletteSize, uint8_t indices[16])
+        {
+            uint32_t totalError = 0;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                uint32_t bestError = UINT32_MAX;
+                for (uint32_t p = 0; p < paletteSize; p++)
+                {
+                    uint32_t error = 0;
+                    for (uint32_t c = 0; c < channels; c++)
+                    {
+                        int d = (int)block[i * 4 + c] - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[i] = (uint8_t)p;
+                    }
+                }
+                totalError += bestError;
+            }
+            return totalError;
+        }
+
+        /** Fetch a 4x4 block, clamping coordinates to the image
+        */
+        static void fetchBlock(const uint8_t* pRGBA, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[64])
+        {
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                uint32_t srcY = std::min(blockY * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+                    const uint8_t* pSrc = pRGBA + ((size_t)srcY * width + srcX) * 4;
+                    std::copy(pSrc, pSrc + 4, block + (y * 4 + x) * 4);
+                }
+            }
+        }
+
+        /** Write a decoded 4x4 block, discarding the texels outside the image
+        */
+        static void storeBlock(const uint8_t block[64], uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* pRGBA)
+        {
+            for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+            {
+                for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+                {
+                    uint8_t* pDst = pRGBA + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4;
+                    std::copy(block + (y * 4 + x) * 4, block + (y * 4 + x) * 4 + 4, pDst);
+                }
+            }
+        }
+
+        // BC1
+
+        static uint16_t packRGB565(const float c[3])
+        {
+            uint32_t r = (uint32_t)std::round(c[0] * 31.0f / 255.0f);
+            uint32_t g = (uint32_t)std::round(c[1] * 63.0f / 255.0f);
+            uint32_t b = (uint32_t)std::round(c[2] * 31.0f / 255.0f);
+            return (uint16_t)((r << 11) | (g << 5) | b);
+        }
+
+        static void unpackRGB565(uint16_t v, int c[4])
+        {
+            int r = (v >> 11) & 31;
+            int g = (v >> 5) & 63;
+            int b = v & 31;
+            c[0] = (r << 3) | (r >> 2);
+            c[1] = (g << 2) | (g >> 4);
+            c[2] = (b << 3) | (b >> 2);
+            c[3] = 255;
+        }
+
+        static void getBC1Palette(uint16_t c0, uint16_t c1, bool fourColors, int palette[4][4])
+        {
+            unpackRGB565(c0, palette[0]);
+            unpackRGB565(c1, palette[1]);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                if (fourColors)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = fourColors ? 255 : 0;
+        }
+
+        static uint32_t quantizeBC1(const uint8_t block[64], const float e0[4], const float e1[4], uint16_t& c0, uint16_t& c1, uint8_t indices[16])
+        {
+            // We only use the 4-color mode, which requires c0 > c1. When c0 == c1 all the texels pick index 0, which decodes the same in both modes
+            c0 = packRGB565(e0);
+            c1 = packRGB565(e1);
+            if (c0 < c1) std::swap(c0, c1);
+
+            int palette[4][4];
+            getBC1Palette(c0, c1, true, palette);
+            return findIndices(block, 3, palette, 4, indices);
+        }
+
+        static void encodeBC1Block(const uint8_t block[64], uint8_t* pOut)
+        {
+            float e0[4], e1[4];
+            findEndpoints(block, 3, e0, e1);
+
+            uint16_t c0, c1;
+            uint8_t indices[16];
+            uint32_t error = quantizeBC1(block, e0, e1, c0, c1, indices);
+
+            // Refine the endpoints once using the selected indices
+            static const float kWeights[4] = { 0, 1, 1.0f / 3.0f, 2.0f / 3.0f };
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) weights[i] = kWeights[indices[i]];
+            if (error > 0 && refineEndpoints(block, 3, weights, e0, e1))
+            {
+                uint16_t refined0, refined1;
+                uint8_t refinedIndices[16];
+                uint32_t refinedError = quantizeBC1(block, e0, e1, refined0, refined1, refinedIndices);
+                if (refinedError < error)
+                {
+                    c0 = refined0;
+                    c1 = refined1;
+                    std::copy(refinedIndices, refinedIndices + 16, indices);
+                }
+            }
+
+            uint32_t packed = 0;
+            for (uint32_t i = 0; i < 16; i++) packed |= (uint32_t)indices[i] << (i * 2);
+            pOut[0] = (uint8_t)(c0 & 0xFF);
+            pOut[1] = (uint8_t)(c0 >> 8);
+            pOut[2] = (uint8_t)(c1 & 0xFF);
+            pOut[3] = (uint8_t)(c1 >> 8);
+            for (uint32_t i = 0; i < 4; i++) pOut[4 + i] = (uint8_t)(packed >> (i * 8));
+        }
+
+        static void decodeBC1Color(const uint8_t* pIn, bool allowThreeColors, uint8_t block[64])
+        {
+            uint16_t c0 = (uint16_t)(pIn[0] | (pIn[1] << 8));
+            uint16_t c1 = (uint16_t)(pIn[2] | (pIn[3] << 8));
+            uint32_t packed = pIn[4] | (pIn[5] << 8) | (pIn[6] << 16) | ((uint32_t)pIn[7] << 24);
+
+            int palette[4][4];
+            getBC1Palette(c0, c1, (c0 > c1) || !allowThreeColors, palette);
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                const int* pColor = palette[(packed >> (i * 2)) & 3];
+                for (uint32_t c = 0; c < 4; c++) block[i * 4 + c] = (uint8_t)pColor[c];
+            }
+        }
+
+        static void decodeBC1Block(const uint8_t* pIn, uint8_t block[64])
+        {
+            decodeBC1Color(pIn, true, block);
+        }
+
+        // BC4
+
+        static void getBC4Palette(uint8_t e0, uint8_t e1, int palette[8])
+        {
+            palette[0] = e0;
+            palette[1] = e1;
+            if (e0 > e1)
+            {
+                for (int i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * e0 + i * e1 + 3) / 7;
+            }
+            else
+            {
+                for (int i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * e0 + i * e1 + 2) / 5;
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+        }
+
+        static void encodeBC4Channel(const uint8_t block[64], uint32_t channel, uint8_t* pOut)
+        {
+            uint8_t minVal = 255;
+            uint8_t maxVal = 0;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                minVal = std::min(minVal, block[i * 4 + channel]);
+                maxVal = std::max(maxVal, block[i * 4 + channel]);
+            }
+
+            // Use the 8-value mode. When both endpoints are equal all the texels pick index 0
+            int palette[8];
+            getBC4Palette(maxVal, minVal, palette);
+
+            uint64_t packed = 0;
+            if (maxVal > minVal)
+            {
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    int v = block[i * 4 + channel];
+                    uint32_t bestIndex = 0;
+                    int bestError = INT32_MAX;
+                    for (uint32_t p = 0; p < 8; p++)
+                    {
+                        int error = std::abs(v - palette[p]);
+                        if (error < bestError)
+                        {
+                            bestError = error;
+                            bestIndex = p;
+                        }
+                    }
+                    packed |= (uint64_t)bestIndex << (i * 3);
+                }
+            }
+
+            pOut[0] = maxVal;
+            pOut[1] = minVal;
+            for (uint32_t i = 0; i < 6; i++) pOut[2 + i] = (uint8_t)(packed >> (i * 8));
+        }
+
+        static void decodeBC4Channel(const uint8_t* pIn, uint32_t channel, uint8_t block[64])
+        {
+            int palette[8];
+            getBC4Palette(pIn[0], pIn[1], palette);
+
+            uint64_t packed = 0;
+            for (uint32_t i = 0; i < 6; i++) packed |= (uint64_t)pIn[2 + i] << (i * 8);
+            for (uint32_t i = 0; i < 16; i++) block[i * 4 + channel] = (uint8_t)palette[(packed >> (i * 3)) & 7];
+        }
+
+        static void encodeBC4Block(const uint8_t block[64], uint8_t* pOut)
+        {
+            encodeBC4Channel(block, 0, pOut);
+        }
+
+        static void decodeBC4Block(const uint8_t* pIn, uint8_t block[64])
+        {
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                block[i * 4 + 1] = 0;
+                block[i * 4 + 2] = 0;
+                block[i * 4 + 3] = 255;
+            }
+            decodeBC4Channel(pIn, 0, block);
+        }
+
+        // BC3 and BC5
+
+        static void encodeBC3Block(const uint8_t block[64], uint8_t* pOut)
+        {
+            encodeBC4Channel(block, 3, pOut);
+            encodeBC1Block(block, pOut + 8);
+        }
+
+        static void decodeBC3Block(const uint8_t* pIn, uint8_t block[64])
+        {
+            decodeBC1Color(pIn + 8, false, block);
+            decodeBC4Channel(pIn, 3, block);
+        }
+
+        static void encodeBC5Block(const uint8_t block[64], uint8_t* pOut)
+        {
+            encodeBC4Channel(block, 0, pOut);
+            encodeBC4Channel(block, 1, pOut + 8);
+        }
+
+        static void decodeBC5Block(const uint8_t* pIn, uint8_t block[64])
+        {
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                block[i * 4 + 2] = 0;
+                block[i * 4 + 3] = 255;
+            }
+            decodeBC4Channel(pIn, 0, block);
+            decodeBC4Channel(pIn + 8, 1, block);
+        }
+
+        // BC7 mode 6. RGBA 7.7.7.7 endpoints with a unique P-bit per endpoint and 4-bit indices
+
+        class BitWriter
+        {
+        public:
+            BitWriter(uint8_t* pData) : mpData(pData) { std::fill(pData, pData + 16, (uint8_t)0); }
+            void write(uint32_t value, uint32_t bitCount)
+            {
+                for (uint32_t i = 0; i < bitCount; i++, mOffset++)
+                {
+                    mpData[mOffset / 8] |= (uint8_t)(((value >> i) & 1) << (mOffset % 8));
+                }
+            }
+        private:
+            uint8_t* mpData;
+            uint32_t mOffset = 0;
+        };
+
+        class BitReader
+        {
+        public:
+            BitReader(const uint8_t* pData) : mpData(pData) {}
+            uint32_t read(uint32_t bitCount)
+            {
+                uint32_t value = 0;
+                for (uint32_t i = 0; i < bitCount; i++, mOffset++)
+                {
+                    value |= ((mpData[mOffset / 8] >> (mOffset % 8)) & 1u) << i;
+                }
+                return value;
+            }
+        private:
+            const uint8_t* mpData;
+            uint32_t mOffset = 0;
+        };
+
+        /** Quantize an endpoint to 7 bits per channel, choosing the P-bit with the lowest error
+        */
+        static void quantizeBC7Endpoint(const float e[4], uint32_t q[4], uint32_t& pBit)
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 2; p++)
+            {
+                uint32_t candidate[4];
+                float error = 0;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    candidate[c] = (uint32_t)std::min(std::max(std::round((e[c] - p) / 2.0f), 0.0f), 127.0f);
+                    float d = (float)((candidate[c] << 1) | p) - e[c];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBit = p;
+                    std::copy(candidate, candidate + 4, q);
+                }
+            }
+        }
+
+        static void getBC7Palette(const uint32_t q0[4], uint32_t p0, const uint32_t q1[4], uint32_t p1, int palette[16][4])
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                uint32_t e0 = (q0[c] << 1) | p0;
+                uint32_t e1 = (q1[c] << 1) | p1;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    palette[i][c] = (int)(((64 - kBC7Weights4[i]) * e0 + kBC7Weights4[i] * e1 + 32) >> 6);
+                }
+            }
+        }
+
+        struct BC7Mode6Block
+        {
+            uint32_t q[2][4];
+            uint32_t p[2];
+            uint8_t indices[16];
+        };
+
+        static uint32_t quantizeBC7(const uint8_t block[64], const float e0[4], const float e1[4], BC7Mode6Block& result)
+        {
+            quantizeBC7Endpoint(e0, result.q[0], result.p[0]);
+            quantizeBC7Endpoint(e1, result.q[1], result.p[1]);
+            int palette[16][4];
+            getBC7Palette(result.q[0], result.p[0], result.q[1], result.p[1], palette);
+            return findIndices(block, 4, palette, 16, result.indices);
+        }
+
+        static void encodeBC7Block(const uint8_t block[64], uint8_t* pOut)
+        {
+            float e0[4], e1[4];
+            findEndpoints(block, 4, e0, e1);
+
+            BC7Mode6Block result;
+            uint32_t error = quantizeBC7(block, e0, e1, result);
+
+            // Refine the endpoints once using the selected indices
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) weights[i] = kBC7Weights4[result.indices[i]] / 64.0f;
+            if (error > 0 && refineEndpoints(block, 4, weights, e0, e1))
+            {
+                BC7Mode6Block refined;
+                if (quantizeBC7(block, e0, e1, refined) < error) result = refined;
+            }
+
+            // The MSB of the anchor index is implicitly 0. Swap the endpoints if needed
+            if (result.indices[0] & 8)
+            {
+                std::swap(result.q[0], result.q[1]);
+                std::swap(result.p[0], result.p[1]);
+                for (uint32_t i = 0; i < 16; i++) result.indices[i] = 15 - result.indices[i];
+            }
+
+            BitWriter writer(pOut);
+            writer.write(1 << 6, 7);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                writer.write(result.q[0][c], 7);
+                writer.write(result.q[1][c], 7);
+            }
+            writer.write(result.p[0], 1);
+            writer.write(result.p[1], 1);
+            writer.write(result.indices[0], 3);
+            for (uint32_t i = 1; i < 16; i++) writer.write(result.indices[i], 4);
+        }
+
+        static void decodeBC7Block(const uint8_t* pIn, uint8_t block[64])
+        {
+            if ((pIn[0] & 0x7F) != 0x40)
+            {
+                // Not mode 6. Output magenta, like the reference decoder does for invalid blocks
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    block[i * 4 + 0] = 255;
+                    block[i * 4 + 1] = 0;
+                    block[i * 4 + 2] = 255;
+                    block[i * 4 + 3] = 255;
+                }
+                return;
+            }
+
+            BitReader reader(pIn);
+            reader.read(7);
+            uint32_t q[2][4];
+            uint32_t p[2];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                q[0][c] = reader.read(7);
+                q[1][c] = reader.read(7);
+            }
+            p[0] = reader.read(1);
+            p[1] = reader.read(1);
+
+            int palette[16][4];
+            getBC7Palette(q[0], p[0], q[1], p[1], palette);
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                uint32_t index = reader.read(i == 0 ? 3 : 4);
+                for (uint32_t c = 0; c < 4; c++) block[i * 4 + c] = (uint8_t)palette[index][c];
+            }
+        }
+
+        static EncodeFunc getEncodeFunc(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::BC1Unorm:
+            case ResourceFormat::BC1UnormSrgb:
+                return encodeBC1Block;
+            case ResourceFormat::BC3Unorm:
+            case ResourceFormat::BC3UnormSrgb:
+                return encodeBC3Block;
+            case ResourceFormat::BC4Unorm:
+                return encodeBC4Block;
+            case ResourceFormat::BC5Unorm:
+                return encodeBC5Block;
+            case ResourceFormat::BC7Unorm:
+            case ResourceFormat::BC7UnormSrgb:
+                return encodeBC7Block;
+            default:
+                return nullptr;
+            }
+        }
+
+        static DecodeFunc getDecodeFunc(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::BC1Unorm:
+            case ResourceFormat::BC1UnormSrgb:
+                return decodeBC1Block;
+            case ResourceFormat::BC3Unorm:
+            case ResourceFormat::BC3UnormSrgb:
+                return decodeBC3Block;
+            case ResourceFormat::BC4Unorm:
+                return decodeBC4Block;
+            case ResourceFormat::BC5Unorm:
+                return decodeBC5Block;
+            case ResourceFormat::BC7Unorm:
+            case ResourceFormat::BC7UnormSrgb:
+                return decodeBC7Block;
+            default:
+                return nullptr;
+            }
+        }
+
+        /** Run a function over all the block rows of an image. Rows are distributed between threads for large images
+        */
+        template<typename RowFunc>
+        static void forEachBlockRow(uint32_t blocksX, uint32_t blocksY, RowFunc func)
+        {
+            uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+            threadCount = std::min(threadCount, std::max(1u, (blocksX * blocksY) / kMinBlocksPerThread));
+
+            std::atomic<uint32_t> nextRow{ 0 };
+            auto worker = [&]()
+            {
+                for (uint32_t row = nextRow++; row < blocksY; row = nextRow++) func(row);
+            };
+
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; i++) threads.emplace_back(worker);
+            worker();
+            for (auto& t : threads) t.join();
+        }
+
+        bool isFormatSupported(ResourceFormat format)
+        {
+            return getEncodeFunc(format) != nullptr;
+        }
+
+        size_t getCompressedSize(ResourceFormat format, uint32_t width, uint32_t height)
+        {
+            size_t blocksX = (width + 3) / 4;
+            size_t blocksY = (height + 3) / 4;
+            return blocksX * blocksY * getFormatBytesPerBlock(format);
+        }
+
+        bool compress(ResourceFormat format, const uint8_t* pRGBA, uint32_t width, uint32_t height, uint8_t* pOutput)
+        {
+            EncodeFunc encode = getEncodeFunc(format);
+            if (encode == nullptr) return false;
+
+            uint32_t blocksX = (width + 3) / 4;
+            uint32_t blocksY = (height + 3) / 4;
+            uint32_t blockSize = getFormatBytesPerBlock(format);
+
+            forEachBlockRow(blocksX, blocksY, [&](uint32_t row)
+            {
+                uint8_t block[64];
+                uint8_t* pDst = pOutput + (size_t)row * blocksX * blockSize;
+                for (uint32_t x = 0; x < blocksX; x++)
+                {
+                    fetchBlock(pRGBA, width, height, x, row, block);
+                    encode(block, pDst + x * blockSize);
+                }
+            });
+            return true;
+        }
+
+        bool decompress(ResourceFormat format, const uint8_t* pBlocks, uint32_t width, uint32_t height, uint8_t* pRGBA)
+        {
+            DecodeFunc decode = getDecodeFunc(format);
+            if (decode == nullptr) return false;
+
+            uint32_t blocksX = (width + 3) / 4;
+            uint32_t blocksY = (height + 3) / 4;
+            uint32_t blockSize = getFormatBytesPerBlock(format);
+
+            forEachBlockRow(blocksX, blocksY, [&](uint32_t row)
+            {
+                uint8_t block[64];
+                const uint8_t* pSrc = pBlocks + (size_t)row * blocksX * blockSize;
+                for (uint32_t x = 0; x < blocksX; x++)
+                {
+                    decode(pSrc + x * blockSize, block);
+                    storeBlock(block, width, height, x, row, pRGBA);
+                }
+            });
+            return true;
+        }
+
+        float calcPSNR(const uint8_t* pRGBA0, const uint8_t* pRGBA1, uint32_t width, uint32_t height, uint32_t channelCount)
+        {
+            double sum = 0;
+            size_t texelCount = (size_t)width * height;
+            for (size_t i = 0; i < texelCount; i++)
+            {
+                for (uint32_t c = 0; c < channelCount; c++)
+                {
+                    double d = (double)pRGBA0[i * 4 + c] - (double)pRGBA1[i * 4 + c];
+                    sum += d * d;
+                }
+            }
+
+            double mse = sum / (double)(texelCount * channelCount);
+            if (mse == 0) return std::numeric_limits<float>::infinity();
+            return (float)(10.0 * std::log10(255.0 * 255.0 / mse));
+        }
+    }
+}
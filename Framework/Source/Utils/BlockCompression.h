@@ -0,0 +1,73 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "API/Formats.h"
+
+namespace Falcor
+{
+    /** CPU block compression into the BC formats.
+        All functions take and return tightly packed RGBA8 images. Images which are not a multiple of the block size are padded by repeating the edge texels.
+        Supported formats are BC1 (opaque), BC3, BC4, BC5 and BC7. The BC7 encoder only uses mode 6 (a single subset with 4-bit indices).
+    */
+    namespace BlockCompression
+    {
+        /** Check if a format can be compressed by this module.
+        */
+        bool isFormatSupported(ResourceFormat format);
+
+        /** Get the size in bytes of a compressed image.
+        */
+        size_t getCompressedSize(ResourceFormat format, uint32_t width, uint32_t height);
+
+        /** Compress an image. Multiple threads are used for large images.
+            \param[in] format The output format
+            \param[in] pRGBA The source image
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[out] pOutput Destination buffer. Must hold getCompressedSize() bytes
+            \return Whether the format is supported
+        */
+        bool compress(ResourceFormat format, const uint8_t* pRGBA, uint32_t width, uint32_t height, uint8_t* pOutput);
+
+        /** Decompress an image produced by compress().
+            \param[in] format The compressed format
+            \param[in] pBlocks The compressed data
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[out] pRGBA Destination image. Must hold width * height * 4 bytes. Channels missing from the format are set to 0, alpha is set to 255
+            \return Whether the format is supported
+        */
+        bool decompress(ResourceFormat format, const uint8_t* pBlocks, uint32_t width, uint32_t height, uint8_t* pRGBA);
+
+        /** Calculate the peak signal-to-noise ratio between two RGBA8 images, in dB.
+            \param[in] channelCount The number of channels to compare, starting from red
+        */
+        float calcPSNR(const uint8_t* pRGBA0, const uint8_t* pRGBA1, uint32_t width, uint32_t height, uint32_t channelCount);
+    }
+}
@@ -0,0 +1,465 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageCompare.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
+#include "glm/gtc/packing.hpp"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <fstream>
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+namespace Falcor
+{
+    const float ImageCompare::kMaxPsnr = 100.0f;
+
+    static const float kMaxDeltaE = 100.0f;         // CIELAB difference mapped to a perceptual error of 1
+    static const float kHeatmapScale = 10.0f;       // The heatmap saturates at a perceptual error of 0.1
+    static const float kSsimC1 = 0.01f * 0.01f;
+    static const float kSsimC2 = 0.03f * 0.03f;
+
+    static bool isFormatSupported(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::RG8Unorm:
+        case ResourceFormat::R8Unorm:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGB16Float:
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::R32Float:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** Convert a row of a bitmap to RGBA floats. Alpha is set to 0, so it doesn't contribute to the metrics. Single-channel images are replicated to gray
+    */
+    static void loadRow(const Bitmap* pBitmap, uint32_t y, float* pDst)
+    {
+        ResourceFormat format = pBitmap->getFormat();
+        uint32_t width = pBitmap->getWidth();
+        uint32_t channels = getFormatChannelCount(format);
+        const uint8_t* pSrc = pBitmap->getData() + (size_t)y * width * getFormatBytesPerBlock(format);
+
+        for(uint32_t x = 0; x < width; x++)
+        {
+            float c[4] = { 0, 0, 0, 0 };
+            switch(format)
+            {
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRX8Unorm:
+                c[0] = pSrc[x * 4 + 2] / 255.0f;
+                c[1] = pSrc[x * 4 + 1] / 255.0f;
+                c[2] = pSrc[x * 4 + 0] / 255.0f;
+                break;
+            case ResourceFormat::RG8Unorm:
+            case ResourceFormat::R8Unorm:
+                for(uint32_t i = 0; i < channels; i++) c[i] = pSrc[x * channels + i] / 255.0f;
+                break;
+            case ResourceFormat::RGBA16Float:
+            case ResourceFormat::RGB16Float:
+                for(uint32_t i = 0; i < 3; i++) c[i] = glm::unpackHalf1x16(((const uint16_t*)pSrc)[x * channels + i]);
+                break;
+            case ResourceFormat::RGBA32Float:
+            case ResourceFormat::RGB32Float:
+            case ResourceFormat::R32Float:
+                for(uint32_t i = 0; i < std::min(channels, 3u); i++) c[i] = ((const float*)pSrc)[x * channels + i];
+                break;
+            default:
+                should_not_get_here();
+            }
+
+            if(channels == 1) c[1] = c[2] = c[0];
+            pDst[x * 4 + 0] = c[0];
+            pDst[x * 4 + 1] = c[1];
+            pDst[x * 4 + 2] = c[2];
+            pDst[x * 4 + 3] = 0;
+        }
+    }
+
+    struct SrgbToLinearTable
+    {
+        float values[256];
+        SrgbToLinearTable()
+        {
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                float v = i / 255.0f;
+                values[i] = (v <= 0.04045f) ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+            }
+        }
+    };
+
+    static float labF(float t)
+    {
+        return (t > 0.008856f) ? cbrtf(t) : 7.787f * t + 16.0f / 116.0f;
+    }
+
+    /** Convert RGB to CIELAB, assuming sRGB primaries and a D65 white point
+    */
+    static void rgbToLab(const float* pRgb, bool isSrgb, float* pLab)
+    {
+        static const SrgbToLinearTable kSrgbTable;
+        float rgb[3];
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            float v = glm::clamp(pRgb[i], 0.0f, 1.0f);
+            rgb[i] = isSrgb ? kSrgbTable.values[(uint32_t)(v * 255.0f + 0.5f)] : v;
+        }
+
+        float fx = labF((0.4124f * rgb[0] + 0.3576f * rgb[1] + 0.1805f * rgb[2]) / 0.95047f);
+        float fy = labF(0.2126f * rgb[0] + 0.7152f * rgb[1] + 0.0722f * rgb[2]);
+        float fz = labF((0.0193f * rgb[0] + 0.1192f * rgb[1] + 0.9505f * rgb[2]) / 1.08883f);
+        pLab[0] = 116.0f * fy - 16.0f;
+        pLab[1] = 500.0f * (fx - fy);
+        pLab[2] = 200.0f * (fy - fz);
+    }
+
+    bool ImageCompare::compare(const Bitmap* pReference, const Bitmap* pImage, float pixelThreshold, Metrics& metrics, std::vector<float>* pErrorMap)
+    {
+        metrics = Metrics();
+        if(pReference->getWidth() != pImage->getWidth() || pReference->getHeight() != pImage->getHeight())
+        {
+            logWarning("ImageCompare::compare() - the images have different sizes");
+            return false;
+        }
+        if(isFormatSupported(pReference->getFormat()) == false || isFormatSupported(pImage->getFormat()) == false)
+        {
+            logWarning("ImageCompare::compare() - unsupported image format");
+            return false;
+        }
+
+        const uint32_t width = pReference->getWidth();
+        const uint32_t height = pReference->getHeight();
+        const bool refSrgb = getFormatType(pReference->getFormat()) != FormatType::Float;
+        const bool imageSrgb = getFormatType(pImage->getFormat()) != FormatType::Float;
+        metrics.width = width;
+        metrics.height = height;
+        if(pErrorMap) pErrorMap->resize((size_t)width * height);
+
+        std::vector<float> refRow(width * 4);
+        std::vector<float> imageRow(width * 4);
+
+        // SSIM is evaluated on non-overlapping windows. The sums of each window in the current band of rows are accumulated as the rows are processed
+        const uint32_t windowWidth = std::min(8u, width);
+        const uint32_t windowHeight = std::min(8u, height);
+        const uint32_t windowsX = width / windowWidth;
+        const uint32_t bands = height / windowHeight;
+        struct WindowSums { double ref, image, refSq, imageSq, cross; };
+        std::vector<WindowSums> windows(windowsX);
+        double ssimSum = 0;
+
+        // The perceptual error filters the CIELAB differences over 3x3 pixels, so the differences of the last 3 rows are kept
+        std::vector<float> labDiff[3];
+        for(auto& row : labDiff) row.resize(width * 3);
+        double perceptualSum = 0;
+        auto filterRow = [&](uint32_t y)
+        {
+            const float* rows[3] = { labDiff[(std::max(y, 1u) - 1) % 3].data(), labDiff[y % 3].data(), labDiff[std::min(y + 1, height - 1) % 3].data() };
+            for(uint32_t x = 0; x < width; x++)
+            {
+                float d[3] = { 0, 0, 0 };
+                for(uint32_t r = 0; r < 3; r++)
+                {
+                    for(uint32_t sx : { std::max(x, 1u) - 1, x, std::min(x + 1, width - 1) })
+                    {
+                        for(uint32_t c = 0; c < 3; c++) d[c] += rows[r][sx * 3 + c];
+                    }
+                }
+                float error = std::min(1.0f, sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) / 9.0f / kMaxDeltaE);
+                perceptualSum += error;
+                metrics.maxPerceptualError = std::max(metrics.maxPerceptualError, error);
+                if(pErrorMap) (*pErrorMap)[(size_t)y * width + x] = error;
+            }
+        };
+
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 threshold = _mm_set1_ps(pixelThreshold);
+        double absSum = 0;
+        double sqSum = 0;
+        __m128 maxAbs = _mm_setzero_ps();
+
+        for(uint32_t y = 0; y < height; y++)
+        {
+            loadRow(pReference, y, refRow.data());
+            loadRow(pImage, y, imageRow.data());
+
+            __m128 rowAbs = _mm_setzero_ps();
+            __m128 rowSq = _mm_setzero_ps();
+            for(uint32_t x = 0; x < width; x++)
+            {
+                __m128 a = _mm_loadu_ps(&refRow[x * 4]);
+                __m128 b = _mm_loadu_ps(&imageRow[x * 4]);
+                __m128 d = _mm_sub_ps(a, b);
+                __m128 ad = _mm_and_ps(d, absMask);
+                rowAbs = _mm_add_ps(rowAbs, ad);
+                rowSq = _mm_add_ps(rowSq, _mm_mul_ps(d, d));
+                maxAbs = _mm_max_ps(maxAbs, ad);
+                if(_mm_movemask_ps(_mm_cmpgt_ps(ad, threshold))) metrics.differentPixels++;
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, rowAbs);
+            absSum += (double)lanes[0] + lanes[1] + lanes[2];
+            _mm_storeu_ps(lanes, rowSq);
+            sqSum += (double)lanes[0] + lanes[1] + lanes[2];
+
+            // SSIM
+            uint32_t band = y / windowHeight;
+            if(band < bands)
+            {
+                for(uint32_t x = 0; x < windowsX * windowWidth; x++)
+                {
+                    float a = 0.2126f * refRow[x * 4] + 0.7152f * refRow[x * 4 + 1] + 0.0722f * refRow[x * 4 + 2];
+                    float b = 0.2126f * imageRow[x * 4] + 0.7152f * imageRow[x * 4 + 1] + 0.0722f * imageRow[x * 4 + 2];
+                    WindowSums& w = windows[x / windowWidth];
+                    w.ref += a;
+                    w.image += b;
+                    w.refSq += a * a;
+                    w.imageSq += b * b;
+                    w.cross += a * b;
+                }
+
+                if((y % windowHeight) == windowHeight - 1)
+                {
+                    const double n = windowWidth * windowHeight;
+                    for(auto& w : windows)
+                    {
+                        double muA = w.ref / n;
+                        double muB = w.image / n;
+                        double varA = std::max(0.0, w.refSq / n - muA * muA);
+                        double varB = std::max(0.0, w.imageSq / n - muB * muB);
+                        double cov = w.cross / n - muA * muB;
+                        ssimSum += ((2 * muA * muB + kSsimC1) * (2 * cov + kSsimC2)) / ((muA * muA + muB * muB + kSsimC1) * (varA + varB + kSsimC2));
+                        w = {};
+                    }
+                }
+            }
+
+            // Perceptual error
+            float* pLabDiff = labDiff[y % 3].data();
+            for(uint32_t x = 0; x < width; x++)
+            {
+                float labA[3], labB[3];
+                rgbToLab(&refRow[x * 4], refSrgb, labA);
+                rgbToLab(&imageRow[x * 4], imageSrgb, labB);
+                for(uint32_t c = 0; c < 3; c++) pLabDiff[x * 3 + c] = labA[c] - labB[c];
+            }
+            if(y > 0) filterRow(y - 1);
+        }
+        filterRow(height - 1);
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, maxAbs);
+        const double sampleCount = (double)width * height * 3;
+        metrics.maxAbsDiff = std::max(lanes[0], std::max(lanes[1], lanes[2]));
+        metrics.meanAbsDiff = (float)(absSum / sampleCount);
+        double mse = sqSum / sampleCount;
+        metrics.rmse = (float)sqrt(mse);
+        metrics.psnr = (mse > 0) ? std::min(kMaxPsnr, (float)(10.0 * log10(1.0 / mse))) : kMaxPsnr;
+        metrics.ssim = (float)(ssimSum / ((double)windowsX * bands));
+        metrics.perceptualError = (float)(perceptualSum / ((double)width * height));
+        return true;
+    }
+
+    bool ImageCompare::passes(const Metrics& metrics, const Tolerance& tolerance)
+    {
+        return metrics.rmse <= tolerance.maxRmse && metrics.ssim >= tolerance.minSsim && metrics.perceptualError <= tolerance.maxPerceptualError;
+    }
+
+    void ImageCompare::saveHeatmap(const std::string& filename, const std::vector<float>& errorMap, uint32_t width, uint32_t height)
+    {
+        // Black for no error, through purple, red and orange to light yellow for large errors
+        static const glm::vec3 kRamp[] = { glm::vec3(0, 0, 0), glm::vec3(0.34f, 0.06f, 0.43f), glm::vec3(0.73f, 0.21f, 0.33f), glm::vec3(0.98f, 0.55f, 0.04f), glm::vec3(0.99f, 1.0f, 0.64f) };
+        const uint32_t stops = arraysize(kRamp);
+
+        std::vector<uint8_t> pixels((size_t)width * height * 4);
+        for(size_t i = 0; i < errorMap.size(); i++)
+        {
+            float t = std::min(1.0f, errorMap[i] * kHeatmapScale) * (stops - 1);
+            uint32_t stop = std::min((uint32_t)t, stops - 2);
+            glm::vec3 color = glm::mix(kRamp[stop], kRamp[stop + 1], t - stop);
+            pixels[i * 4 + 0] = (uint8_t)(color.r * 255.0f + 0.5f);
+            pixels[i * 4 + 1] = (uint8_t)(color.g * 255.0f + 0.5f);
+            pixels[i * 4 + 2] = (uint8_t)(color.b * 255.0f + 0.5f);
+            pixels[i * 4 + 3] = 0xff;
+        }
+        Bitmap::saveImage(filename, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, true, pixels.data());
+    }
+
+    static void compareFilePair(ImageCompare::Result& result, const ImageCompare::Tolerance& tolerance)
+    {
+        // Check the files first, Bitmap shows a message box for missing files
+        const ImageCompare::FilePair& files = result.files;
+        if(doesFileExist(files.reference) == false || doesFileExist(files.image) == false)
+        {
+            logWarning("ImageCompare - can't find " + (doesFileExist(files.reference) ? files.image : files.reference));
+            return;
+        }
+
+        Bitmap::UniqueConstPtr pReference = Bitmap::createFromFile(files.reference, true);
+        Bitmap::UniqueConstPtr pImage = Bitmap::createFromFile(files.image, true);
+        if(pReference == nullptr || pImage == nullptr) return;
+
+        std::vector<float> errorMap;
+        result.valid = ImageCompare::compare(pReference.get(), pImage.get(), tolerance.pixelThreshold, result.metrics, files.heatmap.empty() ? nullptr : &errorMap);
+        if(result.valid)
+        {
+            result.passed = ImageCompare::passes(result.metrics, tolerance);
+            if(files.heatmap.size()) ImageCompare::saveHeatmap(files.heatmap, errorMap, result.metrics.width, result.metrics.height);
+        }
+    }
+
+    std::vector<ImageCompare::Result> ImageCompare::compareFiles(const std::vector<FilePair>& files, const Tolerance& tolerance, uint32_t threadCount)
+    {
+        std::vector<Result> results(files.size());
+        for(size_t i = 0; i < files.size(); i++) results[i].files = files[i];
+
+        if(threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min(threadCount, (uint32_t)files.size());
+
+        std::atomic<size_t> nextFile{ 0 };
+        auto worker = [&]()
+        {
+            for(size_t i = nextFile++; i < results.size(); i = nextFile++) compareFilePair(results[i], tolerance);
+        };
+
+        std::vector<std::thread> threads;
+        for(uint32_t i = 1; i < threadCount; i++) threads.emplace_back(worker);
+        worker();
+        for(auto& t : threads) t.join();
+        return results;
+    }
+
+    std::vector<ImageCompare::Result> ImageCompare::compareDirectories(const std::string& referenceDir, const std::string& imageDir, const std::string& heatmapDir, const Tolerance& tolerance)
+    {
+        static const std::string kHeatmapSuffix = "_diff.png";
+        static const std::string kExtensions[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".pfm", ".exr", ".hdr" };
+
+        std::vector<FilePair> files;
+        std::error_code err;
+        for(const auto& entry : fs::directory_iterator(imageDir, err))
+        {
+            if(fs::is_regular_file(entry.path()) == false) continue;
+            std::string name = entry.path().filename().string();
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if(std::find(std::begin(kExtensions), std::end(kExtensions), extension) == std::end(kExtensions)) continue;
+            if(hasSuffix(name, kHeatmapSuffix)) continue;
+
+            FilePair pair;
+            pair.reference = (fs::path(referenceDir) / name).string();
+            pair.image = entry.path().string();
+            if(heatmapDir.size()) pair.heatmap = (fs::path(heatmapDir) / (entry.path().stem().string() + kHeatmapSuffix)).string();
+            files.push_back(pair);
+        }
+
+        if(err)
+        {
+            logError("ImageCompare::compareDirectories() - can't read directory " + imageDir);
+        }
+        return compareFiles(files, tolerance);
+    }
+
+    void ImageCompare::writeJson(const std::vector<Result>& results, rapidjson::Value& jsonArray, rapidjson::Document::AllocatorType& allocator)
+    {
+        jsonArray.SetArray();
+        for(const auto& result : results)
+        {
+            rapidjson::Value jsonResult(rapidjson::kObjectType);
+            jsonResult.AddMember("Reference", rapidjson::Value(result.files.reference.c_str(), allocator), allocator);
+            jsonResult.AddMember("Image", rapidjson::Value(result.files.image.c_str(), allocator), allocator);
+            jsonResult.AddMember("Heatmap", rapidjson::Value(result.files.heatmap.c_str(), allocator), allocator);
+            jsonResult.AddMember("Valid", result.valid, allocator);
+            jsonResult.AddMember("Passed", result.passed, allocator);
+            if(result.valid)
+            {
+                const Metrics& m = result.metrics;
+                jsonResult.AddMember("Width", m.width, allocator);
+                jsonResult.AddMember("Height", m.height, allocator);
+                jsonResult.AddMember("Max Abs Diff", m.maxAbsDiff, allocator);
+                jsonResult.AddMember("Mean Abs Diff", m.meanAbsDiff, allocator);
+                jsonResult.AddMember("RMSE", m.rmse, allocator);
+                jsonResult.AddMember("PSNR", m.psnr, allocator);
+                jsonResult.AddMember("SSIM", m.ssim, allocator);
+                jsonResult.AddMember("Perceptual Error", m.perceptualError, allocator);
+                jsonResult.AddMember("Max Perceptual Error", m.maxPerceptualError, allocator);
+                jsonResult.AddMember("Different Pixels", m.differentPixels, allocator);
+            }
+            jsonArray.PushBack(jsonResult, allocator);
+        }
+    }
+
+    bool ImageCompare::writeReport(const std::string& filename, const std::vector<Result>& results, const Tolerance& tolerance)
+    {
+        rapidjson::Document jsonReport;
+        jsonReport.SetObject();
+        auto& allocator = jsonReport.GetAllocator();
+
+        rapidjson::Value jsonTolerance(rapidjson::kObjectType);
+        jsonTolerance.AddMember("Pixel Threshold", tolerance.pixelThreshold, allocator);
+        jsonTolerance.AddMember("Max RMSE", tolerance.maxRmse, allocator);
+        jsonTolerance.AddMember("Min SSIM", tolerance.minSsim, allocator);
+        jsonTolerance.AddMember("Max Perceptual Error", tolerance.maxPerceptualError, allocator);
+        jsonReport.AddMember("Tolerance", jsonTolerance, allocator);
+
+        uint32_t passed = (uint32_t)std::count_if(results.begin(), results.end(), [](const Result& r) { return r.passed; });
+        jsonReport.AddMember("Passed", passed, allocator);
+        jsonReport.AddMember("Failed", (uint32_t)results.size() - passed, allocator);
+
+        rapidjson::Value jsonResults;
+        writeJson(results, jsonResults, allocator);
+        jsonReport.AddMember("Images", jsonResults, allocator);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.SetIndent(' ', 4);
+        jsonReport.Accept(writer);
+
+        std::ofstream outputStream(filename.c_str());
+        if(outputStream.fail())
+        {
+            logError("ImageCompare::writeReport() - can't write to " + filename);
+            return false;
+        }
+        outputStream << std::string(buffer.GetString(), buffer.GetSize());
+        return true;
+    }
+}
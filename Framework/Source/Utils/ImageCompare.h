@@ -0,0 +1,123 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Utils/Bitmap.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+
+namespace Falcor
+{
+    /** CPU image comparison for regression testing.
+        Images are compared on their RGB channels. 8-bit images are treated as sRGB-encoded, floating-point images as linear.
+        The perceptual error is a simplified FLIP-like metric: the CIELAB difference of the two images after a 3x3 box filter, normalized to [0, 1].
+    */
+    class ImageCompare
+    {
+    public:
+        struct Metrics
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            float maxAbsDiff = 0;           ///< Largest absolute difference of any channel
+            float meanAbsDiff = 0;          ///< Mean absolute difference over all channels
+            float rmse = 0;                 ///< Root mean square error over all channels
+            float psnr = 0;                 ///< Peak signal-to-noise ratio in dB, for a peak value of 1. Capped at kMaxPsnr for identical images
+            float ssim = 1;                 ///< Mean structural similarity of the luminance over 8x8 windows
+            float perceptualError = 0;      ///< Mean perceptual error
+            float maxPerceptualError = 0;   ///< Largest perceptual error of any pixel
+            uint64_t differentPixels = 0;   ///< Number of pixels with a channel differing by more than Tolerance::pixelThreshold
+        };
+
+        struct Tolerance
+        {
+            float pixelThreshold = 1.0f / 255.0f;   ///< Channel difference above which a pixel counts as different
+            float maxRmse = 0.01f;
+            float minSsim = 0.98f;
+            float maxPerceptualError = 0.02f;       ///< Limit for the mean perceptual error
+        };
+
+        struct FilePair
+        {
+            std::string reference;
+            std::string image;
+            std::string heatmap;            ///< File the perceptual error heatmap is written to. Empty to skip the heatmap
+        };
+
+        struct Result
+        {
+            FilePair files;
+            bool valid = false;             ///< false if the images couldn't be loaded or have different sizes
+            bool passed = false;
+            Metrics metrics;
+        };
+
+        static const float kMaxPsnr;
+
+        /** Compare two images
+            \param[in] pReference The reference image
+            \param[in] pImage The image to test
+            \param[in] pixelThreshold Channel difference above which a pixel counts as different
+            \param[out] metrics The comparison results
+            \param[out] pErrorMap Optional. Receives the perceptual error of each pixel, top row first
+            \return false if the images have different sizes or an unsupported format
+        */
+        static bool compare(const Bitmap* pReference, const Bitmap* pImage, float pixelThreshold, Metrics& metrics, std::vector<float>* pErrorMap = nullptr);
+
+        /** Check if metrics are within a tolerance
+        */
+        static bool passes(const Metrics& metrics, const Tolerance& tolerance);
+
+        /** Write a perceptual error map as a color-coded PNG
+        */
+        static void saveHeatmap(const std::string& filename, const std::vector<float>& errorMap, uint32_t width, uint32_t height);
+
+        /** Compare pairs of image files. The pairs are compared in parallel
+            \param[in] files The files to compare
+            \param[in] tolerance The tolerance used to decide if an image passes
+            \param[in] threadCount Number of worker threads. 0 uses all cores
+        */
+        static std::vector<Result> compareFiles(const std::vector<FilePair>& files, const Tolerance& tolerance, uint32_t threadCount = 0);
+
+        /** Compare all images in a directory with the images with the same name in a reference directory
+            \param[in] referenceDir The directory containing the reference images
+            \param[in] imageDir The directory containing the images to test
+            \param[in] heatmapDir Directory the heatmaps are written to, as <name>_diff.png. Empty to skip the heatmaps
+            \param[in] tolerance The tolerance used to decide if an image passes
+        */
+        static std::vector<Result> compareDirectories(const std::string& referenceDir, const std::string& imageDir, const std::string& heatmapDir, const Tolerance& tolerance);
+
+        /** Convert results to a JSON array
+        */
+        static void writeJson(const std::vector<Result>& results, rapidjson::Value& jsonArray, rapidjson::Document::AllocatorType& allocator);
+
+        /** Write a JSON report with the tolerance, a summary and the results of each image
+        */
+        static bool writeReport(const std::string& filename, const std::vector<Result>& results, const Tolerance& tolerance);
+    };
+}
@@ -0,0 +1,442 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MipGenerator.h"
+#include "glm/gtc/packing.hpp"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cstring>
+
+namespace Falcor
+{
+    static const float kKaiserRadius = 3.0f;    // In destination texels
+    static const float kKaiserAlpha = 4.0f;
+    static const uint32_t kMinTexelsPerThread = 16384;
+    static const uint32_t kCoverageSearchSteps = 12;
+
+    /** Separable filter weights for one axis. Destination texel i reads tapCount source texels, starting at i * tapCount in both arrays
+    */
+    struct FilterKernel
+    {
+        uint32_t tapCount = 0;
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    static float besselI0(float x)
+    {
+        // Power series of the modified Bessel function of the first kind
+        float sum = 1.0f;
+        float term = 1.0f;
+        float halfX = x * 0.5f;
+        for (uint32_t k = 1; k < 32; k++)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+            if (term < sum * 1e-8f) break;
+        }
+        return sum;
+    }
+
+    static float kaiser(float t)
+    {
+        // t is in destination texels
+        if (std::abs(t) >= kKaiserRadius) return 0;
+
+        float x = t * (float)M_PI;
+        float sinc = (x == 0) ? 1.0f : std::sin(x) / x;
+        float r = t / kKaiserRadius;
+        return sinc * besselI0(kKaiserAlpha * std::sqrt(1.0f - r * r)) / besselI0(kKaiserAlpha);
+    }
+
+    static FilterKernel createKernel(uint32_t srcSize, uint32_t dstSize, MipGenerator::Filter filter)
+    {
+        float scale = (float)srcSize / (float)dstSize;
+        float radius = (filter == MipGenerator::Filter::Box) ? scale * 0.5f : kKaiserRadius * scale;
+
+        // Collect the non-zero taps of each destination texel
+        std::vector<std::vector<std::pair<int32_t, float>>> taps(dstSize);
+        FilterKernel kernel;
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            float center = (i + 0.5f) * scale;
+            int32_t first = (int32_t)std::floor(center - radius);
+            int32_t last = (int32_t)std::ceil(center + radius);
+            float sum = 0;
+            for (int32_t j = first; j <= last; j++)
+            {
+                float w;
+                if (filter == MipGenerator::Filter::Box)
+                {
+                    // The overlap of the source texel with the footprint of the destination texel
+                    w = std::max(0.0f, std::min((float)j + 1, center + radius) - std::max((float)j, center - radius));
+                }
+                else
+                {
+                    w = kaiser(((float)j + 0.5f - center) / scale);
+                }
+
+                if (w != 0)
+                {
+                    taps[i].push_back({ std::min(std::max(j, 0), (int32_t)srcSize - 1), w });
+                    sum += w;
+                }
+            }
+
+            for (auto& tap : taps[i]) tap.second /= sum;
+            kernel.tapCount = std::max(kernel.tapCount, (uint32_t)taps[i].size());
+        }
+
+        // Pad to a fixed tap count
+        kernel.indices.resize(dstSize * kernel.tapCount, 0);
+        kernel.weights.resize(dstSize * kernel.tapCount, 0.0f);
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            for (size_t t = 0; t < taps[i].size(); t++)
+            {
+                kernel.indices[i * kernel.tapCount + t] = taps[i][t].first;
+                kernel.weights[i * kernel.tapCount + t] = taps[i][t].second;
+            }
+        }
+        return kernel;
+    }
+
+    /** Run a function over all rows. Rows are distributed between threads when there is enough work
+    */
+    template<typename RowFunc>
+    static void forEachRow(uint32_t rowCount, uint32_t rowWidth, RowFunc func)
+    {
+        uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min(threadCount, std::max(1u, (uint32_t)(((uint64_t)rowCount * rowWidth) / kMinTexelsPerThread)));
+
+        std::atomic<uint32_t> nextRow{ 0 };
+        auto worker = [&]()
+        {
+            for (uint32_t row = nextRow++; row < rowCount; row = nextRow++) func(row);
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++) threads.emplace_back(worker);
+        worker();
+        for (auto& t : threads) t.join();
+    }
+
+    /** Apply a kernel to a row of RGBA float texels
+    */
+    static void filterRow(const float* pSrc, const FilterKernel& kernel, uint32_t dstSize, float* pDst)
+    {
+        const uint32_t* pIndices = kernel.indices.data();
+        const float* pWeights = kernel.weights.data();
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            __m128 acc = _mm_setzero_ps();
+            for (uint32_t t = 0; t < kernel.tapCount; t++)
+            {
+                __m128 texel = _mm_loadu_ps(pSrc + (size_t)pIndices[t] * 4);
+                acc = _mm_add_ps(acc, _mm_mul_ps(texel, _mm_set1_ps(pWeights[t])));
+            }
+            _mm_storeu_ps(pDst + i * 4, acc);
+            pIndices += kernel.tapCount;
+            pWeights += kernel.tapCount;
+        }
+    }
+
+    /** Conversion between 8-bit sRGB and linear values
+    */
+    class SrgbTable
+    {
+    public:
+        static const SrgbTable& get()
+        {
+            static const SrgbTable sTable;
+            return sTable;
+        }
+
+        float toLinear(uint8_t v) const { return mToLinear[v]; }
+
+        uint8_t fromLinear(float v) const
+        {
+            // Find the sRGB value whose rounding interval contains v
+            return (uint8_t)(std::upper_bound(mThresholds, mThresholds + 255, v) - mThresholds);
+        }
+
+    private:
+        static float srgbToLinear(float c)
+        {
+            return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        SrgbTable()
+        {
+            for (uint32_t i = 0; i < 256; i++) mToLinear[i] = srgbToLinear(i / 255.0f);
+            for (uint32_t i = 0; i < 255; i++) mThresholds[i] = srgbToLinear((i + 0.5f) / 255.0f);
+        }
+
+        float mToLinear[256];
+        float mThresholds[255];
+    };
+
+    enum class TexelType
+    {
+        Unorm8,
+        Half,
+        Float,
+    };
+
+    static TexelType getTexelType(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::RGBA16Float:
+            return TexelType::Half;
+        case ResourceFormat::RGBA32Float:
+            return TexelType::Float;
+        default:
+            return TexelType::Unorm8;
+        }
+    }
+
+    static void loadRow(const uint8_t* pSrc, TexelType type, bool linearize, uint32_t width, float* pDst)
+    {
+        const SrgbTable& srgb = SrgbTable::get();
+        for (uint32_t x = 0; x < width; x++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                size_t i = x * 4 + c;
+                switch (type)
+                {
+                case TexelType::Unorm8:
+                    pDst[i] = (linearize && c < 3) ? srgb.toLinear(pSrc[i]) : pSrc[i] / 255.0f;
+                    break;
+                case TexelType::Half:
+                    pDst[i] = glm::unpackHalf1x16(((const uint16_t*)pSrc)[i]);
+                    break;
+                case TexelType::Float:
+                    pDst[i] = ((const float*)pSrc)[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    static void storeRow(const float* pSrc, TexelType type, bool linearize, uint32_t width, uint8_t* pDst)
+    {
+        const SrgbTable& srgb = SrgbTable::get();
+        for (uint32_t x = 0; x < width; x++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                size_t i = x * 4 + c;
+                switch (type)
+                {
+                case TexelType::Unorm8:
+                    pDst[i] = (linearize && c < 3) ? srgb.fromLinear(pSrc[i]) : (uint8_t)(std::min(std::max(pSrc[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+                    break;
+                case TexelType::Half:
+                    ((uint16_t*)pDst)[i] = glm::packHalf1x16(pSrc[i]);
+                    break;
+                case TexelType::Float:
+                    ((float*)pDst)[i] = pSrc[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    static float calcAlphaCoverage(const std::vector<float>& texels, float alphaReference, float scale)
+    {
+        size_t covered = 0;
+        for (size_t i = 3; i < texels.size(); i += 4)
+        {
+            if (texels[i] * scale > alphaReference) covered++;
+        }
+        return (float)covered / (float)(texels.size() / 4);
+    }
+
+    /** Find the alpha scale which makes the coverage of a level closest to the target, and apply it
+    */
+    static void scaleAlphaToCoverage(std::vector<float>& texels, float alphaReference, float targetCoverage)
+    {
+        float minScale = 0;
+        float maxScale = 4;
+        float bestScale = 1;
+        float bestError = std::abs(calcAlphaCoverage(texels, alphaReference, 1) - targetCoverage);
+        for (uint32_t i = 0; i < kCoverageSearchSteps; i++)
+        {
+            float scale = (minScale + maxScale) * 0.5f;
+            float coverage = calcAlphaCoverage(texels, alphaReference, scale);
+            float error = std::abs(coverage - targetCoverage);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestScale = scale;
+            }
+
+            if (coverage < targetCoverage) minScale = scale;
+            else maxScale = scale;
+        }
+
+        for (size_t i = 3; i < texels.size(); i += 4)
+        {
+            texels[i] = std::min(texels[i] * bestScale, 1.0f);
+        }
+    }
+
+    bool MipGenerator::isFormatSupported(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGBA32Float:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint32_t MipGenerator::getMaxMipCount(uint32_t width, uint32_t height)
+    {
+        return bitScanReverse(width | height) + 1;
+    }
+
+    bool MipGenerator::generate(ResourceFormat format, const void* pData, uint32_t width, uint32_t height, const Options& options, MipChain& mipChain)
+    {
+        if (isFormatSupported(format) == false)
+        {
+            logError("MipGenerator::generate() - format " + to_string(format) + " is not supported");
+            return false;
+        }
+
+        TexelType type = getTexelType(format);
+        bool linearize = (type == TexelType::Unorm8) && (options.isSrgb || isSrgbFormat(format));
+        bool hasAlpha = (format != ResourceFormat::BGRX8Unorm) && (format != ResourceFormat::BGRX8UnormSrgb);
+        bool preserveCoverage = options.preserveAlphaCoverage && hasAlpha;
+        uint32_t bytesPerTexel = getFormatBytesPerBlock(format);
+
+        uint32_t mipCount = getMaxMipCount(width, height);
+        if (options.maxLevels) mipCount = std::min(mipCount, options.maxLevels);
+
+        // Lay out the chain
+        mipChain.format = format;
+        mipChain.levels.resize(mipCount);
+        size_t size = 0;
+        for (uint32_t i = 0; i < mipCount; i++)
+        {
+            Level& level = mipChain.levels[i];
+            level.width = std::max(width >> i, 1u);
+            level.height = std::max(height >> i, 1u);
+            level.offset = size;
+            level.size = (size_t)level.width * level.height * bytesPerTexel;
+            size += level.size;
+        }
+        mipChain.data.resize(size);
+        std::memcpy(mipChain.data.data(), pData, mipChain.levels[0].size);
+
+        if (mipCount == 1)
+        {
+            return true;
+        }
+
+        // Filtering is done on linear RGBA float texels
+        std::vector<float> src((size_t)width * height * 4);
+        forEachRow(height, width, [&](uint32_t y)
+        {
+            loadRow(mipChain.data.data() + (size_t)y * width * bytesPerTexel, type, linearize, width, src.data() + (size_t)y * width * 4);
+        });
+
+        float targetCoverage = preserveCoverage ? calcAlphaCoverage(src, options.alphaReference, 1) : 0;
+
+        std::vector<float> temp;
+        std::vector<float> dst;
+        for (uint32_t i = 1; i < mipCount; i++)
+        {
+            const Level& srcLevel = mipChain.levels[i - 1];
+            const Level& dstLevel = mipChain.levels[i];
+            FilterKernel kernelX = createKernel(srcLevel.width, dstLevel.width, options.filter);
+            FilterKernel kernelY = createKernel(srcLevel.height, dstLevel.height, options.filter);
+
+            // Horizontal pass, then vertical pass
+            temp.resize((size_t)dstLevel.width * srcLevel.height * 4);
+            forEachRow(srcLevel.height, dstLevel.width * kernelX.tapCount, [&](uint32_t y)
+            {
+                filterRow(src.data() + (size_t)y * srcLevel.width * 4, kernelX, dstLevel.width, temp.data() + (size_t)y * dstLevel.width * 4);
+            });
+
+            dst.resize((size_t)dstLevel.width * dstLevel.height * 4);
+            forEachRow(dstLevel.height, dstLevel.width * kernelY.tapCount, [&](uint32_t y)
+            {
+                float* pDstRow = dst.data() + (size_t)y * dstLevel.width * 4;
+                const FilterKernel& k = kernelY;
+                for (uint32_t x = 0; x < dstLevel.width; x++)
+                {
+                    __m128 acc = _mm_setzero_ps();
+                    for (uint32_t t = 0; t < k.tapCount; t++)
+                    {
+                        const float* pTexel = temp.data() + ((size_t)k.indices[y * k.tapCount + t] * dstLevel.width + x) * 4;
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(pTexel), _mm_set1_ps(k.weights[y * k.tapCount + t])));
+                    }
+
+                    // The negative lobes of the Kaiser filter can overshoot
+                    acc = _mm_max_ps(acc, _mm_setzero_ps());
+                    _mm_storeu_ps(pDstRow + x * 4, acc);
+                    pDstRow[x * 4 + 3] = std::min(pDstRow[x * 4 + 3], 1.0f);
+                }
+            });
+
+            if (preserveCoverage)
+            {
+                scaleAlphaToCoverage(dst, options.alphaReference, targetCoverage);
+            }
+
+            uint8_t* pLevelData = mipChain.data.data() + dstLevel.offset;
+            forEachRow(dstLevel.height, dstLevel.width, [&](uint32_t y)
+            {
+                storeRow(dst.data() + (size_t)y * dstLevel.width * 4, type, linearize, dstLevel.width, pLevelData + (size_t)y * dstLevel.width * bytesPerTexel);
+            });
+
+            src.swap(dst);
+        }
+
+        return true;
+    }
+
+    bool MipGenerator::generate(const Bitmap* pBitmap, const Options& options, MipChain& mipChain)
+    {
+        return generate(pBitmap->getFormat(), pBitmap->getData(), pBitmap->getWidth(), pBitmap->getHeight(), options, mipChain);
+    }
+}
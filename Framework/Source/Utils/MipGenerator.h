@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "API/Formats.h"
+#include "Utils/Bitmap.h"
+
+namespace Falcor
+{
+    /** CPU mip-chain generation.
+        Supports 4-channel 8-bit formats, RGBA16Float and RGBA32Float. Each level is filtered from the previous one with a separable filter, using multiple threads for the rows of large levels.
+        8-bit color channels of sRGB images are filtered in linear space. Alpha is always linear.
+    */
+    class MipGenerator
+    {
+    public:
+        enum class Filter
+        {
+            Box,    ///< Averages the source texels covered by the destination texel. Fast and ringing-free
+            Kaiser, ///< Kaiser-windowed sinc. Sharper, may ring around high contrast edges
+        };
+
+        struct Options
+        {
+            Filter filter = Filter::Box;
+            bool isSrgb = false;                    ///< Filter the color channels of 8-bit images in linear space. Implied by the sRGB formats
+            bool preserveAlphaCoverage = false;     ///< Scale the alpha of each level so that the fraction of texels passing the alpha test matches level 0. Use for alpha-tested textures
+            float alphaReference = 0.5f;            ///< The alpha-test threshold used to measure the coverage
+            uint32_t maxLevels = 0;                 ///< The maximum number of levels to generate, including level 0. 0 means the full chain
+        };
+
+        struct Level
+        {
+            uint32_t width;
+            uint32_t height;
+            size_t offset;      ///< Offset of the level in MipChain::data
+            size_t size;
+        };
+
+        /** A mip-chain, with all the levels stored contiguously. The data can be passed directly to Texture::create2D()
+        */
+        struct MipChain
+        {
+            ResourceFormat format = ResourceFormat::Unknown;
+            std::vector<Level> levels;
+            std::vector<uint8_t> data;
+
+            const uint8_t* getLevelData(uint32_t level) const { return data.data() + levels[level].offset; }
+        };
+
+        /** Check if mips can be generated for a format
+        */
+        static bool isFormatSupported(ResourceFormat format);
+
+        /** Get the number of levels in a full mip-chain
+        */
+        static uint32_t getMaxMipCount(uint32_t width, uint32_t height);
+
+        /** Generate a mip-chain.
+            \param[in] format The format of the image
+            \param[in] pData The image. Level 0 of the mip-chain
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] options Generation options
+            \param[out] mipChain The generated mip-chain, including a copy of level 0
+            \return false if the format is not supported, otherwise true
+        */
+        static bool generate(ResourceFormat format, const void* pData, uint32_t width, uint32_t height, const Options& options, MipChain& mipChain);
+
+        /** Generate a mip-chain for a bitmap
+        */
+        static bool generate(const Bitmap* pBitmap, const Options& options, MipChain& mipChain);
+
+    private:
+        MipGenerator() = delete;
+    };
+}
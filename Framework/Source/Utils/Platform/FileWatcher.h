@@ -0,0 +1,68 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace Falcor
+{
+    struct FileWatcherData;
+
+    /** Watches files for modifications using the OS change notifications (inotify on Linux, directory change notifications on Windows).
+        The parent directory of each file is watched rather than the file itself, so editors which save by replacing the file are detected.
+        Not thread-safe. All calls should be made from the same thread.
+    */
+    class FileWatcher
+    {
+    public:
+        using SharedPtr = std::shared_ptr<FileWatcher>;
+
+        /** Create a file watcher
+            \return A new object, or nullptr if the OS notifications are not available
+        */
+        static SharedPtr create();
+
+        ~FileWatcher();
+
+        /** Start watching a file. Watching a file which is already watched does nothing
+            \param[in] path The file path. The same string is returned by pollChanges() when the file is modified
+        */
+        void watchFile(const std::string& path);
+
+        /** Get the files which were modified since the last call. Doesn't block
+        */
+        std::vector<std::string> pollChanges();
+
+    private:
+        FileWatcher() = default;
+        bool platformInit();
+
+        FileWatcherData* mpData = nullptr;
+    };
+}
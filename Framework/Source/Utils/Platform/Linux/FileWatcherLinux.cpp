@@ -0,0 +1,128 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Utils/Platform/FileWatcher.h"
+#include "Utils/Platform/OS.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <unordered_map>
+#include <algorithm>
+
+namespace Falcor
+{
+    struct FileWatcherData
+    {
+        struct Directory
+        {
+            std::string path;
+            std::unordered_map<std::string, std::string> files;     ///< File name -> the path passed to watchFile()
+        };
+
+        int fd = -1;
+        std::unordered_map<int, Directory> directories;             ///< Watch descriptor -> directory
+        std::unordered_map<std::string, int> directoryWatches;      ///< Directory path -> watch descriptor
+    };
+
+    bool FileWatcher::platformInit()
+    {
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            logWarning("FileWatcher - inotify_init1() failed: " + std::string(strerror(errno)));
+            return false;
+        }
+        mpData = new FileWatcherData;
+        mpData->fd = fd;
+        return true;
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        if (mpData)
+        {
+            close(mpData->fd);
+            safe_delete(mpData);
+        }
+    }
+
+    void FileWatcher::watchFile(const std::string& path)
+    {
+        std::string dir = getDirectoryFromFile(path);
+        if (dir.empty()) dir = ".";
+
+        auto it = mpData->directoryWatches.find(dir);
+        int wd;
+        if (it == mpData->directoryWatches.end())
+        {
+            // Editors usually save by writing a temporary file and renaming it over the original, so watch for both writes and moves
+            wd = inotify_add_watch(mpData->fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd < 0)
+            {
+                logWarning("FileWatcher - can't watch directory '" + dir + "': " + std::string(strerror(errno)));
+                return;
+            }
+            mpData->directoryWatches[dir] = wd;
+            mpData->directories[wd].path = dir;
+        }
+        else
+        {
+            wd = it->second;
+        }
+        mpData->directories[wd].files[getFilenameFromPath(path)] = path;
+    }
+
+    std::vector<std::string> FileWatcher::pollChanges()
+    {
+        std::vector<std::string> changes;
+        alignas(inotify_event) char buffer[4096];
+
+        while (true)
+        {
+            ssize_t size = read(mpData->fd, buffer, sizeof(buffer));
+            if (size <= 0) break;   // EAGAIN - no more events
+
+            for (char* p = buffer; p < buffer + size; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+            {
+                const inotify_event* pEvent = (const inotify_event*)p;
+                if (pEvent->len == 0) continue;
+
+                auto dir = mpData->directories.find(pEvent->wd);
+                if (dir == mpData->directories.end()) continue;
+
+                auto file = dir->second.files.find(pEvent->name);
+                if (file != dir->second.files.end())
+                {
+                    if (std::find(changes.begin(), changes.end(), file->second) == changes.end()) changes.push_back(file->second);
+                }
+            }
+        }
+        return changes;
+    }
+}
@@ -37,6 +37,8 @@
 #include <gtk/gtk.h>
 #include <fstream>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <libgen.h>
 #include <errno.h>
 #include <algorithm>
@@ -147,6 +149,30 @@ namespace Falcor
         return (stat(pathname, &sb) == 0) && S_ISDIR(sb.st_mode);
     }
 
+    const void* mapFileToMemory(const std::string& fullpath, size_t& size)
+    {
+        int fd = open(fullpath.c_str(), O_RDONLY);
+        if (fd == -1) return nullptr;
+
+        struct stat sb;
+        void* pData = nullptr;
+        if (fstat(fd, &sb) == 0 && sb.st_size > 0)
+        {
+            size = (size_t)sb.st_size;
+            pData = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData == MAP_FAILED) pData = nullptr;
+        }
+
+        // The mapping stays valid after the file is closed
+        close(fd);
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        munmap(const_cast<void*>(pData), size);
+    }
+
     const std::string& getExecutableDirectory()
     {
         char result[PATH_MAX];
@@ -154,6 +154,19 @@ namespace Falcor
     */
     bool readFileToString(const std::string& fullpath, std::string& str);
 
+    /** Map a file into memory for reading. The function expects a full path to the file, and will not look in the common directories.
+        \param[in] fullpath The path to the requested file
+        \param[out] size On successful return, the size of the file in bytes
+        \return A pointer to the mapped file, or nullptr if an error occurred. Release it with unmapFile()
+    */
+    const void* mapFileToMemory(const std::string& fullpath, size_t& size);
+
+    /** Unmap a file which was mapped with mapFileToMemory().
+        \param[in] pData The mapped address
+        \param[in] size The size of the file
+    */
+    void unmapFile(const void* pData, size_t size);
+
     /** Adds a folder into the search directory. Once added, calls to FindFileInCommonDirs() will seach that directory as well
         \param[in] dir The new directory to add to the common directories.
     */
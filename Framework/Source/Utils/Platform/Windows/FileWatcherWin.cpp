@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Utils/Platform/FileWatcher.h"
+#include "Utils/Platform/OS.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    struct FileWatcherData
+    {
+        struct Directory
+        {
+            HANDLE handle = INVALID_HANDLE_VALUE;
+            std::unordered_map<std::string, time_t> files;      ///< The path passed to watchFile() -> modification time
+        };
+
+        std::unordered_map<std::string, Directory> directories;
+    };
+
+    bool FileWatcher::platformInit()
+    {
+        mpData = new FileWatcherData;
+        return true;
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        if (mpData)
+        {
+            for (auto& d : mpData->directories) FindCloseChangeNotification(d.second.handle);
+            safe_delete(mpData);
+        }
+    }
+
+    void FileWatcher::watchFile(const std::string& path)
+    {
+        std::string dir = getDirectoryFromFile(path);
+        if (dir.empty()) dir = ".";
+
+        auto& d = mpData->directories[dir];
+        if (d.handle == INVALID_HANDLE_VALUE)
+        {
+            // Editors usually save by writing a temporary file and renaming it over the original, so watch for both writes and renames
+            d.handle = FindFirstChangeNotificationA(dir.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+            if (d.handle == INVALID_HANDLE_VALUE)
+            {
+                logWarning("FileWatcher - can't watch directory '" + dir + "'");
+                mpData->directories.erase(dir);
+                return;
+            }
+        }
+        if (d.files.find(path) == d.files.end()) d.files[path] = getFileModifiedTime(path);
+    }
+
+    std::vector<std::string> FileWatcher::pollChanges()
+    {
+        std::vector<std::string> changes;
+        for (auto& d : mpData->directories)
+        {
+            if (WaitForSingleObject(d.second.handle, 0) != WAIT_OBJECT_0) continue;
+            FindNextChangeNotification(d.second.handle);
+
+            // The notification only tells us that something in the directory changed. Find the watched files which were modified
+            for (auto& f : d.second.files)
+            {
+                time_t t = getFileModifiedTime(f.first);
+                if (t != f.second)
+                {
+                    f.second = t;
+                    changes.push_back(f.first);
+                }
+            }
+        }
+        return changes;
+    }
+}
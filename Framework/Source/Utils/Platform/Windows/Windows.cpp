@@ -105,6 +105,35 @@ namespace Falcor
         return res == TRUE;
     }
 
+    const void* mapFileToMemory(const std::string& fullpath, size_t& size)
+    {
+        HANDLE hFile = CreateFileA(fullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE) return nullptr;
+
+        const void* pData = nullptr;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0)
+        {
+            HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (hMapping)
+            {
+                pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+                size = (size_t)fileSize.QuadPart;
+
+                // The view keeps the mapping alive
+                CloseHandle(hMapping);
+            }
+        }
+
+        CloseHandle(hFile);
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        UnmapViewOfFile(pData);
+    }
+
     const std::string& getExecutableDirectory()
     {
         static std::string folder;
@@ -149,6 +149,8 @@ namespace Falcor
                 pData->stepNr = 0;
             }
 #endif
+            pData->cpuLastFrame = pData->cpuTotal;
+            pData->gpuLastFrame = (float)gpuTime;
             pData->cpuTotal = 0;
             pData->gpuTotal = 0;
             profileResults += event;
@@ -82,6 +82,8 @@ namespace Falcor
             CpuTimer::TimePoint cpuEnd;
             float cpuTotal = 0;
             float gpuTotal = 0;
+            float cpuLastFrame = 0;     ///< CPU time of the last frame passed to endFrame()
+            float gpuLastFrame = 0;     ///< GPU time of the frame before that, since GPU timers are double-buffered
             uint32_t level;
 #if _PROFILING_LOG == 1
             int stepNr = 0;
@@ -148,6 +150,10 @@ namespace Falcor
         */
         static void clearEvents();
 
+        /** Get all the events, in the order they were first used
+        */
+        static const std::vector<EventData*>& getEvents() { return sProfilerVector; }
+
     private:
         static std::map<size_t, EventData*> sProfilerEvents;
         static std::vector<EventData*> sProfilerVector;
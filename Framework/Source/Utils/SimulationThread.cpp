@@ -0,0 +1,95 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SimulationThread.h"
+
+namespace Falcor
+{
+    SimulationThread::UniquePtr SimulationThread::create(const SimulateFunc& simulateFunc)
+    {
+        return UniquePtr(new SimulationThread(simulateFunc));
+    }
+
+    SimulationThread::SimulationThread(const SimulateFunc& simulateFunc) : mSimulateFunc(simulateFunc)
+    {
+        mThread = std::thread(&SimulationThread::threadFunc, this);
+    }
+
+    SimulationThread::~SimulationThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    void SimulationThread::kick(float currentTime, uint64_t frameID)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mBusy == false; });
+        mCurrentTime = currentTime;
+        mFrameID = frameID;
+        mKickTimes[frameID % kSnapshotCount] = CpuTimer::getCurrentTimePoint();
+        mBusy = true;
+        lock.unlock();
+        mCondition.notify_all();
+    }
+
+    void SimulationThread::wait()
+    {
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mBusy == false; });
+        mStallTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    }
+
+    void SimulationThread::threadFunc()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true)
+        {
+            mCondition.wait(lock, [this] { return mBusy || mTerminate; });
+            if (mTerminate) break;
+
+            float currentTime = mCurrentTime;
+            uint64_t frameID = mFrameID;
+            lock.unlock();
+
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            mSimulateFunc(currentTime, frameID);
+            float simulationTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+            lock.lock();
+            mSimulationTime = simulationTime;
+            mBusy = false;
+            mCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    /** Runs the simulation stage of a two-stage frame pipeline on a dedicated thread.
+        The render thread calls kick() to start simulating the next frame, records the current frame, and calls wait() before touching any state the simulation writes.
+        Results are published through snapshots indexed by frame ID (frameID % kSnapshotCount), so the simulation of frame N+1 never writes the snapshot frame N renders from.
+    */
+    class SimulationThread
+    {
+    public:
+        using UniquePtr = std::unique_ptr<SimulationThread>;
+
+        /** Simulation callback
+            \param[in] currentTime The time to simulate to
+            \param[in] frameID The frame the result will be rendered in
+        */
+        using SimulateFunc = std::function<void(float currentTime, uint64_t frameID)>;
+
+        static const uint32_t kSnapshotCount = 2;
+
+        static UniquePtr create(const SimulateFunc& simulateFunc);
+        ~SimulationThread();
+
+        /** Start simulating a frame. Waits for the previous step first.
+        */
+        void kick(float currentTime, uint64_t frameID);
+
+        /** Block until the current step is done. Does nothing if the thread is idle.
+        */
+        void wait();
+
+        /** Get the ID of the last frame passed to kick()
+        */
+        uint64_t getLastFrameID() const { return mFrameID; }
+
+        /** Get the CPU time at which the simulation of a frame was kicked. Only valid for the last kSnapshotCount frames
+        */
+        CpuTimer::TimePoint getKickTime(uint64_t frameID) const { return mKickTimes[frameID % kSnapshotCount]; }
+
+        /** Get the CPU time of the last simulation step, in milliseconds
+        */
+        float getSimulationTime() const { return mSimulationTime; }
+
+        /** Get the time the last call to wait() blocked, in milliseconds
+        */
+        float getStallTime() const { return mStallTime; }
+
+    private:
+        SimulationThread(const SimulateFunc& simulateFunc);
+        void threadFunc();
+
+        SimulateFunc mSimulateFunc;
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mBusy = false;
+        bool mTerminate = false;
+
+        float mCurrentTime = 0;
+        uint64_t mFrameID = uint64_t(-1);
+        CpuTimer::TimePoint mKickTimes[kSnapshotCount];
+        float mSimulationTime = 0;
+        float mStallTime = 0;
+    };
+}
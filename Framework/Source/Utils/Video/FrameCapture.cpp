@@ -0,0 +1,148 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "FrameCapture.h"
+
+namespace Falcor
+{
+    FrameCapture::UniquePtr FrameCapture::create(const Desc& desc)
+    {
+        if (desc.maxFramesInFlight == 0)
+        {
+            logError("FrameCapture::create() - maxFramesInFlight must be greater than zero");
+            return nullptr;
+        }
+        return UniquePtr(new FrameCapture(desc));
+    }
+
+    FrameCapture::FrameCapture(const Desc& desc) : mDesc(desc)
+    {
+        mThread = std::thread(&FrameCapture::workerThread, this);
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    bool FrameCapture::captureFrame(CopyContext* pContext, const Texture* pTexture, uint32_t subresource, const FrameFunc& func)
+    {
+        releaseRetiredTasks();
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mFramesInFlight >= mDesc.maxFramesInFlight)
+            {
+                if (mDesc.allowFrameDrops)
+                {
+                    mStats.droppedFrames++;
+                    return false;
+                }
+                mCondition.wait(lock, [this]() { return mFramesInFlight < mDesc.maxFramesInFlight; });
+            }
+        }
+
+        // Records the copy and submits the command list without waiting for the GPU
+        Frame frame;
+        frame.pTask = pContext->asyncReadTextureSubresource(pTexture, subresource);
+        frame.func = func;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPendingFrames.push_back(std::move(frame));
+            mFramesInFlight++;
+            mStats.capturedFrames++;
+        }
+        mCondition.notify_all();
+        return true;
+    }
+
+    void FrameCapture::flush()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mFramesInFlight == 0; });
+        }
+        releaseRetiredTasks();
+    }
+
+    uint32_t FrameCapture::getFramesInFlight() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mFramesInFlight;
+    }
+
+    FrameCapture::Stats FrameCapture::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void FrameCapture::releaseRetiredTasks()
+    {
+        // Destroying the readback buffers isn't thread-safe, so the worker hands the tasks back instead of releasing them
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> retired;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            retired.swap(mRetiredTasks);
+        }
+    }
+
+    void FrameCapture::workerThread()
+    {
+        while (true)
+        {
+            Frame frame;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mTerminate || mPendingFrames.empty() == false; });
+                if (mPendingFrames.empty()) return;
+                frame = std::move(mPendingFrames.front());
+                mPendingFrames.pop_front();
+            }
+
+            // Waits on the task's fence and maps the readback buffer
+            std::vector<uint8_t> data = frame.pTask->getData();
+            frame.func(data);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRetiredTasks.push_back(std::move(frame.pTask));
+                mFramesInFlight--;
+                mStats.processedFrames++;
+            }
+            mCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include "API/CopyContext.h"
+
+namespace Falcor
+{
+    /** Pipelined readback of rendered frames.
+        Each captured frame is copied into a readback buffer on the GPU, and a worker thread waits for the copy and passes the data to the frame's callback.
+        The rendering thread never waits for the GPU. When the maximum number of frames are in flight, new frames are dropped, or the caller blocks if frame drops are disabled.
+    */
+    class FrameCapture
+    {
+    public:
+        using UniquePtr = std::unique_ptr<FrameCapture>;
+
+        /** Called on the worker thread with the frame's pixels, in the texture's format and without row padding
+        */
+        using FrameFunc = std::function<void(const std::vector<uint8_t>& data)>;
+
+        struct Desc
+        {
+            uint32_t maxFramesInFlight = 4;     ///< Maximum number of frames copied or processed at the same time
+            bool allowFrameDrops = true;        ///< If true, frames captured while the pipeline is full are dropped. Otherwise captureFrame() waits for a slot
+        };
+
+        struct Stats
+        {
+            uint64_t capturedFrames = 0;        ///< Number of frames submitted to the pipeline
+            uint64_t processedFrames = 0;       ///< Number of frames passed to their callbacks
+            uint64_t droppedFrames = 0;         ///< Number of frames dropped because the pipeline was full
+        };
+
+        ~FrameCapture();
+
+        /** Create a new object
+            \param[in] desc The pipeline settings
+        */
+        static UniquePtr create(const Desc& desc = Desc());
+
+        /** Capture a texture subresource. Must be called from the rendering thread.
+            \param[in] pContext The context used to copy the texture
+            \param[in] pTexture The texture to capture
+            \param[in] subresource The subresource to capture
+            \param[in] func The function receiving the frame data. Called on the worker thread, in capture order
+            \return false if the frame was dropped, otherwise true
+        */
+        bool captureFrame(CopyContext* pContext, const Texture* pTexture, uint32_t subresource, const FrameFunc& func);
+
+        /** Wait until all frames in flight were processed. Must be called from the rendering thread.
+        */
+        void flush();
+
+        /** Release the readback buffers of processed frames. Call once per frame from the rendering thread, so that a one-off capture doesn't keep its buffers until the next capture.
+        */
+        void endFrame() { releaseRetiredTasks(); }
+
+        /** Get the number of frames currently in flight
+        */
+        uint32_t getFramesInFlight() const;
+
+        /** Get the capture statistics
+        */
+        Stats getStats() const;
+
+    private:
+        FrameCapture(const Desc& desc);
+        void workerThread();
+        void releaseRetiredTasks();
+
+        struct Frame
+        {
+            CopyContext::ReadTextureTask::SharedPtr pTask;
+            FrameFunc func;
+        };
+
+        Desc mDesc;
+        Stats mStats;
+        uint32_t mFramesInFlight = 0;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<Frame> mPendingFrames;
+        std::vector<CopyContext::ReadTextureTask::SharedPtr> mRetiredTasks;    // Processed tasks. Their resources are released on the rendering thread
+        bool mTerminate = false;
+        std::thread mThread;
+    };
+}
@@ -25,11 +25,10 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
-#if 0
 #include "Framework.h"
 #include "VideoDecoder.h"
-#include "Utils/Platform/OS.h"
-#include "Utils/BinaryFileStream.h"
+#include "API/Device.h"
+
 extern "C"
 {
 #include "libavcodec/avcodec.h"
@@ -37,302 +36,358 @@ extern "C"
 #include "libswscale/swscale.h"
 }
 
-#include <cstdio>
-
 namespace Falcor
 {
-    float VideoDecoder::rationalToFloat(const AVRational& r)
+    static bool error(const std::string& filename, const std::string& msg)
     {
-        return ((float)r.num / (float)r.den);
+        logError("Error when opening video file " + filename + ".\n" + msg);
+        return false;
     }
 
-    VideoDecoder::UniquePtr VideoDecoder::create(const std::string& filename, uint32_t bufferedFrames, bool async)
+    VideoDecoder::UniquePtr VideoDecoder::create(const std::string& filename, uint32_t textureCount, uint32_t decodeAheadFrames)
     {
-        auto pVideo = UniquePtr(new VideoDecoder());
-        if(pVideo->load(filename, bufferedFrames, async) == false)
+        UniquePtr pVideo = UniquePtr(new VideoDecoder(filename));
+        if(pVideo->open(textureCount, decodeAheadFrames) == false)
         {
             pVideo = nullptr;
         }
-
         return pVideo;
     }
 
-    VideoDecoder::VideoDecoder()
+    VideoDecoder::VideoDecoder(const std::string& filename) : mFilename(filename)
     {
     }
 
-    bool VideoDecoder::load(const std::string& filename, uint32_t bufferedFrames, bool async)
-    {
-        mFilename = filename;
-        mVidBufferCount = bufferedFrames;
-
-        if(async)
-        {
-            mAsyncDecoding = std::make_shared<std::future<void>>(std::async(std::launch::async, &VideoDecoder::bufferFrames, this));
-        }
-        else
-            bufferFrames();
-
-        return true;
-    }
-
     VideoDecoder::~VideoDecoder()
     {
-        // Flush the async operation
-        if(mAsyncDecoding)
+        if(mThread.joinable())
         {
-            mAsyncDecoding->get();
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mTerminate = true;
+            }
+            mCondition.notify_all();
+            mThread.join();
         }
 
-        av_free(mpFrame);
-
-        // Close the codec
-        avcodec_close(mpCodecCtx);
-        // Close the video file
+        sws_freeContext(mpSwsCtx);
+        av_frame_free(&mpFrame);
+        avcodec_free_context(&mpCodecCtx);
         avformat_close_input(&mpFormatCtx);
-
-        for(auto& tex : (*mFrameTextures))
-            if(tex) tex->evict(nullptr);
     }
 
-    void FlipRGBFrame(AVFrame* pFrame, int H)
+    bool VideoDecoder::open(uint32_t textureCount, uint32_t decodeAheadFrames)
     {
-        uint8_t* templine = new uint8_t[pFrame->linesize[0]];
-
-        int hby2 = H / 2;
-
-        for(int line = 0; line < hby2; line++)
+        // av_register_all() is deprecated since 58.9.100, but Linux repos may not get a newer version, so this call cannot be completely removed.
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+        av_register_all();
+#endif
+        if(avformat_open_input(&mpFormatCtx, mFilename.c_str(), nullptr, nullptr) != 0)
         {
-            auto* line1 = pFrame->data[0] + (line)* pFrame->linesize[0];
-            auto* line2 = pFrame->data[0] + (H - 1 - line) * pFrame->linesize[0];
-
-            memcpy(templine, line1, pFrame->linesize[0]);
-            memcpy(line1, line2, pFrame->linesize[0]);
-            memcpy(line2, templine, pFrame->linesize[0]);
+            return error(mFilename, "Can't open file.");
         }
 
-        delete[] templine;
-    }
-
-    void VideoDecoder::bufferFrames()
-    {
-        if(mAsyncDecoding)
+        if(avformat_find_stream_info(mpFormatCtx, nullptr) < 0)
         {
-            setThreadPriority(getCurrentThread(), ThreadPriorityType::Low);
-            setThreadAffinity(getCurrentThread(), (1<<5)|(1<<6)|(1<<7)|(1<<8));
+            return error(mFilename, "Can't find stream information.");
         }
 
-        if(mpFrame)
+        AVCodec* pCodec = nullptr;
+        mVideoStream = av_find_best_stream(mpFormatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, &pCodec, 0);
+        if(mVideoStream < 0 || pCodec == nullptr)
         {
-            av_free(mpFrame);
-            mpFrame = nullptr;
+            return error(mFilename, "Can't find a video stream with a supported codec.");
         }
+        AVStream* pStream = mpFormatCtx->streams[mVideoStream];
 
-        // Close the codec
-        if(mpCodecCtx)
-        {
-            avcodec_close(mpCodecCtx);
-            mpCodecCtx = nullptr;
-        }
-        // Close the video file
-        if(mpFormatCtx)
+        mpCodecCtx = avcodec_alloc_context3(pCodec);
+        if(mpCodecCtx == nullptr || avcodec_parameters_to_context(mpCodecCtx, pStream->codecpar) < 0)
         {
-            avformat_close_input(&mpFormatCtx);
-            mpFormatCtx = nullptr;
+            return error(mFilename, "Can't create the codec context.");
         }
 
-        // Register the codecs
-        avcodec_register_all();
-        av_register_all();
-
-        if(avformat_open_input(&mpFormatCtx, mFilename.c_str(), NULL, NULL) != 0)
+        // Decode several frames in parallel, and frame slices on different threads, where the codec supports it
+        mpCodecCtx->thread_count = 0;
+        mpCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        if(avcodec_open2(mpCodecCtx, pCodec, nullptr) < 0)
         {
-            printf("Cannot open file\n");
-            return;
+            return error(mFilename, "Can't open video codec.");
         }
 
-        if(avformat_find_stream_info(mpFormatCtx, NULL) < 0)
+        mFPS = (float)av_q2d(pStream->avg_frame_rate);
+        if(mFPS <= 0) mFPS = (float)av_q2d(pStream->r_frame_rate);
+        if(mFPS <= 0) mFPS = 30;
+        mTimeBase = av_q2d(pStream->time_base);
+        mStartTime = (pStream->start_time != AV_NOPTS_VALUE) ? pStream->start_time : 0;
+
+        if(pStream->nb_frames > 0)
         {
-            printf("Couldn't find stream information.\n");
-            return;
+            mFrameCount = (uint32_t)pStream->nb_frames;
         }
-
-        for(uint32_t i = 0; i < mpFormatCtx->nb_streams; i++)
+        else
         {
-            auto& stream = mpFormatCtx->streams[i];
-            if(stream->codec->codec_type == AVMEDIA_TYPE_VIDEO)
-            {
-                mVideoStream = i;
-                break;
-            }
+            double duration = (pStream->duration != AV_NOPTS_VALUE) ? pStream->duration * mTimeBase : (double)mpFormatCtx->duration / AV_TIME_BASE;
+            mFrameCount = std::max(1u, (uint32_t)llround(duration * mFPS));
         }
 
-        if(mVideoStream == -1)
+        mWidth = mpCodecCtx->width;
+        mHeight = mpCodecCtx->height;
+        mRowPitch = mWidth * 4;
+        mpSwsCtx = sws_getContext(mWidth, mHeight, mpCodecCtx->pix_fmt, mWidth, mHeight, AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+        mpFrame = av_frame_alloc();
+        if(mpSwsCtx == nullptr || mpFrame == nullptr)
         {
-            return;
+            return error(mFilename, "Can't allocate the conversion context.");
         }
 
-        auto& stream = mpFormatCtx->streams[mVideoStream];
-
-        // Get a pointer to the codec context for the video stream
-        mpCodecCtxOrig = stream->codec;
-
-        mFPS = rationalToFloat(stream->avg_frame_rate);
-
-        // Find the decoder for the video stream
-        mpCodec = avcodec_find_decoder(mpCodecCtxOrig->codec_id);
-
-        if(mpCodec == NULL)
+        // The decoder thread owns the free buffers, the render thread owns the decoded ones until it recycles them
+        mDecodeAheadFrames = std::max(1u, decodeAheadFrames);
+        mBuffers.resize(mDecodeAheadFrames, std::vector<uint8_t>(mHeight * mRowPitch));
+        for(uint32_t i = 1; i < mDecodeAheadFrames; i++)
         {
-            printf("Unsupported codec!\n");
-            return; // Codec not found
+            mFreeBuffers.push_back(i);
         }
 
-        // Copy context
-        mpCodecCtx = avcodec_alloc_context3(mpCodec);
-        if(avcodec_copy_context(mpCodecCtx, mpCodecCtxOrig) != 0)
+        mTextureRing.resize(std::max(1u, textureCount));
+        for(auto& entry : mTextureRing)
         {
-            printf("Couldn't copy codec context\n");
-            return; // Error copying codec context
+            entry.pTexture = Texture::create2D(mWidth, mHeight, ResourceFormat::RGBA8UnormSrgb, 1, 1);
         }
 
-        // Open codec
-        if(avcodec_open2(mpCodecCtx, mpCodec, nullptr) < 0)
+        // Decode the first frame right away, so there's always a texture to return
+        uint32_t frameIndex;
+        if(decodeFrame(frameIndex) == false)
         {
-            return; // Could not open codec
+            return error(mFilename, "Can't decode the first frame.");
         }
+        convertFrame(mBuffers[0].data());
+        uploadFrame(mBuffers[0], frameIndex);
+        mFreeBuffers.push_back(0);
 
-        // Allocate video frame
-        mpFrame = av_frame_alloc();
+        mThread = std::thread(&VideoDecoder::decoderThread, this);
+        return true;
+    }
 
+    bool VideoDecoder::decodeFrame(uint32_t& frameIndex)
+    {
+        uint32_t restarts = 0;
+        while(true)
+        {
+            int r = avcodec_receive_frame(mpCodecCtx, mpFrame);
+            if(r == 0)
+            {
+                int64_t pts = mpFrame->best_effort_timestamp;
+                frameIndex = (pts == AV_NOPTS_VALUE) ? mLastDecodedFrame + 1 : (uint32_t)std::max(0ll, llround((pts - mStartTime) * mTimeBase * mFPS));
+                frameIndex = std::min(frameIndex, mFrameCount - 1);
+                mLastDecodedFrame = frameIndex;
+                return true;
+            }
+            else if(r == AVERROR_EOF)
+            {
+                // Loop back to the start. Give up if a full pass didn't produce a frame
+                if(restarts++ > 0) return false;
+                seekStream(0);
+                continue;
+            }
+            else if(r != AVERROR(EAGAIN))
+            {
+                return false;
+            }
 
-        mFrames.clear();
-        mFrames.reserve(mVidBufferCount);
+            AVPacket packet;
+            av_init_packet(&packet);
+            packet.data = nullptr;
+            packet.size = 0;
+            if(av_read_frame(mpFormatCtx, &packet) < 0)
+            {
+                // Drain the frames the codec still holds
+                avcodec_send_packet(mpCodecCtx, nullptr);
+                mEndOfStream = true;
+                continue;
+            }
 
-        const bool async = mAsyncDecoding != nullptr;
+            if(packet.stream_index == mVideoStream)
+            {
+                avcodec_send_packet(mpCodecCtx, &packet);
+            }
+            av_packet_unref(&packet);
+        }
+    }
 
-        //printf("Buffering frames...\n");
-        uint32_t frameIdx = 0;
+    void VideoDecoder::convertFrame(uint8_t* pDst)
+    {
+        // Write the rows bottom-up, so the conversion also flips the image
+        uint8_t* dst[AV_NUM_DATA_POINTERS] = {0};
+        int32_t rowPitch[AV_NUM_DATA_POINTERS] = {0};
+        dst[0] = pDst + (mHeight - 1) * mRowPitch;
+        rowPitch[0] = -(int32_t)mRowPitch;
+        sws_scale(mpSwsCtx, (uint8_t const* const*)mpFrame->data, mpFrame->linesize, 0, mHeight, dst, rowPitch);
+    }
 
-        SwsContext *sws_ctx = sws_getContext(
-            mpCodecCtx->width, mpCodecCtx->height, mpCodecCtx->pix_fmt,
-            mpCodecCtx->width, mpCodecCtx->height, PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL);
+    void VideoDecoder::seekStream(uint32_t frameIndex)
+    {
+        int64_t timestamp = mStartTime + (int64_t)(frameIndex / mFPS / mTimeBase);
+        av_seek_frame(mpFormatCtx, mVideoStream, timestamp, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(mpCodecCtx);
+        mEndOfStream = false;
+        mSkipUntilFrame = frameIndex;
+        mLastDecodedFrame = frameIndex - 1;     // Used to number frames without timestamps
+    }
 
-        AVPacket packet;
-        while(av_read_frame(mpFormatCtx, &packet) >= 0 && (frameIdx < mVidBufferCount))
+    void VideoDecoder::decoderThread()
+    {
+        uint32_t generation = 0;
+        while(true)
         {
-            if(packet.stream_index == mVideoStream)
+            uint32_t bufferIndex;
             {
-                int32_t isFrameDone;
-                avcodec_decode_video2(mpCodecCtx, mpFrame, &isFrameDone, &packet);
-                if(isFrameDone)
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [&]() { return mTerminate || mSeekGeneration != generation || mFreeBuffers.empty() == false; });
+                if(mTerminate) return;
+
+                if(mSeekGeneration != generation)
                 {
-                    // Create either a single frame, or all frames one-by-one on CPU
-                    if(async || mFrames.empty())
-                    {
-                        // Inplace construction to avoid releasing of arrays
-                        mFrames.push_back(Frame());
-                        new(&mFrames.back()) Frame(mpCodecCtx);
-                    }
-                    Frame& frame = mFrames.back();
-
-                    // Convert the image from its native format to RGB
-                    sws_scale(sws_ctx, (uint8_t const * const *)mpFrame->data, mpFrame->linesize, 0, mpCodecCtx->height, frame.mpFrameRGB->data, frame.mpFrameRGB->linesize);
-                    FlipRGBFrame(frame.mpFrameRGB, mpCodecCtx->height);
-                    if(!async)
-                        uploadToGPU(frameIdx);
-
-                    frameIdx++;
+                    generation = mSeekGeneration;
+                    seekStream(mSeekFrame);
                 }
+                if(mFreeBuffers.empty()) continue;
+                bufferIndex = mFreeBuffers.front();
+                mFreeBuffers.pop_front();
             }
-            av_free_packet(&packet);
-        }
-        //printf("Done reading %d frames\n", frameIdx);
 
-        mRealFrameCount = frameIdx;
-    }
+            // Decode outside the lock. Frames from before a seek target are skipped, unless the stream looped
+            uint32_t frameIndex;
+            bool decoded;
+            do
+            {
+                decoded = decodeFrame(frameIndex);
+            } while(decoded && frameIndex < mSkipUntilFrame);
+            mSkipUntilFrame = 0;
 
-    void VideoDecoder::uploadToGPU(int frameStart)
-    {
-        if(!mFrameTextures)
-            mFrameTextures = std::make_shared<TexturePool>();
-        for(size_t i=0;i<mFrames.size();++i)
-        {
-            auto& frame = mFrames[i];
-            if(frameStart + i >= mFrameTextures->size())
+            if(decoded)
+            {
+                convertFrame(mBuffers[bufferIndex].data());
+            }
+            else
+            {
+                logError("VideoDecoder: decoding " + mFilename + " failed. Playback stops at the current frame.");
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(decoded && generation == mSeekGeneration)
             {
-                mFrameTextures->push_back(Texture::create2D(mpCodecCtx->width, mpCodecCtx->height, ResourceFormat::RGBA8UnormSrgb, 1, 1, frame.mpFrameRGB->data[0]));
-                mFrameTextures->back()->makeResident(nullptr);
+                mDecodedFrames.push_back({bufferIndex, frameIndex});
             }
             else
             {
-                (*mFrameTextures)[frameStart + i]->uploadSubresourceData(frame.mpFrameRGB->data[0], frame.mFrameSize);
+                mFreeBuffers.push_back(bufferIndex);
             }
+            if(decoded == false) return;
         }
-        mFrames.clear();
     }
 
-    Texture::SharedPtr VideoDecoder::getTextureForNextFrame(float curTime)
+    uint32_t VideoDecoder::getFrameDistance(uint32_t from, uint32_t to) const
     {
-        // Flush the async operation, upload everything to video memory
-        if(mAsyncDecoding)
-        {
-            mAsyncDecoding->get();
-            mAsyncDecoding.reset();
-            uploadToGPU();
-        }
-        int curFrame = ((int)floor(curTime * mFPS)) % mRealFrameCount;
-        //SetBufferToTexture(m_VidBuffers[curFrame]);
-        //printf("time, frame: %f, %d\n", curTime, curFrame);
-        return (*mFrameTextures)[curFrame];
+        // Number of frames played from 'from' until 'to' is reached, taking looping into account
+        return (to + mFrameCount - from) % mFrameCount;
     }
 
-    float VideoDecoder::getDuration()
+    void VideoDecoder::uploadFrame(const std::vector<uint8_t>& data, uint32_t frameIndex)
     {
-        // Flush the async operation, upload everything to video memory
-        if(mAsyncDecoding)
-        {
-            mAsyncDecoding->get();
-            mAsyncDecoding.reset();
-            uploadToGPU();
-        }
-
-        return ((float)mRealFrameCount) / mFPS;
+        RingEntry& entry = mTextureRing[mNextRingEntry];
+        gpDevice->getRenderContext()->updateSubresourceData(entry.pTexture.get(), 0, data.data());
+        entry.frameIndex = frameIndex;
+        mCurrentRingEntry = mNextRingEntry;
+        mNextRingEntry = (mNextRingEntry + 1) % (uint32_t)mTextureRing.size();
     }
 
-    VideoDecoder::TexturePoolPtr VideoDecoder::getTexturePool()
+    void VideoDecoder::requestSeek(uint32_t frameIndex)
     {
-        return mFrameTextures;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for(const auto& frame : mDecodedFrames)
+            {
+                mFreeBuffers.push_back(frame.bufferIndex);
+            }
+            mDecodedFrames.clear();
+            mSeekFrame = frameIndex;
+            mSeekGeneration++;
+        }
+        mCondition.notify_all();
+        mSeekPending = true;
+        mSeekTarget = frameIndex;
     }
 
-    void VideoDecoder::setTexturePool(TexturePoolPtr& texturePool)
+    void VideoDecoder::seek(float time)
     {
-        mFrameTextures = texturePool;
+        float frame = fmodf(time * mFPS, (float)mFrameCount);
+        if(frame < 0) frame += mFrameCount;
+        requestSeek(std::min((uint32_t)frame, mFrameCount - 1));
     }
 
-    VideoDecoder::Frame::Frame(AVCodecContext* codec)
+    Texture::SharedPtr VideoDecoder::getTextureForNextFrame(float curTime)
     {
-        mFrameSize = avpicture_get_size(PIX_FMT_RGBA, codec->width, codec->height);
+        float frame = fmodf(floorf(curTime * mFPS), (float)mFrameCount);
+        if(frame < 0) frame += mFrameCount;
+        uint32_t target = std::min((uint32_t)frame, mFrameCount - 1);
 
-        // Allocate an AVFrame structure
-        mpFrameRGB = av_frame_alloc();
-        if(mpFrameRGB == NULL)
+        // The frame may still be in the ring
+        for(const auto& entry : mTextureRing)
         {
-            printf("Cannot allocate frame. Possibly out of CPU memory!\n");
-            return;
+            if(entry.frameIndex == target) return entry.pTexture;
         }
-        mCpuVidBuffer = (uint8_t*)av_malloc(mFrameSize*sizeof(uint8_t));
 
-        avpicture_fill((AVPicture *)mpFrameRGB, mCpuVidBuffer, PIX_FMT_RGBA, codec->width, codec->height);
-        //printf("frame size is %d Mbytes\n", mFrameSize / (1024 * 1024));
-    }
+        // Drop the decoded frames which are behind the target, and take the target frame if it's ready
+        uint32_t bufferIndex = uint32_t(-1);
+        uint32_t ready = 0;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while(mDecodedFrames.empty() == false)
+            {
+                const DecodedFrame& front = mDecodedFrames.front();
+                uint32_t behind = getFrameDistance(front.frameIndex, target);
+                if(behind > mFrameCount / 2)
+                {
+                    // The next decoded frame is ahead of the target. Keep showing the current frame
+                    break;
+                }
 
-    VideoDecoder::Frame::~Frame()
-    {
-        if(mCpuVidBuffer)
-            av_free(mCpuVidBuffer);
-        if(mpFrameRGB)
-            av_free(mpFrameRGB);
+                if(behind == 0)
+                {
+                    bufferIndex = front.bufferIndex;
+                    mDecodedFrames.pop_front();
+                    break;
+                }
+                mFreeBuffers.push_back(front.bufferIndex);
+                mDecodedFrames.pop_front();
+            }
+            ready = (uint32_t)mDecodedFrames.size();
+        }
+        mCondition.notify_all();
+
+        if(bufferIndex != uint32_t(-1))
+        {
+            uploadFrame(mBuffers[bufferIndex], target);
+            mSeekPending = false;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFreeBuffers.push_back(bufferIndex);
+            }
+            mCondition.notify_all();
+        }
+        else
+        {
+            // Restart decoding if playback jumped backwards, or further ahead than the decoder can catch up with
+            uint32_t current = mSeekPending ? mSeekTarget : mTextureRing[mCurrentRingEntry].frameIndex;
+            uint32_t ahead = getFrameDistance(current, target);
+            bool jumpedBack = ahead > mFrameCount / 2 && (mFrameCount - ahead) > 1;
+            bool jumpedAhead = ahead <= mFrameCount / 2 && ahead > 2 * mDecodeAheadFrames && ready == 0;
+            if(jumpedBack || jumpedAhead)
+            {
+                requestSeek(target);
+            }
+        }
+
+        return mTextureRing[mCurrentRingEntry].pTexture;
     }
 }
-#endif
\ No newline at end of file
@@ -27,23 +27,23 @@
 ***************************************************************************/
 #pragma once
 #include <string>
-#include <future>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "API/Texture.h"
 
 struct AVFormatContext;
-struct AVStream;
 struct AVFrame;
-struct AVPicture;
 struct SwsContext;
 struct AVCodecContext;
-struct AVCodec;
-struct AVRational;
 
 namespace Falcor
-{        
-    /** Simple video decoder for high-framerate and high-resolution
-        playback of rendered videos. Currently decodes the first N frames
-        as textures before playing.
+{
+    /** Streaming video decoder for high-framerate and high-resolution playback of rendered videos.
+        A worker thread decodes ahead of the playback position into a bounded set of CPU frames. getTextureForNextFrame() uploads the frame it needs into a small ring of textures, so memory usage doesn't depend on the length of the video.
+        Playback loops at the end of the video. Seeking, or jumping in time, restarts decoding at the new position and keeps returning the last uploaded frame until the new one is ready.
     */
     class VideoDecoder
     {
@@ -51,83 +51,95 @@ namespace Falcor
         using UniquePtr = std::unique_ptr<VideoDecoder>;
         using UniqueConstPtr = std::unique_ptr<const VideoDecoder>;
 
-        typedef std::vector<Texture::SharedPtr> TexturePool;
-        typedef std::shared_ptr<TexturePool> TexturePoolPtr;
-
         /** Create a new VideoDecoder object
             \param[in] filename Input video file (with path)
-            \param[in] bufferFrames The maximum number of input frames to buffer as Texture objects. Default is 300.
-            \param[in] async Whether load operation should happen asynchronously
+            \param[in] textureCount The number of textures in the ring. A returned texture is valid until textureCount more frames were uploaded
+            \param[in] decodeAheadFrames The maximum number of frames decoded ahead of the playback position
+            \return A new object, or nullptr if the file couldn't be opened
         */
-        static UniquePtr create(const std::string& filename, uint32_t bufferedFrames = 300, bool async = false);
+        static UniquePtr create(const std::string& filename, uint32_t textureCount = 3, uint32_t decodeAheadFrames = 8);
         ~VideoDecoder();
 
-        /** Get a texture object for the frame at current time
-            \param[in] curTime Time for which frame is sought
+        /** Get a texture object for the frame at current time. Never waits for the decoder. If the frame isn't decoded yet, the last uploaded frame is returned.
+            \param[in] curTime Time for which frame is sought. Wraps around the video duration
             \return Texture pointer to texture object
         */
         Texture::SharedPtr getTextureForNextFrame(float curTime);
 
-        /** Return duration of video loaded (in seconds).
-            This uses the actual number of frames. Only makes sense
-            for videos shorter than the requested frame count.
-            \return Duration of video loaded in seconds.
+        /** Restart decoding at a given time. Use this before a jump in playback time to avoid waiting for the decoder to notice it
+            \param[in] time The new playback time, in seconds
         */
-        float getDuration();
+        void seek(float time);
 
-        /** Returns reusable shared texture pool
+        /** Return duration of video loaded (in seconds).
         */
-        TexturePoolPtr getTexturePool();
+        float getDuration() const { return mFrameCount / mFPS; }
 
-        /** Sets reusable shared texture pool
+        /** Get the video frame rate
         */
-        void setTexturePool(TexturePoolPtr& texturePool);
+        float getFPS() const { return mFPS; }
 
-        /** Opens a file
-            \param[in] filename Input video file (with path)
-            \param[in] bufferFrames The maximum number of input frames to buffer as Texture objects. Default is 300.
-            \param[in] async Whether load operation should happen asynchronously
-        */
-        bool load(const std::string& filename, uint32_t bufferedFrames, bool async);
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
 
     private:
-        /** Holds a single video frame on CPU
-        */
-        struct Frame
+        struct DecodedFrame
         {
-            Frame() {}
-            Frame(AVCodecContext* codec);
-            ~Frame();
-            AVFrame*    mpFrameRGB = nullptr;
-            uint8_t*    mCpuVidBuffer = nullptr;
-            int         mFrameSize = 0;
+            uint32_t bufferIndex;
+            uint32_t frameIndex;
         };
 
-        VideoDecoder();
+        struct RingEntry
+        {
+            Texture::SharedPtr pTexture;
+            uint32_t frameIndex = uint32_t(-1);
+        };
 
-        void uploadToGPU(int frameStart = 0);
+        VideoDecoder(const std::string& filename);
+        bool open(uint32_t textureCount, uint32_t decodeAheadFrames);
+        void decoderThread();
+        bool decodeFrame(uint32_t& frameIndex);
+        void convertFrame(uint8_t* pDst);
+        void seekStream(uint32_t frameIndex);
+        void requestSeek(uint32_t frameIndex);
+        void uploadFrame(const std::vector<uint8_t>& data, uint32_t frameIndex);
+        uint32_t getFrameDistance(uint32_t from, uint32_t to) const;
 
         std::string mFilename;
-
-        AVFormatContext*                        mpFormatCtx       = nullptr;
-        AVCodecContext*                         mpCodecCtxOrig    = nullptr;
-        AVCodecContext*                         mpCodecCtx        = nullptr;
-        AVCodec*                                mpCodec           = nullptr;
-        AVFrame*                                mpFrame           = nullptr;
-        std::vector<Frame>                      mFrames;
-
-        float                                   mFPS              = 30;
-        bool                                    mFlipY            = true;
-        unsigned                                mVideoStream      = -1;
-        uint32_t                                mVidBufferCount   = 300;
-        uint32_t                                mRealFrameCount = 0;
-
-        std::shared_ptr<std::future<void>>        mAsyncDecoding = nullptr;
-
-        TexturePoolPtr                          mFrameTextures;
-
-        // helper routines
-        void  bufferFrames();
-        float rationalToFloat(const AVRational& r);
+        AVFormatContext* mpFormatCtx = nullptr;
+        AVCodecContext* mpCodecCtx = nullptr;
+        AVFrame* mpFrame = nullptr;
+        SwsContext* mpSwsCtx = nullptr;
+        int32_t mVideoStream = -1;
+        double mTimeBase = 0;           // Seconds per stream timestamp unit
+        int64_t mStartTime = 0;
+        bool mEndOfStream = false;
+        uint32_t mDecodeAheadFrames = 0;
+        uint32_t mLastDecodedFrame = uint32_t(-1);  // Frames without timestamps are numbered from here, so the first one is frame 0, as after seekStream(0)
+        uint32_t mSkipUntilFrame = 0;   // After a seek, frames before the target are decoded and discarded
+
+        float mFPS = 30;
+        uint32_t mFrameCount = 0;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mRowPitch = 0;
+
+        // Shared with the decoder thread
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::vector<std::vector<uint8_t>> mBuffers;
+        std::deque<uint32_t> mFreeBuffers;
+        std::deque<DecodedFrame> mDecodedFrames;
+        uint32_t mSeekFrame = 0;
+        uint32_t mSeekGeneration = 0;           // Incremented on every seek. Frames decoded before the latest seek are discarded
+        bool mTerminate = false;
+        std::thread mThread;
+
+        // Render thread only
+        std::vector<RingEntry> mTextureRing;
+        uint32_t mNextRingEntry = 0;
+        uint32_t mCurrentRingEntry = uint32_t(-1);
+        bool mSeekPending = false;
+        uint32_t mSeekTarget = 0;
     };
-}
\ No newline at end of file
+}
@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "VideoEncoder.h"
 #include "Utils/BinaryFileStream.h"
+#include "Utils/CpuTimer.h"
 
 extern "C"
 {
@@ -50,6 +51,8 @@ namespace Falcor
             return AV_PIX_FMT_YUV422P;
         case AV_CODEC_ID_MPEG4:
             return AV_PIX_FMT_YUV420P;
+        case AV_CODEC_ID_FFV1:
+            return AV_PIX_FMT_0RGB32;
         default:
             should_not_get_here();
             return AV_PIX_FMT_NONE;
@@ -86,6 +89,8 @@ namespace Falcor
             return AV_CODEC_ID_MPEG2VIDEO;
         case VideoEncoder::CodecID::MPEG4:
             return AV_CODEC_ID_MPEG4;
+        case VideoEncoder::CodecID::FFV1:
+            return AV_CODEC_ID_FFV1;
         default:
             should_not_get_here();
             return AV_CODEC_ID_NONE;
@@ -100,7 +105,7 @@ namespace Falcor
         return false;
     }
 
-    AVCodecContext* createCodecContext(AVFormatContext* pCtx, uint32_t width, uint32_t height, uint32_t fps, float bitrateMbps, uint32_t gopSize, AVCodecID codecID, AVCodec* pCodec)
+    AVCodecContext* createCodecContext(AVFormatContext* pCtx, uint32_t width, uint32_t height, uint32_t fps, float bitrateMbps, uint32_t gopSize, uint32_t threadCount, AVCodecID codecID, AVCodec* pCodec)
     {
         // Initialize the codec context
         AVCodecContext* pCodecCtx = avcodec_alloc_context3(pCodec);
@@ -112,6 +117,10 @@ namespace Falcor
         pCodecCtx->gop_size = gopSize;
         pCodecCtx->pix_fmt = getPictureFormatFromCodec(codecID);
 
+        // Let the codec encode several frames in parallel, and split frames into slices encoded on different threads. Codecs ignore the modes they don't support
+        pCodecCtx->thread_count = threadCount;
+        pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
         // Some formats want stream headers to be separate
         if(pCtx->oformat->flags & AVFMT_GLOBALHEADER)
         {
@@ -182,6 +191,13 @@ namespace Falcor
             */
             av_dict_set(&param, "preset", "veryslow", 0);
         }
+        else if(pCodecCtx->codec_id == AV_CODEC_ID_FFV1)
+        {
+            // Version 3 supports slices, which FFV1 encodes in parallel. The slice CRCs make damaged files recoverable
+            av_dict_set(&param, "level", "3", 0);
+            av_dict_set(&param, "slices", "16", 0);
+            av_dict_set(&param, "slicecrc", "1", 0);
+        }
 
         // Open the codec
         if(avcodec_open2(pCodecCtx, pCodec, &param) < 0)
@@ -250,7 +266,7 @@ namespace Falcor
             return false;
         }
 
-        mpCodecContext = createCodecContext(mpOutputContext, desc.width, desc.height, desc.fps, desc.bitrateMbps, desc.gopSize, getCodecID(desc.codec), pVideoCodec);
+        mpCodecContext = createCodecContext(mpOutputContext, desc.width, desc.height, desc.fps, desc.bitrateMbps, desc.gopSize, desc.threadCount, getCodecID(desc.codec), pVideoCodec);
         if(mpCodecContext == nullptr)
         {
             return false;
@@ -285,10 +301,7 @@ namespace Falcor
 
         mFormat = desc.format;
         mRowPitch = getFormatBytesPerBlock(desc.format) * desc.width;
-        if(desc.flipY)
-        {
-            mpFlippedImage = new uint8_t[desc.height * mRowPitch];
-        }
+        mFlipY = desc.flipY;
 
         mpSwsContext = sws_getContext(desc.width, desc.height, getPictureFormatFromFalcorFormat(desc.format), desc.width, desc.height, mpCodecContext->pix_fmt, SWS_POINT, nullptr, nullptr, nullptr);
         if(mpSwsContext == nullptr)
@@ -335,6 +348,12 @@ namespace Falcor
     {
         if(mpOutputContext)
         {
+            if(mFrameCount)
+            {
+                float fps = mEncodeTime > 0 ? float(mFrameCount) * 1000.0f / mEncodeTime : 0.0f;
+                logInfo("VideoEncoder: encoded " + std::to_string(mFrameCount) + " frames of " + std::to_string(mpCodecContext->width) + "x" + std::to_string(mpCodecContext->height) + " at " + std::to_string(fps) + " frames/s into " + mFilename);
+            }
+
             // Flush the codex
             avcodec_send_frame(mpCodecContext, nullptr);
             flush(mpCodecContext, mpOutputContext, mpOutputStream, mFilename);
@@ -349,28 +368,32 @@ namespace Falcor
             mpOutputContext = nullptr;
             mpOutputStream = nullptr;
         }
-        safe_delete(mpFlippedImage)
     }
 
     void VideoEncoder::appendFrame(const void* pData)
     {
-        if(mpFlippedImage)
-        {
-            // Flip the image
-            for(int32_t h = 0; h < mpCodecContext->height; h++)
-            {
-                const uint8_t* pSrc = (uint8_t*)pData + h * mRowPitch;
-                uint8_t* pDst = mpFlippedImage + (mpCodecContext->height - 1 - h) * mRowPitch;
-                memcpy(pDst, pSrc, mRowPitch);
-            }
-
-            pData = mpFlippedImage;
-        }
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
 
         uint8_t* src[AV_NUM_DATA_POINTERS] = {0};
         int32_t rowPitch[AV_NUM_DATA_POINTERS] = {0};
-        src[0] = (uint8_t*)pData;
-        rowPitch[0] = (int32_t)mRowPitch;
+        if(mFlipY)
+        {
+            // Start at the last row and walk up, so the conversion flips the image without an extra copy
+            src[0] = (uint8_t*)pData + (mpCodecContext->height - 1) * mRowPitch;
+            rowPitch[0] = -(int32_t)mRowPitch;
+        }
+        else
+        {
+            src[0] = (uint8_t*)pData;
+            rowPitch[0] = (int32_t)mRowPitch;
+        }
+
+        // With frame threading the encoder can still reference the buffer sent with the previous frame. If it does, this allocates a new one
+        if(av_frame_make_writable(mpFrame) < 0)
+        {
+            error(mFilename, "Can't make the video frame writable");
+            return;
+        }
 
         // Scale and convert the image
         sws_scale(mpSwsContext, src, rowPitch, 0, mpCodecContext->height, mpFrame->data, mpFrame->linesize);
@@ -390,6 +413,9 @@ namespace Falcor
             error(mFilename, "Can't send video frame");
             return;
         }
+
+        mFrameCount++;
+        mEncodeTime += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
     }
 
     const std::string VideoEncoder::getSupportedContainerForCodec(CodecID codec)
@@ -412,6 +438,9 @@ namespace Falcor
         case VideoEncoder::CodecID::HEVC:
             s += MP4 + MKV;
             break;
+        case VideoEncoder::CodecID::FFV1:
+            s += MKV + AVI;
+            break;
         default:
             should_not_get_here();
         }
@@ -419,4 +448,9 @@ namespace Falcor
         s += "\0";
         return s;
     }
+
+    bool VideoEncoder::isLosslessCodec(CodecID codec)
+    {
+        return codec == CodecID::RawVideo || codec == CodecID::FFV1;
+    }
 }
\ No newline at end of file
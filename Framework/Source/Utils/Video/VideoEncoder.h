@@ -49,6 +49,7 @@ namespace Falcor
             HEVC,
             MPEG2,
             MPEG4,
+            FFV1,       ///< Lossless. Meant for high-resolution intermediate captures which are transcoded later
         };
 
         struct Desc
@@ -61,6 +62,7 @@ namespace Falcor
             CodecID codec = CodecID::RawVideo;
             ResourceFormat format = ResourceFormat::BGRA8UnormSrgb;
             bool flipY = false;
+            uint32_t threadCount = 0;   ///< Number of encoder threads. 0 lets FFmpeg choose based on the number of cores
             std::string filename;
         };
 
@@ -71,6 +73,10 @@ namespace Falcor
         void endCapture();
 
         static const std::string getSupportedContainerForCodec(CodecID codec);
+
+        /** Check if a codec preserves the images exactly
+        */
+        static bool isLosslessCodec(CodecID codec);
     private:
         VideoEncoder(const std::string& filename);
         bool init(const Desc& desc);
@@ -84,6 +90,9 @@ namespace Falcor
         const std::string mFilename;
         ResourceFormat mFormat;
         uint32_t mRowPitch = 0;
-        uint8_t* mpFlippedImage = nullptr; // Used in case the image memory layout if bottom->top
+        bool mFlipY = false;
+
+        uint64_t mFrameCount = 0;
+        float mEncodeTime = 0;      // Total time spent in appendFrame(), in milliseconds
     };
 }
\ No newline at end of file
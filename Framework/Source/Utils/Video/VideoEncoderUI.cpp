@@ -38,7 +38,8 @@ namespace Falcor
         { (int32_t)VideoEncoder::CodecID::H264, std::string("H.264") },
         { (int32_t)VideoEncoder::CodecID::HEVC, std::string("HEVC(H.265)") },
         { (int32_t)VideoEncoder::CodecID::MPEG2, std::string("MPEG2") },
-        { (int32_t)VideoEncoder::CodecID::MPEG4, std::string("MPEG4") }
+        { (int32_t)VideoEncoder::CodecID::MPEG4, std::string("MPEG4") },
+        { (int32_t)VideoEncoder::CodecID::FFV1, std::string("FFV1 (Lossless)") }
     };
 
     VideoEncoderUI::UniquePtr VideoEncoderUI::create(uint32_t topLeftX, uint32_t topLeftY, uint32_t width, uint32_t height, Callback startCaptureCB, Callback endCaptureCB)
@@ -35,6 +35,40 @@ void ShaderBuffersSample::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
     pGui->addRgbColor("Light intensity", mLightData.intensity);
     pGui->addRgbColor("Surface Color", mSurfaceColor);
     pGui->addCheckBox("Count FS invocations", mCountPixelShaderInvocations);
+
+    if (pGui->addButton("Benchmark variable handles"))
+    {
+        benchmarkVariableHandles();
+    }
+    if (mHandleBenchmarkResult.size())
+    {
+        pGui->addText(mHandleBenchmarkResult.c_str());
+    }
+}
+
+void ShaderBuffersSample::benchmarkVariableHandles()
+{
+    // Compare setting variables and resources by name against the pre-resolved handles
+    static const uint32_t kIterations = 100000;
+    ConstantBuffer::SharedPtr pCB = mpProgramVars["PerFrameCB"];
+    ParameterBlock* pBlock = mpProgramVars->getDefaultBlock().get();
+    const glm::mat4 wvp = mpCamera->getViewProjMatrix();
+
+    auto measure = [](const std::function<void()>& func)
+    {
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        for (uint32_t i = 0; i < kIterations; i++) func();
+        return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1e6f / kIterations;
+    };
+
+    float cbName = measure([&]() { pCB->setVariable("gWvpMat", wvp); });
+    float cbHandle = measure([&]() { pCB->setVariable(mWvpMatHandle, wvp); });
+    float bufName = measure([&]() { pBlock->setRawBuffer("gInvocationBuffer", mpInvocationsBuffer); });
+    float bufHandle = measure([&]() { pBlock->setRawBuffer(mInvocationBufferHandle, mpInvocationsBuffer); });
+
+    mHandleBenchmarkResult = "setVariable() by name " + std::to_string(cbName) + "ns, by handle " + std::to_string(cbHandle) + "ns\n";
+    mHandleBenchmarkResult += "setRawBuffer() by name " + std::to_string(bufName) + "ns, by handle " + std::to_string(bufHandle) + "ns";
+    logInfo(mHandleBenchmarkResult);
 }
 
 Vao::SharedConstPtr ShaderBuffersSample::getVao()
@@ -77,6 +111,9 @@ void ShaderBuffersSample::onLoad(SampleCallbacks* pSample, RenderContext::Shared
     uint32_t z = 0;
     mpInvocationsBuffer = Buffer::create(sizeof(uint32_t), Buffer::BindFlags::UnorderedAccess, Buffer::CpuAccess::Read, &z);
     mpProgramVars->setRawBuffer("gInvocationBuffer", mpInvocationsBuffer);
+    mWorldMatHandle = mpProgramVars["PerFrameCB"]->getVariableHandle("gWorldMat");
+    mWvpMatHandle = mpProgramVars["PerFrameCB"]->getVariableHandle("gWvpMat");
+    mInvocationBufferHandle = mpProgramVars->getDefaultBlock()->getResourceHandle("gInvocationBuffer");
     mpProgramVars->setTypedBuffer("gSurfaceColor[1]", mpSurfaceColorBuffer);
 
     mpRWBuffer = StructuredBuffer::create(mpProgram, "gRWBuffer", 4);
@@ -141,9 +178,9 @@ void ShaderBuffersSample::onFrameRender(SampleCallbacks* pSample, RenderContext:
     pContext->setGraphicsState(mpGraphicsState);
 
     // Update uniform-buffers data
-    mpProgramVars["PerFrameCB"]["gWorldMat"] = glm::mat4();
+    mpProgramVars["PerFrameCB"][mWorldMatHandle] = glm::mat4();
     glm::mat4 wvp = mpCamera->getViewProjMatrix();
-    mpProgramVars["PerFrameCB"]["gWvpMat"] = wvp;
+    mpProgramVars["PerFrameCB"][mWvpMatHandle] = wvp;
 
     mpSurfaceColorBuffer[0] = mSurfaceColor;
     mpSurfaceColorBuffer->uploadToGPU();
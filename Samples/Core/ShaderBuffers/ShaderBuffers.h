@@ -75,5 +75,13 @@ private:
     glm::vec3 mSurfaceColor = glm::vec3(0.36f,0.87f,0.52f);
     Vao::SharedConstPtr getVao();
 
+    // Resolved once in onLoad(), used every frame instead of the variable names
+    ShaderVarHandle mWorldMatHandle;
+    ShaderVarHandle mWvpMatHandle;
+    ShaderVarHandle mInvocationBufferHandle;
+
+    std::string mHandleBenchmarkResult;
+    void benchmarkVariableHandles();
+
     static const std::string skDefaultModel;
 };
\ No newline at end of file
@@ -154,12 +154,17 @@ void ForwardRenderer::initScene(SampleCallbacks* pSample, Scene::SharedPtr pScen
     }
 
     mpSceneRenderer = ForwardRendererSceneRenderer::create(pScene);
+    for (auto& pSnapshot : mpSnapshots)
+    {
+        pSnapshot = SceneSnapshot::create();
+    }
     mpSceneRenderer->setCameraControllerType(SceneRenderer::CameraControllerType::FirstPerson);
     mpSceneRenderer->toggleStaticMaterialCompilation(mPerMaterialShader);
     setSceneSampler(mpSceneSampler ? mpSceneSampler->getMaxAnisotropy() : 4);
     setActiveCameraAspectRatio(pSample->getCurrentFbo()->getWidth(), pSample->getCurrentFbo()->getHeight());
     initDepthPass();
     initLightingPass();
+    if (mUseMaterialTable || mUseIndirectDraw) applySceneResourceMode();
     auto pTargetFbo = pSample->getCurrentFbo();
     initShadowPass(pTargetFbo->getWidth(), pTargetFbo->getHeight());
     initSSAO();
@@ -207,7 +212,8 @@ void ForwardRenderer::loadScene(SampleCallbacks* pSample, const std::string& fil
         pBar = ProgressBar::create("Loading Scene", 100);
     }
 
-    Scene::SharedPtr pScene = Scene::loadFromFile(filename);
+    Scene::LoadFlags sceneFlags = mMergeGeometry ? Scene::LoadFlags::MergeGeometryBuffers : Scene::LoadFlags::None;
+    Scene::SharedPtr pScene = Scene::loadFromFile(filename, Model::LoadFlags::None, sceneFlags);
 
     if (pScene != nullptr)
     {
@@ -272,7 +278,7 @@ void ForwardRenderer::renderSkyBox(RenderContext* pContext)
     {
         PROFILE(skyBox);
         mpState->setDepthStencilState(mSkyBox.pDS);
-        mSkyBox.pEffect->render(pContext, mpSceneRenderer->getScene()->getActiveCamera().get());
+        mSkyBox.pEffect->render(pContext, mpSceneRenderer->getActiveCamera().get());
         mpState->setDepthStencilState(nullptr);
     }
 }
@@ -292,7 +298,7 @@ void ForwardRenderer::beginFrame(RenderContext* pContext, Fbo* pTargetFbo, uint6
         const auto& samplePattern = (mTAASamplePattern == SamplePattern::Halton) ? kHaltonSamplePattern : kDX11SamplePattern;
         static_assert(arraysize(kHaltonSamplePattern) == arraysize(kDX11SamplePattern), "Mismatch in the array size of the sample patterns");
         uint32_t patternIndex = uint32_t(frameId % arraysize(kHaltonSamplePattern));
-        mpSceneRenderer->getScene()->getActiveCamera()->setJitter(samplePattern[patternIndex][0] / targetResolution.x, samplePattern[patternIndex][1] / targetResolution.y);
+        mpSceneRenderer->getActiveCamera()->setJitter(samplePattern[patternIndex][0] / targetResolution.x, samplePattern[patternIndex][1] / targetResolution.y);
     }
 }
 
@@ -301,6 +307,71 @@ void ForwardRenderer::endFrame(RenderContext* pContext)
     pContext->popGraphicsState();
 }
 
+void ForwardRenderer::validateCullingWithHiddenInstance(RenderContext* pContext, IndirectDrawList* pDrawList)
+{
+    // Hiding an instance removes the draws which are left without instances, so the argument data shrinks below the size of the argument buffer.
+    // Prefer a model with a single instance, hiding it removes all of its draws
+    Scene* pScene = mpSceneRenderer->getScene().get();
+    ModelInstance* pInstance = nullptr;
+    for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+    {
+        uint32_t instanceCount = pScene->getModelInstanceCount(modelID);
+        if (instanceCount && (pInstance == nullptr || instanceCount == 1))
+        {
+            pInstance = pScene->getModelInstance(modelID, 0).get();
+            if (instanceCount == 1) break;
+        }
+    }
+    if (pInstance == nullptr || pInstance->isVisible() == false) return;
+
+    const Camera* pCamera = mpSceneRenderer->getActiveCamera().get();
+    const MaterialTable* pMaterialTable = mUseMaterialTable ? mpSceneRenderer->getMaterialTable().get() : nullptr;
+    Buffer::SharedPtr pTransforms = pDrawList->getTransformBuffer();
+    size_t drawCount = pDrawList->getDraws().size();
+
+    pInstance->setVisible(false);
+    pDrawList->update(pScene, pMaterialTable);
+    pDrawList->cull(pContext, pCamera, pTransforms);
+    pDrawList->validate(pContext, pCamera);
+    const IndirectDrawList::Stats& stats = pDrawList->getStats();
+    logInfo("Indirect draws with '" + pInstance->getName() + "' hidden - " + std::to_string(drawCount) + " -> " + std::to_string(pDrawList->getDraws().size()) + " draws, " +
+        std::to_string(stats.visibleInstanceCount) + " out of " + std::to_string(stats.instanceCount) + " instances visible, " + std::to_string(stats.mismatchCount) + " mismatches");
+
+    pInstance->setVisible(true);
+    pDrawList->update(pScene, pMaterialTable);
+    pDrawList->cull(pContext, pCamera, pTransforms);
+}
+
+void ForwardRenderer::finishIndirectDraws(SampleCallbacks* pSample, RenderContext* pContext)
+{
+    PROFILE(finishIndirectDraws);
+    const IndirectDrawList::SharedPtr& pDrawList = mpSceneRenderer->getIndirectDrawList();
+    if (pDrawList == nullptr) return;
+
+    // Validate the lighting pass culling before the Hi-Z buffer it used is overwritten
+    if (mValidateCulling && mUseIndirectDraw)
+    {
+        pDrawList->validate(pContext, mpSceneRenderer->getActiveCamera().get());
+        const IndirectDrawList::Stats& stats = pDrawList->getStats();
+        logInfo("Indirect draws - " + std::to_string(stats.visibleInstanceCount) + " out of " + std::to_string(stats.instanceCount) + " instances visible, " + std::to_string(stats.mismatchCount) + " mismatches");
+
+        // The next case changes the scene, so the simulation thread must not be reading it
+        pSample->waitForSimulation();
+        validateCullingWithHiddenInstance(pContext, pDrawList.get());
+    }
+    mValidateCulling = false;
+
+    // The next frame culls against this frame's depth
+    if (mUseIndirectDraw && mUseHiZCulling && mEnableDepthPass)
+    {
+        pDrawList->buildHiZ(pContext, (mAAMode == AAMode::MSAA) ? mpResolveFbo->getColorTexture(2) : mpDepthPassFbo->getDepthStencilTexture());
+    }
+    else
+    {
+        pDrawList->setHiZ(nullptr);
+    }
+}
+
 void ForwardRenderer::postProcess(RenderContext* pContext, Fbo::SharedPtr pTargetFbo)
 {
     PROFILE(postProcess);    
@@ -398,7 +469,7 @@ void ForwardRenderer::shadowPass(RenderContext* pContext)
     PROFILE(shadowPass);
     if (mControls[EnableShadows].enabled && mShadowPass.updateShadowMap)
     {
-        mShadowPass.camVpAtLastCsmUpdate = mpSceneRenderer->getScene()->getActiveCamera()->getViewProjMatrix();
+        mShadowPass.camVpAtLastCsmUpdate = mpSceneRenderer->getActiveCamera()->getViewProjMatrix();
         Texture::SharedPtr pDepth;
         if (mAAMode == AAMode::MSAA)
         {
@@ -408,7 +479,7 @@ void ForwardRenderer::shadowPass(RenderContext* pContext)
         {
             pDepth = mpDepthPassFbo->getDepthStencilTexture();
         }
-        mShadowPass.pVisibilityBuffer = mShadowPass.pCsm->generateVisibilityBuffer(pContext, mpSceneRenderer->getScene()->getActiveCamera().get(), mEnableDepthPass ? pDepth : nullptr);
+        mShadowPass.pVisibilityBuffer = mShadowPass.pCsm->generateVisibilityBuffer(pContext, mpSceneRenderer->getActiveCamera().get(), mEnableDepthPass ? pDepth : nullptr);
         pContext->flush();
     }
 }
@@ -444,7 +515,7 @@ void ForwardRenderer::ambientOcclusion(RenderContext* pContext, Fbo::SharedPtr p
     if (mControls[EnableSSAO].enabled)
     {
         Texture::SharedPtr pDepth = (mAAMode == AAMode::MSAA) ? mpResolveFbo->getColorTexture(2) : mpResolveFbo->getDepthStencilTexture();
-        Texture::SharedPtr pAOMap = mSSAO.pSSAO->generateAOMap(pContext, mpSceneRenderer->getScene()->getActiveCamera().get(), pDepth, mpResolveFbo->getColorTexture(1));
+        Texture::SharedPtr pAOMap = mSSAO.pSSAO->generateAOMap(pContext, mpSceneRenderer->getActiveCamera().get(), pDepth, mpResolveFbo->getColorTexture(1));
         mSSAO.pVars->setTexture("gColor", mpPostProcessFbo->getColorTexture(0));
         mSSAO.pVars->setTexture("gAOMap", pAOMap);
 
@@ -480,11 +551,20 @@ void ForwardRenderer::onFrameRender(SampleCallbacks* pSample, RenderContext::Sha
 {
     if (mpSceneRenderer)
     {
-        beginFrame(pRenderContext.get(), pTargetFbo.get(), pSample->getFrameID());
         {
             PROFILE(updateScene);
-            mpSceneRenderer->update(pSample->getCurrentTime());
+            if (pSample->isSimulationPipelined())
+            {
+                mpSceneRenderer->setSnapshot(getFrameSnapshot(pSample));
+            }
+            else
+            {
+                mpSceneRenderer->setSnapshot(nullptr);
+                mpSceneRenderer->update(pSample->getCurrentTime());
+            }
+            mShadowPass.pCsm->setSceneSnapshot(mpSceneRenderer->getSnapshot());
         }
+        beginFrame(pRenderContext.get(), pTargetFbo.get(), pSample->getFrameID());
 
         depthPass(pRenderContext.get());
         resolveDepthMSAA(pRenderContext.get()); // Only runs in MSAA mode
@@ -493,6 +573,7 @@ void ForwardRenderer::onFrameRender(SampleCallbacks* pSample, RenderContext::Sha
         renderSkyBox(pRenderContext.get());
         lightingPass(pRenderContext.get(), pTargetFbo.get());
         resolveMSAA(pRenderContext.get());      // This will only run if we are in MSAA mode
+        finishIndirectDraws(pSample, pRenderContext.get());
 
         Fbo::SharedPtr pPostProcessDst = mControls[EnableSSAO].enabled ? mpPostProcessFbo : pTargetFbo;
         postProcess(pRenderContext.get(), pPostProcessDst);
@@ -509,6 +590,38 @@ void ForwardRenderer::onFrameRender(SampleCallbacks* pSample, RenderContext::Sha
 
 }
 
+void ForwardRenderer::onFrameSimulate(SampleCallbacks* pSample, float currentTime, uint64_t frameID)
+{
+    // Runs on the simulation thread. The profiler isn't thread-safe, so the step is timed by the sample instead
+    if (mpSceneRenderer)
+    {
+        mpSceneRenderer->simulate(currentTime, frameID, mpSnapshots[frameID % SimulationThread::kSnapshotCount].get());
+    }
+}
+
+SceneSnapshot::SharedPtr ForwardRenderer::getFrameSnapshot(SampleCallbacks* pSample)
+{
+    const Scene* pScene = mpSceneRenderer->getScene().get();
+    uint64_t frameID = pSample->getFrameID();
+    const auto& pSnapshot = mpSnapshots[frameID % SimulationThread::kSnapshotCount];
+    if (pSnapshot->isCurrent(pScene))
+    {
+        return pSnapshot;
+    }
+
+    // The scene was loaded or edited after this frame was simulated. The simulation of the next frame started after the change, so wait for it and render its result
+    pSample->waitForSimulation();
+    const auto& pNextSnapshot = mpSnapshots[(frameID + 1) % SimulationThread::kSnapshotCount];
+    if (pNextSnapshot->isCurrent(pScene))
+    {
+        return pNextSnapshot;
+    }
+
+    // The simulation thread is idle now, so it's safe to simulate here
+    mpSceneRenderer->simulate(pSample->getCurrentTime(), frameID, pSnapshot.get());
+    return pSnapshot;
+}
+
 void ForwardRenderer::applyCameraPathState()
 {
     const Scene* pScene = mpSceneRenderer->getScene().get();
@@ -586,6 +699,20 @@ void ForwardRenderer::applyCsSkinningMode()
     }    
 }
 
+void ForwardRenderer::applySceneResourceMode()
+{
+    // The material table and the indirect draws change the resources the programs declare, so the vars have to be recreated
+    for (GraphicsProgram* pProgram : { mDepthPass.pProgram.get(), mLightingPass.pProgram.get() })
+    {
+        if (mUseMaterialTable) pProgram->addDefine("_MATERIAL_TABLE");
+        else                   pProgram->removeDefine("_MATERIAL_TABLE");
+        if (mUseIndirectDraw)  pProgram->addDefine("_INDIRECT_DRAW");
+        else                   pProgram->removeDefine("_INDIRECT_DRAW");
+    }
+    mDepthPass.pVars = GraphicsVars::create(mDepthPass.pProgram->getReflector());
+    mLightingPass.pVars = GraphicsVars::create(mLightingPass.pProgram->getReflector());
+}
+
 void ForwardRenderer::setActiveCameraAspectRatio(uint32_t w, uint32_t h)
 {
     mpSceneRenderer->getScene()->getActiveCamera()->setAspectRatio((float)w / (float)h);
@@ -619,6 +746,33 @@ void ForwardRenderer::setActiveCameraAspectRatio(uint32_t w, uint32_t h)
      }
  }
 
+void ForwardRenderer::onInitializeBenchmark(SampleCallbacks* pSample, SampleBenchmark* pBenchmark)
+{
+    // The scene arguments are shared with testing. Don't load the scene twice when both are enabled
+    if (pSample->getArgList().argExists("test") == false)
+    {
+        onInitializeTesting(pSample);
+    }
+
+    if (mpSceneRenderer == nullptr)
+    {
+        logWarning("Benchmarking ForwardRenderer without a scene. Use -loadscene or -loadmodel");
+        return;
+    }
+
+    // Paths are animated by Scene::update() with the sample's fixed time step, so the camera follows the same track on every run
+    const auto& pScene = mpSceneRenderer->getScene();
+    uint32_t pathIndex = pBenchmark->getCameraPathIndex();
+    if (pathIndex < pScene->getPathCount())
+    {
+        pScene->getPath(pathIndex)->attachObject(pScene->getActiveCamera());
+    }
+    else if (pScene->getPathCount() > 0)
+    {
+        logWarning("Benchmark camera path " + std::to_string(pathIndex) + " doesn't exist. The scene has " + std::to_string(pScene->getPathCount()) + " paths");
+    }
+}
+
 #ifdef _WIN32
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
 #else
@@ -37,6 +37,7 @@ class ForwardRenderer : public Renderer
 public:
     void onLoad(SampleCallbacks* pSample, RenderContext::SharedPtr pRenderContext) override;
     void onFrameRender(SampleCallbacks* pSample, RenderContext::SharedPtr pRenderContext, Fbo::SharedPtr pTargetFbo) override;
+    void onFrameSimulate(SampleCallbacks* pSample, float currentTime, uint64_t frameID) override;
     void onResizeSwapChain(SampleCallbacks* pSample, uint32_t width, uint32_t height) override;
     bool onKeyEvent(SampleCallbacks* pSample, const KeyboardEvent& keyEvent) override;
     bool onMouseEvent(SampleCallbacks* pSample, const MouseEvent& mouseEvent) override;
@@ -45,6 +46,7 @@ public:
 
     //Testing
     void onInitializeTesting(SampleCallbacks* pSample) override;
+    void onInitializeBenchmark(SampleCallbacks* pSample, SampleBenchmark* pBenchmark) override;
     void onBeginTestFrame(SampleTest* pSampleTest) override;
 
 private:
@@ -158,6 +160,8 @@ private:
 
     GraphicsState::SharedPtr mpState;
 	ForwardRendererSceneRenderer::SharedPtr mpSceneRenderer;
+    SceneSnapshot::SharedPtr mpSnapshots[SimulationThread::kSnapshotCount];  ///< Scene state written by onFrameSimulate(), when simulation pipelining is enabled
+    SceneSnapshot::SharedPtr getFrameSnapshot(SampleCallbacks* pSample);
     void loadModel(SampleCallbacks* pSample, const std::string& filename, bool showProgressBar);
     void loadScene(SampleCallbacks* pSample, const std::string& filename, bool showProgressBar);
     void initScene(SampleCallbacks* pSample, Scene::SharedPtr pScene);
@@ -214,6 +218,14 @@ private:
     bool mUseCameraPath = true;
     void applyCameraPathState();
     bool mPerMaterialShader = false;
+    bool mUseMaterialTable = false;
+    bool mUseIndirectDraw = false;
+    bool mUseHiZCulling = false;
+    bool mValidateCulling = false;
+    bool mMergeGeometry = false;
+    void applySceneResourceMode();
+    void finishIndirectDraws(SampleCallbacks* pSample, RenderContext* pContext);
+    void validateCullingWithHiddenInstance(RenderContext* pContext, IndirectDrawList* pDrawList);
     bool mEnableDepthPass = true;
     bool mUseCsSkinning = false;
     void applyCsSkinningMode();
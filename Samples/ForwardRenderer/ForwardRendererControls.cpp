@@ -156,6 +156,8 @@ void ForwardRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
             loadScene(pSample, filename, true);
         }
     }
+    pGui->addCheckBox("Merge Geometry Buffers", mMergeGeometry);
+    pGui->addTooltip("Pack the vertices and indices of the scene's meshes into shared buffers, so that most draws use the same VAO. Applies to the next loaded scene");
 
     if (mpSceneRenderer)
     {
@@ -219,6 +221,34 @@ void ForwardRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
             }
             pGui->addTooltip("Create a specialized version of the lighting program for each material in the scene");
 
+            if (pGui->addCheckBox("Material Table", mUseMaterialTable))
+            {
+                applySceneResourceMode();
+            }
+            pGui->addTooltip("Bind all the scene materials once per pass and select them by index, instead of binding a parameter-block per material");
+
+            if (pGui->addCheckBox("Indirect Draws", mUseIndirectDraw))
+            {
+                applySceneResourceMode();
+            }
+            pGui->addTooltip("Cull the mesh instances on the GPU and draw each mesh with a single indirect call");
+
+            if (mUseIndirectDraw)
+            {
+                pGui->addCheckBox("Hi-Z Occlusion Culling", mUseHiZCulling);
+                pGui->addTooltip("Cull the mesh instances against the depth of the previous frame. Requires the depth pass");
+
+                if (pGui->addButton("Validate Culling"))
+                {
+                    mValidateCulling = true;
+                }
+                pGui->addTooltip("Compare the GPU culling results of the next frame with the CPU emulation, then hide a model instance, cull again and compare");
+            }
+
+            const SceneRenderer::Stats& stats = mpSceneRenderer->getStats();
+            pGui->addText(("Draws: " + std::to_string(stats.drawCount) + ", VAO changes: " + std::to_string(stats.vaoChangeCount)).c_str());
+            pGui->addTooltip("Statistics of the last pass which rendered the scene");
+
             uint32_t maxAniso = mpSceneSampler->getMaxAnisotropy();
             if (pGui->addIntVar("Max Anisotropy", (int&)maxAniso, 1, 16))
             {
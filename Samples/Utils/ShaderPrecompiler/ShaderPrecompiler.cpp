@@ -0,0 +1,287 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Falcor.h"
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+using namespace Falcor;
+
+/*  Offline shader precompiler.
+    Usage: ShaderPrecompiler <manifest.json> [-threads <count>]
+
+    The manifest describes a list of programs and the permutation axes to compile:
+    {
+        "output": "Shaders.fsa",
+        "shader_models": ["5_1", "6_0"],
+        "programs": [
+            {
+                "libraries": [ { "file": "ModelViewer.ps.hlsl", "entry_points": { "ps": "main" } } ],
+                "default_vs": true,
+                "defines": { "_VERTEX_BLENDING": [null, ""] }
+            }
+        ]
+    }
+
+    Each program is compiled for every combination of shader model and define values. A null define value means the define is not set.
+    A program can override the shader models with its own "shader_models" array. "default_vs" adds the default vertex shader, the same way GraphicsProgram does when no vertex shader is provided.
+    The archive is generated for the graphics API the tool was built for. Load it in a sample with the `-shaderarchive <file>` argument.
+*/
+
+struct Permutation
+{
+    std::string name;
+    Program::Desc desc;
+    Program::DefineList defines;
+};
+
+struct Define
+{
+    std::string name;
+    std::vector<std::pair<bool, std::string>> values;   // A value of false in the first element means the define is not set
+};
+
+static const std::pair<const char*, ShaderType> kStages[] =
+{
+    { "vs", ShaderType::Vertex },
+    { "hs", ShaderType::Hull },
+    { "ds", ShaderType::Domain },
+    { "gs", ShaderType::Geometry },
+    { "ps", ShaderType::Pixel },
+    { "cs", ShaderType::Compute },
+};
+
+static bool error(const std::string& msg)
+{
+    std::cerr << "error: " << msg << std::endl;
+    return false;
+}
+
+static bool parseProgram(const rapidjson::Value& jsonProgram, const std::vector<std::string>& defaultShaderModels, std::vector<Permutation>& permutations)
+{
+    if (jsonProgram.HasMember("libraries") == false || jsonProgram["libraries"].IsArray() == false) return error("Program is missing the 'libraries' array");
+
+    Program::Desc desc;
+    std::string programName;
+    for (const auto& jsonLib : jsonProgram["libraries"].GetArray())
+    {
+        if (jsonLib.HasMember("file") == false || jsonLib["file"].IsString() == false) return error("Shader library is missing the 'file' string");
+        std::string file = jsonLib["file"].GetString();
+        desc.addShaderLibrary(file);
+        programName += (programName.empty() ? "" : "+") + file;
+
+        if (jsonLib.HasMember("entry_points"))
+        {
+            const auto& jsonEntries = jsonLib["entry_points"];
+            for (const auto& stage : kStages)
+            {
+                if (jsonEntries.HasMember(stage.first)) desc.entryPoint(stage.second, jsonEntries[stage.first].GetString());
+            }
+        }
+    }
+
+    if (jsonProgram.HasMember("default_vs") && jsonProgram["default_vs"].GetBool() && desc.getShaderEntryPoint(ShaderType::Vertex).empty())
+    {
+        desc.addShaderLibrary("DefaultVS.slang").vsEntry("defaultVS");
+    }
+
+    std::vector<std::string> shaderModels = defaultShaderModels;
+    if (jsonProgram.HasMember("shader_models"))
+    {
+        shaderModels.clear();
+        for (const auto& sm : jsonProgram["shader_models"].GetArray()) shaderModels.push_back(sm.GetString());
+    }
+    if (shaderModels.empty()) shaderModels.push_back("");
+
+    std::vector<Define> defines;
+    if (jsonProgram.HasMember("defines"))
+    {
+        for (const auto& jsonDefine : jsonProgram["defines"].GetObject())
+        {
+            Define d;
+            d.name = jsonDefine.name.GetString();
+            if (jsonDefine.value.IsArray() == false) return error("The values of define '" + d.name + "' must be an array");
+            for (const auto& v : jsonDefine.value.GetArray())
+            {
+                d.values.push_back(v.IsNull() ? std::make_pair(false, std::string()) : std::make_pair(true, std::string(v.GetString())));
+            }
+            if (d.values.empty()) return error("Define '" + d.name + "' has no values");
+            defines.push_back(d);
+        }
+    }
+
+    // Enumerate the cartesian product of shader models and define values
+    for (const auto& sm : shaderModels)
+    {
+        Permutation base;
+        base.desc = desc;
+        if (sm.size()) base.desc.setShaderModel(sm);
+
+        std::vector<size_t> index(defines.size(), 0);
+        while (true)
+        {
+            Permutation p = base;
+            p.name = programName + " [" + (sm.empty() ? "default" : sm) + "]";
+            for (size_t d = 0; d < defines.size(); d++)
+            {
+                const auto& value = defines[d].values[index[d]];
+                if (value.first)
+                {
+                    p.defines.add(defines[d].name, value.second);
+                    p.name += " " + defines[d].name + (value.second.empty() ? "" : "=" + value.second);
+                }
+            }
+            permutations.push_back(p);
+
+            // Advance to the next combination
+            size_t d = 0;
+            for (; d < defines.size(); d++)
+            {
+                if (++index[d] < defines[d].values.size()) break;
+                index[d] = 0;
+            }
+            if (d == defines.size()) break;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: ShaderPrecompiler <manifest.json> [-threads <count>]" << std::endl;
+        return 1;
+    }
+
+    uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "-threads") threadCount = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    Logger::init();
+    Logger::showBoxOnError(false);
+
+    // Read the manifest. Its directory is a data directory, so shader files can be relative to it
+    std::string manifestPath;
+    if (findFileInDataDirectories(argv[1], manifestPath) == false)
+    {
+        error(std::string("Can't find manifest file ") + argv[1]);
+        return 1;
+    }
+    addDataDirectory(getDirectoryFromFile(manifestPath));
+
+    std::ifstream file(manifestPath);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string jsonData = ss.str();
+
+    rapidjson::Document jdoc;
+    jdoc.Parse(jsonData.c_str());
+    if (jdoc.HasParseError())
+    {
+        size_t line = std::count(jsonData.begin(), jsonData.begin() + jdoc.GetErrorOffset(), '\n');
+        error("JSON Parse error in line " + std::to_string(line) + ". " + rapidjson::GetParseError_En(jdoc.GetParseError()));
+        return 1;
+    }
+
+    std::string output = jdoc.HasMember("output") ? jdoc["output"].GetString() : "Shaders.fsa";
+    std::vector<std::string> shaderModels;
+    if (jdoc.HasMember("shader_models"))
+    {
+        for (const auto& sm : jdoc["shader_models"].GetArray()) shaderModels.push_back(sm.GetString());
+    }
+
+    std::vector<Permutation> permutations;
+    if (jdoc.HasMember("programs") == false || jdoc["programs"].IsArray() == false)
+    {
+        error("Manifest is missing the 'programs' array");
+        return 1;
+    }
+    for (const auto& jsonProgram : jdoc["programs"].GetArray())
+    {
+        if (parseProgram(jsonProgram, shaderModels, permutations) == false) return 1;
+    }
+
+    std::cout << "Compiling " << permutations.size() << " permutations using " << threadCount << " threads" << std::endl;
+
+    // Compile in parallel. Each worker takes the next permutation until all are done
+    ShaderArchive::SharedPtr pArchive = ShaderArchive::create();
+    std::mutex mutex;
+    std::atomic<size_t> next(0);
+    std::atomic<uint32_t> failed(0);
+    size_t savedBytes = 0;
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < permutations.size(); i = next++)
+        {
+            const Permutation& p = permutations[i];
+            Shader::Blob blobs[(uint32_t)ShaderType::Count];
+            ShaderArchive::ReflectionBlob reflection[ShaderArchive::kReflectorCount];
+            ShaderArchive::DependencyList dependencies;
+            std::string log;
+
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            bool success = Program::compileBlobs(p.desc, p.defines, blobs, reflection, dependencies, log);
+            double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (success)
+            {
+                savedBytes += pArchive->addPermutation(Program::getPermutationKey(p.desc, p.defines), blobs, reflection, dependencies);
+                std::cout << ms << " ms\t" << p.name << std::endl;
+            }
+            else
+            {
+                failed++;
+                std::cerr << "FAILED\t" << p.name << "\n" << log << std::endl;
+            }
+        }
+    };
+
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadCount; i++) threads.push_back(std::thread(worker));
+    for (auto& t : threads) t.join();
+    double totalMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    std::cout << "Compiled " << permutations.size() - failed << "/" << permutations.size() << " permutations in " << totalMs << " ms" << std::endl;
+    std::cout << pArchive->getBlobCount() << " unique shader blobs, " << pArchive->getReflectionCount() << " unique reflection layouts, " << savedBytes << " bytes deduplicated" << std::endl;
+
+    bool written = pArchive->writeToFile(output);
+    if (written) std::cout << "Wrote " << output << std::endl;
+    Logger::shutdown();
+    return (failed == 0 && written) ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ReflectionSerializerTest.h"
+
+void ReflectionSerializerTest::addTests()
+{
+    addTestToList<TestComputeRoundTrip>();
+    addTestToList<TestGraphicsRoundTrip>();
+    addTestToList<TestInvalidBlob>();
+}
+
+//Archived programs take their reflection from the serialized data, so a reflector rebuilt from it must bind exactly like the one Slang built
+static std::string compareReflectors(const ProgramReflection* pSlang, const ProgramReflection* pRebuilt)
+{
+    std::vector<uint8_t> slangBlob, rebuiltBlob;
+    pSlang->serialize(slangBlob);
+    pRebuilt->serialize(rebuiltBlob);
+    if (slangBlob != rebuiltBlob)
+    {
+        return "Serializing the rebuilt reflector doesn't return the original data";
+    }
+
+    if (pSlang->getParameterBlockCount() != pRebuilt->getParameterBlockCount() ||
+        pSlang->getThreadGroupSize() != pRebuilt->getThreadGroupSize() ||
+        pSlang->isSampleFrequency() != pRebuilt->isSampleFrequency())
+    {
+        return "Rebuilt reflector's program properties don't match";
+    }
+
+    for (uint32_t b = 0; b < (uint32_t)pSlang->getParameterBlockCount(); ++b)
+    {
+        const ParameterBlockReflection* pBlock = pSlang->getParameterBlock(b).get();
+        const ParameterBlockReflection* pOther = pRebuilt->getParameterBlock(pBlock->getName()).get();
+        if (pOther == nullptr || *pBlock != *pOther)
+        {
+            return "Parameter block '" + pBlock->getName() + "' doesn't match";
+        }
+
+        const auto& resources = pBlock->getResourceVec();
+        const auto& otherResources = pOther->getResourceVec();
+        if (resources.size() != otherResources.size())
+        {
+            return "Parameter block '" + pBlock->getName() + "' has a different number of resources";
+        }
+        for (size_t r = 0; r < resources.size(); ++r)
+        {
+            const auto& res = resources[r];
+            const auto& other = otherResources[r];
+            ParameterBlockReflection::BindLocation loc = pBlock->getResourceBinding(res.name);
+            ParameterBlockReflection::BindLocation otherLoc = pOther->getResourceBinding(res.name);
+            if (res.name != other.name || res.descOffset != other.descOffset || res.descCount != other.descCount ||
+                res.regIndex != other.regIndex || res.regSpace != other.regSpace || res.setType != other.setType ||
+                loc.setIndex != otherLoc.setIndex || loc.rangeIndex != otherLoc.rangeIndex)
+            {
+                return "Binding of resource '" + res.name + "' doesn't match";
+            }
+        }
+    }
+
+    RootSignature::SharedPtr pSlangRootSig = RootSignature::create(pSlang);
+    RootSignature::SharedPtr pRebuiltRootSig = RootSignature::create(pRebuilt);
+    if (!(pSlangRootSig->getDesc() == pRebuiltRootSig->getDesc()))
+    {
+        return "Root signatures don't match";
+    }
+
+    return "";
+}
+
+static std::string roundTrip(const ProgramReflection* pSlang)
+{
+    std::vector<uint8_t> blob;
+    pSlang->serialize(blob);
+    //Don't share the interned object, it would be the Slang reflector itself
+    ProgramReflection::SharedPtr pRebuilt = ProgramReflection::createFromBlob(blob, false);
+    if (pRebuilt == nullptr)
+    {
+        return "Couldn't create a reflector from the serialized data";
+    }
+    if (pRebuilt.get() == pSlang)
+    {
+        return "createFromBlob() returned the interned reflector";
+    }
+    return compareReflectors(pSlang, pRebuilt.get());
+}
+
+testing_func(ReflectionSerializerTest, TestComputeRoundTrip)
+{
+    ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile("ReflectionTest.cs.slang", "main");
+    std::string error = roundTrip(pProgram->getActiveVersion()->getReflector().get());
+    if (error.size())
+    {
+        return test_fail(error);
+    }
+    return test_pass();
+}
+
+testing_func(ReflectionSerializerTest, TestGraphicsRoundTrip)
+{
+    GraphicsProgram::SharedPtr pProgram = GraphicsProgram::createFromFile("ReflectionTest.slang", "vsMain", "psMain");
+    const ProgramReflection* pReflector = pProgram->getActiveVersion()->getReflector().get();
+    std::string error = roundTrip(pReflector);
+    if (error.size())
+    {
+        return test_fail(error);
+    }
+
+    //The vertex attributes and pixel shader outputs are only covered by the byte comparison, check them directly as well
+    std::vector<uint8_t> blob;
+    pReflector->serialize(blob);
+    ProgramReflection::SharedPtr pRebuilt = ProgramReflection::createFromBlob(blob, false);
+    const ProgramReflection::ShaderVariable* pAttrib = pRebuilt->getVertexAttributeBySemantic("NORMAL");
+    const ProgramReflection::ShaderVariable* pOrigAttrib = pReflector->getVertexAttributeBySemantic("NORMAL");
+    const ProgramReflection::ShaderVariable* pOutput = pRebuilt->getPixelShaderOutput("color");
+    const ProgramReflection::ShaderVariable* pOrigOutput = pReflector->getPixelShaderOutput("color");
+    if (pAttrib == nullptr || pOrigAttrib == nullptr || pAttrib->bindLocation != pOrigAttrib->bindLocation || pAttrib->type != pOrigAttrib->type ||
+        pOutput == nullptr || pOrigOutput == nullptr || pOutput->bindLocation != pOrigOutput->bindLocation || pOutput->type != pOrigOutput->type)
+    {
+        return test_fail("Vertex attributes or pixel shader outputs don't match");
+    }
+
+    return test_pass();
+}
+
+testing_func(ReflectionSerializerTest, TestInvalidBlob)
+{
+    ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile("ReflectionTest.cs.slang", "main");
+    std::vector<uint8_t> blob;
+    pProgram->getActiveVersion()->getReflector()->serialize(blob);
+
+    //Truncated data and data from another format version must be rejected instead of creating a partial reflector
+    std::vector<uint8_t> truncated(blob.begin(), blob.begin() + blob.size() / 2);
+    std::vector<uint8_t> wrongVersion = blob;
+    wrongVersion[0] ^= 0xFF;
+    if (ProgramReflection::createFromBlob(truncated, false) != nullptr ||
+        ProgramReflection::createFromBlob(wrongVersion, false) != nullptr ||
+        ProgramReflection::createFromBlob(std::vector<uint8_t>(), false) != nullptr)
+    {
+        return test_fail("Invalid reflection data was accepted");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    ReflectionSerializerTest rst;
+    rst.init(true);
+    rst.run();
+    return 0;
+}